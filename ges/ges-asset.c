@@ -144,21 +144,12 @@ typedef struct
   GESAsset *asset;
 } GESAssetCacheEntry;
 
-/* Also protect all the entries in the cache */
-G_LOCK_DEFINE_STATIC (asset_cache_lock);
-/* We are mapping entries by types and ID, such as:
+/* We are mapping entries by first extractable type and ID, such as:
  *
  * {
- *   first_extractable_type_name1 :
- *      {
- *        "some ID": GESAssetCacheEntry,
- *        "some other ID": GESAssetCacheEntry 2
- *      },
- *   second_extractable_type_name :
- *      {
- *        "some ID": GESAssetCacheEntry,
- *        "some other ID": GESAssetCacheEntry 2
- *      }
+ *   (first_extractable_type1, "some ID"): GESAssetCacheEntry,
+ *   (first_extractable_type1, "some other ID"): GESAssetCacheEntry 2,
+ *   (first_extractable_type2, "some ID"): GESAssetCacheEntry 3
  * }
  *
  * (The first extractable type is the type of the class that implemented
@@ -167,10 +158,27 @@ G_LOCK_DEFINE_STATIC (asset_cache_lock);
  *
  * This is in order to be able to have 2 Asset with the same ID but
  * different extractable types.
+ *
+ * Assets get requested from the discoverer and from the threads loading
+ * timelines, so the cache is split in shards that are locked separately,
+ * each lock also protecting the entries of its shard.
  **/
-static GHashTable *type_entries_table = NULL;
-#define LOCK_CACHE   (G_LOCK (asset_cache_lock))
-#define UNLOCK_CACHE (G_UNLOCK (asset_cache_lock))
+typedef struct
+{
+  GType type;
+  gchar *id;
+  guint hash;
+} GESAssetCacheKey;
+
+typedef struct
+{
+  GRWLock lock;
+  /* GESAssetCacheKey -> GESAssetCacheEntry */
+  GHashTable *entries;
+} GESAssetCacheShard;
+
+#define N_CACHE_SHARDS 16
+static GESAssetCacheShard cache_shards[N_CACHE_SHARDS];
 
 static gchar *
 _check_and_update_parameters (GType * extractable_type, const gchar * id,
@@ -459,28 +467,70 @@ ges_asset_init (GESAsset * self)
 /* Internal methods */
 
 /* Find the type that implemented the GESExtractable interface */
-static inline const gchar *
-_extractable_type_name (GType type)
+static inline GType
+_extractable_root_type (GType type)
 {
-  while (1) {
-    if (g_type_is_a (g_type_parent (type), GES_TYPE_EXTRACTABLE))
-      type = g_type_parent (type);
-    else
-      return g_type_name (type);
-  }
+  while (g_type_is_a (g_type_parent (type), GES_TYPE_EXTRACTABLE))
+    type = g_type_parent (type);
+
+  return type;
 }
 
-static inline GESAssetCacheEntry *
-_lookup_entry (GType extractable_type, const gchar * id)
+/* @id is not copied, keys stored in the cache are created with
+ * _cache_key_copy() */
+static inline void
+_cache_key_init (GESAssetCacheKey * key, GType extractable_type,
+    const gchar * id)
 {
-  GHashTable *entries_table;
+  key->type = _extractable_root_type (extractable_type);
+  key->id = (gchar *) id;
+  key->hash = g_str_hash (id) * 31 + (guint) key->type;
+}
 
-  entries_table = g_hash_table_lookup (type_entries_table,
-      _extractable_type_name (extractable_type));
-  if (entries_table)
-    return g_hash_table_lookup (entries_table, id);
+static GESAssetCacheKey *
+_cache_key_copy (const GESAssetCacheKey * key)
+{
+  GESAssetCacheKey *copy = g_slice_new (GESAssetCacheKey);
 
-  return NULL;
+  copy->type = key->type;
+  copy->id = g_strdup (key->id);
+  copy->hash = key->hash;
+
+  return copy;
+}
+
+static void
+_cache_key_free (GESAssetCacheKey * key)
+{
+  g_free (key->id);
+  g_slice_free (GESAssetCacheKey, key);
+}
+
+static guint
+_cache_key_hash (const GESAssetCacheKey * key)
+{
+  return key->hash;
+}
+
+static gboolean
+_cache_key_equal (const GESAssetCacheKey * key1,
+    const GESAssetCacheKey * key2)
+{
+  return key1->type == key2->type && !g_strcmp0 (key1->id, key2->id);
+}
+
+static inline GESAssetCacheShard *
+_get_shard (const GESAssetCacheKey * key)
+{
+  /* The low bits are used by the hash tables of the shards */
+  return &cache_shards[(key->hash >> 16) % N_CACHE_SHARDS];
+}
+
+/* The lock of the shard of @key must be held */
+static inline GESAssetCacheEntry *
+_lookup_entry (const GESAssetCacheKey * key)
+{
+  return g_hash_table_lookup (_get_shard (key)->entries, key);
 }
 
 static void
@@ -517,15 +567,19 @@ GESAsset *
 ges_asset_cache_lookup (GType extractable_type, const gchar * id)
 {
   GESAsset *asset = NULL;
+  GESAssetCacheKey key;
+  GESAssetCacheShard *shard;
   GESAssetCacheEntry *entry = NULL;
 
   g_return_val_if_fail (id, NULL);
 
-  LOCK_CACHE;
-  entry = _lookup_entry (extractable_type, id);
+  _cache_key_init (&key, extractable_type, id);
+  shard = _get_shard (&key);
+  g_rw_lock_reader_lock (&shard->lock);
+  entry = _lookup_entry (&key);
   if (entry)
     asset = entry->asset;
-  UNLOCK_CACHE;
+  g_rw_lock_reader_unlock (&shard->lock);
 
   return asset;
 }
@@ -534,12 +588,16 @@ static void
 ges_asset_cache_append_task (GType extractable_type,
     const gchar * id, GTask * task)
 {
+  GESAssetCacheKey key;
+  GESAssetCacheShard *shard;
   GESAssetCacheEntry *entry = NULL;
 
-  LOCK_CACHE;
-  if ((entry = _lookup_entry (extractable_type, id)))
+  _cache_key_init (&key, extractable_type, id);
+  shard = _get_shard (&key);
+  g_rw_lock_writer_lock (&shard->lock);
+  if ((entry = _lookup_entry (&key)))
     entry->results = g_list_append (entry->results, task);
-  UNLOCK_CACHE;
+  g_rw_lock_writer_unlock (&shard->lock);
 }
 
 gboolean
@@ -547,14 +605,18 @@ ges_asset_cache_set_loaded (GType extractable_type, const gchar * id,
     GError * error)
 {
   GESAsset *asset;
+  GESAssetCacheKey key;
+  GESAssetCacheShard *shard;
   GESAssetCacheEntry *entry = NULL;
   GList *results = NULL;
   GFunc user_func = NULL;
   gpointer user_data = NULL;
 
-  LOCK_CACHE;
-  if ((entry = _lookup_entry (extractable_type, id)) == NULL) {
-    UNLOCK_CACHE;
+  _cache_key_init (&key, extractable_type, id);
+  shard = _get_shard (&key);
+  g_rw_lock_writer_lock (&shard->lock);
+  if ((entry = _lookup_entry (&key)) == NULL) {
+    g_rw_lock_writer_unlock (&shard->lock);
     GST_ERROR ("Calling but type %s ID: %s not in cached, "
         "something massively screwed", g_type_name (extractable_type), id);
 
@@ -585,8 +647,9 @@ ges_asset_cache_set_loaded (GType extractable_type, const gchar * id,
     user_func = (GFunc) _gtask_return_true;
     GST_DEBUG_OBJECT (asset, "initialized");
   }
-  UNLOCK_CACHE;
+  g_rw_lock_writer_unlock (&shard->lock);
 
+  /* Waiting tasks get completed without blocking the shard */
   g_list_foreach (results, user_func, user_data);
   g_list_free_full (results, g_object_unref);
 
@@ -596,49 +659,42 @@ ges_asset_cache_set_loaded (GType extractable_type, const gchar * id,
 void
 ges_asset_cache_put (GESAsset * asset, GTask * task)
 {
-  GType extractable_type;
-  const gchar *asset_id;
+  GESAssetCacheKey key;
+  GESAssetCacheShard *shard;
   GESAssetCacheEntry *entry;
 
   /* Needing to work with the cache, taking the lock */
-  asset_id = ges_asset_get_id (asset);
-  extractable_type = asset->priv->extractable_type;
-
-  LOCK_CACHE;
-  if (!(entry = _lookup_entry (extractable_type, asset_id))) {
-    GHashTable *entries_table;
-
-    entries_table = g_hash_table_lookup (type_entries_table,
-        _extractable_type_name (extractable_type));
-    if (entries_table == NULL) {
-      entries_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-          _free_entries);
-
-      g_hash_table_insert (type_entries_table,
-          g_strdup (_extractable_type_name (extractable_type)), entries_table);
-    }
+  _cache_key_init (&key, asset->priv->extractable_type,
+      ges_asset_get_id (asset));
+  shard = _get_shard (&key);
 
+  g_rw_lock_writer_lock (&shard->lock);
+  if (!(entry = _lookup_entry (&key))) {
     entry = g_slice_new0 (GESAssetCacheEntry);
 
     entry->asset = asset;
     if (task)
       entry->results = g_list_prepend (entry->results, task);
-    g_hash_table_insert (entries_table, (gpointer) g_strdup (asset_id),
-        (gpointer) entry);
+    g_hash_table_insert (shard->entries, _cache_key_copy (&key), entry);
   } else {
     if (task) {
-      GST_DEBUG ("%s already in cache, adding result %p", asset_id, task);
+      GST_DEBUG ("%s already in cache, adding result %p", key.id, task);
       entry->results = g_list_prepend (entry->results, task);
     }
   }
-  UNLOCK_CACHE;
+  g_rw_lock_writer_unlock (&shard->lock);
 }
 
 void
 ges_asset_cache_init (void)
 {
-  type_entries_table = g_hash_table_new_full (g_str_hash, g_str_equal,
-      g_free, (GDestroyNotify) g_hash_table_unref);
+  guint i;
+
+  for (i = 0; i < N_CACHE_SHARDS; i++)
+    cache_shards[i].entries =
+        g_hash_table_new_full ((GHashFunc) _cache_key_hash,
+        (GEqualFunc) _cache_key_equal, (GDestroyNotify) _cache_key_free,
+        _free_entries);
 
   _init_formatter_assets ();
   _init_standard_transition_assets ();
@@ -647,8 +703,12 @@ ges_asset_cache_init (void)
 void
 ges_asset_cache_deinit (void)
 {
-  g_hash_table_destroy (type_entries_table);
-  type_entries_table = NULL;
+  guint i;
+
+  for (i = 0; i < N_CACHE_SHARDS; i++) {
+    g_hash_table_destroy (cache_shards[i].entries);
+    cache_shards[i].entries = NULL;
+  }
 }
 
 gboolean
@@ -694,11 +754,33 @@ ges_asset_try_proxy (GESAsset * asset, const gchar * new_id)
   return TRUE;
 }
 
-static gboolean
-_lookup_proxied_asset (const gchar * id, GESAssetCacheEntry * entry,
-    const gchar * asset_id)
+/* Returns the entry of the asset of @extractable_type that was proxied by
+ * the asset of @id */
+static GESAssetCacheEntry *
+_lookup_proxied_entry (GType extractable_type, const gchar * id)
 {
-  return !g_strcmp0 (asset_id, entry->asset->priv->proxied_asset_id);
+  guint i;
+  gpointer key, value;
+  GHashTableIter iter;
+  GESAssetCacheEntry *ret = NULL;
+  GType type = _extractable_root_type (extractable_type);
+
+  for (i = 0; i < N_CACHE_SHARDS && !ret; i++) {
+    g_rw_lock_reader_lock (&cache_shards[i].lock);
+    g_hash_table_iter_init (&iter, cache_shards[i].entries);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+      GESAssetCacheEntry *entry = value;
+
+      if (((GESAssetCacheKey *) key)->type == type &&
+          !g_strcmp0 (id, entry->asset->priv->proxied_asset_id)) {
+        ret = entry;
+        break;
+      }
+    }
+    g_rw_lock_reader_unlock (&cache_shards[i].lock);
+  }
+
+  return ret;
 }
 
 /**
@@ -747,13 +829,10 @@ ges_asset_set_proxy (GESAsset * asset, GESAsset * proxy)
   }
 
   if (asset == NULL) {
-    GHashTable *entries_table;
     GESAssetCacheEntry *entry;
 
-    entries_table = g_hash_table_lookup (type_entries_table,
-        _extractable_type_name (proxy->priv->extractable_type));
-    entry = g_hash_table_find (entries_table, (GHRFunc) _lookup_proxied_asset,
-        (gpointer) ges_asset_get_id (proxy));
+    entry = _lookup_proxied_entry (proxy->priv->extractable_type,
+        ges_asset_get_id (proxy));
 
     if (!entry) {
       GST_DEBUG_OBJECT (asset, "Not proxying any asset");
@@ -882,9 +961,9 @@ ges_asset_get_proxy_target (GESAsset * proxy)
 void
 ges_asset_set_id (GESAsset * asset, const gchar * id)
 {
-  GHashTable *entries;
-
-  gpointer orig_id = NULL;
+  GESAssetCacheKey key, new_key;
+  GESAssetCacheShard *shard, *new_shard;
+  gpointer orig_key = NULL;
   GESAssetCacheEntry *entry = NULL;
   GESAssetPrivate *priv = NULL;
 
@@ -904,21 +983,35 @@ ges_asset_set_id (GESAsset * asset, const gchar * id)
     return;
   }
 
-  LOCK_CACHE;
-  entries = g_hash_table_lookup (type_entries_table,
-      _extractable_type_name (asset->priv->extractable_type));
-
-  g_return_if_fail (g_hash_table_lookup_extended (entries, priv->id, &orig_id,
-          (gpointer *) & entry));
+  _cache_key_init (&key, priv->extractable_type, priv->id);
+  _cache_key_init (&new_key, priv->extractable_type, id);
+  shard = _get_shard (&key);
+  new_shard = _get_shard (&new_key);
+
+  /* Always locked in the same order */
+  g_rw_lock_writer_lock (&MIN (shard, new_shard)->lock);
+  if (shard != new_shard)
+    g_rw_lock_writer_lock (&MAX (shard, new_shard)->lock);
+
+  if (!g_hash_table_lookup_extended (shard->entries, &key, &orig_key,
+          (gpointer *) & entry)) {
+    if (shard != new_shard)
+      g_rw_lock_writer_unlock (&new_shard->lock);
+    g_rw_lock_writer_unlock (&shard->lock);
+    g_return_if_reached ();
+  }
 
-  g_hash_table_steal (entries, priv->id);
-  g_hash_table_insert (entries, g_strdup (id), entry);
+  g_hash_table_steal (shard->entries, &key);
+  g_hash_table_insert (new_shard->entries, _cache_key_copy (&new_key), entry);
 
   GST_DEBUG_OBJECT (asset, "Changing id from %s to %s", priv->id, id);
+  _cache_key_free (orig_key);
   g_free (priv->id);
-  g_free (orig_id);
   priv->id = g_strdup (id);
-  UNLOCK_CACHE;
+
+  if (shard != new_shard)
+    g_rw_lock_writer_unlock (&new_shard->lock);
+  g_rw_lock_writer_unlock (&shard->lock);
 }
 
 static GESAsset *
@@ -1339,30 +1432,29 @@ ges_asset_request_finish (GAsyncResult * res, GError ** error)
 GList *
 ges_list_assets (GType filter)
 {
+  guint i;
   GList *ret = NULL;
   GESAsset *asset;
-  GHashTableIter iter, types_iter;
-  gpointer key, value, typename, assets;
+  GHashTableIter iter;
+  gpointer key, value;
 
   g_return_val_if_fail (g_type_is_a (filter, GES_TYPE_EXTRACTABLE), NULL);
 
-  LOCK_CACHE;
-  g_hash_table_iter_init (&types_iter, type_entries_table);
-  while (g_hash_table_iter_next (&types_iter, &typename, &assets)) {
-    if (g_type_is_a (filter, g_type_from_name ((gchar *) typename)) == FALSE)
-      continue;
-
-    g_hash_table_iter_init (&iter, (GHashTable *) assets);
+  for (i = 0; i < N_CACHE_SHARDS; i++) {
+    g_rw_lock_reader_lock (&cache_shards[i].lock);
+    g_hash_table_iter_init (&iter, cache_shards[i].entries);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
-      asset = ((GESAssetCacheEntry *) value)->asset;
+      if (g_type_is_a (filter, ((GESAssetCacheKey *) key)->type) == FALSE)
+        continue;
 
+      asset = ((GESAssetCacheEntry *) value)->asset;
       if (g_type_is_a (asset->priv->extractable_type, filter))
-        ret = g_list_append (ret, asset);
+        ret = g_list_prepend (ret, asset);
     }
+    g_rw_lock_reader_unlock (&cache_shards[i].lock);
   }
-  UNLOCK_CACHE;
 
-  return ret;
+  return g_list_reverse (ret);
 }
 
 /**
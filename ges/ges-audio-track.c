@@ -69,8 +69,8 @@ create_element_for_raw_audio_gap (GESTrack * track)
 {
   GstElement *elem;
 
-  elem = gst_element_factory_make ("audiotestsrc", NULL);
-  g_object_set (elem, "wave", 4, NULL);
+  elem = gst_element_factory_make ("gesgapsrc", NULL);
+  g_object_set (elem, "track-type", GES_TRACK_TYPE_AUDIO, NULL);
 
   return elem;
 }
@@ -31,16 +31,13 @@
 #include "ges-track-element.h"
 #include "ges-audio-transition.h"
 
-#include <gst/controller/gstdirectcontrolbinding.h>
-
 struct _GESAudioTransitionPrivate
 {
-  /* these enable volume interpolation. Unlike video, both inputs are adjusted
-   * simultaneously */
-  GstControlSource *a_control_source;
-
-  GstControlSource *b_control_source;
+  /* Unlike video, both inputs are faded simultaneously, the fade curves are
+   * shared with all the transitions of the same duration */
+  GstElement *a_fade;
 
+  GstElement *b_fade;
 };
 
 enum
@@ -107,17 +104,8 @@ ges_audio_transition_dispose (GObject * object)
 
   self = GES_AUDIO_TRANSITION (object);
 
-  if (self->priv->a_control_source) {
-    if (self->priv->a_control_source)
-      gst_object_unref (self->priv->a_control_source);
-    self->priv->a_control_source = NULL;
-  }
-
-  if (self->priv->b_control_source) {
-    if (self->priv->b_control_source)
-      gst_object_unref (self->priv->b_control_source);
-    self->priv->b_control_source = NULL;
-  }
+  gst_clear_object (&self->priv->a_fade);
+  gst_clear_object (&self->priv->b_fade);
 
   g_signal_handlers_disconnect_by_func (GES_TRACK_ELEMENT (self),
       duration_changed_cb, NULL);
@@ -151,23 +139,25 @@ ges_audio_transition_set_property (GObject * object,
   }
 }
 
-static GObject *
-link_element_to_mixer_with_volume (GstBin * bin, GstElement * element,
-    GstElement * mixer)
+static GstElement *
+link_element_to_mixer_with_fade (GstBin * bin, GstElement * element,
+    GstElement * mixer, gdouble start_volume, gdouble end_volume)
 {
-  GstElement *volume = gst_element_factory_make ("volume", NULL);
+  GstElement *fade = gst_element_factory_make ("gesaudiofade", NULL);
   GstElement *resample = gst_element_factory_make ("audioresample", NULL);
 
-  gst_bin_add (bin, volume);
+  g_object_set (fade, "start-volume", start_volume, "end-volume", end_volume,
+      NULL);
+  gst_bin_add (bin, fade);
   gst_bin_add (bin, resample);
 
-  if (!fast_element_link (element, volume) ||
-      !fast_element_link (volume, resample) ||
+  if (!fast_element_link (element, fade) ||
+      !fast_element_link (fade, resample) ||
       !gst_element_link_pads_full (resample, "src", mixer, "sink_%u",
           GST_PAD_LINK_CHECK_NOTHING))
-    GST_ERROR_OBJECT (bin, "Error linking volume to mixer");
+    GST_ERROR_OBJECT (bin, "Error linking fade to mixer");
 
-  return G_OBJECT (volume);
+  return gst_object_ref (fade);
 }
 
 static GstElement *
@@ -175,12 +165,9 @@ ges_audio_transition_create_element (GESTrackElement * track_element)
 {
   GESAudioTransition *self;
   GstElement *topbin, *iconva, *iconvb, *oconv;
-  GObject *atarget, *btarget = NULL;
-  const gchar *propname = "volume";
   GstElement *mixer = NULL;
   GstPad *sinka_target, *sinkb_target, *src_target, *sinka, *sinkb, *src;
   guint64 duration;
-  GstControlSource *acontrol_source, *bcontrol_source;
 
   self = GES_AUDIO_TRANSITION (track_element);
 
@@ -196,10 +183,12 @@ ges_audio_transition_create_element (GESTrackElement * track_element)
   mixer = gst_element_factory_make ("audiomixer", NULL);
   gst_bin_add (GST_BIN (topbin), mixer);
 
-  atarget = link_element_to_mixer_with_volume (GST_BIN (topbin), iconva, mixer);
-  btarget = link_element_to_mixer_with_volume (GST_BIN (topbin), iconvb, mixer);
-
-  g_assert (atarget && btarget);
+  self->priv->a_fade =
+      link_element_to_mixer_with_fade (GST_BIN (topbin), iconva, mixer, 1.0,
+      0.0);
+  self->priv->b_fade =
+      link_element_to_mixer_with_fade (GST_BIN (topbin), iconvb, mixer, 0.0,
+      1.0);
 
   fast_element_link (mixer, oconv);
 
@@ -215,21 +204,10 @@ ges_audio_transition_create_element (GESTrackElement * track_element)
   gst_element_add_pad (topbin, sinka);
   gst_element_add_pad (topbin, sinkb);
 
-  /* set up interpolation */
-
   gst_object_unref (sinka_target);
   gst_object_unref (sinkb_target);
   gst_object_unref (src_target);
 
-  acontrol_source = gst_interpolation_control_source_new ();
-  g_object_set (acontrol_source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
-
-  bcontrol_source = gst_interpolation_control_source_new ();
-  g_object_set (bcontrol_source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
-
-  self->priv->a_control_source = acontrol_source;
-  self->priv->b_control_source = bcontrol_source;
-
   duration =
       ges_timeline_element_get_duration (GES_TIMELINE_ELEMENT (track_element));
   ges_audio_transition_duration_changed (track_element, duration);
@@ -237,16 +215,6 @@ ges_audio_transition_create_element (GESTrackElement * track_element)
   g_signal_connect (track_element, "notify::duration",
       G_CALLBACK (duration_changed_cb), NULL);
 
-  gst_object_add_control_binding (GST_OBJECT (atarget),
-      gst_direct_control_binding_new (GST_OBJECT (atarget), propname,
-          acontrol_source));
-  gst_object_add_control_binding (GST_OBJECT (btarget),
-      gst_direct_control_binding_new (GST_OBJECT (btarget), propname,
-          bcontrol_source));
-
-  self->priv->a_control_source = acontrol_source;
-  self->priv->b_control_source = bcontrol_source;
-
   return topbin;
 }
 
@@ -254,33 +222,15 @@ static void
 ges_audio_transition_duration_changed (GESTrackElement * track_element,
     guint64 duration)
 {
-  GESAudioTransition *self;
-  GstElement *nleobj = ges_track_element_get_nleobject (track_element);
-  GstTimedValueControlSource *ta, *tb;
-
-  self = GES_AUDIO_TRANSITION (track_element);
-
-  GST_INFO ("updating controller: nleobj (%p)", nleobj);
+  GESAudioTransition *self = GES_AUDIO_TRANSITION (track_element);
 
-  if (G_UNLIKELY ((!self->priv->a_control_source ||
-              !self->priv->b_control_source)))
+  if (G_UNLIKELY (!self->priv->a_fade || !self->priv->b_fade))
     return;
 
-  GST_INFO ("setting values on controller");
-  ta = GST_TIMED_VALUE_CONTROL_SOURCE (self->priv->a_control_source);
-  tb = GST_TIMED_VALUE_CONTROL_SOURCE (self->priv->b_control_source);
-
-  gst_timed_value_control_source_unset_all (ta);
-  gst_timed_value_control_source_unset_all (tb);
-  /* The volume property goes from 0 to 10, so we want to interpolate between
-   * 0 and 0.1 */
-  gst_timed_value_control_source_set (ta, 0, 0.1);
-  gst_timed_value_control_source_set (ta, duration, 0.0);
-
-  gst_timed_value_control_source_set (tb, 0, 0.0);
-  gst_timed_value_control_source_set (tb, duration, 0.1);
-
-  GST_INFO ("done updating controller");
+  GST_INFO ("setting fades duration to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (duration));
+  g_object_set (self->priv->a_fade, "duration", duration, NULL);
+  g_object_set (self->priv->b_fade, "duration", duration, NULL);
 }
 
 /**
@@ -63,6 +63,39 @@ ges_audio_uri_source_track_set_cb (GESAudioUriSource * self,
 
   GST_INFO_OBJECT (self, "Setting caps to: %" GST_PTR_FORMAT, caps);
   g_object_set (self->priv->decodebin, "caps", caps, NULL);
+  ges_audio_uri_source_update_playback_uri (self);
+}
+
+static gchar *
+_get_playback_uri (GESAudioUriSource * self)
+{
+  GESTrack *track = ges_track_element_get_track (GES_TRACK_ELEMENT (self));
+  GESTimeline *timeline =
+      track ? (GESTimeline *) ges_track_get_timeline (track) : NULL;
+
+  return ges_uri_clip_asset_get_playback_uri (self->uri,
+      timeline && timeline_get_use_proxies (timeline));
+}
+
+/* Makes the decodebin play the proxy of the media or the media itself
+ * depending on what the timeline is used for */
+void
+ges_audio_uri_source_update_playback_uri (GESAudioUriSource * self)
+{
+  gchar *uri, *current_uri;
+
+  if (!self->priv->decodebin)
+    return;
+
+  uri = _get_playback_uri (self);
+  g_object_get (self->priv->decodebin, "uri", &current_uri, NULL);
+  if (g_strcmp0 (uri, current_uri)) {
+    GST_INFO_OBJECT (self, "Playing %s for %s", uri, self->uri);
+    g_object_set (self->priv->decodebin, "uri", uri, NULL);
+  }
+
+  g_free (current_uri);
+  g_free (uri);
 }
 
 /* GESSource VMethod */
@@ -71,6 +104,7 @@ ges_audio_uri_source_create_source (GESTrackElement * trksrc)
 {
   GESAudioUriSource *self;
   GESTrack *track;
+  gchar *uri;
   GstElement *decodebin;
   const GstCaps *caps = NULL;
 
@@ -84,8 +118,10 @@ ges_audio_uri_source_create_source (GESTrackElement * trksrc)
   if (track)
     caps = ges_track_get_caps (track);
 
+  uri = _get_playback_uri (self);
   g_object_set (decodebin, "caps", caps,
-      "expose-all-streams", FALSE, "uri", self->uri, NULL);
+      "expose-all-streams", FALSE, "uri", uri, NULL);
+  g_free (uri);
 
   return decodebin;
 }
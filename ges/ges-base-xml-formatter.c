@@ -28,14 +28,17 @@ GST_DEBUG_CATEGORY_STATIC (base_xml_formatter);
 #undef GST_CAT_DEFAULT
 #define GST_CAT_DEFAULT base_xml_formatter
 
+/* Size of the chunks project files are read and parsed in */
+#define READ_CHUNK_SIZE (64 * 1024)
+/* Size of the buffer project files are written through */
+#define WRITE_BUFFER_SIZE (64 * 1024)
+
 #define parent_class ges_base_xml_formatter_parent_class
 
 #define _GET_PRIV(o)\
   (((GESBaseXmlFormatter*) o)->priv)
 
 
-static gboolean _loading_done_cb (GESFormatter * self);
-
 typedef struct PendingEffects
 {
   gchar *track_id;
@@ -110,6 +113,14 @@ struct _GESBaseXmlFormatterPrivate
   GMarkupParseContext *parsecontext;
   gboolean check_only;
 
+  /* The stream the project is parsed from, decompressed if needed */
+  GInputStream *stream;
+  /* The file stream, used to report the loading progress */
+  GSeekable *file_stream;
+  goffset file_size;
+  /* Set until the whole stream has been parsed */
+  gboolean parsing;
+
   /* Asset.id -> PendingClip */
   GHashTable *assetid_pendingclips;
 
@@ -164,23 +175,32 @@ static guint signals[LAST_SIGNAL];
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GESBaseXmlFormatter,
     ges_base_xml_formatter, GES_TYPE_FORMATTER);
 
-static GMarkupParseContext *
-create_parser_context (GESBaseXmlFormatter * self, const gchar * uri,
-    GError ** error)
+static void _finish_parsing (GESBaseXmlFormatter * self, GError * error);
+
+static void
+_close_stream (GESBaseXmlFormatterPrivate * priv)
 {
-  gsize xmlsize;
-  GFile *file = NULL;
-  gchar *xmlcontent = NULL;
-  GMarkupParseContext *parsecontext = NULL;
-  GESBaseXmlFormatterClass *self_class =
-      GES_BASE_XML_FORMATTER_GET_CLASS (self);
+  if (priv->stream)
+    g_input_stream_close (priv->stream, NULL, NULL);
+  g_clear_object (&priv->stream);
+  g_clear_object (&priv->file_stream);
+}
 
+/* Opens the project file, transparently decompressing gzip files */
+static gboolean
+open_stream (GESBaseXmlFormatter * self, const gchar * uri, GError ** error)
+{
+  gsize size;
+  GFileInfo *info;
+  const guint8 *header;
+  GInputStream *buffered;
+  GFileInputStream *fstream;
   GError *err = NULL;
+  GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
+  GFile *file = g_file_new_for_uri (uri);
 
   GST_DEBUG_OBJECT (self, "loading xml from %s", uri);
 
-  file = g_file_new_for_uri (uri);
-
   /* TODO Handle GCancellable */
   if (!g_file_query_exists (file, NULL)) {
     err = g_error_new (GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_FAILED,
@@ -188,39 +208,213 @@ create_parser_context (GESBaseXmlFormatter * self, const gchar * uri,
     goto failed;
   }
 
-  if (!g_file_load_contents (file, NULL, &xmlcontent, &xmlsize, NULL, &err))
-    goto failed;
-
-  if (g_strcmp0 (xmlcontent, "") == 0)
+  fstream = g_file_read (file, NULL, &err);
+  if (!fstream)
     goto failed;
 
-  parsecontext = g_markup_parse_context_new (&self_class->content_parser,
-      G_MARKUP_TREAT_CDATA_AS_TEXT, self, NULL);
+  info = g_file_input_stream_query_info (fstream,
+      G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, NULL);
+  priv->file_size = info ? g_file_info_get_size (info) : 0;
+  g_clear_object (&info);
 
-  if (g_markup_parse_context_parse (parsecontext, xmlcontent, xmlsize,
-          &err) == FALSE)
-    goto failed;
+  priv->file_stream = G_SEEKABLE (fstream);
+  buffered = g_buffered_input_stream_new (G_INPUT_STREAM (fstream));
+  priv->stream = buffered;
 
-  if (!g_markup_parse_context_end_parse (parsecontext, &err))
+  if (g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (buffered), 2,
+          NULL, &err) < 0)
     goto failed;
 
-
-done:
-  g_free (xmlcontent);
+  header = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM
+      (buffered), &size);
+  if (size >= 2 && header[0] == 0x1f && header[1] == 0x8b) {
+    GZlibDecompressor *decompressor =
+        g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+
+    GST_INFO_OBJECT (self, "Decompressing %s", uri);
+    priv->stream = g_converter_input_stream_new (buffered,
+        G_CONVERTER (decompressor));
+    g_object_unref (decompressor);
+    g_object_unref (buffered);
+  }
   g_object_unref (file);
 
-  return parsecontext;
+  return TRUE;
 
 failed:
   GST_WARNING ("failed to load contents from \"%s\"", uri);
   g_propagate_error (error, err);
+  _close_stream (priv);
+  g_object_unref (file);
+
+  return FALSE;
+}
+
+/* Parses the next chunk of the stream, @eos is set once the whole stream
+ * has been parsed */
+static gboolean
+parse_bytes (GESBaseXmlFormatter * self, GBytes * bytes, gboolean * eos,
+    GError ** error)
+{
+  gsize size;
+  const gchar *data = g_bytes_get_data (bytes, &size);
+  GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
+
+  *eos = size == 0;
+  if (*eos)
+    return g_markup_parse_context_end_parse (priv->parsecontext, error);
+
+  return g_markup_parse_context_parse (priv->parsecontext, data, size, error);
+}
 
-  if (parsecontext) {
-    g_markup_parse_context_free (parsecontext);
-    parsecontext = NULL;
+static gboolean
+parse_next_chunk (GESBaseXmlFormatter * self, gboolean * eos, GError ** error)
+{
+  gboolean res;
+  GBytes *bytes = g_input_stream_read_bytes (_GET_PRIV (self)->stream,
+      READ_CHUNK_SIZE, NULL, error);
+
+  if (!bytes)
+    return FALSE;
+
+  res = parse_bytes (self, bytes, eos, error);
+  g_bytes_unref (bytes);
+
+  return res;
+}
+
+/* Opens @uri and parses its first chunk so that invalid files are reported
+ * right away */
+static gboolean
+start_parsing (GESBaseXmlFormatter * self, const gchar * uri, GError ** error)
+{
+  gboolean eos;
+  GError *err = NULL;
+  GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
+  GESBaseXmlFormatterClass *self_class =
+      GES_BASE_XML_FORMATTER_GET_CLASS (self);
+
+  if (!open_stream (self, uri, error))
+    return FALSE;
+
+  priv->parsecontext = g_markup_parse_context_new (&self_class->content_parser,
+      G_MARKUP_TREAT_CDATA_AS_TEXT, self, NULL);
+
+  if (!parse_next_chunk (self, &eos, &err) || eos) {
+    /* Empty files are not an error, we just can not load them */
+    GST_WARNING ("failed to load contents from \"%s\"", uri);
+    g_propagate_error (error, err);
+    g_clear_pointer (&priv->parsecontext, g_markup_parse_context_free);
+    _close_stream (priv);
+
+    return FALSE;
   }
 
-  goto done;
+  return TRUE;
+}
+
+static void
+_chunk_read_cb (GInputStream * stream, GAsyncResult * res,
+    GESBaseXmlFormatter * self)
+{
+  gboolean eos = FALSE;
+  GError *err = NULL;
+  GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
+  GBytes *bytes = g_input_stream_read_bytes_finish (stream, res, &err);
+
+  if (bytes) {
+    parse_bytes (self, bytes, &eos, &err);
+    g_bytes_unref (bytes);
+  }
+
+  if (err || eos) {
+    _finish_parsing (self, err);
+    g_clear_error (&err);
+  } else {
+    if (priv->file_size > 0)
+      ges_project_set_loading_progress (GES_FORMATTER (self)->project,
+          (gdouble) g_seekable_tell (priv->file_stream) / priv->file_size);
+
+    /* Lets what was parsed get materialized before the next chunk, as
+     * assets getting loaded meanwhile */
+    g_input_stream_read_bytes_async (priv->stream, READ_CHUNK_SIZE,
+        G_PRIORITY_DEFAULT_IDLE, NULL, (GAsyncReadyCallback) _chunk_read_cb,
+        gst_object_ref (self));
+  }
+
+  gst_object_unref (self);
+}
+
+static gboolean
+_parsed_cb (GESBaseXmlFormatter * self)
+{
+  _finish_parsing (self, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Opens the file at @uri for writing, compressing what is written to it
+ * with gzip if its name ends with ".gz" */
+static GOutputStream *
+create_output_stream (const gchar * uri, gboolean overwrite,
+    GCancellable * cancellable, GError ** error)
+{
+  GOutputStream *stream, *buffered;
+  GError *err = NULL;
+  GFile *file = g_file_new_for_uri (uri);
+
+  stream = G_OUTPUT_STREAM (g_file_create (file, G_FILE_CREATE_NONE,
+          cancellable, &err));
+  if (!stream && overwrite && g_error_matches (err, G_IO_ERROR,
+          G_IO_ERROR_EXISTS)) {
+    g_clear_error (&err);
+    stream = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
+            G_FILE_CREATE_NONE, cancellable, &err));
+  }
+  g_object_unref (file);
+
+  if (!stream) {
+    GST_WARNING ("Could not open %s because: %s", uri, err->message);
+    g_propagate_error (error, err);
+
+    return NULL;
+  }
+
+  if (g_str_has_suffix (uri, ".gz")) {
+    GOutputStream *fstream = stream;
+    GZlibCompressor *compressor =
+        g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+
+    GST_INFO ("Compressing %s", uri);
+    stream = g_converter_output_stream_new (fstream, G_CONVERTER (compressor));
+    g_object_unref (compressor);
+    g_object_unref (fstream);
+  }
+
+  /* Closing it closes the underlying streams */
+  buffered = g_buffered_output_stream_new_sized (stream, WRITE_BUFFER_SIZE);
+  g_object_unref (stream);
+
+  return buffered;
+}
+
+/* Closes @stream, dropping what was written to it if @written is %FALSE so
+ * that a file being replaced is not replaced by a truncated one */
+static gboolean
+close_output_stream (GOutputStream * stream, gboolean written,
+    GCancellable * cancellable, GError ** error)
+{
+  GCancellable *cancelled;
+
+  if (written)
+    return g_output_stream_close (stream, cancellable, error);
+
+  cancelled = g_cancellable_new ();
+  g_cancellable_cancel (cancelled);
+  g_output_stream_close (stream, cancelled, NULL);
+  g_object_unref (cancelled);
+
+  return FALSE;
 }
 
 /***********************************************
@@ -236,16 +430,23 @@ _can_load_uri (GESFormatter * dummy_formatter, const gchar * uri,
   GMarkupParseContext *ctx;
   GESBaseXmlFormatter *self = GES_BASE_XML_FORMATTER (dummy_formatter);
 
-  /* we create a temporary object so we can use it as a context */
-  _GET_PRIV (self)->check_only = TRUE;
+  gboolean eos = FALSE, res;
+  GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
 
+  /* we create a temporary object so we can use it as a context */
+  priv->check_only = TRUE;
 
-  ctx = create_parser_context (self, uri, error);
-  if (!ctx)
+  if (!start_parsing (self, uri, error))
     return FALSE;
 
-  g_markup_parse_context_free (ctx);
-  return TRUE;
+  do {
+    res = parse_next_chunk (self, &eos, error);
+  } while (res && !eos);
+
+  g_clear_pointer (&priv->parsecontext, g_markup_parse_context_free);
+  _close_stream (priv);
+
+  return res;
 }
 
 static gboolean
@@ -256,15 +457,39 @@ _load_from_uri (GESFormatter * self, GESTimeline * timeline, const gchar * uri,
 
   ges_timeline_set_auto_transition (timeline, FALSE);
 
-  priv->parsecontext =
-      create_parser_context (GES_BASE_XML_FORMATTER (self), uri, error);
-
-  if (!priv->parsecontext)
+  if (!start_parsing (GES_BASE_XML_FORMATTER (self), uri, error))
     return FALSE;
 
-  if (g_hash_table_size (priv->assetid_pendingclips) == 0 &&
-      priv->pending_assets == NULL)
-    g_idle_add ((GSourceFunc) _loading_done_cb, g_object_ref (self));
+  priv->parsing = TRUE;
+  if (priv->file_size > 0 && priv->file_size <= READ_CHUNK_SIZE) {
+    gboolean eos = FALSE, res;
+
+    /* Small files are parsed at once so that truncated or malformed ones
+     * keep failing here */
+    do {
+      res = parse_next_chunk (GES_BASE_XML_FORMATTER (self), &eos, error);
+    } while (res && !eos);
+    _close_stream (priv);
+
+    if (!res) {
+      GST_WARNING_OBJECT (self, "failed to load contents from \"%s\"", uri);
+      priv->parsing = FALSE;
+      g_clear_pointer (&priv->parsecontext, g_markup_parse_context_free);
+
+      return FALSE;
+    }
+
+    g_idle_add_full (G_PRIORITY_DEFAULT, (GSourceFunc) _parsed_cb,
+        gst_object_ref (self), gst_object_unref);
+
+    return TRUE;
+  }
+
+  /* The rest of the file is parsed from the main loop, clips get added as
+   * soon as they are parsed and their assets loaded */
+  g_input_stream_read_bytes_async (priv->stream, READ_CHUNK_SIZE,
+      G_PRIORITY_DEFAULT_IDLE, NULL, (GAsyncReadyCallback) _chunk_read_cb,
+      gst_object_ref (self));
 
   return TRUE;
 }
@@ -273,69 +498,47 @@ static gboolean
 _save_to_uri (GESFormatter * formatter, GESTimeline * timeline,
     const gchar * uri, gboolean overwrite, GError ** error)
 {
-  GFile *file;
+  GBytes *bytes;
   gboolean ret;
-  GString *str;
   GOutputStream *stream;
   GError *lerror = NULL;
+  GESBaseXmlFormatterClass *klass = GES_BASE_XML_FORMATTER_GET_CLASS
+      (formatter);
 
   g_return_val_if_fail (formatter->project, FALSE);
 
-  file = g_file_new_for_uri (uri);
-  stream = G_OUTPUT_STREAM (g_file_create (file, G_FILE_CREATE_NONE, NULL,
-          &lerror));
-  if (stream == NULL) {
-    if (overwrite && lerror->code == G_IO_ERROR_EXISTS) {
-      g_clear_error (&lerror);
-      stream = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
-              G_FILE_CREATE_NONE, NULL, &lerror));
-    }
-
-    if (stream == NULL)
-      goto failed_opening_file;
-  }
-
-  str = GES_BASE_XML_FORMATTER_GET_CLASS (formatter)->save (formatter,
-      timeline, error);
-
-  if (str == NULL)
-    goto serialization_failed;
+  if (!klass->save_to_stream) {
+    bytes = ges_base_xml_formatter_save_to_bytes (GES_BASE_XML_FORMATTER
+        (formatter), timeline, error);
 
-  ret = g_output_stream_write_all (stream, str->str, str->len, NULL,
-      NULL, &lerror);
-  ret = g_output_stream_close (stream, NULL, &lerror);
+    if (!bytes)
+      return FALSE;
 
-  if (ret == FALSE)
-    GST_WARNING_OBJECT (formatter, "Could not save %s because: %s", uri,
-        lerror->message);
+    ret = ges_base_xml_formatter_write_bytes (bytes, uri, overwrite, NULL,
+        error);
+    g_bytes_unref (bytes);
 
-  g_string_free (str, TRUE);
-  gst_object_unref (file);
-  gst_object_unref (stream);
-
-  if (lerror)
-    g_propagate_error (error, lerror);
-
-  return ret;
+    return ret;
+  }
 
-serialization_failed:
-  gst_object_unref (file);
+  stream = create_output_stream (uri, overwrite, NULL, &lerror);
+  if (!stream)
+    goto failed;
 
-  g_output_stream_close (stream, NULL, NULL);
-  gst_object_unref (stream);
-  if (lerror)
-    g_propagate_error (error, lerror);
+  ret = klass->save_to_stream (formatter, timeline, stream, &lerror);
+  if (!close_output_stream (stream, ret, NULL, lerror ? NULL : &lerror))
+    ret = FALSE;
+  g_object_unref (stream);
 
-  return FALSE;
-
-failed_opening_file:
-  gst_object_unref (file);
+  if (!ret)
+    goto failed;
 
-  GST_WARNING_OBJECT (formatter, "Could not open %s because: %s", uri,
-      lerror->message);
+  return TRUE;
 
-  if (lerror)
-    g_propagate_error (error, lerror);
+failed:
+  GST_WARNING_OBJECT (formatter, "Could not save %s because: %s", uri,
+      lerror ? lerror->message : "Unknown error");
+  g_propagate_error (error, lerror);
 
   return FALSE;
 }
@@ -367,6 +570,7 @@ _finalize (GObject * object)
 
   if (priv->parsecontext != NULL)
     g_markup_parse_context_free (priv->parsecontext);
+  _close_stream (priv);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -458,6 +662,12 @@ _add_all_groups (GESFormatter * self)
     for (lchild = ((PendingGroup *) tmp->data)->pending_children; lchild;
         lchild = lchild->next) {
       child = g_hash_table_lookup (priv->containers, lchild->data);
+      if (!child) {
+        /* Its asset could not be loaded */
+        GST_WARNING_OBJECT (tmp->data, "Child %s not found",
+            (const gchar *) lchild->data);
+        continue;
+      }
 
       GST_DEBUG_OBJECT (tmp->data, "Adding %s child %" GST_PTR_FORMAT " %s",
           (const gchar *) lchild->data, child,
@@ -494,17 +704,28 @@ _loading_done (GESFormatter * self)
   ges_project_set_loaded (self->project, self);
 }
 
-static gboolean
-_loading_done_cb (GESFormatter * self)
+static void
+_finish_parsing (GESBaseXmlFormatter * self, GError * error)
 {
-  _loading_done (self);
-  gst_object_unref (self);
+  GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
+  GESProject *project = GES_FORMATTER (self)->project;
 
-  return FALSE;
+  priv->parsing = FALSE;
+  _close_stream (priv);
+
+  /* What could be parsed is kept */
+  if (error)
+    ges_project_set_loading_error (project, GES_FORMATTER (self)->timeline,
+        error);
+  ges_project_set_loading_progress (project, 1.0);
+
+  if (g_hash_table_size (priv->assetid_pendingclips) == 0 &&
+      priv->pending_assets == NULL)
+    _loading_done (GES_FORMATTER (self));
 }
 
-static gboolean
-_set_child_property (GQuark field_id, const GValue * value,
+gboolean
+set_child_property_foreach (GQuark field_id, const GValue * value,
     GESTimelineElement * tlelement)
 {
   GParamSpec *pspec;
@@ -531,7 +752,16 @@ _set_child_property (GQuark field_id, const GValue * value,
 gboolean
 set_property_foreach (GQuark field_id, const GValue * value, GObject * object)
 {
-  g_object_set_property (object, g_quark_to_string (field_id), value);
+  GParamSpec *pspec = _lookup_settable_property (object, field_id);
+
+  if (!pspec) {
+    GST_WARNING ("%s has no %s property that can be set",
+        G_OBJECT_TYPE_NAME (object), g_quark_to_string (field_id));
+
+    return TRUE;
+  }
+
+  g_object_set_property (object, pspec->name, value);
   return TRUE;
 }
 
@@ -562,7 +792,7 @@ _add_object_to_layer (GESBaseXmlFormatterPrivate * priv, const gchar * id,
 
   if (children_properties)
     gst_structure_foreach (children_properties,
-        (GstStructureForeachFunc) _set_child_property, clip);
+        (GstStructureForeachFunc) set_child_property_foreach, clip);
 
   g_hash_table_insert (priv->containers, g_strdup (id), gst_object_ref (clip));
   return clip;
@@ -588,7 +818,7 @@ _add_track_element (GESFormatter * self, GESClip * clip,
 
   ges_container_add (GES_CONTAINER (clip), GES_TIMELINE_ELEMENT (trackelement));
   gst_structure_foreach (children_properties,
-      (GstStructureForeachFunc) _set_child_property, trackelement);
+      (GstStructureForeachFunc) set_child_property_foreach, trackelement);
 
   if (properties) {
     /* We do not serialize the priority anymore, and we should never have. */
@@ -668,7 +898,7 @@ _add_children_properties (GESBaseXmlFormatterPrivate * priv, GList * childprops,
         _get_element_by_track_id (priv, pchildprops->track_id, clip);
     if (element && pchildprops->structure)
       gst_structure_foreach (pchildprops->structure,
-          (GstStructureForeachFunc) _set_child_property, element);
+          (GstStructureForeachFunc) set_child_property_foreach, element);
   }
 }
 
@@ -802,7 +1032,7 @@ done:
   }
 
   if (g_hash_table_size (priv->assetid_pendingclips) == 0 &&
-      priv->pending_assets == NULL)
+      priv->pending_assets == NULL && !priv->parsing)
     _loading_done (self);
 }
 
@@ -923,7 +1153,8 @@ _create_profile (GESBaseXmlFormatter * self,
 void
 ges_base_xml_formatter_add_asset (GESBaseXmlFormatter * self,
     const gchar * id, GType extractable_type, GstStructure * properties,
-    const gchar * metadatas, const gchar * proxy_id, GError ** error)
+    const gchar * metadatas, const gchar * proxy_id, GstDiscovererInfo * info,
+    GError ** error)
 {
   PendingAsset *passet;
   GESBaseXmlFormatterPrivate *priv = _GET_PRIV (self);
@@ -931,6 +1162,12 @@ ges_base_xml_formatter_add_asset (GESBaseXmlFormatter * self,
   if (priv->check_only)
     return;
 
+  /* Lets the clips be created without waiting for the media to be
+   * discovered */
+  if (info && extractable_type == GES_TYPE_URI_CLIP
+      && !g_strcmp0 (gst_discoverer_info_get_uri (info), id))
+    ges_uri_clip_asset_set_provisional_info (info);
+
   passet = g_slice_new0 (PendingAsset);
   passet->metadatas = g_strdup (metadatas);
   passet->proxy_id = g_strdup (proxy_id);
@@ -1234,7 +1471,7 @@ ges_base_xml_formatter_add_source (GESBaseXmlFormatter * self,
   }
 
   gst_structure_foreach (children_properties,
-      (GstStructureForeachFunc) _set_child_property, element);
+      (GstStructureForeachFunc) set_child_property_foreach, element);
 }
 
 void
@@ -1431,3 +1668,76 @@ ges_base_xml_formatter_last_group_add_child (GESBaseXmlFormatter * self,
   GST_DEBUG_OBJECT (self, "Adding %s to %s", child_id,
       GES_TIMELINE_ELEMENT_NAME (((PendingGroup *) priv->groups->data)->group));
 }
+
+/* Serializes @timeline in memory, so that it can be written from another
+ * thread */
+GBytes *
+ges_base_xml_formatter_save_to_bytes (GESBaseXmlFormatter * self,
+    GESTimeline * timeline, GError ** error)
+{
+  GString *str;
+  GOutputStream *stream;
+  GBytes *bytes = NULL;
+  GESBaseXmlFormatterClass *klass = GES_BASE_XML_FORMATTER_GET_CLASS (self);
+
+  if (!klass->save_to_stream) {
+    str = klass->save (GES_FORMATTER (self), timeline, error);
+
+    return str ? g_string_free_to_bytes (str) : NULL;
+  }
+
+  stream = g_memory_output_stream_new_resizable ();
+  if (klass->save_to_stream (GES_FORMATTER (self), timeline, stream, error)
+      && g_output_stream_close (stream, NULL, error))
+    bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM
+        (stream));
+  g_object_unref (stream);
+
+  return bytes;
+}
+
+/* Writes a serialized project to @uri, can be called from any thread */
+gboolean
+ges_base_xml_formatter_write_bytes (GBytes * bytes, const gchar * uri,
+    gboolean overwrite, GCancellable * cancellable, GError ** error)
+{
+  gsize size;
+  gboolean ret;
+  GError *err = NULL;
+  gconstpointer data = g_bytes_get_data (bytes, &size);
+  GOutputStream *stream = create_output_stream (uri, overwrite, cancellable,
+      error);
+
+  if (!stream)
+    return FALSE;
+
+  ret = g_output_stream_write_all (stream, data, size, NULL, cancellable,
+      &err);
+  if (!close_output_stream (stream, ret, cancellable, err ? NULL : &err))
+    ret = FALSE;
+  g_object_unref (stream);
+
+  if (!ret) {
+    GST_WARNING ("Could not save %s because: %s", uri, err->message);
+    g_propagate_error (error, err);
+  }
+
+  return ret;
+}
+
+/* For subclasses loading projects without the markup parser: everything
+ * added between those calls is part of the project being loaded */
+void
+ges_base_xml_formatter_begin_loading (GESBaseXmlFormatter * self,
+    GESTimeline * timeline)
+{
+  ges_timeline_set_auto_transition (timeline, FALSE);
+  _GET_PRIV (self)->parsing = TRUE;
+}
+
+void
+ges_base_xml_formatter_end_loading (GESBaseXmlFormatter * self,
+    GError * error)
+{
+  _finish_parsing (self, error);
+}
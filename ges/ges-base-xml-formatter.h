@@ -61,7 +61,24 @@ struct _GESBaseXmlFormatterClass
 
   GString * (*save) (GESFormatter *formatter, GESTimeline *timeline, GError **error);
 
-  gpointer _ges_reserved[GES_PADDING];
+  /**
+   * GESBaseXmlFormatterClass::save_to_stream:
+   * @formatter: The #GESFormatter
+   * @timeline: The #GESTimeline to save
+   * @stream: The #GOutputStream to write to
+   * @error: An error to be set in case something wrong happens or %NULL
+   *
+   * Writes @timeline to @stream as it gets serialized, used instead of
+   * #GESBaseXmlFormatterClass.save when implemented.
+   *
+   * Returns: %TRUE if @timeline could be written to @stream
+   *
+   * Since: 1.16
+   */
+  gboolean  (*save_to_stream) (GESFormatter *formatter, GESTimeline *timeline,
+                               GOutputStream *stream, GError **error);
+
+  gpointer _ges_reserved[GES_PADDING - 1];
 };
 
 GES_API
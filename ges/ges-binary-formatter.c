@@ -0,0 +1,1631 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION: gesbinaryformatter
+ * @title: GESBinaryFormatter
+ * @short_description: Saves and loads projects in a compact binary format
+ *
+ * The #GESBinaryFormatter saves the same projects as the #GESXmlFormatter,
+ * but in a format that is smaller and faster to load, mostly for timelines
+ * with many clips or keyframes. Its files use the "gesb" extension, and
+ * are loaded from a memory mapping of the file.
+ *
+ * Since: 1.16
+ */
+
+/* File layout, all the integers are little endian 32 bits words:
+ *
+ *  - A FileHeader, locating the tables
+ *  - The tables, each aligned on 8 bytes so that their records can be used
+ *    right from the mapped file. Most are arrays of fixed size records, the
+ *    others hold bytes:
+ *    - The string data, with all the distinct strings of the project, NUL
+ *      terminated and referenced by their index in the strings table
+ *    - The keyframe times, as LEB128 encoded deltas to the previous time
+ *    - The serialized stream infos of the assets
+ *
+ * Clips reference a range of the track elements table, which in turn
+ * reference a range of the bindings table. Properties and metadatas are
+ * stored as serialized GstStructures, as in xges files, so that both formats
+ * load the exact same projects. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#undef VERSION
+#endif
+
+#include <string.h>
+
+#include "ges.h"
+#include "ges-internal.h"
+
+#define parent_class ges_binary_formatter_parent_class
+
+#define MAGIC "GESB"
+/* Bump when the layout changes */
+#define FORMAT_VERSION 1
+
+/* Reference to a missing string */
+#define NO_STRING G_MAXUINT32
+
+#define PROFILE_ENABLED (1 << 0)
+#define PROFILE_VARIABLE_FRAMERATE (1 << 1)
+
+enum
+{
+  TABLE_STRINGS,
+  TABLE_STRING_DATA,
+  TABLE_PROFILES,
+  TABLE_ASSETS,
+  TABLE_TRACKS,
+  TABLE_LAYERS,
+  TABLE_CLIPS,
+  TABLE_ELEMENTS,
+  TABLE_BINDINGS,
+  TABLE_KEYFRAME_TIMES,
+  TABLE_KEYFRAME_VALUES,
+  TABLE_GROUPS,
+  TABLE_GROUP_CHILDREN,
+  TABLE_DATA,
+  N_TABLES
+};
+
+typedef struct
+{
+  guint32 offset;
+  guint32 n_items;
+} Table;
+
+typedef struct
+{
+  gchar magic[4];
+  guint32 version;
+  guint32 project_metadatas;
+  guint32 timeline_properties;
+  guint32 timeline_metadatas;
+  guint32 padding;
+  Table tables[N_TABLES];
+} FileHeader;
+
+/* Both the container profiles and the profiles they contain, the latter
+ * having a parent */
+typedef struct
+{
+  guint32 parent;
+  guint32 type;
+  guint32 name;
+  guint32 description;
+  guint32 format;
+  guint32 preset;
+  guint32 preset_properties;
+  guint32 preset_name;
+  guint32 restriction;
+  guint32 id;
+  guint32 presence;
+  guint32 pass;
+  guint32 flags;
+} ProfileRecord;
+
+typedef struct
+{
+  guint32 id;
+  guint32 type_name;
+  guint32 properties;
+  guint32 metadatas;
+  guint32 proxy_id;
+  /* In the data table */
+  guint32 stream_info_offset;
+  guint32 stream_info_size;
+} AssetRecord;
+
+typedef struct
+{
+  guint32 type;
+  guint32 caps;
+  guint32 properties;
+  guint32 metadatas;
+} TrackRecord;
+
+typedef struct
+{
+  guint32 priority;
+  guint32 properties;
+  guint32 metadatas;
+} LayerRecord;
+
+typedef struct
+{
+  guint32 id;
+  guint32 type_name;
+  guint32 asset_id;
+  guint32 layer_priority;
+  guint32 track_types;
+  guint32 start[2];
+  guint32 duration[2];
+  guint32 inpoint[2];
+  guint32 properties;
+  guint32 children_properties;
+  guint32 metadatas;
+  guint32 first_element;
+  guint32 n_elements;
+} ClipRecord;
+
+/* The effects, and the sources which have no type */
+typedef struct
+{
+  guint32 type_name;
+  guint32 asset_id;
+  /* Index of the track, -1 if none */
+  guint32 track_id;
+  guint32 properties;
+  guint32 children_properties;
+  guint32 metadatas;
+  guint32 first_binding;
+  guint32 n_bindings;
+} ElementRecord;
+
+typedef struct
+{
+  guint32 property;
+  guint32 type;
+  guint32 mode;
+  /* In the keyframe values table */
+  guint32 first_keyframe;
+  guint32 n_keyframes;
+  /* In the keyframe times table */
+  guint32 times_offset;
+} BindingRecord;
+
+typedef struct
+{
+  guint32 id;
+  guint32 properties;
+  guint32 metadatas;
+  guint32 first_child;
+  guint32 n_children;
+} GroupRecord;
+
+typedef struct
+{
+  guint32 id;
+  guint32 name;
+} GroupChildRecord;
+
+/* The bits of a gdouble */
+typedef struct
+{
+  guint32 value[2];
+} KeyframeValue;
+
+static const guint record_sizes[N_TABLES] = {
+  sizeof (guint32),
+  1,
+  sizeof (ProfileRecord),
+  sizeof (AssetRecord),
+  sizeof (TrackRecord),
+  sizeof (LayerRecord),
+  sizeof (ClipRecord),
+  sizeof (ElementRecord),
+  sizeof (BindingRecord),
+  1,
+  sizeof (KeyframeValue),
+  sizeof (GroupRecord),
+  sizeof (GroupChildRecord),
+  1,
+};
+
+G_DEFINE_TYPE (GESBinaryFormatter, ges_binary_formatter,
+    GES_TYPE_BASE_XML_FORMATTER);
+
+static inline guint64
+_get_u64 (const guint32 * words)
+{
+  return ((guint64) words[1] << 32) | words[0];
+}
+
+static inline void
+_set_u64 (guint32 * words, guint64 value)
+{
+  words[0] = value & G_MAXUINT32;
+  words[1] = value >> 32;
+}
+
+/* Converts words from and to little endian */
+static void
+_swap_words (gpointer data, gsize size)
+{
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+  gsize i;
+  guint32 *words = data;
+
+  for (i = 0; i < size / sizeof (guint32); i++)
+    words[i] = GUINT32_SWAP_LE_BE (words[i]);
+#endif
+}
+
+/***********************************************
+ *                                             *
+ *            Saving implementation            *
+ *                                             *
+ ***********************************************/
+
+typedef struct
+{
+  GArray *tables[N_TABLES];
+
+  /* String -> index in the strings table */
+  GHashTable *string_ids;
+
+  GList *tracks;
+
+  /* Clips and groups -> id */
+  GHashTable *element_ids;
+  guint32 next_id;
+} Writer;
+
+static guint32
+_add_string (Writer * writer, const gchar * str)
+{
+  guint32 offset;
+  gpointer id;
+  GArray *data = writer->tables[TABLE_STRING_DATA];
+
+  if (str == NULL)
+    return NO_STRING;
+
+  if (g_hash_table_lookup_extended (writer->string_ids, str, NULL, &id))
+    return GPOINTER_TO_UINT (id);
+
+  offset = data->len;
+  g_array_append_vals (data, str, strlen (str) + 1);
+  g_array_append_val (writer->tables[TABLE_STRINGS], offset);
+
+  id = GUINT_TO_POINTER (writer->tables[TABLE_STRINGS]->len - 1);
+  g_hash_table_insert (writer->string_ids, g_strdup (str), id);
+
+  return GPOINTER_TO_UINT (id);
+}
+
+static guint32
+_take_string (Writer * writer, gchar * str)
+{
+  guint32 id = _add_string (writer, str);
+
+  g_free (str);
+
+  return id;
+}
+
+/* The returned record is only valid until the next one is appended to
+ * @table */
+static gpointer
+_append_record (Writer * writer, guint table)
+{
+  GArray *array = writer->tables[table];
+
+  g_array_set_size (array, array->len + 1);
+
+  return array->data + (array->len - 1) * record_sizes[table];
+}
+
+static void
+_append_varint (GArray * array, guint64 value)
+{
+  do {
+    guint8 byte = value & 0x7f;
+
+    value >>= 7;
+    if (value)
+      byte |= 0x80;
+    g_array_append_val (array, byte);
+  } while (value);
+}
+
+static gchar *
+_get_preset_properties (GstEncodingProfile * prof, const gchar * preset)
+{
+  GstElement *element;
+  gchar *ret = NULL;
+
+  element = get_element_for_encoding_profile (prof,
+      GST_IS_ENCODING_CONTAINER_PROFILE (prof) ?
+      GST_ELEMENT_FACTORY_TYPE_MUXER : GST_ELEMENT_FACTORY_TYPE_ENCODER);
+  if (!element)
+    return NULL;
+
+  if (GST_IS_PRESET (element) &&
+      gst_preset_load_preset (GST_PRESET (element), preset))
+    ret = _serialize_properties (G_OBJECT (element), NULL);
+  gst_object_unref (element);
+
+  return ret;
+}
+
+static void
+_save_profile (Writer * writer, GstEncodingProfile * prof,
+    const gchar * parent, guint id)
+{
+  GstCaps *caps;
+  ProfileRecord *record;
+  gchar *format = NULL, *restriction = NULL, *preset_properties = NULL;
+  const gchar *preset = gst_encoding_profile_get_preset (prof);
+  guint32 flags = PROFILE_ENABLED;
+
+  caps = gst_encoding_profile_get_format (prof);
+  if (caps) {
+    format = gst_caps_to_string (caps);
+    gst_caps_unref (caps);
+  }
+
+  if (preset)
+    preset_properties = _get_preset_properties (prof, preset);
+
+  /* As in xges files, only the contained profiles have those set */
+  if (parent) {
+    caps = gst_encoding_profile_get_restriction (prof);
+    if (caps) {
+      restriction = gst_caps_to_string (caps);
+      gst_caps_unref (caps);
+    }
+
+    if (!gst_encoding_profile_is_enabled (prof))
+      flags &= ~PROFILE_ENABLED;
+    if (GST_IS_ENCODING_VIDEO_PROFILE (prof) &&
+        gst_encoding_video_profile_get_variableframerate
+        (GST_ENCODING_VIDEO_PROFILE (prof)))
+      flags |= PROFILE_VARIABLE_FRAMERATE;
+  }
+
+  record = _append_record (writer, TABLE_PROFILES);
+  record->parent = _add_string (writer, parent);
+  record->type = _add_string (writer,
+      gst_encoding_profile_get_type_nick (prof));
+  record->name = _add_string (writer, gst_encoding_profile_get_name (prof));
+  record->description = _add_string (writer,
+      gst_encoding_profile_get_description (prof));
+  record->format = _take_string (writer, format);
+  record->preset = _add_string (writer, preset);
+  record->preset_properties = _take_string (writer, preset_properties);
+  record->preset_name = _add_string (writer,
+      gst_encoding_profile_get_preset_name (prof));
+  record->restriction = _take_string (writer, restriction);
+  record->id = id;
+  record->presence = parent ? gst_encoding_profile_get_presence (prof) : 0;
+  record->pass = parent && GST_IS_ENCODING_VIDEO_PROFILE (prof) ?
+      gst_encoding_video_profile_get_pass (GST_ENCODING_VIDEO_PROFILE (prof)) :
+      0;
+  record->flags = flags;
+}
+
+static void
+_save_profiles (Writer * writer, GESProject * project)
+{
+  GList *tmp, *profiles = g_list_reverse (g_list_copy ((GList *)
+          ges_project_list_encoding_profiles (project)));
+
+  for (tmp = profiles; tmp; tmp = tmp->next) {
+    GstEncodingProfile *prof = tmp->data;
+
+    _save_profile (writer, prof, NULL, 0);
+    if (GST_IS_ENCODING_CONTAINER_PROFILE (prof)) {
+      guint i = 0;
+      const GList *sprofs;
+
+      for (sprofs = gst_encoding_container_profile_get_profiles
+          (GST_ENCODING_CONTAINER_PROFILE (prof)); sprofs;
+          sprofs = sprofs->next, i++)
+        _save_profile (writer, sprofs->data,
+            gst_encoding_profile_get_name (prof), i);
+    }
+  }
+  g_list_free (profiles);
+}
+
+static void
+_save_assets (Writer * writer, GESProject * project)
+{
+  GList *assets, *tmp;
+
+  assets = ges_project_list_assets (project, GES_TYPE_EXTRACTABLE);
+  for (tmp = assets; tmp; tmp = tmp->next) {
+    AssetRecord *record;
+    GstDiscovererInfo *info = NULL;
+    GESAsset *proxy, *asset = tmp->data;
+
+    record = _append_record (writer, TABLE_ASSETS);
+    record->id = _add_string (writer, ges_asset_get_id (asset));
+    record->type_name = _add_string (writer,
+        g_type_name (ges_asset_get_extractable_type (asset)));
+    record->properties = _take_string (writer,
+        _serialize_properties (G_OBJECT (asset), NULL));
+    record->metadatas = _take_string (writer,
+        ges_meta_container_metas_to_string (GES_META_CONTAINER (asset)));
+
+    proxy = ges_asset_get_proxy (asset);
+    record->proxy_id = proxy ? _add_string (writer,
+        ges_asset_get_id (proxy)) : NO_STRING;
+    if (proxy && !g_list_find (assets, proxy)) {
+      assets = g_list_append (assets, gst_object_ref (proxy));
+
+      if (!tmp->next)
+        tmp->next = g_list_last (assets);
+    }
+
+    if (GES_IS_URI_CLIP_ASSET (asset))
+      info = ges_uri_clip_asset_get_info (GES_URI_CLIP_ASSET (asset));
+
+    if (info) {
+      GArray *data = writer->tables[TABLE_DATA];
+      GVariant *variant = g_variant_ref_sink (g_variant_new_variant
+          (gst_discoverer_info_to_variant (info,
+                  GST_DISCOVERER_SERIALIZE_CAPS)));
+
+      /* Keep the serialized variants aligned */
+      g_array_set_size (data, GST_ROUND_UP_8 (data->len));
+      record->stream_info_offset = data->len;
+      record->stream_info_size = g_variant_get_size (variant);
+      g_array_append_vals (data, g_variant_get_data (variant),
+          g_variant_get_size (variant));
+      g_variant_unref (variant);
+    }
+  }
+  g_list_free_full (assets, gst_object_unref);
+}
+
+static void
+_save_bindings (Writer * writer, GESTrackElement * trackelement,
+    guint32 * first_binding, guint32 * n_bindings)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  *first_binding = writer->tables[TABLE_BINDINGS]->len;
+  *n_bindings = 0;
+
+  g_hash_table_iter_init (&iter,
+      ges_track_element_get_all_control_bindings (trackelement));
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    GList *timed_values, *tmp;
+    GstControlSource *source;
+    BindingRecord *record;
+    GstInterpolationMode mode;
+    gboolean absolute = FALSE;
+    GstClockTime last = 0;
+
+    if (!GST_IS_DIRECT_CONTROL_BINDING (value)) {
+      GST_DEBUG ("Binding type not in [direct, direct-absolute]");
+      continue;
+    }
+
+    g_object_get (value, "control-source", &source, "absolute", &absolute,
+        NULL);
+    if (!GST_IS_INTERPOLATION_CONTROL_SOURCE (source)) {
+      GST_DEBUG ("control source not in [interpolation]");
+      gst_object_unref (source);
+      continue;
+    }
+
+    g_object_get (source, "mode", &mode, NULL);
+    timed_values = gst_timed_value_control_source_get_all
+        (GST_TIMED_VALUE_CONTROL_SOURCE (source));
+
+    record = _append_record (writer, TABLE_BINDINGS);
+    record->property = _add_string (writer, key);
+    record->type = _add_string (writer,
+        absolute ? "direct-absolute" : "direct");
+    record->mode = mode;
+    record->first_keyframe = writer->tables[TABLE_KEYFRAME_VALUES]->len;
+    record->n_keyframes = g_list_length (timed_values);
+    record->times_offset = writer->tables[TABLE_KEYFRAME_TIMES]->len;
+
+    /* The values are sorted by time */
+    for (tmp = timed_values; tmp; tmp = tmp->next) {
+      GstTimedValue *timed_value = tmp->data;
+      KeyframeValue *keyframe;
+      union
+      {
+        gdouble d;
+        guint64 u;
+      } bits;
+
+      _append_varint (writer->tables[TABLE_KEYFRAME_TIMES],
+          timed_value->timestamp - last);
+      last = timed_value->timestamp;
+
+      bits.d = timed_value->value;
+      keyframe = _append_record (writer, TABLE_KEYFRAME_VALUES);
+      _set_u64 (keyframe->value, bits.u);
+    }
+
+    g_list_free (timed_values);
+    gst_object_unref (source);
+    (*n_bindings)++;
+  }
+}
+
+static void
+_save_effect (Writer * writer, GESTrackElement * trackelement)
+{
+  GESTrack *track;
+  ElementRecord *record;
+  gboolean serialize;
+  guint32 first_binding, n_bindings;
+
+  g_object_get (trackelement, "serialize", &serialize, NULL);
+  if (!serialize) {
+    GST_DEBUG_OBJECT (trackelement, "Should not be serialized");
+
+    return;
+  }
+
+  track = ges_track_element_get_track (trackelement);
+  if (track == NULL) {
+    GST_WARNING_OBJECT (trackelement, " Not in any track, can not save it");
+
+    return;
+  }
+
+  _save_bindings (writer, trackelement, &first_binding, &n_bindings);
+
+  record = _append_record (writer, TABLE_ELEMENTS);
+  record->type_name = _add_string (writer,
+      g_type_name (G_OBJECT_TYPE (trackelement)));
+  record->asset_id = _take_string (writer,
+      ges_extractable_get_id (GES_EXTRACTABLE (trackelement)));
+  record->track_id = g_list_index (writer->tracks, track);
+  record->properties = _take_string (writer,
+      _serialize_properties (G_OBJECT (trackelement), "start", "in-point",
+          "duration", "locked", "max-duration", "name", "priority", NULL));
+  record->children_properties = _take_string (writer,
+      _serialize_children_properties (GES_TIMELINE_ELEMENT (trackelement)));
+  record->metadatas = _take_string (writer,
+      ges_meta_container_metas_to_string (GES_META_CONTAINER
+          (trackelement)));
+  record->first_binding = first_binding;
+  record->n_bindings = n_bindings;
+}
+
+static void
+_save_source (Writer * writer, GESTrackElement * trackelement)
+{
+  ElementRecord *record;
+  gboolean serialize;
+  guint32 first_binding, n_bindings;
+
+  g_object_get (trackelement, "serialize", &serialize, NULL);
+  if (!serialize) {
+    GST_DEBUG_OBJECT (trackelement, "Should not be serialized");
+
+    return;
+  }
+
+  _save_bindings (writer, trackelement, &first_binding, &n_bindings);
+
+  record = _append_record (writer, TABLE_ELEMENTS);
+  record->type_name = NO_STRING;
+  record->asset_id = NO_STRING;
+  record->track_id = g_list_index (writer->tracks,
+      ges_track_element_get_track (trackelement));
+  record->properties = NO_STRING;
+  record->children_properties = _take_string (writer,
+      _serialize_children_properties (GES_TIMELINE_ELEMENT (trackelement)));
+  record->metadatas = NO_STRING;
+  record->first_binding = first_binding;
+  record->n_bindings = n_bindings;
+}
+
+static void
+_save_clip (Writer * writer, GESClip * clip, guint priority)
+{
+  GList *tmp, *effects;
+  ClipRecord *record;
+  guint first_element;
+  gboolean serialize;
+
+  g_object_get (clip, "serialize", &serialize, NULL);
+  if (!serialize) {
+    GST_DEBUG_OBJECT (clip, "Should not be serialized");
+
+    return;
+  }
+
+  /* Same order as in xges files, effects first in their priority order */
+  first_element = writer->tables[TABLE_ELEMENTS]->len;
+  effects = ges_clip_get_top_effects (clip);
+  for (tmp = effects; tmp; tmp = tmp->next)
+    _save_effect (writer, tmp->data);
+  g_list_free_full (effects, gst_object_unref);
+
+  for (tmp = GES_CONTAINER_CHILDREN (clip); tmp; tmp = tmp->next) {
+    if (GES_IS_SOURCE (tmp->data))
+      _save_source (writer, tmp->data);
+  }
+
+  record = _append_record (writer, TABLE_CLIPS);
+  record->id = writer->next_id;
+  record->type_name = _add_string (writer, g_type_name (G_OBJECT_TYPE (clip)));
+  record->asset_id = _take_string (writer,
+      ges_extractable_get_id (GES_EXTRACTABLE (clip)));
+  record->layer_priority = priority;
+  record->track_types = ges_clip_get_supported_formats (clip);
+  _set_u64 (record->start, _START (clip));
+  _set_u64 (record->duration, _DURATION (clip));
+  _set_u64 (record->inpoint, _INPOINT (clip));
+  record->properties = _take_string (writer,
+      _serialize_properties (G_OBJECT (clip), "supported-formats", "rate",
+          "in-point", "start", "duration", "max-duration", "priority", "vtype",
+          "uri", NULL));
+  record->children_properties = GES_IS_TRANSITION_CLIP (clip) ?
+      _take_string (writer,
+      _serialize_children_properties (GES_TIMELINE_ELEMENT (clip))) :
+      NO_STRING;
+  record->metadatas = _take_string (writer,
+      ges_meta_container_metas_to_string (GES_META_CONTAINER (clip)));
+  record->first_element = first_element;
+  record->n_elements = writer->tables[TABLE_ELEMENTS]->len - first_element;
+
+  g_hash_table_insert (writer->element_ids, clip,
+      GUINT_TO_POINTER (writer->next_id++));
+}
+
+static void
+_save_layers (Writer * writer, GESTimeline * timeline)
+{
+  GList *tmp, *clips, *tmpclip;
+
+  for (tmp = timeline->layers; tmp; tmp = tmp->next) {
+    LayerRecord *record;
+    GESLayer *layer = tmp->data;
+    guint priority = ges_layer_get_priority (layer);
+
+    record = _append_record (writer, TABLE_LAYERS);
+    record->priority = priority;
+    record->properties = _take_string (writer,
+        _serialize_properties (G_OBJECT (layer), "priority", NULL));
+    record->metadatas = _take_string (writer,
+        ges_meta_container_metas_to_string (GES_META_CONTAINER (layer)));
+
+    clips = ges_layer_get_clips (layer);
+    for (tmpclip = clips; tmpclip; tmpclip = tmpclip->next)
+      _save_clip (writer, tmpclip->data, priority);
+    g_list_free_full (clips, gst_object_unref);
+  }
+}
+
+static void
+_save_group (Writer * writer, GESGroup * group, GList ** seen_groups)
+{
+  GList *tmp;
+  GroupRecord *record;
+  gboolean serialize;
+  guint32 first_child;
+
+  g_object_get (group, "serialize", &serialize, NULL);
+  if (!serialize) {
+    GST_DEBUG_OBJECT (group, "Should not be serialized");
+
+    return;
+  }
+
+  if (g_list_find (*seen_groups, group)) {
+    GST_DEBUG_OBJECT (group, "Already serialized");
+
+    return;
+  }
+
+  *seen_groups = g_list_prepend (*seen_groups, group);
+  for (tmp = GES_CONTAINER_CHILDREN (group); tmp; tmp = tmp->next) {
+    if (GES_IS_GROUP (tmp->data))
+      _save_group (writer, tmp->data, seen_groups);
+  }
+
+  first_child = writer->tables[TABLE_GROUP_CHILDREN]->len;
+  for (tmp = GES_CONTAINER_CHILDREN (group); tmp; tmp = tmp->next) {
+    GroupChildRecord *child = _append_record (writer, TABLE_GROUP_CHILDREN);
+
+    child->id = GPOINTER_TO_UINT (g_hash_table_lookup (writer->element_ids,
+            tmp->data));
+    child->name = _add_string (writer, GES_TIMELINE_ELEMENT_NAME (tmp->data));
+  }
+
+  record = _append_record (writer, TABLE_GROUPS);
+  record->id = writer->next_id;
+  record->properties = _take_string (writer,
+      _serialize_properties (G_OBJECT (group), NULL));
+  record->metadatas = _take_string (writer,
+      ges_meta_container_metas_to_string (GES_META_CONTAINER (group)));
+  record->first_child = first_child;
+  record->n_children = writer->tables[TABLE_GROUP_CHILDREN]->len - first_child;
+
+  g_hash_table_insert (writer->element_ids, group,
+      GUINT_TO_POINTER (writer->next_id++));
+}
+
+static void
+_save_timeline (Writer * writer, GESTimeline * timeline)
+{
+  GList *tmp, *seen_groups = NULL;
+
+  writer->tracks = ges_timeline_get_tracks (timeline);
+  for (tmp = writer->tracks; tmp; tmp = tmp->next) {
+    GESTrack *track = tmp->data;
+    TrackRecord *record = _append_record (writer, TABLE_TRACKS);
+
+    record->type = track->type;
+    record->caps = _take_string (writer,
+        gst_caps_to_string (ges_track_get_caps (track)));
+    record->properties = _take_string (writer,
+        _serialize_properties (G_OBJECT (track), NULL));
+    record->metadatas = _take_string (writer,
+        ges_meta_container_metas_to_string (GES_META_CONTAINER (track)));
+  }
+
+  _save_layers (writer, timeline);
+
+  for (tmp = ges_timeline_get_groups (timeline); tmp; tmp = tmp->next)
+    _save_group (writer, tmp->data, &seen_groups);
+  g_list_free (seen_groups);
+}
+
+static gboolean
+_write_tables (Writer * writer, FileHeader * header, GOutputStream * stream,
+    GError ** error)
+{
+  guint i;
+  gsize written = sizeof (FileHeader);
+  static const guint8 padding[8] = { 0, };
+
+  _swap_words ((guint8 *) header + sizeof (header->magic),
+      sizeof (FileHeader) - sizeof (header->magic));
+  if (!g_output_stream_write_all (stream, header, sizeof (FileHeader), NULL,
+          NULL, error))
+    return FALSE;
+
+  for (i = 0; i < N_TABLES; i++) {
+    GArray *array = writer->tables[i];
+    gsize size = array->len * record_sizes[i];
+
+    if (!g_output_stream_write_all (stream, padding,
+            GST_ROUND_UP_8 (written) - written, NULL, NULL, error))
+      return FALSE;
+    written = GST_ROUND_UP_8 (written);
+
+    if (record_sizes[i] > 1)
+      _swap_words (array->data, size);
+    if (!g_output_stream_write_all (stream, array->data, size, NULL, NULL,
+            error))
+      return FALSE;
+    written += size;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+_save_to_stream (GESFormatter * formatter, GESTimeline * timeline,
+    GOutputStream * stream, GError ** error)
+{
+  guint i;
+  gboolean ret;
+  Writer writer;
+  FileHeader header = { {0,}, };
+  guint64 offset = sizeof (FileHeader);
+  GESProject *project = formatter->project;
+
+  for (i = 0; i < N_TABLES; i++)
+    writer.tables[i] = g_array_new (FALSE, TRUE, record_sizes[i]);
+  writer.string_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      NULL);
+  writer.element_ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+  writer.next_id = 0;
+  writer.tracks = NULL;
+
+  memcpy (header.magic, MAGIC, sizeof (header.magic));
+  header.version = FORMAT_VERSION;
+  header.project_metadatas = _take_string (&writer,
+      ges_meta_container_metas_to_string (GES_META_CONTAINER (project)));
+
+  _save_profiles (&writer, project);
+  _save_assets (&writer, project);
+
+  header.timeline_properties = _take_string (&writer,
+      _serialize_properties (G_OBJECT (timeline), "update", "name",
+          "async-handling", "message-forward", NULL));
+  ges_meta_container_set_uint64 (GES_META_CONTAINER (timeline), "duration",
+      ges_timeline_get_duration (timeline));
+  header.timeline_metadatas = _take_string (&writer,
+      ges_meta_container_metas_to_string (GES_META_CONTAINER (timeline)));
+  _save_timeline (&writer, timeline);
+
+  for (i = 0; i < N_TABLES; i++) {
+    offset = GST_ROUND_UP_8 (offset);
+    header.tables[i].offset = offset;
+    header.tables[i].n_items = writer.tables[i]->len;
+    offset += (guint64) writer.tables[i]->len * record_sizes[i];
+  }
+
+  if (offset > G_MAXUINT32) {
+    g_set_error (error, GES_ERROR, GES_ERROR_FORMATTER_MALFORMED_INPUT_FILE,
+        "Project too big to be saved in the binary format");
+    ret = FALSE;
+  } else {
+    ret = _write_tables (&writer, &header, stream, error);
+  }
+
+  for (i = 0; i < N_TABLES; i++)
+    g_array_free (writer.tables[i], TRUE);
+  g_hash_table_unref (writer.string_ids);
+  g_hash_table_unref (writer.element_ids);
+  g_list_free_full (writer.tracks, gst_object_unref);
+
+  return ret;
+}
+
+/***********************************************
+ *                                             *
+ *           Loading implementation            *
+ *                                             *
+ ***********************************************/
+
+typedef struct
+{
+  GESBaseXmlFormatter *formatter;
+  GBytes *bytes;
+  const guint8 *data;
+  const FileHeader *header;
+
+  /* Set when a reference to another record or string is wrong */
+  gboolean invalid;
+  /* IDs of the assets of unknown types, skipped with what uses them */
+  GHashTable *skipped_assets;
+} Reader;
+
+static GBytes *
+_decompress (GBytes * bytes, GError ** error)
+{
+  GBytes *ret = NULL;
+  GInputStream *stream, *converter;
+  GOutputStream *output = g_memory_output_stream_new_resizable ();
+  GZlibDecompressor *decompressor =
+      g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+
+  stream = g_memory_input_stream_new_from_bytes (bytes);
+  converter = g_converter_input_stream_new (stream,
+      G_CONVERTER (decompressor));
+  if (g_output_stream_splice (output, converter,
+          G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE |
+          G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET, NULL, error) >= 0)
+    ret = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM
+        (output));
+
+  g_object_unref (converter);
+  g_object_unref (stream);
+  g_object_unref (decompressor);
+  g_object_unref (output);
+
+  return ret;
+}
+
+/* Maps the file when possible */
+static GBytes *
+_read_file (const gchar * uri, GError ** error)
+{
+  gsize size;
+  const guint8 *data;
+  GBytes *bytes = NULL;
+  GFile *file = g_file_new_for_uri (uri);
+  gchar *path = g_file_get_path (file);
+
+  if (path) {
+    GMappedFile *mapped = g_mapped_file_new (path, FALSE, error);
+
+    if (mapped) {
+      bytes = g_mapped_file_get_bytes (mapped);
+      g_mapped_file_unref (mapped);
+    }
+  } else {
+    gchar *contents;
+    gsize length;
+
+    if (g_file_load_contents (file, NULL, &contents, &length, NULL, error))
+      bytes = g_bytes_new_take (contents, length);
+  }
+  g_free (path);
+  g_object_unref (file);
+
+  if (!bytes)
+    return NULL;
+
+  data = g_bytes_get_data (bytes, &size);
+  if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+    GBytes *decompressed = _decompress (bytes, error);
+
+    g_bytes_unref (bytes);
+    bytes = decompressed;
+  }
+
+  return bytes;
+}
+
+static gboolean
+_open_file (Reader * reader, const gchar * uri, GError ** error)
+{
+  guint i;
+  gsize size;
+  const FileHeader *header;
+
+  reader->invalid = FALSE;
+  reader->bytes = _read_file (uri, error);
+  if (!reader->bytes)
+    return FALSE;
+
+  reader->data = g_bytes_get_data (reader->bytes, &size);
+  header = (const FileHeader *) reader->data;
+  if (size < sizeof (FileHeader) ||
+      memcmp (header->magic, MAGIC, sizeof (header->magic)))
+    goto invalid;
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+  {
+    guint8 *data = g_bytes_unref_to_data (reader->bytes, &size);
+
+    _swap_words (data + sizeof (header->magic),
+        sizeof (FileHeader) - sizeof (header->magic));
+    reader->bytes = g_bytes_new_take (data, size);
+    reader->data = data;
+    header = (const FileHeader *) data;
+  }
+#endif
+
+  if (header->version != FORMAT_VERSION) {
+    g_set_error (error, GES_ERROR, GES_ERROR_FORMATTER_MALFORMED_INPUT_FILE,
+        "Unsupported binary project version %u", header->version);
+    goto failed;
+  }
+
+  for (i = 0; i < N_TABLES; i++) {
+    const Table *table = &header->tables[i];
+
+    if (table->offset % 8 || (guint64) table->offset +
+        (guint64) table->n_items * record_sizes[i] > size)
+      goto invalid;
+
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    if (record_sizes[i] > 1)
+      _swap_words ((guint8 *) reader->data + table->offset,
+          table->n_items * record_sizes[i]);
+#endif
+  }
+
+  /* So that all the strings are terminated */
+  if (header->tables[TABLE_STRING_DATA].n_items &&
+      reader->data[header->tables[TABLE_STRING_DATA].offset +
+          header->tables[TABLE_STRING_DATA].n_items - 1])
+    goto invalid;
+
+  reader->header = header;
+
+  return TRUE;
+
+invalid:
+  g_set_error (error, GES_ERROR, GES_ERROR_FORMATTER_MALFORMED_INPUT_FILE,
+      "%s is not a valid binary project", uri);
+
+failed:
+  g_clear_pointer (&reader->bytes, g_bytes_unref);
+
+  return FALSE;
+}
+
+static gconstpointer
+_get_records (Reader * reader, guint table, guint32 first, guint32 n_items)
+{
+  const Table *t = &reader->header->tables[table];
+
+  if ((guint64) first + n_items > t->n_items) {
+    reader->invalid = TRUE;
+
+    return NULL;
+  }
+
+  return reader->data + t->offset + (gsize) first * record_sizes[table];
+}
+
+static const gchar *
+_get_string (Reader * reader, guint32 id)
+{
+  const guint32 *offset;
+
+  if (id == NO_STRING)
+    return NULL;
+
+  offset = _get_records (reader, TABLE_STRINGS, id, 1);
+  if (!offset
+      || *offset >= reader->header->tables[TABLE_STRING_DATA].n_items) {
+    reader->invalid = TRUE;
+
+    return NULL;
+  }
+
+  return (const gchar *) reader->data +
+      reader->header->tables[TABLE_STRING_DATA].offset + *offset;
+}
+
+static GstStructure *
+_get_structure (Reader * reader, guint32 id)
+{
+  GstStructure *structure;
+  const gchar *str = _get_string (reader, id);
+
+  if (!str)
+    return NULL;
+
+  structure = gst_structure_from_string (str, NULL);
+  if (!structure)
+    reader->invalid = TRUE;
+
+  return structure;
+}
+
+static GstCaps *
+_get_caps (Reader * reader, guint32 id)
+{
+  GstCaps *caps;
+  const gchar *str = _get_string (reader, id);
+
+  if (!str)
+    return NULL;
+
+  caps = gst_caps_from_string (str);
+  if (!caps)
+    reader->invalid = TRUE;
+
+  return caps;
+}
+
+static GType
+_get_type (Reader * reader, guint32 id, GType parent)
+{
+  const gchar *name = _get_string (reader, id);
+  GType type = name ? g_type_from_name (name) : G_TYPE_NONE;
+
+  if (!g_type_is_a (type, parent)) {
+    GST_WARNING ("%s is not a %s", GST_STR_NULL (name), g_type_name (parent));
+    reader->invalid = TRUE;
+
+    return G_TYPE_NONE;
+  }
+
+  return type;
+}
+
+static void
+_load_profiles (Reader * reader, GError ** error)
+{
+  guint32 i;
+  const ProfileRecord *records = _get_records (reader, TABLE_PROFILES, 0,
+      reader->header->tables[TABLE_PROFILES].n_items);
+
+  for (i = 0; i < reader->header->tables[TABLE_PROFILES].n_items; i++) {
+    const ProfileRecord *record = &records[i];
+    GstStructure *preset_properties =
+        _get_structure (reader, record->preset_properties);
+
+    ges_base_xml_formatter_add_encoding_profile (reader->formatter,
+        _get_string (reader, record->type),
+        _get_string (reader, record->parent),
+        _get_string (reader, record->name),
+        _get_string (reader, record->description),
+        _get_caps (reader, record->format),
+        _get_string (reader, record->preset), preset_properties,
+        _get_string (reader, record->preset_name), record->id,
+        record->presence, _get_caps (reader, record->restriction),
+        record->pass, record->flags & PROFILE_VARIABLE_FRAMERATE, NULL,
+        record->flags & PROFILE_ENABLED, error);
+
+    if (preset_properties)
+      gst_structure_free (preset_properties);
+    if (reader->invalid || *error)
+      return;
+  }
+}
+
+static GstDiscovererInfo *
+_get_stream_info (Reader * reader, const AssetRecord * record)
+{
+  GBytes *bytes;
+  GVariant *variant;
+  GstDiscovererInfo *info = NULL;
+  const Table *data = &reader->header->tables[TABLE_DATA];
+
+  if (!record->stream_info_size)
+    return NULL;
+
+  if ((guint64) record->stream_info_offset + record->stream_info_size >
+      data->n_items) {
+    reader->invalid = TRUE;
+
+    return NULL;
+  }
+
+  bytes = g_bytes_new_from_bytes (reader->bytes,
+      data->offset + record->stream_info_offset, record->stream_info_size);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes
+      (G_VARIANT_TYPE_VARIANT, bytes, FALSE));
+  g_bytes_unref (bytes);
+
+  /* Only an optimization, the media will be discovered otherwise */
+  if (g_variant_is_normal_form (variant)) {
+    GVariant *vinfo = g_variant_get_variant (variant);
+
+    info = gst_discoverer_info_from_variant (vinfo);
+    g_variant_unref (vinfo);
+  }
+  g_variant_unref (variant);
+
+  if (!info)
+    GST_WARNING ("Invalid stream info for %s",
+        _get_string (reader, record->id));
+
+  return info;
+}
+
+/* Assets of types that are not registered, usually because the plugin
+ * providing them is missing, do not make the whole project fail loading */
+static void
+_skip_asset (Reader * reader, const gchar * id, const gchar * type_name)
+{
+  GError *error = g_error_new (GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+      "Unknown type %s for asset %s", type_name, id);
+
+  GST_WARNING ("%s, skipping it", error->message);
+  g_hash_table_add (reader->skipped_assets, g_strdup (id));
+  ges_project_set_asset_loading_error (GES_FORMATTER (reader->formatter)->
+      project, id, G_TYPE_NONE, error);
+  g_error_free (error);
+}
+
+static gboolean
+_is_skipped (Reader * reader, guint32 asset_id)
+{
+  const gchar *id = _get_string (reader, asset_id);
+
+  return id && g_hash_table_contains (reader->skipped_assets, id);
+}
+
+static void
+_load_assets (Reader * reader, GError ** error)
+{
+  guint32 i;
+  const AssetRecord *records = _get_records (reader, TABLE_ASSETS, 0,
+      reader->header->tables[TABLE_ASSETS].n_items);
+
+  for (i = 0; i < reader->header->tables[TABLE_ASSETS].n_items; i++) {
+    GType type;
+    GstStructure *properties;
+    GstDiscovererInfo *info;
+    const gchar *id = _get_string (reader, records[i].id);
+    const gchar *type_name = _get_string (reader, records[i].type_name);
+
+    if (id && type_name && !g_type_from_name (type_name)) {
+      _skip_asset (reader, id, type_name);
+      continue;
+    }
+
+    type = _get_type (reader, records[i].type_name, GES_TYPE_EXTRACTABLE);
+
+    if (!id || reader->invalid) {
+      reader->invalid = TRUE;
+      return;
+    }
+
+    properties = _get_structure (reader, records[i].properties);
+    info = _get_stream_info (reader, &records[i]);
+    ges_base_xml_formatter_add_asset (reader->formatter, id, type,
+        properties, _get_string (reader, records[i].metadatas),
+        _get_string (reader, records[i].proxy_id), info, error);
+
+    if (properties)
+      gst_structure_free (properties);
+    if (info)
+      gst_discoverer_info_unref (info);
+    if (reader->invalid || *error)
+      return;
+  }
+}
+
+static void
+_load_tracks (Reader * reader, GError ** error)
+{
+  guint32 i;
+  const TrackRecord *records = _get_records (reader, TABLE_TRACKS, 0,
+      reader->header->tables[TABLE_TRACKS].n_items);
+
+  for (i = 0; i < reader->header->tables[TABLE_TRACKS].n_items; i++) {
+    gchar *id;
+    GstStructure *properties;
+    GstCaps *caps = _get_caps (reader, records[i].caps);
+
+    if (!caps) {
+      reader->invalid = TRUE;
+      return;
+    }
+
+    id = g_strdup_printf ("%u", i);
+    properties = _get_structure (reader, records[i].properties);
+    ges_base_xml_formatter_add_track (reader->formatter, records[i].type,
+        caps, id, properties, _get_string (reader, records[i].metadatas),
+        error);
+
+    if (properties)
+      gst_structure_free (properties);
+    gst_caps_unref (caps);
+    g_free (id);
+    if (reader->invalid || *error)
+      return;
+  }
+}
+
+static void
+_load_layers (Reader * reader, GError ** error)
+{
+  guint32 i;
+  const LayerRecord *records = _get_records (reader, TABLE_LAYERS, 0,
+      reader->header->tables[TABLE_LAYERS].n_items);
+
+  for (i = 0; i < reader->header->tables[TABLE_LAYERS].n_items; i++) {
+    GstStructure *properties = _get_structure (reader, records[i].properties);
+
+    ges_base_xml_formatter_add_layer (reader->formatter, G_TYPE_NONE,
+        records[i].priority, properties,
+        _get_string (reader, records[i].metadatas), error);
+
+    if (properties)
+      gst_structure_free (properties);
+    if (reader->invalid || *error)
+      return;
+  }
+}
+
+static void
+_free_timed_value (GstTimedValue * value)
+{
+  g_slice_free (GstTimedValue, value);
+}
+
+static void
+_load_bindings (Reader * reader, const ElementRecord * element,
+    const gchar * track_id)
+{
+  guint32 i, j;
+  const BindingRecord *records = _get_records (reader, TABLE_BINDINGS,
+      element->first_binding, element->n_bindings);
+  const Table *times = &reader->header->tables[TABLE_KEYFRAME_TIMES];
+
+  for (i = 0; records && i < element->n_bindings; i++) {
+    const BindingRecord *record = &records[i];
+    const KeyframeValue *values = _get_records (reader,
+        TABLE_KEYFRAME_VALUES, record->first_keyframe, record->n_keyframes);
+    const guint8 *cursor = reader->data + times->offset + record->times_offset;
+    const guint8 *end = reader->data + times->offset + times->n_items;
+    GstClockTime timestamp = 0;
+    GSList *timed_values = NULL;
+
+    if (!values || record->times_offset > times->n_items) {
+      reader->invalid = TRUE;
+      return;
+    }
+
+    for (j = 0; j < record->n_keyframes; j++) {
+      guint64 delta = 0;
+      guint shift = 0;
+      GstTimedValue *value;
+      union
+      {
+        gdouble d;
+        guint64 u;
+      } bits;
+
+      /* LEB128 */
+      do {
+        if (cursor == end || shift > 63) {
+          reader->invalid = TRUE;
+          g_slist_free_full (timed_values, (GDestroyNotify) _free_timed_value);
+          return;
+        }
+        delta |= (guint64) (*cursor & 0x7f) << shift;
+        shift += 7;
+      } while (*cursor++ & 0x80);
+
+      timestamp += delta;
+      bits.u = _get_u64 (values[j].value);
+
+      value = g_slice_new (GstTimedValue);
+      value->timestamp = timestamp;
+      value->value = bits.d;
+      timed_values = g_slist_prepend (timed_values, value);
+    }
+
+    timed_values = g_slist_reverse (timed_values);
+    ges_base_xml_formatter_add_control_binding (reader->formatter,
+        _get_string (reader, record->type), "interpolation",
+        _get_string (reader, record->property), record->mode, track_id,
+        timed_values);
+    g_slist_free_full (timed_values, (GDestroyNotify) _free_timed_value);
+  }
+}
+
+static void
+_load_elements (Reader * reader, const ClipRecord * clip,
+    const gchar * clip_id, GError ** error)
+{
+  guint32 i;
+  const ElementRecord *records = _get_records (reader, TABLE_ELEMENTS,
+      clip->first_element, clip->n_elements);
+
+  for (i = 0; records && i < clip->n_elements; i++) {
+    GstStructure *children_properties;
+    gchar *track_id;
+    const ElementRecord *record = &records[i];
+
+    if (record->type_name != NO_STRING && _is_skipped (reader,
+            record->asset_id))
+      continue;
+
+    children_properties = _get_structure (reader, record->children_properties);
+    track_id = g_strdup_printf ("%d", (gint32) record->track_id);
+    if (!children_properties) {
+      reader->invalid = TRUE;
+    } else if (record->type_name != NO_STRING) {
+      GType type = _get_type (reader, record->type_name,
+          GES_TYPE_BASE_EFFECT);
+      GstStructure *properties = _get_structure (reader, record->properties);
+
+      if (!reader->invalid) {
+        ges_base_xml_formatter_add_track_element (reader->formatter, type,
+            _get_string (reader, record->asset_id), track_id, clip_id,
+            children_properties, properties,
+            _get_string (reader, record->metadatas), error);
+        _load_bindings (reader, record, "-1");
+      }
+
+      if (properties)
+        gst_structure_free (properties);
+    } else {
+      ges_base_xml_formatter_add_source (reader->formatter, track_id,
+          children_properties);
+      _load_bindings (reader, record, track_id);
+    }
+
+    if (children_properties)
+      gst_structure_free (children_properties);
+    g_free (track_id);
+    if (reader->invalid || *error)
+      return;
+  }
+}
+
+static void
+_load_clips (Reader * reader, GError ** error)
+{
+  guint32 i;
+  const ClipRecord *records = _get_records (reader, TABLE_CLIPS, 0,
+      reader->header->tables[TABLE_CLIPS].n_items);
+
+  for (i = 0; i < reader->header->tables[TABLE_CLIPS].n_items; i++) {
+    gchar *id;
+    GType type;
+    const gchar *asset_id;
+    GstStructure *properties, *children_properties;
+    const ClipRecord *record = &records[i];
+
+    if (_is_skipped (reader, record->asset_id)) {
+      GST_INFO ("Skipping clip %u as its asset could not be loaded",
+          record->id);
+      continue;
+    }
+
+    type = _get_type (reader, record->type_name, GES_TYPE_CLIP);
+    asset_id = _get_string (reader, record->asset_id);
+    properties = _get_structure (reader, record->properties);
+    children_properties = _get_structure (reader, record->children_properties);
+
+    id = g_strdup_printf ("%u", record->id);
+    if (!reader->invalid) {
+      ges_base_xml_formatter_add_clip (reader->formatter, id, asset_id, type,
+          _get_u64 (record->start), _get_u64 (record->inpoint),
+          _get_u64 (record->duration), record->layer_priority,
+          record->track_types, properties, children_properties,
+          _get_string (reader, record->metadatas), error);
+      if (!*error)
+        _load_elements (reader, record, id, error);
+    }
+
+    if (properties)
+      gst_structure_free (properties);
+    if (children_properties)
+      gst_structure_free (children_properties);
+    g_free (id);
+    if (reader->invalid || *error)
+      return;
+  }
+}
+
+static void
+_load_groups (Reader * reader)
+{
+  guint32 i, j;
+  const GroupRecord *records = _get_records (reader, TABLE_GROUPS, 0,
+      reader->header->tables[TABLE_GROUPS].n_items);
+
+  for (i = 0; i < reader->header->tables[TABLE_GROUPS].n_items; i++) {
+    gchar *id = g_strdup_printf ("%u", records[i].id);
+    const GroupChildRecord *children = _get_records (reader,
+        TABLE_GROUP_CHILDREN, records[i].first_child, records[i].n_children);
+
+    ges_base_xml_formatter_add_group (reader->formatter, id,
+        _get_string (reader, records[i].properties),
+        _get_string (reader, records[i].metadatas));
+    g_free (id);
+
+    for (j = 0; children && j < records[i].n_children; j++) {
+      id = g_strdup_printf ("%u", children[j].id);
+      ges_base_xml_formatter_last_group_add_child (reader->formatter, id,
+          _get_string (reader, children[j].name));
+      g_free (id);
+    }
+
+    if (reader->invalid)
+      return;
+  }
+}
+
+/* Loads everything in the order of xges files, stopping at the first
+ * error */
+static void
+_load (Reader * reader, GESFormatter * formatter, GESTimeline * timeline,
+    GError ** error)
+{
+  const gchar *metadatas;
+  const FileHeader *header = reader->header;
+
+  metadatas = _get_string (reader, header->project_metadatas);
+  if (formatter->project && metadatas)
+    ges_meta_container_add_metas_from_string (GES_META_CONTAINER
+        (formatter->project), metadatas);
+
+  _load_profiles (reader, error);
+  if (!reader->invalid && !*error)
+    _load_assets (reader, error);
+  if (!reader->invalid && !*error)
+    ges_base_xml_formatter_set_timeline_properties (reader->formatter,
+        timeline, _get_string (reader, header->timeline_properties),
+        _get_string (reader, header->timeline_metadatas));
+  if (!reader->invalid && !*error)
+    _load_tracks (reader, error);
+  if (!reader->invalid && !*error)
+    _load_layers (reader, error);
+  if (!reader->invalid && !*error)
+    _load_clips (reader, error);
+  if (!reader->invalid && !*error)
+    _load_groups (reader);
+
+  if (reader->invalid && !*error)
+    g_set_error (error, GES_ERROR, GES_ERROR_FORMATTER_MALFORMED_INPUT_FILE,
+        "Invalid reference in binary project");
+}
+
+typedef struct
+{
+  GESBaseXmlFormatter *formatter;
+  GError *error;
+} LoadedData;
+
+static gboolean
+_loaded_cb (LoadedData * data)
+{
+  ges_base_xml_formatter_end_loading (data->formatter, data->error);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+_free_loaded_data (LoadedData * data)
+{
+  g_clear_error (&data->error);
+  gst_object_unref (data->formatter);
+  g_slice_free (LoadedData, data);
+}
+
+/***********************************************
+ *                                             *
+ * GESFormatter virtual methods implementation *
+ *                                             *
+ ***********************************************/
+
+static gboolean
+_can_load_uri (GESFormatter * dummy_formatter, const gchar * uri,
+    GError ** error)
+{
+  Reader reader;
+
+  if (!_open_file (&reader, uri, error))
+    return FALSE;
+
+  g_bytes_unref (reader.bytes);
+
+  return TRUE;
+}
+
+static gboolean
+_load_from_uri (GESFormatter * formatter, GESTimeline * timeline,
+    const gchar * uri, GError ** error)
+{
+  Reader reader;
+  LoadedData *data;
+
+  if (!_open_file (&reader, uri, error))
+    return FALSE;
+
+  reader.formatter = GES_BASE_XML_FORMATTER (formatter);
+  reader.skipped_assets = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, NULL);
+  data = g_slice_new0 (LoadedData);
+  data->formatter = gst_object_ref (formatter);
+
+  ges_base_xml_formatter_begin_loading (reader.formatter, timeline);
+  _load (&reader, formatter, timeline, &data->error);
+  g_hash_table_unref (reader.skipped_assets);
+  g_bytes_unref (reader.bytes);
+
+  /* What could be loaded is kept, as for xges files. The project is only
+   * loaded once this returned, and its assets are ready */
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, (GSourceFunc) _loaded_cb, data,
+      (GDestroyNotify) _free_loaded_data);
+
+  return TRUE;
+}
+
+/***********************************************
+ *                                             *
+ *   GObject virtual methods implementation    *
+ *                                             *
+ ***********************************************/
+
+static void
+ges_binary_formatter_init (GESBinaryFormatter * self)
+{
+}
+
+static void
+ges_binary_formatter_class_init (GESBinaryFormatterClass * klass)
+{
+  GESFormatterClass *formatter_class = GES_FORMATTER_CLASS (klass);
+  GESBaseXmlFormatterClass *basexmlformatter_class =
+      GES_BASE_XML_FORMATTER_CLASS (klass);
+
+  formatter_class->can_load_uri = _can_load_uri;
+  formatter_class->load_from_uri = _load_from_uri;
+
+  basexmlformatter_class->save_to_stream = _save_to_stream;
+
+  ges_formatter_class_register_metas (formatter_class, "gesb",
+      "GStreamer Editing Services binary project files", "gesb",
+      "application/x-ges-binary", FORMAT_VERSION, GST_RANK_SECONDARY);
+}
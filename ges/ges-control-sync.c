@@ -0,0 +1,334 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Keyframe aware replacement for gst_object_sync_values () used on every
+ * buffer by the elements positioning frames.
+ *
+ * When all the bound values are constant around the current time, as when
+ * the surrounding keyframes have the same value, the time of the next
+ * keyframe is remembered and nothing is evaluated until it is reached.
+ * Values actually changing over time are evaluated in blocks of upcoming
+ * buffers with gst_control_binding_get_g_value_array (). Any change to the
+ * control sources, or to the bindings themselves, invalidates what was
+ * computed ahead. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/controller/gstinterpolationcontrolsource.h>
+
+#include "ges-internal.h"
+
+/* Number of buffers evaluated at once for values changing over time */
+#define BLOCK_SIZE 16
+
+typedef struct
+{
+  GParamSpec *pspec;
+
+  /* The binding the values below were computed for, a reference is held on
+   * it so a new binding can not have the same address */
+  GstControlBinding *binding;
+  gboolean disabled;
+  GstControlSource *source;
+  GSList *handler_ids;
+
+  /* Values at block_start + i * block_interval */
+  GValue values[BLOCK_SIZE];
+  guint n_values;
+  GstClockTime block_start;
+  GstClockTime block_interval;
+} BoundProperty;
+
+struct _GESControlSync
+{
+  GstObject *object;
+
+  BoundProperty *properties;
+  guint n_properties;
+
+  /* No bound value changes in [valid_from, valid_until) */
+  GstClockTime valid_from;
+  GstClockTime valid_until;
+
+  /* Set when a control source changed */
+  gint dirty;
+};
+
+static void
+clear_block (BoundProperty * prop)
+{
+  guint i;
+
+  for (i = 0; i < prop->n_values; i++)
+    g_value_unset (&prop->values[i]);
+  prop->n_values = 0;
+}
+
+static void
+source_changed_cb (GstControlSource * source, gpointer unused,
+    GESControlSync * sync)
+{
+  g_atomic_int_set (&sync->dirty, TRUE);
+}
+
+static void
+set_binding (GESControlSync * sync, BoundProperty * prop,
+    GstControlBinding * binding)
+{
+  clear_block (prop);
+
+  if (prop->source) {
+    GSList *tmp;
+
+    for (tmp = prop->handler_ids; tmp; tmp = tmp->next)
+      g_signal_handler_disconnect (prop->source, GPOINTER_TO_SIZE (tmp->data));
+    g_slist_free (prop->handler_ids);
+    prop->handler_ids = NULL;
+  }
+  gst_clear_object (&prop->source);
+  gst_clear_object (&prop->binding);
+
+  if (!binding)
+    return;
+
+  prop->binding = binding;
+  g_object_get (binding, "control-source", &prop->source, NULL);
+  if (GST_IS_TIMED_VALUE_CONTROL_SOURCE (prop->source)) {
+    const gchar *signals[] = { "value-added", "value-changed",
+      "value-removed", "notify::mode", NULL
+    };
+    guint i;
+
+    for (i = 0; signals[i]; i++)
+      prop->handler_ids = g_slist_prepend (prop->handler_ids,
+          GSIZE_TO_POINTER (g_signal_connect (prop->source, signals[i],
+                  G_CALLBACK (source_changed_cb), sync)));
+  }
+}
+
+/* Returns %TRUE if the value of @prop does not change from @timestamp
+ * until @until */
+static gboolean
+get_constant_range (BoundProperty * prop, GstClockTime timestamp,
+    GstClockTime * until)
+{
+  GSequenceIter *iter, *next;
+  GstTimedValueControlSource *source;
+  GstInterpolationMode mode;
+  gboolean ret = TRUE;
+
+  if (!GST_IS_INTERPOLATION_CONTROL_SOURCE (prop->source))
+    return FALSE;
+
+  source = GST_TIMED_VALUE_CONTROL_SOURCE (prop->source);
+  g_object_get (source, "mode", &mode, NULL);
+
+  GST_TIMED_VALUE_CONTROL_SOURCE_LOCK (source);
+  *until = GST_CLOCK_TIME_NONE;
+  if (!source->values)
+    goto done;
+
+  iter = gst_timed_value_control_source_find_control_point_iter (source,
+      timestamp);
+  if (!iter) {
+    /* Before the first keyframe */
+    next = g_sequence_get_begin_iter (source->values);
+    if (!g_sequence_iter_is_end (next))
+      *until = ((GstControlPoint *) g_sequence_get (next))->timestamp;
+
+    goto done;
+  }
+
+  next = g_sequence_iter_next (iter);
+  if (g_sequence_iter_is_end (next))
+    goto done;
+
+  *until = ((GstControlPoint *) g_sequence_get (next))->timestamp;
+  if (mode != GST_INTERPOLATION_MODE_NONE &&
+      (mode != GST_INTERPOLATION_MODE_LINEAR ||
+          ((GstControlPoint *) g_sequence_get (iter))->value !=
+          ((GstControlPoint *) g_sequence_get (next))->value))
+    ret = FALSE;
+
+done:
+  GST_TIMED_VALUE_CONTROL_SOURCE_UNLOCK (source);
+
+  return ret;
+}
+
+/* Values of the block are reused for timestamps within half an interval of
+ * theirs, as buffer timestamps are rounded with fractional framerates */
+static void
+sync_from_block (GESControlSync * sync, BoundProperty * prop,
+    GstClockTime timestamp, GstClockTime duration)
+{
+  guint index = 0;
+
+  if (prop->n_values && timestamp >= prop->block_start) {
+    GstClockTime offset = timestamp - prop->block_start;
+
+    if (prop->block_interval)
+      index = (offset + prop->block_interval / 2) / prop->block_interval;
+    else if (offset)
+      index = prop->n_values;
+  }
+
+  if (!prop->n_values || timestamp < prop->block_start
+      || index >= prop->n_values) {
+    guint n_values = GST_CLOCK_TIME_IS_VALID (duration) && duration ?
+        BLOCK_SIZE : 1;
+
+    clear_block (prop);
+    if (!gst_control_binding_get_g_value_array (prop->binding, timestamp,
+            duration, n_values, prop->values)) {
+      GST_DEBUG_OBJECT (sync->object, "Could not get values for %s",
+          prop->pspec->name);
+
+      return;
+    }
+
+    prop->n_values = n_values;
+    prop->block_start = timestamp;
+    prop->block_interval = n_values > 1 ? duration : 0;
+    index = 0;
+  }
+
+  g_object_set_property (G_OBJECT (sync->object), prop->pspec->name,
+      &prop->values[index]);
+}
+
+/**
+ * ges_control_sync_new:
+ * @object: The #GstObject whose controllable properties are synced
+ *
+ * Returns: (transfer full): A new #GESControlSync for @object, which should
+ * not outlive it
+ */
+GESControlSync *
+ges_control_sync_new (GstObject * object)
+{
+  guint i, n_pspecs;
+  GParamSpec **pspecs;
+  GESControlSync *sync = g_slice_new0 (GESControlSync);
+
+  sync->object = object;
+  sync->valid_until = sync->valid_from = GST_CLOCK_TIME_NONE;
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (object),
+      &n_pspecs);
+  sync->properties = g_new0 (BoundProperty, n_pspecs);
+  for (i = 0; i < n_pspecs; i++) {
+    if (pspecs[i]->flags & GST_PARAM_CONTROLLABLE)
+      sync->properties[sync->n_properties++].pspec = pspecs[i];
+  }
+  g_free (pspecs);
+
+  return sync;
+}
+
+void
+ges_control_sync_free (GESControlSync * sync)
+{
+  guint i;
+
+  for (i = 0; i < sync->n_properties; i++)
+    set_binding (sync, &sync->properties[i], NULL);
+  g_free (sync->properties);
+  g_slice_free (GESControlSync, sync);
+}
+
+/**
+ * ges_control_sync_values:
+ * @sync: A #GESControlSync
+ * @timestamp: The time to sync the values at
+ * @duration: The expected interval to the next sync, used to evaluate
+ * values ahead, or %GST_CLOCK_TIME_NONE
+ *
+ * Sets the controlled properties of the object to their values at
+ * @timestamp, as gst_object_sync_values () would.
+ */
+void
+ges_control_sync_values (GESControlSync * sync, GstClockTime timestamp,
+    GstClockTime duration)
+{
+  guint i;
+  gboolean changed = FALSE;
+
+  if (!gst_object_has_active_control_bindings (sync->object))
+    return;
+
+  /* Bindings can be replaced, disabled or enabled at any time */
+  for (i = 0; i < sync->n_properties; i++) {
+    gboolean disabled;
+    BoundProperty *prop = &sync->properties[i];
+    GstControlBinding *binding =
+        gst_object_get_control_binding (sync->object, prop->pspec->name);
+
+    if (binding != prop->binding) {
+      set_binding (sync, prop, binding);
+      changed = TRUE;
+    } else if (binding) {
+      gst_object_unref (binding);
+    }
+
+    disabled = binding && gst_control_binding_is_disabled (binding);
+    if (disabled != prop->disabled) {
+      prop->disabled = disabled;
+      changed = TRUE;
+    }
+  }
+
+  if (g_atomic_int_compare_and_exchange (&sync->dirty, TRUE, FALSE)) {
+    for (i = 0; i < sync->n_properties; i++)
+      clear_block (&sync->properties[i]);
+    changed = TRUE;
+  }
+
+  if (!changed && GST_CLOCK_TIME_IS_VALID (sync->valid_from)
+      && timestamp >= sync->valid_from && timestamp < sync->valid_until)
+    return;
+
+  sync->valid_from = timestamp;
+  sync->valid_until = GST_CLOCK_TIME_NONE;
+  for (i = 0; i < sync->n_properties; i++) {
+    GstClockTime until;
+    BoundProperty *prop = &sync->properties[i];
+
+    if (!prop->binding || prop->disabled)
+      continue;
+
+    if (get_constant_range (prop, timestamp, &until)) {
+      GValue value = G_VALUE_INIT;
+
+      clear_block (prop);
+      if (gst_control_binding_get_g_value_array (prop->binding, timestamp, 0,
+              1, &value)) {
+        g_object_set_property (G_OBJECT (sync->object), prop->pspec->name,
+            &value);
+        g_value_unset (&value);
+      }
+      sync->valid_until = MIN (sync->valid_until, until);
+    } else {
+      sync_from_block (sync, prop, timestamp, duration);
+      /* Evaluate again on the next buffer */
+      sync->valid_until = timestamp + 1;
+    }
+  }
+}
@@ -0,0 +1,370 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Persistent cache of media discovery results.
+ *
+ * The GstDiscovererInfo of successfully discovered media files is
+ * serialized with gst_discoverer_info_to_variant () to one file per URI in
+ * the user cache directory, along with the modification time and the size
+ * the media file had. Requesting the asset of an unchanged file again, even
+ * from another process, then deserializes that info instead of running a
+ * discovery pipeline.
+ *
+ * The cache directory can be set with the GES_DISCOVERY_CACHE_DIR
+ * environment variable, the cache is disabled if it is empty.
+ *
+ * Entries are touched when they are used, and the least recently used ones
+ * are removed when storing a new entry makes the cache bigger than its
+ * budget. The budget can be set in megabytes with the
+ * GES_DISCOVERY_CACHE_SIZE environment variable.
+ *
+ * Entries are written from a worker thread, which keeps track of the size
+ * of the cache so that the cache directory only needs to be listed when
+ * going over the budget. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gst/pbutils/pbutils.h>
+
+#include "ges-internal.h"
+
+/* Bump when the format of the entries changes */
+#define CACHE_VERSION 1
+/* version, uri, modification time in microseconds, size, info */
+#define CACHE_ENTRY_FORMAT "(usttv)"
+#define DEFAULT_DISCOVERY_CACHE_SIZE (32 * 1024 * 1024)
+
+static GQuark from_cache_quark;
+static guint64 cache_budget = DEFAULT_DISCOVERY_CACHE_SIZE;
+
+/* Writes the entries one at a time */
+G_LOCK_DEFINE_STATIC (store_pool);
+static GThreadPool *store_pool = NULL;
+/* Estimated size of the cache, only used from the store_pool thread.
+ * G_MAXUINT64 until the cache directory has been listed */
+static guint64 cache_size = G_MAXUINT64;
+
+static const gchar *
+get_cache_dir (void)
+{
+  static gsize initialized = 0;
+  static gchar *cache_dir = NULL;
+
+  if (g_once_init_enter (&initialized)) {
+    const gchar *dir = g_getenv ("GES_DISCOVERY_CACHE_DIR");
+    const gchar *size_str = g_getenv ("GES_DISCOVERY_CACHE_SIZE");
+
+    if (size_str) {
+      guint64 size = g_ascii_strtoull (size_str, NULL, 10);
+
+      if (size <= G_MAXUINT64 / (1024 * 1024))
+        cache_budget = size * 1024 * 1024;
+    }
+
+    if (!dir)
+      cache_dir = g_build_filename (g_get_user_cache_dir (), "gstreamer-1.0",
+          "ges-discovery", NULL);
+    else if (*dir)
+      cache_dir = g_strdup (dir);
+
+    from_cache_quark = g_quark_from_static_string ("ges-discovery-cache");
+    GST_INFO ("Caching discovery results in: %s", GST_STR_NULL (cache_dir));
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return cache_dir;
+}
+
+/* Gets what identifies the version of the file at @uri, only works for
+ * files whose modification time can be known */
+static gboolean
+get_file_stamp (const gchar * uri, guint64 * mtime, guint64 * size)
+{
+  GFileInfo *finfo;
+  GFile *file = g_file_new_for_uri (uri);
+  gboolean res = FALSE;
+
+  finfo = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+      G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," G_FILE_ATTRIBUTE_STANDARD_SIZE,
+      G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  g_object_unref (file);
+
+  if (!finfo)
+    return FALSE;
+
+  if (g_file_info_has_attribute (finfo, G_FILE_ATTRIBUTE_TIME_MODIFIED)) {
+    *mtime = g_file_info_get_attribute_uint64 (finfo,
+        G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+        g_file_info_get_attribute_uint32 (finfo,
+        G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+    *size = g_file_info_get_size (finfo);
+    res = TRUE;
+  }
+  g_object_unref (finfo);
+
+  return res;
+}
+
+typedef struct
+{
+  GFile *file;
+  guint64 mtime;
+  guint64 size;
+} CacheFile;
+
+static gint
+compare_mtime (const CacheFile * a, const CacheFile * b)
+{
+  return a->mtime < b->mtime ? -1 : a->mtime > b->mtime;
+}
+
+/* Removes the least recently used entries until the cache fits in its
+ * budget, returns the size of the remaining entries */
+static guint64
+prune_cache (const gchar * cache_dir)
+{
+  guint i;
+  GFileInfo *finfo;
+  GArray *files;
+  guint64 total = 0;
+  GFile *dir = g_file_new_for_path (cache_dir);
+  GFileEnumerator *enumerator = g_file_enumerate_children (dir,
+      G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+      G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+
+  g_object_unref (dir);
+  if (!enumerator)
+    return 0;
+
+  files = g_array_new (FALSE, FALSE, sizeof (CacheFile));
+  while ((finfo = g_file_enumerator_next_file (enumerator, NULL, NULL))) {
+    CacheFile file;
+
+    /* Skip the temporary files of entries being written */
+    if (g_file_info_get_file_type (finfo) == G_FILE_TYPE_REGULAR
+        && !strchr (g_file_info_get_name (finfo), '.')) {
+      file.file = g_file_enumerator_get_child (enumerator, finfo);
+      file.size = g_file_info_get_size (finfo);
+      file.mtime = g_file_info_get_attribute_uint64 (finfo,
+          G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+          g_file_info_get_attribute_uint32 (finfo,
+          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+      total += file.size;
+      g_array_append_val (files, file);
+    }
+    g_object_unref (finfo);
+  }
+  g_object_unref (enumerator);
+
+  if (total > cache_budget)
+    g_array_sort (files, (GCompareFunc) compare_mtime);
+
+  for (i = 0; i < files->len; i++) {
+    CacheFile *file = &g_array_index (files, CacheFile, i);
+
+    if (total > cache_budget && g_file_delete (file->file, NULL, NULL)) {
+      GST_DEBUG ("Evicted %" G_GUINT64_FORMAT " bytes entry", file->size);
+      total -= file->size;
+    }
+    g_object_unref (file->file);
+  }
+  g_array_free (files, TRUE);
+
+  return total;
+}
+
+static gchar *
+get_entry_path (const gchar * cache_dir, const gchar * uri)
+{
+  gchar *path, *checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+      uri, -1);
+
+  path = g_build_filename (cache_dir, checksum, NULL);
+  g_free (checksum);
+
+  return path;
+}
+
+/**
+ * ges_discovery_cache_lookup:
+ * @uri: The URI of a media file
+ *
+ * Returns: (transfer full) (nullable): The info previously discovered for
+ * @uri if the file did not change since then
+ */
+GstDiscovererInfo *
+ges_discovery_cache_lookup (const gchar * uri)
+{
+  gsize length;
+  guint version;
+  const gchar *cached_uri;
+  guint64 mtime, size, cached_mtime, cached_size;
+  gchar *path, *contents;
+  GVariant *entry, *vinfo;
+  GstDiscovererInfo *info = NULL;
+  const gchar *cache_dir = get_cache_dir ();
+
+  if (!cache_dir || !get_file_stamp (uri, &mtime, &size))
+    return NULL;
+
+  path = get_entry_path (cache_dir, uri);
+  if (!g_file_get_contents (path, &contents, &length, NULL)) {
+    g_free (path);
+
+    return NULL;
+  }
+
+  entry = g_variant_new_from_data (G_VARIANT_TYPE (CACHE_ENTRY_FORMAT),
+      contents, length, FALSE, g_free, contents);
+  g_variant_ref_sink (entry);
+
+  /* The entry could have been truncated or corrupted, only complete and
+   * well formed infos are given to the discoverer */
+  if (g_variant_is_normal_form (entry)) {
+    g_variant_get (entry, "(u&stt@v)", &version, &cached_uri, &cached_mtime,
+        &cached_size, &vinfo);
+
+    if (version == CACHE_VERSION && !g_strcmp0 (cached_uri, uri)
+        && cached_mtime == mtime && cached_size == size
+        && g_variant_is_of_type (vinfo, G_VARIANT_TYPE_VARIANT)
+        && g_variant_is_normal_form (vinfo)) {
+      info = gst_discoverer_info_from_variant (vinfo);
+      if (info)
+        g_object_set_qdata (G_OBJECT (info), from_cache_quark,
+            GINT_TO_POINTER (TRUE));
+    }
+    g_variant_unref (vinfo);
+  }
+
+  if (info) {
+    /* Most recently used */
+    g_utime (path, NULL);
+  } else {
+    GST_DEBUG ("Removing outdated entry for %s", uri);
+    g_unlink (path);
+  }
+
+  g_variant_unref (entry);
+  g_free (path);
+
+  return info;
+}
+
+typedef struct
+{
+  gchar *uri;
+  gchar *path;
+  GVariant *entry;
+} StoreJob;
+
+static void
+store_entry (StoreJob * job, const gchar * cache_dir)
+{
+  GStatBuf stat_buf;
+  GError *err = NULL;
+  guint64 replaced_size = 0, size = g_variant_get_size (job->entry);
+
+  if (g_mkdir_with_parents (cache_dir, 0700)) {
+    GST_WARNING ("Could not create %s: %s", cache_dir, g_strerror (errno));
+    goto done;
+  }
+
+  if (!g_stat (job->path, &stat_buf))
+    replaced_size = stat_buf.st_size;
+
+  if (!g_file_set_contents (job->path, g_variant_get_data (job->entry), size,
+          &err)) {
+    GST_WARNING ("Could not cache discovery info for %s: %s", job->uri,
+        err->message);
+    g_clear_error (&err);
+    goto done;
+  }
+
+  if (cache_size != G_MAXUINT64)
+    cache_size = cache_size + size > replaced_size ?
+        cache_size + size - replaced_size : 0;
+
+  /* Other processes can share the cache, the actual size is only known
+   * after listing it */
+  if (cache_size == G_MAXUINT64 || cache_size > cache_budget)
+    cache_size = prune_cache (cache_dir);
+
+done:
+  g_variant_unref (job->entry);
+  g_free (job->path);
+  g_free (job->uri);
+  g_slice_free (StoreJob, job);
+}
+
+/**
+ * ges_discovery_cache_store:
+ * @info: A #GstDiscovererInfo
+ *
+ * Saves @info so that it does not need to be discovered again as long as
+ * the file does not change. Unsuccessful results are never stored. The
+ * entry is written asynchronously.
+ */
+void
+ges_discovery_cache_store (GstDiscovererInfo * info)
+{
+  StoreJob *job;
+  guint64 mtime, size;
+  const gchar *cache_dir = get_cache_dir ();
+  const gchar *uri = gst_discoverer_info_get_uri (info);
+
+  if (!cache_dir || gst_discoverer_info_get_result (info) != GST_DISCOVERER_OK
+      || g_object_get_qdata (G_OBJECT (info), from_cache_quark)
+      || !get_file_stamp (uri, &mtime, &size))
+    return;
+
+  job = g_slice_new (StoreJob);
+  job->uri = g_strdup (uri);
+  job->path = get_entry_path (cache_dir, uri);
+  job->entry = g_variant_new (CACHE_ENTRY_FORMAT, CACHE_VERSION, uri, mtime,
+      size, gst_discoverer_info_to_variant (info,
+          GST_DISCOVERER_SERIALIZE_ALL));
+  g_variant_ref_sink (job->entry);
+
+  G_LOCK (store_pool);
+  if (!store_pool)
+    store_pool = g_thread_pool_new ((GFunc) store_entry, (gpointer) cache_dir,
+        1, FALSE, NULL);
+  g_thread_pool_push (store_pool, job, NULL);
+  G_UNLOCK (store_pool);
+}
+
+/* Waits for the pending entries to be written */
+void
+ges_discovery_cache_deinit (void)
+{
+  GThreadPool *pool;
+
+  G_LOCK (store_pool);
+  pool = store_pool;
+  store_pool = NULL;
+  G_UNLOCK (store_pool);
+
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
+}
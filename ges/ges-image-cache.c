@@ -0,0 +1,567 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Process wide cache of decoded images.
+ *
+ * Images are decoded once per (uri, modification time) and converted once
+ * per target caps, all the image sources using the same picture then share
+ * the memory of a single frame. The cache is bounded by a memory budget,
+ * least recently used frames are evicted first, frames still in use by
+ * sources stay alive until they are released. The budget can be set in
+ * megabytes with the GES_IMAGE_CACHE_SIZE environment variable.
+ *
+ * Image sequences bypass the cache and decode their frames with a
+ * GESImageDecoder, which keeps one image decoder element around and feeds
+ * it whole files, instead of building a decoding pipeline per frame. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/video/video.h>
+#include <gst/base/gsttypefindhelper.h>
+
+#include "ges-internal.h"
+
+#define DEFAULT_IMAGE_CACHE_SIZE (256 * 1024 * 1024)
+#define DECODE_TIMEOUT (10 * GST_SECOND)
+
+typedef struct
+{
+  gchar *key;
+  GstSample *sample;
+  gsize size;
+
+  /* Set while a thread is decoding or converting the image */
+  gboolean pending;
+} CacheEntry;
+
+static GMutex cache_lock;
+static GCond cache_cond;
+static GHashTable *cache = NULL;
+/* Most recently used entries first */
+static GQueue lru = G_QUEUE_INIT;
+static gsize cache_size = 0;
+static gsize cache_budget = 0;
+
+static void
+cache_entry_free (CacheEntry * entry)
+{
+  g_free (entry->key);
+  if (entry->sample)
+    gst_sample_unref (entry->sample);
+  g_slice_free (CacheEntry, entry);
+}
+
+static void
+ensure_cache (void)
+{
+  const gchar *size_str;
+
+  if (cache)
+    return;
+
+  cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) cache_entry_free);
+
+  cache_budget = DEFAULT_IMAGE_CACHE_SIZE;
+  size_str = g_getenv ("GES_IMAGE_CACHE_SIZE");
+  if (size_str) {
+    guint64 size = g_ascii_strtoull (size_str, NULL, 10);
+
+    if (size <= G_MAXSIZE / (1024 * 1024))
+      cache_budget = size * 1024 * 1024;
+  }
+}
+
+static void
+evict_entries (CacheEntry * keep)
+{
+  GList *tmp, *prev;
+
+  for (tmp = lru.tail; tmp && cache_size > cache_budget; tmp = prev) {
+    CacheEntry *entry = tmp->data;
+
+    prev = tmp->prev;
+    if (entry == keep || entry->pending)
+      continue;
+
+    GST_DEBUG ("Evicting %s", entry->key);
+    cache_size -= entry->size;
+    g_queue_delete_link (&lru, tmp);
+    g_hash_table_remove (cache, entry->key);
+  }
+}
+
+static guint64
+get_modification_time (const gchar * uri)
+{
+  GFileInfo *info;
+  guint64 mtime = 0;
+  GFile *file = g_file_new_for_uri (uri);
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+      G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (info) {
+    mtime = g_file_info_get_attribute_uint64 (info,
+        G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+        g_file_info_get_attribute_uint32 (info,
+        G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+    g_object_unref (info);
+  }
+  g_object_unref (file);
+
+  return mtime;
+}
+
+static void
+decoded_pad_added_cb (GstElement * decodebin, GstPad * pad, GstElement * sink)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  if (!gst_pad_is_linked (sinkpad))
+    gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+/**
+ * ges_image_decode:
+ * @uri: The URI of the image
+ * @error: A #GError to fill in case of failure
+ *
+ * Prerolls a uridecodebin on @uri, bypassing the cache.
+ *
+ * Returns: (transfer full): The first raw video frame of @uri, or %NULL
+ */
+static GstSample *
+ges_image_decode (const gchar * uri, GError ** error)
+{
+  GstMessage *msg;
+  GstBus *bus;
+  GstSample *sample = NULL;
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  GstElement *decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstCaps *caps = gst_caps_new_empty_simple ("video/x-raw");
+
+  g_object_set (decodebin, "uri", uri, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (sink, "enable-last-sample", TRUE, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), decodebin, sink, NULL);
+  g_signal_connect (decodebin, "pad-added",
+      G_CALLBACK (decoded_pad_added_cb), sink);
+
+  bus = gst_element_get_bus (pipeline);
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  msg = gst_bus_timed_pop_filtered (bus, DECODE_TIMEOUT,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+
+  if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ASYNC_DONE) {
+    g_object_get (sink, "last-sample", &sample, NULL);
+  } else if (msg) {
+    gst_message_parse_error (msg, error, NULL);
+  }
+
+  if (!sample && error && !*error)
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Could not decode an image from %s", uri);
+
+  if (msg)
+    gst_message_unref (msg);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return sample;
+}
+
+struct _GESImageDecoder
+{
+  GstElement *decoder;
+  GstBus *bus;
+  /* The input caps @decoder was created for */
+  GstCaps *caps;
+  /* Pads feeding @decoder and collecting its output */
+  GstPad *srcpad;
+  GstPad *sinkpad;
+
+  GstSample *sample;
+};
+
+static GstFlowReturn
+image_decoder_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GESImageDecoder *self = gst_pad_get_element_private (pad);
+  GstCaps *caps = gst_pad_get_current_caps (pad);
+
+  if (!self->sample)
+    self->sample = gst_sample_new (buffer, caps, NULL, NULL);
+  if (caps)
+    gst_caps_unref (caps);
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static void
+image_decoder_clear (GESImageDecoder * self)
+{
+  if (!self->decoder)
+    return;
+
+  gst_element_set_state (self->decoder, GST_STATE_NULL);
+  gst_pad_set_active (self->srcpad, FALSE);
+  gst_pad_set_active (self->sinkpad, FALSE);
+  gst_clear_object (&self->srcpad);
+  gst_clear_object (&self->sinkpad);
+  gst_element_set_bus (self->decoder, NULL);
+  gst_clear_object (&self->decoder);
+  gst_caps_replace (&self->caps, NULL);
+}
+
+static GstElement *
+make_image_decoder (GstCaps * caps)
+{
+  GList *factories, *decoders;
+  GstElement *decoder = NULL;
+
+  factories = gst_element_factory_list_get_elements
+      (GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE,
+      GST_RANK_MARGINAL);
+  decoders = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK,
+      FALSE);
+  decoders = g_list_sort (decoders, gst_plugin_feature_rank_compare_func);
+  if (decoders)
+    decoder = gst_element_factory_create (decoders->data, NULL);
+  gst_plugin_feature_list_free (decoders);
+  gst_plugin_feature_list_free (factories);
+
+  return decoder;
+}
+
+/* Plugs a decoder for @caps and starts a stream on it */
+static gboolean
+image_decoder_setup (GESImageDecoder * self, GstCaps * caps)
+{
+  GstPad *pad;
+  GstSegment segment;
+  gboolean linked;
+
+  image_decoder_clear (self);
+  self->decoder = make_image_decoder (caps);
+  if (!self->decoder)
+    return FALSE;
+
+  gst_element_set_bus (self->decoder, self->bus);
+  self->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  self->sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_element_private (self->sinkpad, self);
+  gst_pad_set_chain_function (self->sinkpad, image_decoder_chain);
+
+  pad = gst_element_get_static_pad (self->decoder, "sink");
+  linked = gst_pad_link (self->srcpad, pad) == GST_PAD_LINK_OK;
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (self->decoder, "src");
+  linked &= gst_pad_link (pad, self->sinkpad) == GST_PAD_LINK_OK;
+  gst_object_unref (pad);
+
+  gst_pad_set_active (self->sinkpad, TRUE);
+  gst_pad_set_active (self->srcpad, TRUE);
+  if (!linked || gst_element_set_state (self->decoder, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    image_decoder_clear (self);
+
+    return FALSE;
+  }
+
+  gst_pad_push_event (self->srcpad, gst_event_new_stream_start ("image"));
+  gst_pad_push_event (self->srcpad, gst_event_new_caps (caps));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (self->srcpad, gst_event_new_segment (&segment));
+  self->caps = gst_caps_ref (caps);
+
+  return TRUE;
+}
+
+/* Makes the decoder output what it still holds and restarts the stream */
+static void
+image_decoder_drain (GESImageDecoder * self)
+{
+  GstSegment segment;
+
+  gst_pad_push_event (self->srcpad, gst_event_new_eos ());
+  gst_pad_push_event (self->srcpad, gst_event_new_flush_start ());
+  gst_pad_push_event (self->srcpad, gst_event_new_flush_stop (TRUE));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (self->srcpad, gst_event_new_segment (&segment));
+}
+
+GESImageDecoder *
+ges_image_decoder_new (void)
+{
+  GESImageDecoder *self = g_slice_new0 (GESImageDecoder);
+
+  self->bus = gst_bus_new ();
+  gst_bus_set_flushing (self->bus, FALSE);
+
+  return self;
+}
+
+void
+ges_image_decoder_free (GESImageDecoder * self)
+{
+  image_decoder_clear (self);
+  gst_object_unref (self->bus);
+  g_slice_free (GESImageDecoder, self);
+}
+
+/**
+ * ges_image_decoder_decode:
+ * @self: A #GESImageDecoder
+ * @filename: The image file to decode
+ * @error: A #GError to fill in case of failure
+ *
+ * Decodes @filename, reusing the decoder element of the previous image when
+ * it has the same format. Not thread safe, use one decoder per thread.
+ *
+ * Returns: (transfer full): The decoded image, or %NULL
+ */
+GstSample *
+ges_image_decoder_decode (GESImageDecoder * self, const gchar * filename,
+    GError ** error)
+{
+  gchar *data;
+  gsize size;
+  GstCaps *caps;
+  GstBuffer *buffer;
+  GstMessage *msg;
+  GstSample *sample;
+  GstFlowReturn ret;
+
+  if (!g_file_get_contents (filename, &data, &size, error))
+    return NULL;
+
+  buffer = gst_buffer_new_wrapped (data, size);
+  caps = gst_type_find_helper_for_buffer (NULL, buffer, NULL);
+  if (!caps) {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_TYPE_NOT_FOUND,
+        "Could not find the type of %s", filename);
+    gst_buffer_unref (buffer);
+
+    return NULL;
+  }
+
+  if ((!self->caps || !gst_caps_is_equal (caps, self->caps))
+      && !image_decoder_setup (self, caps)) {
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+        "No decoder for %s (%" GST_PTR_FORMAT ")", filename, caps);
+    gst_caps_unref (caps);
+    gst_buffer_unref (buffer);
+
+    return NULL;
+  }
+  gst_caps_unref (caps);
+
+  ret = gst_pad_push (self->srcpad, buffer);
+  if (ret == GST_FLOW_OK && !self->sample)
+    image_decoder_drain (self);
+
+  sample = self->sample;
+  self->sample = NULL;
+  if (sample)
+    return sample;
+
+  msg = gst_bus_pop_filtered (self->bus, GST_MESSAGE_ERROR);
+  if (msg) {
+    gst_message_parse_error (msg, error, NULL);
+    gst_message_unref (msg);
+  } else {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_DECODE,
+        "Could not decode %s: %s", filename, gst_flow_get_name (ret));
+  }
+  gst_bus_set_flushing (self->bus, TRUE);
+  gst_bus_set_flushing (self->bus, FALSE);
+  /* Start again from a clean decoder */
+  image_decoder_clear (self);
+
+  return NULL;
+}
+
+/* Scales @decoded into @caps keeping its display aspect ratio, adding black
+ * borders where the picture does not cover the frame, as videoscale does with
+ * add-borders */
+static GstSample *
+convert_image (GstSample * decoded, GstCaps * caps, GError ** error)
+{
+  gint width, height, x, y;
+  guint64 num, den;
+  GstBuffer *buffer;
+  GstStructure *config;
+  GstVideoInfo in_info, out_info;
+  GstVideoFrame in_frame, out_frame;
+  GstVideoConverter *converter;
+  GstSample *sample = NULL;
+
+  if (!gst_video_info_from_caps (&in_info, gst_sample_get_caps (decoded))
+      || !gst_video_info_from_caps (&out_info, caps)) {
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_NEGOTIATION,
+        "Can not convert image to %" GST_PTR_FORMAT, caps);
+
+    return NULL;
+  }
+
+  /* Picture width for the full output height, in output pixels */
+  num = (guint64) GST_VIDEO_INFO_WIDTH (&in_info) *
+      GST_VIDEO_INFO_PAR_N (&in_info) * GST_VIDEO_INFO_PAR_D (&out_info);
+  den = (guint64) GST_VIDEO_INFO_HEIGHT (&in_info) *
+      GST_VIDEO_INFO_PAR_D (&in_info) * GST_VIDEO_INFO_PAR_N (&out_info);
+  width = gst_util_uint64_scale (GST_VIDEO_INFO_HEIGHT (&out_info), num, den);
+  height = GST_VIDEO_INFO_HEIGHT (&out_info);
+  if (width > GST_VIDEO_INFO_WIDTH (&out_info)) {
+    width = GST_VIDEO_INFO_WIDTH (&out_info);
+    height = gst_util_uint64_scale (width, den, num);
+  }
+  width = MAX (width, 1);
+  height = MAX (height, 1);
+  x = (GST_VIDEO_INFO_WIDTH (&out_info) - width) / 2;
+  y = (GST_VIDEO_INFO_HEIGHT (&out_info) - height) / 2;
+
+  config = gst_structure_new ("GstVideoConverter",
+      GST_VIDEO_CONVERTER_OPT_DEST_X, G_TYPE_INT, x,
+      GST_VIDEO_CONVERTER_OPT_DEST_Y, G_TYPE_INT, y,
+      GST_VIDEO_CONVERTER_OPT_DEST_WIDTH, G_TYPE_INT, width,
+      GST_VIDEO_CONVERTER_OPT_DEST_HEIGHT, G_TYPE_INT, height,
+      GST_VIDEO_CONVERTER_OPT_FILL_BORDER, G_TYPE_BOOLEAN, TRUE,
+      GST_VIDEO_CONVERTER_OPT_BORDER_ARGB, G_TYPE_UINT, 0xff000000, NULL);
+  converter = gst_video_converter_new (&in_info, &out_info, config);
+  if (!converter) {
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_NEGOTIATION,
+        "Can not convert image to %" GST_PTR_FORMAT, caps);
+
+    return NULL;
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&out_info),
+      NULL);
+  if (gst_video_frame_map (&in_frame, &in_info,
+          gst_sample_get_buffer (decoded), GST_MAP_READ)) {
+    if (gst_video_frame_map (&out_frame, &out_info, buffer, GST_MAP_WRITE)) {
+      gst_video_converter_frame (converter, &in_frame, &out_frame);
+      gst_video_frame_unmap (&out_frame);
+      sample = gst_sample_new (buffer, caps, NULL, NULL);
+    }
+    gst_video_frame_unmap (&in_frame);
+  }
+  gst_video_converter_free (converter);
+  gst_buffer_unref (buffer);
+
+  if (!sample)
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Could not map image frames");
+
+  return sample;
+}
+
+/**
+ * ges_image_cache_get_sample:
+ * @uri: The URI of the image
+ * @caps: (allow-none): The caps the frame should be converted to, or %NULL
+ * to get the image in its decoded format
+ * @error: A #GError to fill in case of failure
+ *
+ * Returns: (transfer full): The decoded image, or %NULL if it could not be
+ * decoded or converted to @caps
+ */
+GstSample *
+ges_image_cache_get_sample (const gchar * uri, GstCaps * caps, GError ** error)
+{
+  gchar *key, *caps_str;
+  CacheEntry *entry;
+  GstSample *sample = NULL;
+
+  g_return_val_if_fail (uri, NULL);
+  g_return_val_if_fail (!caps || gst_caps_is_fixed (caps), NULL);
+
+  caps_str = caps ? gst_caps_to_string (caps) : NULL;
+  key = g_strdup_printf ("%s|%" G_GUINT64_FORMAT "|%s", uri,
+      get_modification_time (uri), caps_str ? caps_str : "");
+  g_free (caps_str);
+
+  g_mutex_lock (&cache_lock);
+  ensure_cache ();
+
+  while ((entry = g_hash_table_lookup (cache, key)) && entry->pending)
+    g_cond_wait (&cache_cond, &cache_lock);
+
+  if (entry) {
+    GList *link = g_queue_find (&lru, entry);
+
+    GST_LOG ("Reusing %s", key);
+    g_queue_unlink (&lru, link);
+    g_queue_push_head_link (&lru, link);
+    sample = gst_sample_ref (entry->sample);
+    g_mutex_unlock (&cache_lock);
+    g_free (key);
+
+    return sample;
+  }
+
+  entry = g_slice_new0 (CacheEntry);
+  entry->key = key;
+  entry->pending = TRUE;
+  g_hash_table_insert (cache, entry->key, entry);
+  g_mutex_unlock (&cache_lock);
+
+  if (caps) {
+    GstSample *decoded = ges_image_cache_get_sample (uri, NULL, error);
+
+    if (decoded) {
+      sample = convert_image (decoded, caps, error);
+      gst_sample_unref (decoded);
+    }
+  } else {
+    GST_DEBUG ("Decoding %s", uri);
+    sample = ges_image_decode (uri, error);
+  }
+
+  g_mutex_lock (&cache_lock);
+  if (sample) {
+    entry->sample = gst_sample_ref (sample);
+    entry->size = gst_buffer_get_size (gst_sample_get_buffer (sample));
+    entry->pending = FALSE;
+    g_queue_push_head (&lru, entry);
+    cache_size += entry->size;
+    evict_entries (entry);
+  } else {
+    g_hash_table_remove (cache, entry->key);
+  }
+  g_cond_broadcast (&cache_cond);
+  g_mutex_unlock (&cache_lock);
+
+  return sample;
+}
+
+void
+ges_image_cache_deinit (void)
+{
+  g_mutex_lock (&cache_lock);
+  g_queue_clear (&lru);
+  g_clear_pointer (&cache, g_hash_table_unref);
+  cache_size = 0;
+  g_mutex_unlock (&cache_lock);
+}
@@ -22,6 +22,7 @@
 #define __GES_INTERNAL_H__
 #include <gst/gst.h>
 #include <gst/pbutils/encoding-profile.h>
+#include <gst/pbutils/gstdiscoverer.h>
 #include <gio/gio.h>
 
 #include "ges-timeline.h"
@@ -30,6 +31,7 @@
 
 #include "ges-asset.h"
 #include "ges-base-xml-formatter.h"
+#include "ges-xml-formatter.h"
 
 G_BEGIN_DECLS
 
@@ -125,6 +127,15 @@ G_GNUC_INTERNAL
 void
 timeline_fill_gaps            (GESTimeline *timeline);
 
+G_GNUC_INTERNAL
+void
+timeline_set_use_proxies      (GESTimeline *timeline,
+                               gboolean use_proxies);
+
+G_GNUC_INTERNAL
+gboolean
+timeline_get_use_proxies      (GESTimeline *timeline);
+
 G_GNUC_INTERNAL void
 timeline_create_transitions (GESTimeline * timeline, GESTrackElement * track_element);
 
@@ -136,6 +147,14 @@ G_GNUC_INTERNAL
 void
 track_disable_last_gap        (GESTrack *track, gboolean disabled);
 
+G_GNUC_INTERNAL
+void
+track_set_resample_quality    (GESTrack *track, gint quality);
+
+G_GNUC_INTERNAL
+gint
+track_get_resample_quality    (GESTrack *track);
+
 G_GNUC_INTERNAL void
 ges_asset_cache_init (void);
 
@@ -219,7 +238,47 @@ G_GNUC_INTERNAL  gchar * ges_project_try_updating_id              (GESProject *s
 G_GNUC_INTERNAL  void ges_project_add_loading_asset               (GESProject *project,
                                                                    GType extractable_type,
                                                                    const gchar *id);
+G_GNUC_INTERNAL  void ges_project_set_loading_progress            (GESProject *project,
+                                                                   gdouble progress);
+G_GNUC_INTERNAL  void ges_project_set_loading_error               (GESProject *project,
+                                                                   GESTimeline *timeline,
+                                                                   GError *error);
+G_GNUC_INTERNAL  void ges_project_set_asset_loading_error         (GESProject *project,
+                                                                   const gchar *id,
+                                                                   GType extractable_type,
+                                                                   GError *error);
 G_GNUC_INTERNAL  gchar* ges_uri_asset_try_update_id               (GError *error, GESAsset *wrong_asset);
+G_GNUC_INTERNAL  void ges_missing_uri_relocation_deinit          (void);
+G_GNUC_INTERNAL  void ges_uri_clip_asset_set_provisional_info   (GstDiscovererInfo *info);
+G_GNUC_INTERNAL  gchar * ges_uri_clip_asset_get_playback_uri      (const gchar *uri,
+                                                                   gboolean use_proxies);
+
+/************************************************
+ *                                              *
+ *        GESProjectJournal internal methods    *
+ *                                              *
+ ************************************************/
+
+typedef struct _GESProjectJournal GESProjectJournal;
+
+G_GNUC_INTERNAL  GESProjectJournal * ges_project_journal_new      (GESProject *project,
+                                                                   GESTimeline *timeline,
+                                                                   const gchar *uri,
+                                                                   GESAsset *formatter_asset,
+                                                                   GError **error);
+G_GNUC_INTERNAL  void ges_project_journal_free                    (GESProjectJournal *journal);
+G_GNUC_INTERNAL  gboolean ges_project_journal_sync                (GESProjectJournal *journal,
+                                                                   GError **error);
+G_GNUC_INTERNAL  gboolean ges_project_journal_begin_save          (GESProjectJournal *journal,
+                                                                   GESTimeline *timeline,
+                                                                   const gchar *uri);
+G_GNUC_INTERNAL  void ges_project_journal_end_save                (GESProjectJournal *journal,
+                                                                   gboolean saved);
+G_GNUC_INTERNAL  void ges_project_journal_replay_async            (GESProject *project,
+                                                                   GESTimeline *timeline,
+                                                                   GAsyncReadyCallback callback,
+                                                                   gpointer user_data);
+
 /************************************************
  *                                              *
  *   GESBaseXmlFormatter internal methods       *
@@ -247,6 +306,7 @@ G_GNUC_INTERNAL void ges_base_xml_formatter_add_asset        (GESBaseXmlFormatte
                                                                  GstStructure *properties,
                                                                  const gchar *metadatas,
                                                                  const gchar *proxy_id,
+                                                                 GstDiscovererInfo *info,
                                                                  GError **error);
 G_GNUC_INTERNAL void ges_base_xml_formatter_add_layer           (GESBaseXmlFormatter *self,
                                                                  GType extractable_type,
@@ -309,10 +369,49 @@ G_GNUC_INTERNAL void ges_base_xml_formatter_add_control_binding (GESBaseXmlForma
                                                                   const gchar *track_id,
                                                                   GSList * timed_values);
 
+G_GNUC_INTERNAL GBytes * ges_base_xml_formatter_save_to_bytes  (GESBaseXmlFormatter *self,
+                                                                 GESTimeline *timeline,
+                                                                 GError **error);
+
+G_GNUC_INTERNAL gboolean ges_base_xml_formatter_write_bytes     (GBytes *bytes,
+                                                                 const gchar *uri,
+                                                                 gboolean overwrite,
+                                                                 GCancellable *cancellable,
+                                                                 GError **error);
+
+G_GNUC_INTERNAL void ges_xml_formatter_save_to_bytes_async    (GESXmlFormatter *self,
+                                                                 GESTimeline *timeline,
+                                                                 GCancellable *cancellable,
+                                                                 GAsyncReadyCallback callback,
+                                                                 gpointer user_data);
+
+G_GNUC_INTERNAL GBytes * ges_xml_formatter_save_to_bytes_finish (GESXmlFormatter *self,
+                                                                 GAsyncResult *result,
+                                                                 GError **error);
+
+G_GNUC_INTERNAL void ges_base_xml_formatter_begin_loading      (GESBaseXmlFormatter *self,
+                                                                 GESTimeline *timeline);
+
+G_GNUC_INTERNAL void ges_base_xml_formatter_end_loading        (GESBaseXmlFormatter *self,
+                                                                 GError *error);
+
+G_GNUC_INTERNAL gchar * _serialize_properties                   (GObject * object,
+                                                                 const gchar * fieldname,
+                                                                 ...);
+
+G_GNUC_INTERNAL gchar * _serialize_children_properties          (GESTimelineElement * element);
+
+G_GNUC_INTERNAL GParamSpec * _lookup_settable_property          (GObject * object,
+                                                                 GQuark field_id);
+
 G_GNUC_INTERNAL gboolean set_property_foreach                   (GQuark field_id,
                                                                  const GValue * value,
                                                                  GObject * object);
 
+G_GNUC_INTERNAL gboolean set_child_property_foreach             (GQuark field_id,
+                                                                 const GValue * value,
+                                                                 GESTimelineElement * element);
+
 G_GNUC_INTERNAL GstElement * get_element_for_encoding_profile   (GstEncodingProfile *prof,
                                                                  GstElementFactoryListType type);
 
@@ -327,6 +426,41 @@ G_GNUC_INTERNAL gint element_end_compare                  (GESTimelineElement *
                                                            GESTimelineElement * b);
 G_GNUC_INTERNAL GstElementFactory *
 ges_get_compositor_factory                                (void);
+G_GNUC_INTERNAL void ges_text_render_cache_attach          (GstElement * text,
+                                                           GstElement * background,
+                                                           const gchar ** props);
+G_GNUC_INTERNAL GstSample * ges_image_cache_get_sample     (const gchar * uri,
+                                                           GstCaps * caps,
+                                                           GError ** error);
+G_GNUC_INTERNAL void ges_image_cache_deinit               (void);
+G_GNUC_INTERNAL GstDiscovererInfo * ges_discovery_cache_lookup (const gchar * uri);
+G_GNUC_INTERNAL void ges_discovery_cache_store            (GstDiscovererInfo * info);
+G_GNUC_INTERNAL void ges_discovery_cache_deinit           (void);
+typedef struct _GESImageDecoder GESImageDecoder;
+G_GNUC_INTERNAL GESImageDecoder * ges_image_decoder_new   (void);
+G_GNUC_INTERNAL void ges_image_decoder_free               (GESImageDecoder * self);
+G_GNUC_INTERNAL GstSample * ges_image_decoder_decode      (GESImageDecoder * self,
+                                                           const gchar * filename,
+                                                           GError ** error);
+typedef struct _GESControlSync GESControlSync;
+G_GNUC_INTERNAL GESControlSync * ges_control_sync_new      (GstObject * object);
+G_GNUC_INTERNAL void ges_control_sync_free                (GESControlSync * sync);
+G_GNUC_INTERNAL void ges_control_sync_values              (GESControlSync * sync,
+                                                           GstClockTime timestamp,
+                                                           GstClockTime duration);
+G_GNUC_INTERNAL void ges_pad_forward_sticky_events        (GstPad * from,
+                                                           GstPad * to);
+typedef struct _GESMixerBypass GESMixerBypass;
+G_GNUC_INTERNAL GESMixerBypass * ges_mixer_bypass_new      (GstBin * bin,
+                                                           GstPad * mixer_srcpad);
+G_GNUC_INTERNAL void ges_mixer_bypass_free                (GESMixerBypass * bypass);
+G_GNUC_INTERNAL GstPad * ges_mixer_bypass_get_srcpad      (GESMixerBypass * bypass);
+G_GNUC_INTERNAL void ges_mixer_bypass_unlock              (GESMixerBypass * bypass);
+G_GNUC_INTERNAL void ges_mixer_bypass_reset               (GESMixerBypass * bypass);
+G_GNUC_INTERNAL GstPadProbeReturn ges_mixer_bypass_probe  (GESMixerBypass * bypass,
+                                                           GstPad * pad,
+                                                           GstPadProbeInfo * info,
+                                                           gboolean can_bypass);
 
 G_GNUC_INTERNAL void
 ges_base_xml_formatter_set_timeline_properties(GESBaseXmlFormatter * self,
@@ -389,6 +523,8 @@ G_GNUC_INTERNAL GstElement * ges_track_get_composition (GESTrack *track);
 G_GNUC_INTERNAL GESAudioTestSource * ges_audio_test_source_new (void);
 G_GNUC_INTERNAL GESAudioUriSource  * ges_audio_uri_source_new  (gchar *uri);
 G_GNUC_INTERNAL GESVideoUriSource  * ges_video_uri_source_new  (gchar *uri);
+G_GNUC_INTERNAL void ges_audio_uri_source_update_playback_uri (GESAudioUriSource *self);
+G_GNUC_INTERNAL void ges_video_uri_source_update_playback_uri (GESVideoUriSource *self);
 G_GNUC_INTERNAL GESImageSource     * ges_image_source_new      (gchar *uri);
 G_GNUC_INTERNAL GESTitleSource     * ges_title_source_new      (void);
 G_GNUC_INTERNAL GESVideoTestSource * ges_video_test_source_new (void);
@@ -0,0 +1,549 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Single input bypass of the mixers of the smart mixers.
+ *
+ * The output of the mixer goes through an input-selector, whose other input
+ * is fed with the buffers of the mixer input that is bypassing it, so that
+ * only one of them is ever pushed downstream. The mixer keeps getting the
+ * events of the bypassing input but none of its buffers, so it just waits
+ * meanwhile. When it has to take over, a single GAP event covering all
+ * that was bypassed brings it back in sync.
+ *
+ * What the mixer outputs between the first and the last bypassed buffers is
+ * dropped (or clipped, for audio). The bypass only starts once the mixer
+ * has output everything it got before, so the output timestamps never go
+ * backward when switching from one to the other. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/audio/audio.h>
+
+#include "ges-internal.h"
+
+struct _GESMixerBypass
+{
+  GstElement *selector;
+  /* The selector pad the mixer output is linked to */
+  GstPad *mixer_sinkpad;
+  /* Our pad pushing the bypassed buffers, and its peer in the selector */
+  GstPad *srcpad;
+  GstPad *bypass_sinkpad;
+  /* The pad the mixer outputs on */
+  GstPad *mixer_srcpad;
+  gulong mixer_probe_id;
+
+  /* Protects everything below */
+  GMutex lock;
+  GCond cond;
+
+  /* The input currently bypassing the mixer, not reffed */
+  GstPad *bypassing_pad;
+  gboolean forward_events;
+  gboolean flushing;
+  /* Whether the mixer got buffers since the last flush */
+  gboolean mixer_fed;
+  /* Running time the mixer output reached */
+  GstClockTime mixer_position;
+  /* Running times between which the mixer output is dropped, @skip_end
+   * being GST_CLOCK_TIME_NONE while bypassing */
+  GstClockTime skip_start;
+  GstClockTime skip_end;
+  /* Range of the bypassed buffers the mixer did not get yet, in the segment
+   * of the bypassing input. @gap_start is GST_CLOCK_TIME_NONE if empty */
+  GstClockTime gap_start;
+  GstClockTime gap_end;
+};
+
+static gboolean
+get_running_times (GstPad * pad, GstBuffer * buffer, GstClockTime * start,
+    GstClockTime * end, GstSegment * segment)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  GstEvent *event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+
+  if (!event)
+    return FALSE;
+
+  gst_event_copy_segment (event, segment);
+  gst_event_unref (event);
+
+  if (segment->format != GST_FORMAT_TIME || !GST_CLOCK_TIME_IS_VALID (pts))
+    return FALSE;
+
+  *start = gst_segment_to_running_time (segment, GST_FORMAT_TIME, pts);
+  *end = *start;
+  if (GST_BUFFER_DURATION_IS_VALID (buffer))
+    *end = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        pts + GST_BUFFER_DURATION (buffer));
+
+  return GST_CLOCK_TIME_IS_VALID (*start) && GST_CLOCK_TIME_IS_VALID (*end);
+}
+
+/* Removes the part of @buffer, which ends after @skip_start, that lies
+ * between @skip_start and @skip_end as it was already output by the bypass.
+ * Video frames are dropped when they start in that range. Returns NULL if
+ * nothing is left. */
+static GstBuffer *
+clip_mixer_output (GstPad * pad, GstBuffer * buffer, GstSegment * segment,
+    GstClockTime start, GstClockTime skip_start, GstClockTime skip_end)
+{
+  GstAudioInfo info;
+  GstSegment clip_segment = *segment;
+  GstCaps *caps = gst_pad_get_current_caps (pad);
+  gboolean skipped = start >= skip_start;
+  gboolean is_audio = caps
+      && gst_structure_has_name (gst_caps_get_structure (caps, 0),
+      "audio/x-raw") && gst_audio_info_from_caps (&info, caps);
+
+  gst_clear_caps (&caps);
+  if (!is_audio) {
+    if (!skipped)
+      return buffer;
+
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  /* Only keep what comes before or after the bypassed range */
+  if (!skipped) {
+    clip_segment.stop = gst_segment_position_from_running_time (segment,
+        GST_FORMAT_TIME, skip_start);
+  } else if (GST_CLOCK_TIME_IS_VALID (skip_end)) {
+    clip_segment.start = gst_segment_position_from_running_time (segment,
+        GST_FORMAT_TIME, skip_end);
+  } else {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  return gst_audio_buffer_clip (buffer, &clip_segment,
+      GST_AUDIO_INFO_RATE (&info), GST_AUDIO_INFO_BPF (&info));
+}
+
+static GstPadProbeReturn
+mixer_output_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    GESMixerBypass * bypass)
+{
+  GstBuffer *buffer;
+  GstSegment segment;
+  GstClockTime start, end, skip_start, skip_end;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP) {
+      g_mutex_lock (&bypass->lock);
+      bypass->mixer_position = GST_CLOCK_TIME_NONE;
+      g_mutex_unlock (&bypass->lock);
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (!get_running_times (pad, buffer, &start, &end, &segment))
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&bypass->lock);
+  if (!GST_CLOCK_TIME_IS_VALID (bypass->mixer_position)
+      || end > bypass->mixer_position) {
+    bypass->mixer_position = end;
+    g_cond_broadcast (&bypass->cond);
+  }
+
+  /* Past the bypassed range, nothing to skip anymore */
+  if (GST_CLOCK_TIME_IS_VALID (bypass->skip_end) && start >= bypass->skip_end)
+    bypass->skip_start = bypass->skip_end = GST_CLOCK_TIME_NONE;
+
+  skip_start = bypass->skip_start;
+  skip_end = bypass->skip_end;
+  g_mutex_unlock (&bypass->lock);
+
+  if (!GST_CLOCK_TIME_IS_VALID (skip_start) || end <= skip_start)
+    return GST_PAD_PROBE_OK;
+
+  buffer = clip_mixer_output (pad, buffer, &segment, start, skip_start,
+      skip_end);
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+  if (!buffer) {
+    GST_LOG_OBJECT (pad, "Dropping output already bypassed");
+
+    return GST_PAD_PROBE_DROP;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* The mixer path gets upstream events */
+static gboolean
+bypass_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  gst_event_unref (event);
+
+  return FALSE;
+}
+
+static void
+push_gap_to_mixer (GstPad * pad, GstClockTime pts, GstClockTime duration)
+{
+  GstPad *internal = GST_PAD (gst_proxy_pad_get_internal (GST_PROXY_PAD
+          (pad)));
+
+  gst_pad_push_event (internal, gst_event_new_gap (pts, duration));
+  gst_object_unref (internal);
+}
+
+/* Called with the lock, brings the mixer in sync with what @pad bypassed */
+static void
+push_pending_gap (GESMixerBypass * bypass, GstPad * pad)
+{
+  GstClockTime start = bypass->gap_start, end = bypass->gap_end;
+
+  if (!GST_CLOCK_TIME_IS_VALID (start))
+    return;
+
+  bypass->gap_start = bypass->gap_end = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&bypass->lock);
+  push_gap_to_mixer (pad, start, end - start);
+  g_mutex_lock (&bypass->lock);
+}
+
+/* Called with the lock, waits until the mixer output everything before
+ * @running_time. Returns FALSE if flushing started meanwhile */
+static gboolean
+wait_mixer_drained (GESMixerBypass * bypass, GstClockTime running_time)
+{
+  while (!bypass->flushing
+      && (!GST_CLOCK_TIME_IS_VALID (bypass->mixer_position)
+          || bypass->mixer_position < running_time))
+    g_cond_wait (&bypass->cond, &bypass->lock);
+
+  return !bypass->flushing;
+}
+
+static void
+set_active_pad (GESMixerBypass * bypass, GstPad * pad)
+{
+  g_mutex_unlock (&bypass->lock);
+  g_object_set (bypass->selector, "active-pad", pad, NULL);
+  g_mutex_lock (&bypass->lock);
+}
+
+static GstPadProbeReturn
+handle_event (GESMixerBypass * bypass, GstPad * pad, GstEvent * event)
+{
+  gboolean bypassing, forward_events = FALSE;
+
+  g_mutex_lock (&bypass->lock);
+  bypassing = bypass->bypassing_pad == pad;
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      bypass->flushing = TRUE;
+      g_cond_broadcast (&bypass->cond);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      bypass->flushing = FALSE;
+      bypass->mixer_fed = FALSE;
+      bypass->mixer_position = GST_CLOCK_TIME_NONE;
+      bypass->skip_start = bypass->skip_end = GST_CLOCK_TIME_NONE;
+      bypass->gap_start = bypass->gap_end = GST_CLOCK_TIME_NONE;
+      break;
+    case GST_EVENT_CAPS:
+      if (bypassing)
+        bypass->forward_events = TRUE;
+      break;
+    case GST_EVENT_SEGMENT:
+      /* What was bypassed belongs to the previous segment */
+      if (bypassing) {
+        push_pending_gap (bypass, pad);
+        bypass->forward_events = TRUE;
+      }
+      break;
+    case GST_EVENT_GAP:
+      if (bypassing) {
+        push_pending_gap (bypass, pad);
+        forward_events = bypass->forward_events;
+        bypass->forward_events = FALSE;
+      }
+      break;
+    default:
+      break;
+  }
+  g_mutex_unlock (&bypass->lock);
+
+  if (!bypassing)
+    return GST_PAD_PROBE_OK;
+
+  /* Caps and segments are forwarded with the next bypassed data, once we
+   * know the new format can be bypassed */
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_GAP:
+      if (forward_events)
+        ges_pad_forward_sticky_events (pad, bypass->srcpad);
+      /* fallthrough */
+    case GST_EVENT_FLUSH_START:
+    case GST_EVENT_FLUSH_STOP:
+    case GST_EVENT_EOS:
+      gst_pad_push_event (bypass->srcpad, gst_event_ref (event));
+      break;
+    default:
+      break;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+handle_buffer (GESMixerBypass * bypass, GstPad * pad, GstPadProbeInfo * info,
+    gboolean can_bypass)
+{
+  GstSegment segment;
+  GstClockTime start = GST_CLOCK_TIME_NONE, end, pts, duration;
+  gboolean forward_events, gap_pushed = FALSE;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (can_bypass && !get_running_times (pad, buffer, &start, &end, &segment))
+    can_bypass = FALSE;
+
+  g_mutex_lock (&bypass->lock);
+  if (bypass->bypassing_pad && bypass->bypassing_pad != pad)
+    can_bypass = FALSE;
+
+  if (!can_bypass) {
+    if (bypass->bypassing_pad == pad) {
+      GST_DEBUG_OBJECT (pad, "Stop bypassing the mixer");
+
+      push_pending_gap (bypass, pad);
+      bypass->bypassing_pad = NULL;
+      if (GST_CLOCK_TIME_IS_VALID (bypass->skip_start)
+          && get_running_times (pad, buffer, &start, &end, &segment))
+        bypass->skip_end = start;
+      else
+        bypass->skip_start = bypass->skip_end = GST_CLOCK_TIME_NONE;
+      set_active_pad (bypass, bypass->mixer_sinkpad);
+    }
+    bypass->mixer_fed = TRUE;
+    g_mutex_unlock (&bypass->lock);
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  pts = GST_BUFFER_PTS (buffer);
+  duration = GST_BUFFER_DURATION (buffer);
+  if (bypass->bypassing_pad != pad) {
+    GST_DEBUG_OBJECT (pad, "Bypassing the mixer from %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (start));
+
+    bypass->skip_start = start;
+    bypass->skip_end = GST_CLOCK_TIME_NONE;
+    if (bypass->mixer_fed) {
+      /* Lets the mixer output what it still has before @start */
+      g_mutex_unlock (&bypass->lock);
+      push_gap_to_mixer (pad, pts, duration);
+      gap_pushed = TRUE;
+      g_mutex_lock (&bypass->lock);
+
+      if (!wait_mixer_drained (bypass, start)) {
+        g_mutex_unlock (&bypass->lock);
+        GST_PAD_PROBE_INFO_FLOW_RETURN (info) = GST_FLOW_FLUSHING;
+        gst_buffer_unref (buffer);
+        GST_PAD_PROBE_INFO_DATA (info) = NULL;
+
+        return GST_PAD_PROBE_HANDLED;
+      }
+    }
+
+    bypass->bypassing_pad = pad;
+    bypass->forward_events = TRUE;
+    set_active_pad (bypass, bypass->bypass_sinkpad);
+  } else if (!GST_CLOCK_TIME_IS_VALID (bypass->skip_start)) {
+    /* Restarting after a flush */
+    bypass->skip_start = start;
+  }
+
+  /* The mixer only gets what it missed when it has to take over */
+  if (!gap_pushed && GST_CLOCK_TIME_IS_VALID (pts)) {
+    if (!GST_CLOCK_TIME_IS_VALID (bypass->gap_start))
+      bypass->gap_start = bypass->gap_end = pts;
+    bypass->gap_end = MAX (bypass->gap_end,
+        GST_CLOCK_TIME_IS_VALID (duration) ? pts + duration : pts);
+  }
+
+  forward_events = bypass->forward_events;
+  bypass->forward_events = FALSE;
+  g_mutex_unlock (&bypass->lock);
+
+  if (forward_events)
+    ges_pad_forward_sticky_events (pad, bypass->srcpad);
+
+  GST_PAD_PROBE_INFO_FLOW_RETURN (info) = gst_pad_push (bypass->srcpad,
+      buffer);
+  GST_PAD_PROBE_INFO_DATA (info) = NULL;
+
+  return GST_PAD_PROBE_HANDLED;
+}
+
+/**
+ * ges_mixer_bypass_probe:
+ * @bypass: The #GESMixerBypass
+ * @pad: The ghost pad of an input of the mixer
+ * @info: The probe info of buffers and downstream (including flush) events
+ * on @pad
+ * @can_bypass: Whether the buffer in @info, if any, can be output as is
+ *
+ * To be called from a probe on each input of the mixer so that buffers are
+ * pushed through the bypass instead of being mixed when @can_bypass.
+ */
+GstPadProbeReturn
+ges_mixer_bypass_probe (GESMixerBypass * bypass, GstPad * pad,
+    GstPadProbeInfo * info, gboolean can_bypass)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_BOTH)
+    return handle_event (bypass, pad, GST_PAD_PROBE_INFO_EVENT (info));
+
+  return handle_buffer (bypass, pad, info, can_bypass);
+}
+
+/**
+ * ges_mixer_bypass_unlock:
+ * @bypass: The #GESMixerBypass
+ *
+ * Wakes up the streaming thread of an input waiting for the mixer to
+ * drain, to be called before the pads get deactivated.
+ */
+void
+ges_mixer_bypass_unlock (GESMixerBypass * bypass)
+{
+  g_mutex_lock (&bypass->lock);
+  bypass->flushing = TRUE;
+  g_cond_broadcast (&bypass->cond);
+  g_mutex_unlock (&bypass->lock);
+}
+
+/**
+ * ges_mixer_bypass_reset:
+ * @bypass: The #GESMixerBypass
+ *
+ * Goes back to mixing, to be called when the mixer stops.
+ */
+void
+ges_mixer_bypass_reset (GESMixerBypass * bypass)
+{
+  g_mutex_lock (&bypass->lock);
+  bypass->bypassing_pad = NULL;
+  bypass->forward_events = FALSE;
+  bypass->flushing = FALSE;
+  bypass->mixer_fed = FALSE;
+  bypass->mixer_position = GST_CLOCK_TIME_NONE;
+  bypass->skip_start = bypass->skip_end = GST_CLOCK_TIME_NONE;
+  bypass->gap_start = bypass->gap_end = GST_CLOCK_TIME_NONE;
+  set_active_pad (bypass, bypass->mixer_sinkpad);
+  g_mutex_unlock (&bypass->lock);
+
+  /* Drop the sticky events of the previous stream */
+  gst_pad_set_active (bypass->srcpad, FALSE);
+  gst_pad_set_active (bypass->srcpad, TRUE);
+}
+
+/**
+ * ges_mixer_bypass_new:
+ * @bin: The bin the mixer is in
+ * @mixer_srcpad: The pad the mixer output goes out on
+ *
+ * Adds the input-selector switching between the mixer output and the
+ * bypassed buffers in @bin, linked to @mixer_srcpad.
+ *
+ * Returns: The new #GESMixerBypass, or %NULL if input-selector is missing
+ */
+GESMixerBypass *
+ges_mixer_bypass_new (GstBin * bin, GstPad * mixer_srcpad)
+{
+  GESMixerBypass *bypass;
+  GstElement *selector = gst_element_factory_make ("input-selector", NULL);
+
+  if (!selector) {
+    GST_WARNING_OBJECT (bin, "No input-selector, can not bypass the mixer");
+
+    return NULL;
+  }
+
+  bypass = g_slice_new0 (GESMixerBypass);
+  g_mutex_init (&bypass->lock);
+  g_cond_init (&bypass->cond);
+  bypass->mixer_position = GST_CLOCK_TIME_NONE;
+  bypass->skip_start = bypass->skip_end = GST_CLOCK_TIME_NONE;
+  bypass->gap_start = bypass->gap_end = GST_CLOCK_TIME_NONE;
+
+  /* We take care of not outputting anything twice ourself */
+  bypass->selector = gst_object_ref (selector);
+  g_object_set (selector, "sync-streams", FALSE, NULL);
+  gst_bin_add (bin, selector);
+
+  bypass->mixer_srcpad = gst_object_ref (mixer_srcpad);
+  bypass->mixer_sinkpad = gst_element_get_request_pad (selector, "sink_%u");
+  gst_pad_link (mixer_srcpad, bypass->mixer_sinkpad);
+  bypass->mixer_probe_id = gst_pad_add_probe (mixer_srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) mixer_output_probe_cb, bypass, NULL);
+
+  bypass->srcpad = gst_pad_new ("bypass_src", GST_PAD_SRC);
+  gst_pad_set_event_function (bypass->srcpad, bypass_src_event);
+  bypass->bypass_sinkpad = gst_element_get_request_pad (selector, "sink_%u");
+  gst_pad_link (bypass->srcpad, bypass->bypass_sinkpad);
+  gst_pad_set_active (bypass->srcpad, TRUE);
+
+  g_object_set (selector, "active-pad", bypass->mixer_sinkpad, NULL);
+
+  return bypass;
+}
+
+/**
+ * ges_mixer_bypass_get_srcpad:
+ * @bypass: The #GESMixerBypass
+ *
+ * Returns: (transfer full): The pad outputting either the mixer output or
+ * the bypassed buffers
+ */
+GstPad *
+ges_mixer_bypass_get_srcpad (GESMixerBypass * bypass)
+{
+  return gst_element_get_static_pad (bypass->selector, "src");
+}
+
+void
+ges_mixer_bypass_free (GESMixerBypass * bypass)
+{
+  gst_pad_remove_probe (bypass->mixer_srcpad, bypass->mixer_probe_id);
+  gst_object_unref (bypass->mixer_srcpad);
+
+  gst_pad_set_active (bypass->srcpad, FALSE);
+  gst_pad_unlink (bypass->srcpad, bypass->bypass_sinkpad);
+  gst_object_unref (bypass->srcpad);
+
+  gst_element_release_request_pad (bypass->selector, bypass->bypass_sinkpad);
+  gst_object_unref (bypass->bypass_sinkpad);
+  gst_element_release_request_pad (bypass->selector, bypass->mixer_sinkpad);
+  gst_object_unref (bypass->mixer_sinkpad);
+  gst_object_unref (bypass->selector);
+
+  g_mutex_clear (&bypass->lock);
+  g_cond_clear (&bypass->cond);
+  g_slice_free (GESMixerBypass, bypass);
+}
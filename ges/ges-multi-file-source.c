@@ -110,17 +110,6 @@ ges_multi_file_source_dispose (GObject * object)
   G_OBJECT_CLASS (ges_multi_file_source_parent_class)->dispose (object);
 }
 
-static void
-pad_added_cb (GstElement * decodebin, GstPad * pad, GstElement * bin)
-{
-  GstPad *srcpad;
-
-  srcpad = gst_ghost_pad_new ("src", pad);
-
-  gst_pad_set_active (srcpad, TRUE);
-  gst_element_add_pad (bin, srcpad);
-}
-
 /**
   * ges_multi_file_uri_new: (skip)
   *
@@ -166,58 +155,42 @@ ges_multi_file_uri_new (const gchar * uri)
   return uri_data;
 }
 
+static guint
+get_env_uint (const gchar * name)
+{
+  const gchar *str = g_getenv (name);
+  guint64 value = str ? g_ascii_strtoull (str, NULL, 10) : 0;
+
+  return value <= G_MAXINT16 ? value : 0;
+}
+
+/* The frames are decoded ahead, in parallel, the number of decoding threads
+ * and of frames decoded ahead can be set with the GES_IMAGE_SEQUENCE_THREADS
+ * and GES_IMAGE_SEQUENCE_WINDOW environment variables */
 static GstElement *
 ges_multi_file_source_create_source (GESTrackElement * track_element)
 {
-  GESMultiFileSource *self;
-  GstElement *bin, *src, *decodebin;
-  GstCaps *disc_caps;
-  GstDiscovererStreamInfo *stream_info;
-  GValue fps = G_VALUE_INIT;
-  GstCaps *caps;
-  GESUriSourceAsset *asset;
+  GstElement *src;
+  guint n_threads, window_size;
   GESMultiFileURI *uri_data;
+  GESMultiFileSource *self = (GESMultiFileSource *) track_element;
 
-  self = (GESMultiFileSource *) track_element;
-
-  asset =
-      GES_URI_SOURCE_ASSET (ges_extractable_get_asset (GES_EXTRACTABLE (self)));
-
-  if (asset != NULL) {
-    stream_info = ges_uri_source_asset_get_stream_info (asset);
-    g_assert (stream_info);
-    disc_caps = gst_discoverer_stream_info_get_caps (stream_info);
-    caps = gst_caps_copy (disc_caps);
-    GST_DEBUG_OBJECT (disc_caps, "Got some nice caps");
-    gst_object_unref (stream_info);
-    gst_caps_unref (disc_caps);
-  } else {
-    caps = gst_caps_new_empty ();
-    GST_WARNING ("Could not extract asset.");
-  }
-
-  g_value_init (&fps, GST_TYPE_FRACTION);
-  gst_value_set_fraction (&fps, 25, 1);
-  gst_caps_set_value (caps, "framerate", &fps);
-
-  bin = GST_ELEMENT (gst_bin_new ("multi-image-bin"));
-  src = gst_element_factory_make ("multifilesrc", NULL);
+  src = gst_element_factory_make ("gesimagesequencesrc", NULL);
 
   uri_data = ges_multi_file_uri_new (self->uri);
   g_object_set (src, "start-index", uri_data->start, "stop-index",
-      uri_data->end, "caps", caps, "location", uri_data->location, NULL);
+      uri_data->end, "location", uri_data->location, NULL);
   g_free (uri_data);
 
-  decodebin = gst_element_factory_make ("decodebin", NULL);
-
-  gst_bin_add_many (GST_BIN (bin), src, decodebin, NULL);
-  gst_element_link_pads_full (src, "src", decodebin, "sink",
-      GST_PAD_LINK_CHECK_NOTHING);
+  n_threads = get_env_uint ("GES_IMAGE_SEQUENCE_THREADS");
+  if (n_threads)
+    g_object_set (src, "n-threads", n_threads, NULL);
 
-  g_signal_connect (G_OBJECT (decodebin), "pad-added",
-      G_CALLBACK (pad_added_cb), bin);
+  window_size = get_env_uint ("GES_IMAGE_SEQUENCE_WINDOW");
+  if (window_size)
+    g_object_set (src, "window-size", window_size, NULL);
 
-  return bin;
+  return src;
 }
 
 static void
@@ -33,7 +33,9 @@
 
 #include <gst/gst.h>
 #include <gst/video/videooverlay.h>
+#include <glib/gstdio.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "ges-internal.h"
 #include "ges-pipeline.h"
@@ -49,6 +51,45 @@ GST_DEBUG_CATEGORY_STATIC (ges_pipeline_debug);
 #define IN_RENDERING_MODE(timeline) ((timeline->priv->mode) & (GES_PIPELINE_MODE_RENDER | GES_PIPELINE_MODE_SMART_RENDER))
 #define CHECK_THREAD(pipeline) g_assert(pipeline->priv->valid_thread == g_thread_self())
 
+/* Quality of the audio resampling in the mixers, from 0 (fastest) to 10
+ * (best): previewing favours speed, rendering the output quality without
+ * the cost of the highest settings */
+#define PREVIEW_RESAMPLE_QUALITY 0
+#define RENDER_RESAMPLE_QUALITY 6
+
+/* Adaptive preview, see GESPipeline:adaptive-preview
+ *  - 1: half the resolution
+ *  - 2: half the resolution and half the framerate
+ *  - 3: quarter of the resolution, half the framerate and decoders skipping
+ *       non-reference frames */
+#define ADAPTIVE_PREVIEW_MAX_QUALITY_LEVEL 3
+/* Number of consecutive late QoS events before lowering quality */
+#define ADAPTIVE_PREVIEW_LATE_THRESHOLD 10
+/* Number of consecutive QoS events with enough headroom before raising
+ * quality back */
+#define ADAPTIVE_PREVIEW_HEADROOM_THRESHOLD 100
+#define ADAPTIVE_PREVIEW_HEADROOM_PROPORTION 0.7
+
+/* Checkpointed rendering, see GESPipeline:render-checkpoint-interval.
+ * Fragments and the manifest are written next to the output file */
+#define CHECKPOINT_FRAGMENT_SUFFIX ".part"
+#define CHECKPOINT_MANIFEST_SUFFIX ".checkpoint"
+#define CHECKPOINT_MANIFEST_GROUP "checkpoint"
+
+/* Time spent by a decoder of a source between receiving data and outputting
+ * the corresponding decoded data, see GESPipeline:render-stats-interval */
+typedef struct
+{
+  gint refcount;
+  gchar *source;
+  gchar *decoder;
+  GstClockTime input_ts;
+  GstClockTime decode_time;
+  guint64 n_frames;
+} DecoderStats;
+
+G_LOCK_DEFINE_STATIC (decoder_stats);
+
 /* Structure corresponding to a timeline - sink link */
 
 typedef struct
@@ -58,6 +99,20 @@ typedef struct
   GstPad *srcpad;               /* Timeline source pad */
   GstPad *playsinkpad;
   GstPad *encodebinpad;
+
+  gulong qos_probe_id;
+
+  /* When rendering with checkpoints, each track is encoded by its own
+   * encodebin feeding the splitmuxsink */
+  GstElement *encodebin;
+  GstPad *splitmuxpad;
+  gulong resume_probe_id;
+
+  /* Render statistics, the position is protected by the srcpad object lock */
+  gulong stats_probe_id;
+  gint n_buffers;
+  gint last_n_buffers;
+  GstClockTime position;
 } OutputChain;
 
 
@@ -78,8 +133,49 @@ struct _GESPipelinePrivate
   GstEncodingProfile *profile;
 
   GThread *valid_thread;
+
+  /* Adaptive preview, protected by the object lock */
+  gboolean adaptive_preview;
+  guint preview_quality;
+  gboolean preview_quality_update_pending;
+  guint n_late_qos;
+  guint n_headroom_qos;
+  /* The video track restriction caps at full quality */
+  GstCaps *preview_restriction_caps;
+  /* The video track restriction caps as lowered for the preview */
+  GstCaps *preview_lowered_caps;
+  /* The video format at full quality the lowered caps are derived from */
+  GstCaps *preview_full_caps;
+
+  /* Checkpointed rendering */
+  gchar *output_uri;
+  GstClockTime checkpoint_interval;
+  /* Only set when rendering with checkpoints */
+  GstElement *splitmuxsink;
+  gchar *checkpoint_location;
+  gchar *checkpoint_fingerprint;
+  /* Timeline positions at which completed fragments end, protected by
+   * the object lock */
+  GArray *checkpoint_ends;
+  GstClockTime resume_position;
+
+  /* Render statistics */
+  GstClockTime stats_interval;
+  GstClockID stats_clock_id;
+  GstClockTime stats_last_sample;
+  GstClockTime stats_last_position;
+  /* Protected by the decoder_stats lock */
+  GList *decoder_stats;
+  /* Protected by the object lock */
+  GstStructure *render_stats;
 };
 
+typedef struct
+{
+  GESPipeline *pipeline;
+  gint step;
+} PreviewQualityUpdate;
+
 enum
 {
   PROP_0,
@@ -89,6 +185,10 @@ enum
   PROP_MODE,
   PROP_AUDIO_FILTER,
   PROP_VIDEO_FILTER,
+  PROP_ADAPTIVE_PREVIEW,
+  PROP_PREVIEW_QUALITY,
+  PROP_RENDER_CHECKPOINT_INTERVAL,
+  PROP_RENDER_STATS_INTERVAL,
   PROP_LAST
 };
 
@@ -96,6 +196,10 @@ static GParamSpec *properties[PROP_LAST];
 
 static GstStateChangeReturn ges_pipeline_change_state (GstElement *
     element, GstStateChange transition);
+static gboolean ges_pipeline_post_message (GstElement * element,
+    GstMessage * message);
+static void ges_pipeline_deep_element_added (GstBin * bin, GstBin * sub_bin,
+    GstElement * child);
 
 static OutputChain *get_output_chain_for_track (GESPipeline * self,
     GESTrack * track);
@@ -103,6 +207,9 @@ static OutputChain *new_output_chain_for_track (GESPipeline * self,
     GESTrack * track);
 static void _link_track (GESPipeline * self, GESTrack * track);
 static void _unlink_track (GESPipeline * self, GESTrack * track);
+static void _unlock_unused_tracks (GESPipeline * self);
+static void _set_preview_quality (GESPipeline * self, guint level);
+static gboolean _update_preview_quality (PreviewQualityUpdate * update);
 
 /****************************************************
  *    Video Overlay vmethods implementation         *
@@ -187,6 +294,22 @@ ges_pipeline_get_property (GObject * object, guint property_id,
       g_object_get_property (G_OBJECT (self->priv->playsink), "video-filter",
           value);
       break;
+    case PROP_ADAPTIVE_PREVIEW:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->priv->adaptive_preview);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PREVIEW_QUALITY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->priv->preview_quality);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_RENDER_CHECKPOINT_INTERVAL:
+      g_value_set_uint64 (value, self->priv->checkpoint_interval);
+      break;
+    case PROP_RENDER_STATS_INTERVAL:
+      g_value_set_uint64 (value, self->priv->stats_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -222,6 +345,33 @@ ges_pipeline_set_property (GObject * object, guint property_id,
       g_object_set (self->priv->playsink, "video-filter",
           GST_ELEMENT (g_value_get_object (value)), NULL);
       break;
+    case PROP_ADAPTIVE_PREVIEW:
+      GST_OBJECT_LOCK (self);
+      self->priv->adaptive_preview = g_value_get_boolean (value);
+      self->priv->n_late_qos = self->priv->n_headroom_qos = 0;
+      GST_OBJECT_UNLOCK (self);
+
+      if (self->priv->adaptive_preview)
+        break;
+
+      /* The tracks can only be modified from the thread the pipeline was
+       * created in */
+      if (self->priv->valid_thread == g_thread_self ()) {
+        _set_preview_quality (self, 0);
+      } else {
+        PreviewQualityUpdate *update = g_slice_new (PreviewQualityUpdate);
+
+        update->pipeline = gst_object_ref (self);
+        update->step = 0;
+        g_idle_add ((GSourceFunc) _update_preview_quality, update);
+      }
+      break;
+    case PROP_RENDER_CHECKPOINT_INTERVAL:
+      self->priv->checkpoint_interval = g_value_get_uint64 (value);
+      break;
+    case PROP_RENDER_STATS_INTERVAL:
+      self->priv->stats_interval = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -244,6 +394,30 @@ _timeline_track_removed_cb (GESTimeline * timeline, GESTrack * track,
   _unlink_track (pipeline, track);
 }
 
+static void
+_decoder_stats_unref (DecoderStats * stats)
+{
+  if (!g_atomic_int_dec_and_test (&stats->refcount))
+    return;
+
+  g_free (stats->source);
+  g_free (stats->decoder);
+  g_slice_free (DecoderStats, stats);
+}
+
+static void
+_clear_decoder_stats (GESPipeline * self)
+{
+  GList *decoder_stats;
+
+  G_LOCK (decoder_stats);
+  decoder_stats = self->priv->decoder_stats;
+  self->priv->decoder_stats = NULL;
+  G_UNLOCK (decoder_stats);
+
+  g_list_free_full (decoder_stats, (GDestroyNotify) _decoder_stats_unref);
+}
+
 static void
 ges_pipeline_dispose (GObject * object)
 {
@@ -271,6 +445,19 @@ ges_pipeline_dispose (GObject * object)
     self->priv->profile = NULL;
   }
 
+  gst_caps_replace (&self->priv->preview_restriction_caps, NULL);
+  gst_caps_replace (&self->priv->preview_lowered_caps, NULL);
+  gst_caps_replace (&self->priv->preview_full_caps, NULL);
+
+  gst_clear_object (&self->priv->splitmuxsink);
+  g_clear_pointer (&self->priv->output_uri, g_free);
+  g_clear_pointer (&self->priv->checkpoint_location, g_free);
+  g_clear_pointer (&self->priv->checkpoint_fingerprint, g_free);
+  g_clear_pointer (&self->priv->checkpoint_ends, g_array_unref);
+
+  _clear_decoder_stats (self);
+  g_clear_pointer (&self->priv->render_stats, gst_structure_free);
+
   if (self->priv->timeline) {
     g_signal_handlers_disconnect_by_func (self->priv->timeline,
         _timeline_track_added_cb, self);
@@ -282,16 +469,28 @@ ges_pipeline_dispose (GObject * object)
   G_OBJECT_CLASS (ges_pipeline_parent_class)->dispose (object);
 }
 
+static void
+ges_pipeline_finalize (GObject * object)
+{
+  GESPipeline *self = GES_PIPELINE (object);
+
+  g_mutex_clear (&self->priv->dyn_mutex);
+
+  G_OBJECT_CLASS (ges_pipeline_parent_class)->finalize (object);
+}
+
 static void
 ges_pipeline_class_init (GESPipelineClass * klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBinClass *bin_class = GST_BIN_CLASS (klass);
 
   GST_DEBUG_CATEGORY_INIT (ges_pipeline_debug, "gespipeline",
       GST_DEBUG_FG_YELLOW, "ges pipeline");
 
   object_class->dispose = ges_pipeline_dispose;
+  object_class->finalize = ges_pipeline_finalize;
   object_class->get_property = ges_pipeline_get_property;
   object_class->set_property = ges_pipeline_set_property;
 
@@ -359,9 +558,98 @@ ges_pipeline_class_init (GESPipelineClass * klass)
       "the Video filter(s) to apply, if possible", GST_TYPE_ELEMENT,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GESPipeline:adaptive-preview:
+   *
+   * Whether to lower the quality of the video preview when the pipeline
+   * can not keep up with realtime, as reported by QoS events. The resolution,
+   * then the framerate of the video track are lowered and decoders are asked
+   * to skip non-reference frames. Quality is raised back when there is enough
+   * headroom. See #GESPipeline:preview-quality.
+   *
+   * Since: 1.16
+   */
+  properties[PROP_ADAPTIVE_PREVIEW] =
+      g_param_spec_boolean ("adaptive-preview", "Adaptive preview",
+      "Lower the video preview quality when falling behind realtime", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GESPipeline:preview-quality:
+   *
+   * The current quality level of the video preview, 0 being full quality.
+   * It can only be different from 0 when #GESPipeline:adaptive-preview is
+   * %TRUE.
+   *
+   * Since: 1.16
+   */
+  properties[PROP_PREVIEW_QUALITY] =
+      g_param_spec_uint ("preview-quality", "Preview quality",
+      "The current quality level of the video preview, 0 being full quality",
+      0, ADAPTIVE_PREVIEW_MAX_QUALITY_LEVEL, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GESPipeline:render-checkpoint-interval:
+   *
+   * When different from 0, rendering in #GES_PIPELINE_MODE_RENDER to a local
+   * file with a container profile is done in independently decodable
+   * fragments of that duration, written next to the output file, and a
+   * manifest of the completed fragments is kept up to date. If rendering
+   * stops before the end, rendering the same timeline with the same profile
+   * to the same file later continues after the last completed fragment.
+   * Once everything has been rendered, the fragments are concatenated into
+   * the output file without reencoding and removed, before
+   * %GST_MESSAGE_EOS is posted.
+   *
+   * This needs to be set before switching to #GES_PIPELINE_MODE_RENDER.
+   *
+   * Since: 1.16
+   */
+  properties[PROP_RENDER_CHECKPOINT_INTERVAL] =
+      g_param_spec_uint64 ("render-checkpoint-interval",
+      "Render checkpoint interval",
+      "Duration of the fragments to render in, 0 meaning no checkpoints",
+      0, G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GESPipeline:render-stats-interval:
+   *
+   * When different from 0, statistics about the rendering are sampled at
+   * that interval while rendering and posted on the bus as a
+   * %GST_MESSAGE_ELEMENT with a "ges-render-stats" structure, the last one
+   * being available through ges_pipeline_get_render_stats(). It contains:
+   *
+   *  - "position" (#GstClockTime): the furthest position rendered
+   *  - "realtime-factor" (#gdouble): how much faster than realtime
+   *    rendering progressed since the previous sample
+   *  - "tracks" (#GstValueArray of #GstStructure): for each rendered track,
+   *    its "type", its output "fps" (buffers per second) and total
+   *    "buffers", the number of "stack-switches" of its composition and the
+   *    "stack-switch-time" spent setting up new stacks
+   *  - "queues" (#GstValueArray of #GstStructure): the "name", "fill"
+   *    proportion (from 0.0 to 1.0), "level-time" and "level-buffers" of
+   *    the queues in the encoding part of the pipeline
+   *  - "sources" (#GstValueArray of #GstStructure): for each decoder, the
+   *    "source" it decodes for, its name as "decoder", the "decode-time"
+   *    it used and the number of "frames" it output
+   *
+   * This needs to be set before the pipeline goes to %GST_STATE_PAUSED.
+   *
+   * Since: 1.16
+   */
+  properties[PROP_RENDER_STATS_INTERVAL] =
+      g_param_spec_uint64 ("render-stats-interval", "Render stats interval",
+      "Interval at which render statistics are posted, 0 meaning never",
+      0, G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (object_class, PROP_LAST, properties);
 
   element_class->change_state = GST_DEBUG_FUNCPTR (ges_pipeline_change_state);
+  element_class->post_message = GST_DEBUG_FUNCPTR (ges_pipeline_post_message);
+
+  bin_class->deep_element_added =
+      GST_DEBUG_FUNCPTR (ges_pipeline_deep_element_added);
 
   /* TODO : Add state_change handlers
    * Don't change state if we don't have a timeline */
@@ -373,6 +661,9 @@ ges_pipeline_init (GESPipeline * self)
   GST_INFO_OBJECT (self, "Creating new 'playsink'");
   self->priv = ges_pipeline_get_instance_private (self);
   self->priv->valid_thread = g_thread_self ();
+  self->priv->checkpoint_ends = g_array_new (FALSE, FALSE,
+      sizeof (GstClockTime));
+  g_mutex_init (&self->priv->dyn_mutex);
 
   self->priv->playsink =
       gst_element_factory_make ("playsink", "internal-sinks");
@@ -525,7 +816,7 @@ _link_tracks (GESPipeline * pipeline)
   for (tmp = pipeline->priv->timeline->tracks; tmp; tmp = tmp->next)
     _link_track (pipeline, tmp->data);
 
-  if (IN_RENDERING_MODE (pipeline)) {
+  if (IN_RENDERING_MODE (pipeline) && !pipeline->priv->splitmuxsink) {
     GString *unlinked_issues = NULL;
     GstIterator *pads;
     gboolean done = FALSE;
@@ -576,6 +867,18 @@ _link_tracks (GESPipeline * pipeline)
   }
 }
 
+/* Makes uri sources play the proxy of their media (if any) in preview
+ * modes and the original media in render modes. Clips keep their asset so
+ * that saving the project after a preview does not reference proxies. */
+static void
+_update_proxies (GESPipeline * self)
+{
+  if (!self->priv->timeline)
+    return;
+
+  timeline_set_use_proxies (self->priv->timeline, !IN_RENDERING_MODE (self));
+}
+
 static void
 _unlink_tracks (GESPipeline * pipeline)
 {
@@ -592,6 +895,861 @@ _unlink_tracks (GESPipeline * pipeline)
     _unlink_track (pipeline, tmp->data);
 }
 
+/*
+ * Checkpointed rendering
+ *
+ * Tracks are encoded separately and muxed by a splitmuxsink into fragments
+ * starting with a keyframe. Each time a fragment is closed, the position it
+ * ends at is saved in the manifest, along with a fingerprint of the timeline
+ * and profile. When rendering again, the fragments listed in a matching
+ * manifest are kept and rendering starts at the end of the last one.
+ */
+static gchar *
+_checkpoint_manifest_path (GESPipeline * self)
+{
+  return g_strconcat (self->priv->checkpoint_location,
+      CHECKPOINT_MANIFEST_SUFFIX, NULL);
+}
+
+static GstElement *
+_make_muxer (GstEncodingProfile * profile)
+{
+  GstElement *muxer, *tmp =
+      get_element_for_encoding_profile (profile,
+      GST_ELEMENT_FACTORY_TYPE_MUXER);
+
+  if (!tmp)
+    return NULL;
+
+  muxer = gst_element_factory_create (gst_element_get_factory (tmp), NULL);
+  gst_object_unref (tmp);
+
+  return muxer;
+}
+
+static void
+_checksum_take_string (GChecksum * checksum, gchar * str)
+{
+  g_checksum_update (checksum, (const guchar *) str, -1);
+  g_free (str);
+}
+
+static void
+_checksum_caps (GChecksum * checksum, const GstCaps * caps)
+{
+  if (caps)
+    _checksum_take_string (checksum, gst_caps_to_string (caps));
+}
+
+static void
+_checksum_profile (GChecksum * checksum, GstEncodingProfile * profile)
+{
+  GstCaps *caps;
+
+  _checksum_take_string (checksum, g_strdup_printf ("%s %s %s",
+          G_OBJECT_TYPE_NAME (profile),
+          GST_STR_NULL (gst_encoding_profile_get_preset (profile)),
+          GST_STR_NULL (gst_encoding_profile_get_preset_name (profile))));
+
+  caps = gst_encoding_profile_get_format (profile);
+  _checksum_caps (checksum, caps);
+  gst_caps_unref (caps);
+
+  if ((caps = gst_encoding_profile_get_restriction (profile))) {
+    _checksum_caps (checksum, caps);
+    gst_caps_unref (caps);
+  }
+
+  if (GST_IS_ENCODING_CONTAINER_PROFILE (profile)) {
+    const GList *tmp =
+        gst_encoding_container_profile_get_profiles
+        (GST_ENCODING_CONTAINER_PROFILE (profile));
+
+    for (; tmp; tmp = tmp->next)
+      _checksum_profile (checksum, tmp->data);
+  }
+}
+
+static void
+_checksum_element (GChecksum * checksum, GESTimelineElement * element)
+{
+  guint i, n_specs;
+  GParamSpec **specs;
+  GESAsset *asset = ges_extractable_get_asset (GES_EXTRACTABLE (element));
+
+  _checksum_take_string (checksum, g_strdup_printf ("%s %s %" G_GUINT64_FORMAT
+          " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %u %d",
+          G_OBJECT_TYPE_NAME (element), asset ? ges_asset_get_id (asset) : "",
+          element->start, element->inpoint, element->duration,
+          element->priority, GES_IS_TRACK_ELEMENT (element) ?
+          ges_track_element_is_active (GES_TRACK_ELEMENT (element)) : TRUE));
+
+  specs = ges_timeline_element_list_children_properties (element, &n_specs);
+  for (i = 0; i < n_specs; i++) {
+    gchar *serialized;
+    GValue value = G_VALUE_INIT;
+
+    g_value_init (&value, specs[i]->value_type);
+    ges_timeline_element_get_child_property_by_pspec (element, specs[i],
+        &value);
+    serialized = gst_value_serialize (&value);
+    _checksum_take_string (checksum, g_strdup_printf ("%s=%s", specs[i]->name,
+            GST_STR_NULL (serialized)));
+    g_free (serialized);
+    g_value_unset (&value);
+    g_param_spec_unref (specs[i]);
+  }
+  g_free (specs);
+}
+
+/* Identifies what is being rendered, so that fragments from a different
+ * timeline or profile are never reused */
+static gchar *
+_checkpoint_compute_fingerprint (GESPipeline * self)
+{
+  gchar *fingerprint;
+  GList *layers, *ltmp, *clips, *ctmp, *children, *tmp;
+  GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
+
+  _checksum_profile (checksum, self->priv->profile);
+
+  for (tmp = self->priv->timeline->tracks; tmp; tmp = tmp->next) {
+    GstCaps *restriction_caps;
+
+    g_object_get (tmp->data, "restriction-caps", &restriction_caps, NULL);
+    _checksum_caps (checksum, restriction_caps);
+    gst_clear_caps (&restriction_caps);
+  }
+
+  layers = ges_timeline_get_layers (self->priv->timeline);
+  for (ltmp = layers; ltmp; ltmp = ltmp->next) {
+    _checksum_take_string (checksum, g_strdup_printf ("layer %u",
+            ges_layer_get_priority (ltmp->data)));
+
+    clips = ges_layer_get_clips (ltmp->data);
+    for (ctmp = clips; ctmp; ctmp = ctmp->next) {
+      _checksum_element (checksum, ctmp->data);
+
+      children = ges_container_get_children (GES_CONTAINER (ctmp->data), FALSE);
+      for (tmp = children; tmp; tmp = tmp->next)
+        _checksum_element (checksum, tmp->data);
+      g_list_free_full (children, gst_object_unref);
+    }
+    g_list_free_full (clips, gst_object_unref);
+  }
+  g_list_free_full (layers, gst_object_unref);
+
+  fingerprint = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  return fingerprint;
+}
+
+static void
+_checkpoint_save_manifest (GESPipeline * self)
+{
+  guint i;
+  gchar **fragments;
+  GError *err = NULL;
+  GKeyFile *manifest = g_key_file_new ();
+  gchar *path = _checkpoint_manifest_path (self);
+
+  GST_OBJECT_LOCK (self);
+  fragments = g_new0 (gchar *, self->priv->checkpoint_ends->len + 1);
+  for (i = 0; i < self->priv->checkpoint_ends->len; i++)
+    fragments[i] = g_strdup_printf ("%" G_GUINT64_FORMAT,
+        g_array_index (self->priv->checkpoint_ends, GstClockTime, i));
+  GST_OBJECT_UNLOCK (self);
+
+  g_key_file_set_string (manifest, CHECKPOINT_MANIFEST_GROUP, "fingerprint",
+      self->priv->checkpoint_fingerprint);
+  g_key_file_set_string_list (manifest, CHECKPOINT_MANIFEST_GROUP,
+      "fragments", (const gchar * const *) fragments, i);
+
+  if (!g_key_file_save_to_file (manifest, path, &err)) {
+    GST_WARNING_OBJECT (self, "Could not save checkpoint manifest %s: %s",
+        path, err->message);
+    g_clear_error (&err);
+  }
+
+  g_strfreev (fragments);
+  g_key_file_free (manifest);
+  g_free (path);
+}
+
+/* Returns the number of completed fragments that can be reused */
+static guint
+_checkpoint_load_manifest (GESPipeline * self)
+{
+  gsize i, n_fragments = 0;
+  gchar *fingerprint, **fragments = NULL;
+  GstClockTime end, last_end = 0;
+  GKeyFile *manifest = g_key_file_new ();
+  gchar *path = _checkpoint_manifest_path (self);
+
+  if (!g_key_file_load_from_file (manifest, path, G_KEY_FILE_NONE, NULL))
+    goto done;
+
+  fingerprint = g_key_file_get_string (manifest, CHECKPOINT_MANIFEST_GROUP,
+      "fingerprint", NULL);
+  if (g_strcmp0 (fingerprint, self->priv->checkpoint_fingerprint)) {
+    GST_INFO_OBJECT (self, "%s does not match what is being rendered", path);
+    g_free (fingerprint);
+    goto done;
+  }
+  g_free (fingerprint);
+
+  fragments = g_key_file_get_string_list (manifest, CHECKPOINT_MANIFEST_GROUP,
+      "fragments", &n_fragments, NULL);
+  for (i = 0; i < n_fragments; i++) {
+    gchar *fragment = g_strdup_printf ("%s" CHECKPOINT_FRAGMENT_SUFFIX "%05u",
+        self->priv->checkpoint_location, (guint) i);
+    gboolean exists = g_file_test (fragment, G_FILE_TEST_IS_REGULAR);
+
+    g_free (fragment);
+    end = g_ascii_strtoull (fragments[i], NULL, 10);
+    if (!exists || !GST_CLOCK_TIME_IS_VALID (end) || end <= last_end)
+      break;
+
+    g_array_append_val (self->priv->checkpoint_ends, end);
+    last_end = end;
+  }
+  n_fragments = i;
+
+done:
+  g_strfreev (fragments);
+  g_key_file_free (manifest);
+  g_free (path);
+
+  return n_fragments;
+}
+
+/* Removes the fragments from @first_index on */
+static void
+_checkpoint_remove_fragments (GESPipeline * self, guint first_index)
+{
+  GDir *dir;
+  const gchar *name;
+  gchar *dirname = g_path_get_dirname (self->priv->checkpoint_location);
+  gchar *basename = g_path_get_basename (self->priv->checkpoint_location);
+  gchar *prefix = g_strconcat (basename, CHECKPOINT_FRAGMENT_SUFFIX, NULL);
+  gsize prefix_len = strlen (prefix);
+
+  if (!(dir = g_dir_open (dirname, 0, NULL)))
+    goto done;
+
+  while ((name = g_dir_read_name (dir))) {
+    gchar *end, *path;
+    guint64 index;
+
+    if (!g_str_has_prefix (name, prefix) || !name[prefix_len])
+      continue;
+
+    index = g_ascii_strtoull (name + prefix_len, &end, 10);
+    if (*end || index < first_index)
+      continue;
+
+    path = g_build_filename (dirname, name, NULL);
+    GST_DEBUG_OBJECT (self, "Removing fragment %s", path);
+    g_unlink (path);
+    g_free (path);
+  }
+  g_dir_close (dir);
+
+done:
+  g_free (prefix);
+  g_free (basename);
+  g_free (dirname);
+}
+
+/* Creates the splitmuxsink, returns %FALSE if the render can not be
+ * checkpointed with the current settings */
+static gboolean
+_checkpoint_setup (GESPipeline * self, GESPipelineFlags mode)
+{
+  gchar *location, *pattern;
+  GstElement *muxer, *splitmuxsink;
+
+  if (!self->priv->checkpoint_interval || !(mode & GES_PIPELINE_MODE_RENDER)
+      || (mode & GES_PIPELINE_MODE_SMART_RENDER))
+    return FALSE;
+
+  if (!self->priv->output_uri ||
+      !GST_IS_ENCODING_CONTAINER_PROFILE (self->priv->profile) ||
+      !(location = g_filename_from_uri (self->priv->output_uri, NULL, NULL))) {
+    GST_WARNING_OBJECT (self, "Checkpoints are only possible when rendering "
+        "to a local file with a container profile");
+    return FALSE;
+  }
+
+  muxer = _make_muxer (self->priv->profile);
+  splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
+  if (!muxer || !splitmuxsink) {
+    GST_WARNING_OBJECT (self, "Missing elements to render with checkpoints");
+    gst_clear_object (&muxer);
+    gst_clear_object (&splitmuxsink);
+    g_free (location);
+    return FALSE;
+  }
+
+  pattern = g_strconcat (location, CHECKPOINT_FRAGMENT_SUFFIX "%05d", NULL);
+  g_object_set (splitmuxsink, "location", pattern, "muxer", muxer,
+      "max-size-time", self->priv->checkpoint_interval,
+      "send-keyframe-requests", TRUE, NULL);
+  g_free (pattern);
+
+  g_free (self->priv->checkpoint_location);
+  self->priv->checkpoint_location = location;
+  self->priv->splitmuxsink = gst_object_ref_sink (splitmuxsink);
+
+  return TRUE;
+}
+
+/* Drops whatever is rendered before the seek to the resume position */
+static GstPadProbeReturn
+_resume_probe_cb (GstPad * pad, GstPadProbeInfo * info, OutputChain * chain)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    return GST_PAD_PROBE_DROP;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_FLUSH_STOP) {
+    chain->resume_probe_id = 0;
+
+    return GST_PAD_PROBE_REMOVE;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+_checkpoint_prepare (GESPipeline * self)
+{
+  GList *tmp;
+  guint n_fragments;
+
+  g_free (self->priv->checkpoint_fingerprint);
+  self->priv->checkpoint_fingerprint = _checkpoint_compute_fingerprint (self);
+
+  GST_OBJECT_LOCK (self);
+  g_array_set_size (self->priv->checkpoint_ends, 0);
+  GST_OBJECT_UNLOCK (self);
+
+  n_fragments = _checkpoint_load_manifest (self);
+  _checkpoint_remove_fragments (self, n_fragments);
+  _checkpoint_save_manifest (self);
+
+  self->priv->resume_position = n_fragments ?
+      g_array_index (self->priv->checkpoint_ends, GstClockTime,
+      n_fragments - 1) : 0;
+  g_object_set (self->priv->splitmuxsink, "start-index", n_fragments, NULL);
+
+  if (!self->priv->resume_position)
+    return;
+
+  GST_INFO_OBJECT (self, "Resuming render after %u fragments at %"
+      GST_TIME_FORMAT, n_fragments,
+      GST_TIME_ARGS (self->priv->resume_position));
+
+  for (tmp = self->priv->chains; tmp; tmp = tmp->next) {
+    OutputChain *chain = tmp->data;
+
+    if (chain->encodebin && !chain->resume_probe_id)
+      chain->resume_probe_id = gst_pad_add_probe (chain->srcpad,
+          GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+          GST_PAD_PROBE_TYPE_EVENT_FLUSH, (GstPadProbeCallback)
+          _resume_probe_cb, chain, NULL);
+  }
+}
+
+static void
+_checkpoint_seek_resume_position (GESPipeline * self)
+{
+  GList *tmp;
+  GstEvent *seek = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, GST_SEEK_TYPE_SET,
+      self->priv->resume_position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+
+  for (tmp = self->priv->chains; tmp; tmp = tmp->next) {
+    OutputChain *chain = tmp->data;
+
+    if (chain->resume_probe_id &&
+        !gst_pad_send_event (chain->srcpad, gst_event_ref (seek)))
+      GST_ELEMENT_ERROR (self, CORE, SEEK, (NULL),
+          ("Could not seek %" GST_PTR_FORMAT " to resume rendering",
+              chain->track));
+  }
+  gst_event_unref (seek);
+}
+
+static void
+_checkpoint_fragment_closed (GESPipeline * self, GstMessage * message)
+{
+  GstClockTime running_time, end;
+  const GstStructure *structure = gst_message_get_structure (message);
+
+  if (!gst_structure_get_clock_time (structure, "running-time", &running_time))
+    return;
+
+  end = self->priv->resume_position + running_time;
+  GST_INFO_OBJECT (self, "%s completed, rendered up to %" GST_TIME_FORMAT,
+      gst_structure_get_string (structure, "location"), GST_TIME_ARGS (end));
+
+  GST_OBJECT_LOCK (self);
+  g_array_append_val (self->priv->checkpoint_ends, end);
+  GST_OBJECT_UNLOCK (self);
+
+  _checkpoint_save_manifest (self);
+}
+
+static void
+_stitch_pad_added_cb (GstElement * src, GstPad * pad, GstElement * muxer)
+{
+  GstPad *sinkpad = gst_element_get_compatible_pad (muxer, pad, NULL);
+
+  if (!sinkpad || gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_ERROR_OBJECT (muxer, "Could not link %" GST_PTR_FORMAT, pad);
+
+  gst_clear_object (&sinkpad);
+}
+
+/* Concatenates the fragments into the output file without reencoding,
+ * then lets the EOS through */
+static gpointer
+_checkpoint_stitch (GESPipeline * self)
+{
+  GstBus *bus;
+  gchar *pattern;
+  GstMessage *msg;
+  GError *err = NULL;
+  GstElement *pipeline = gst_pipeline_new ("ges-stitcher");
+  GstElement *src = gst_element_factory_make ("splitmuxsrc", NULL);
+  GstElement *muxer = _make_muxer (self->priv->profile);
+  GstElement *sink = gst_element_make_from_uri (GST_URI_SINK,
+      self->priv->output_uri, NULL, &err);
+
+  if (!src || !muxer || !sink) {
+    if (!err)
+      err = g_error_new_literal (GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+          "Missing elements to stitch the fragments");
+    gst_clear_object (&src);
+    gst_clear_object (&muxer);
+    gst_clear_object (&sink);
+    gst_object_unref (pipeline);
+    goto done;
+  }
+
+  pattern = g_strconcat (self->priv->checkpoint_location,
+      CHECKPOINT_FRAGMENT_SUFFIX "*", NULL);
+  g_object_set (src, "location", pattern, NULL);
+  g_free (pattern);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, muxer, sink, NULL);
+  gst_element_link (muxer, sink);
+  g_signal_connect (src, "pad-added", G_CALLBACK (_stitch_pad_added_cb), muxer);
+
+  bus = gst_element_get_bus (pipeline);
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  else
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+  if (!msg)
+    err = g_error_new_literal (GST_CORE_ERROR, GST_CORE_ERROR_STATE_CHANGE,
+        "Could not start stitching the fragments");
+  else if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+    gst_message_parse_error (msg, &err, NULL);
+
+  if (msg)
+    gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+done:
+  if (err) {
+    GST_ELEMENT_ERROR (self, RESOURCE, WRITE, (NULL),
+        ("Could not stitch the rendered fragments: %s", err->message));
+    g_error_free (err);
+  } else {
+    gchar *manifest = _checkpoint_manifest_path (self);
+
+    GST_INFO_OBJECT (self, "Fragments stitched into %s",
+        self->priv->output_uri);
+    _checkpoint_remove_fragments (self, 0);
+    g_unlink (manifest);
+    g_free (manifest);
+
+    GST_ELEMENT_CLASS (ges_pipeline_parent_class)->post_message
+        (GST_ELEMENT (self), gst_message_new_eos (GST_OBJECT (self)));
+  }
+  gst_object_unref (self);
+
+  return NULL;
+}
+
+static gboolean
+ges_pipeline_post_message (GstElement * element, GstMessage * message)
+{
+  GESPipeline *self = GES_PIPELINE (element);
+
+  if (self->priv->splitmuxsink) {
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ELEMENT &&
+        GST_MESSAGE_SRC (message) == GST_OBJECT (self->priv->splitmuxsink) &&
+        gst_message_has_name (message, "splitmuxsink-fragment-closed")) {
+      _checkpoint_fragment_closed (self, message);
+    } else if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS &&
+        GST_MESSAGE_SRC (message) == GST_OBJECT (self)) {
+      GST_INFO_OBJECT (self, "All fragments rendered, stitching them");
+      g_thread_unref (g_thread_new ("ges-stitcher",
+              (GThreadFunc) _checkpoint_stitch, gst_object_ref (self)));
+      gst_message_unref (message);
+
+      return TRUE;
+    }
+  }
+
+  return GST_ELEMENT_CLASS (ges_pipeline_parent_class)->post_message (element,
+      message);
+}
+
+/*
+ * Render statistics
+ */
+static GstPadProbeReturn
+_decoder_input_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    DecoderStats * stats)
+{
+  G_LOCK (decoder_stats);
+  if (!GST_CLOCK_TIME_IS_VALID (stats->input_ts))
+    stats->input_ts = gst_util_get_timestamp ();
+  G_UNLOCK (decoder_stats);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+_decoder_output_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    DecoderStats * stats)
+{
+  G_LOCK (decoder_stats);
+  if (GST_CLOCK_TIME_IS_VALID (stats->input_ts)) {
+    stats->decode_time += gst_util_get_timestamp () - stats->input_ts;
+    stats->input_ts = GST_CLOCK_TIME_NONE;
+  }
+  stats->n_frames++;
+  G_UNLOCK (decoder_stats);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+_watch_decoder (GESPipeline * self, GstElement * decoder)
+{
+  GstObject *parent, *tmp;
+  GstPad *sinkpad, *srcpad;
+  DecoderStats *stats;
+  GESTimelineElement *source = NULL;
+  const gchar *klass = gst_element_class_get_metadata (GST_ELEMENT_GET_CLASS
+      (decoder), GST_ELEMENT_METADATA_KLASS);
+
+  if (!klass || !strstr (klass, "Decoder"))
+    return;
+
+  sinkpad = gst_element_get_static_pad (decoder, "sink");
+  srcpad = gst_element_get_static_pad (decoder, "src");
+  if (!sinkpad || !srcpad)
+    goto done;
+
+  stats = g_slice_new0 (DecoderStats);
+  stats->refcount = 3;
+  stats->input_ts = GST_CLOCK_TIME_NONE;
+  stats->decoder = gst_object_get_name (GST_OBJECT (decoder));
+
+  /* Find the GESTrackElement owning the NleObject the decoder is in */
+  parent = gst_object_get_parent (GST_OBJECT (decoder));
+  while (parent && !source) {
+    source = g_object_get_qdata (G_OBJECT (parent),
+        NLE_OBJECT_TRACK_ELEMENT_QUARK);
+    if (source && source->parent)
+      source = source->parent;
+    if (source)
+      stats->source = g_strdup (GES_TIMELINE_ELEMENT_NAME (source));
+
+    tmp = gst_object_get_parent (parent);
+    gst_object_unref (parent);
+    parent = tmp;
+  }
+  gst_clear_object (&parent);
+
+  GST_DEBUG_OBJECT (self, "Measuring decode time of %s for %s",
+      stats->decoder, GST_STR_NULL (stats->source));
+
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) _decoder_input_probe_cb, stats,
+      (GDestroyNotify) _decoder_stats_unref);
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) _decoder_output_probe_cb, stats,
+      (GDestroyNotify) _decoder_stats_unref);
+
+  G_LOCK (decoder_stats);
+  self->priv->decoder_stats = g_list_prepend (self->priv->decoder_stats, stats);
+  G_UNLOCK (decoder_stats);
+
+done:
+  gst_clear_object (&sinkpad);
+  gst_clear_object (&srcpad);
+}
+
+static void
+ges_pipeline_deep_element_added (GstBin * bin, GstBin * sub_bin,
+    GstElement * child)
+{
+  GESPipeline *self = GES_PIPELINE (bin);
+
+  if (self->priv->stats_interval && IN_RENDERING_MODE (self))
+    _watch_decoder (self, child);
+
+  if (GST_BIN_CLASS (ges_pipeline_parent_class)->deep_element_added)
+    GST_BIN_CLASS (ges_pipeline_parent_class)->deep_element_added (bin,
+        sub_bin, child);
+}
+
+static GstPadProbeReturn
+_output_stats_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    OutputChain * chain)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  g_atomic_int_inc (&chain->n_buffers);
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer)) {
+    GST_OBJECT_LOCK (pad);
+    chain->position = GST_BUFFER_PTS (buffer) +
+        (GST_BUFFER_DURATION_IS_VALID (buffer) ?
+        GST_BUFFER_DURATION (buffer) : 0);
+    GST_OBJECT_UNLOCK (pad);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+_append_structure (GValue * array, GstStructure * structure)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, GST_TYPE_STRUCTURE);
+  gst_value_set_structure (&value, structure);
+  gst_value_array_append_and_take_value (array, &value);
+  gst_structure_free (structure);
+}
+
+static void
+_append_queue_stats (const GValue * item, GValue * queues)
+{
+  gdouble fill = 0.0;
+  gchar *path;
+  guint level_buffers, max_buffers, level_bytes, max_bytes;
+  guint64 level_time, max_time;
+  GstElement *element = g_value_get_object (item);
+
+  if (!g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+          "current-level-time") ||
+      !g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+          "max-size-time"))
+    return;
+
+  g_object_get (element, "current-level-buffers", &level_buffers,
+      "max-size-buffers", &max_buffers, "current-level-bytes", &level_bytes,
+      "max-size-bytes", &max_bytes, "current-level-time", &level_time,
+      "max-size-time", &max_time, NULL);
+
+  if (max_buffers)
+    fill = MAX (fill, (gdouble) level_buffers / max_buffers);
+  if (max_bytes)
+    fill = MAX (fill, (gdouble) level_bytes / max_bytes);
+  if (max_time)
+    fill = MAX (fill, (gdouble) level_time / max_time);
+
+  path = gst_object_get_path_string (GST_OBJECT (element));
+  _append_structure (queues, gst_structure_new ("queue",
+          "name", G_TYPE_STRING, path,
+          "fill", G_TYPE_DOUBLE, MIN (fill, 1.0),
+          "level-time", GST_TYPE_CLOCK_TIME, level_time,
+          "level-buffers", G_TYPE_UINT, level_buffers, NULL));
+  g_free (path);
+}
+
+static void
+_append_encoder_queues_stats (GstElement * encodebin, GValue * queues)
+{
+  GstIterator *it = gst_bin_iterate_recurse (GST_BIN (encodebin));
+
+  gst_iterator_foreach (it, (GstIteratorForeachFunction) _append_queue_stats,
+      queues);
+  gst_iterator_free (it);
+}
+
+static GstStructure *
+_sample_render_stats (GESPipeline * self)
+{
+  GList *tmp;
+  GstStructure *stats;
+  GstClockTime position = 0, now = gst_util_get_timestamp ();
+  GValue tracks = G_VALUE_INIT, queues = G_VALUE_INIT, sources = G_VALUE_INIT;
+  gdouble elapsed = (gdouble) (now - self->priv->stats_last_sample) /
+      GST_SECOND;
+
+  g_value_init (&tracks, GST_TYPE_ARRAY);
+  g_value_init (&queues, GST_TYPE_ARRAY);
+  g_value_init (&sources, GST_TYPE_ARRAY);
+
+  g_mutex_lock (&self->priv->dyn_mutex);
+  for (tmp = self->priv->chains; tmp; tmp = tmp->next) {
+    OutputChain *chain = tmp->data;
+    GstElement *composition = ges_track_get_composition (chain->track);
+    guint64 n_switches = 0, switch_time = 0;
+    GstClockTime chain_position;
+    gint n_buffers;
+
+    if (!chain->stats_probe_id)
+      continue;
+
+    GST_OBJECT_LOCK (chain->srcpad);
+    chain_position = chain->position;
+    GST_OBJECT_UNLOCK (chain->srcpad);
+    n_buffers = g_atomic_int_get (&chain->n_buffers);
+
+    if (composition)
+      g_object_get (composition, "stack-switches", &n_switches,
+          "stack-switch-time", &switch_time, NULL);
+
+    _append_structure (&tracks, gst_structure_new ("track",
+            "type", G_TYPE_STRING, ges_track_type_name (chain->track->type),
+            "fps", G_TYPE_DOUBLE, elapsed > 0 ?
+            (n_buffers - chain->last_n_buffers) / elapsed : 0.0,
+            "buffers", G_TYPE_UINT, (guint) n_buffers,
+            "stack-switches", G_TYPE_UINT64, n_switches,
+            "stack-switch-time", GST_TYPE_CLOCK_TIME, switch_time, NULL));
+    chain->last_n_buffers = n_buffers;
+    position = MAX (position, chain_position);
+
+    if (chain->encodebin)
+      _append_encoder_queues_stats (chain->encodebin, &queues);
+  }
+  g_mutex_unlock (&self->priv->dyn_mutex);
+
+  if (!self->priv->splitmuxsink)
+    _append_encoder_queues_stats (self->priv->encodebin, &queues);
+
+  G_LOCK (decoder_stats);
+  for (tmp = self->priv->decoder_stats; tmp; tmp = tmp->next) {
+    DecoderStats *decoder = tmp->data;
+
+    _append_structure (&sources, gst_structure_new ("source",
+            "source", G_TYPE_STRING, decoder->source,
+            "decoder", G_TYPE_STRING, decoder->decoder,
+            "decode-time", GST_TYPE_CLOCK_TIME, decoder->decode_time,
+            "frames", G_TYPE_UINT64, decoder->n_frames, NULL));
+  }
+  G_UNLOCK (decoder_stats);
+
+  stats = gst_structure_new ("ges-render-stats",
+      "position", GST_TYPE_CLOCK_TIME, position,
+      "realtime-factor", G_TYPE_DOUBLE, elapsed > 0 && position >
+      self->priv->stats_last_position ?
+      (gdouble) (position - self->priv->stats_last_position) / GST_SECOND /
+      elapsed : 0.0, NULL);
+  gst_structure_take_value (stats, "tracks", &tracks);
+  gst_structure_take_value (stats, "queues", &queues);
+  gst_structure_take_value (stats, "sources", &sources);
+
+  self->priv->stats_last_sample = now;
+  self->priv->stats_last_position = position;
+
+  return stats;
+}
+
+static gboolean
+_render_stats_clock_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    GESPipeline * self)
+{
+  GstStructure *stats = _sample_render_stats (self);
+
+  GST_LOG_OBJECT (self, "Render stats: %" GST_PTR_FORMAT, stats);
+
+  GST_OBJECT_LOCK (self);
+  if (self->priv->render_stats)
+    gst_structure_free (self->priv->render_stats);
+  self->priv->render_stats = gst_structure_copy (stats);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), stats));
+
+  return TRUE;
+}
+
+/* Resets statistics and starts measuring, before going to PAUSED */
+static void
+_prepare_render_stats (GESPipeline * self)
+{
+  GList *tmp;
+
+  _clear_decoder_stats (self);
+  self->priv->stats_last_position = 0;
+
+  GST_OBJECT_LOCK (self);
+  g_clear_pointer (&self->priv->render_stats, gst_structure_free);
+  GST_OBJECT_UNLOCK (self);
+
+  if (!self->priv->stats_interval || !IN_RENDERING_MODE (self))
+    return;
+
+  for (tmp = self->priv->chains; tmp; tmp = tmp->next) {
+    OutputChain *chain = tmp->data;
+
+    if (!chain->stats_probe_id)
+      chain->stats_probe_id = gst_pad_add_probe (chain->srcpad,
+          GST_PAD_PROBE_TYPE_BUFFER, (GstPadProbeCallback)
+          _output_stats_probe_cb, chain, NULL);
+  }
+}
+
+static void
+_start_render_stats (GESPipeline * self)
+{
+  GstClock *clock;
+
+  if (!self->priv->stats_interval || !IN_RENDERING_MODE (self) ||
+      self->priv->stats_clock_id)
+    return;
+
+  clock = gst_system_clock_obtain ();
+  self->priv->stats_last_sample = gst_util_get_timestamp ();
+  self->priv->stats_clock_id = gst_clock_new_periodic_id (clock,
+      gst_clock_get_time (clock) + self->priv->stats_interval,
+      self->priv->stats_interval);
+  gst_clock_id_wait_async (self->priv->stats_clock_id,
+      (GstClockCallback) _render_stats_clock_cb, gst_object_ref (self),
+      gst_object_unref);
+  gst_object_unref (clock);
+}
+
+static void
+_stop_render_stats (GESPipeline * self)
+{
+  if (!self->priv->stats_clock_id)
+    return;
+
+  gst_clock_id_unschedule (self->priv->stats_clock_id);
+  gst_clock_id_unref (self->priv->stats_clock_id);
+  self->priv->stats_clock_id = NULL;
+}
+
 static GstStateChangeReturn
 ges_pipeline_change_state (GstElement * element, GstStateChange transition)
 {
@@ -617,21 +1775,25 @@ ges_pipeline_change_state (GstElement * element, GstStateChange transition)
           goto done;
         }
       }
+      _update_proxies (self);
       _link_tracks (self);
+      if (self->priv->splitmuxsink)
+        _checkpoint_prepare (self);
+      _prepare_render_stats (self);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
-    {
-      GList *tmp;
-
-      for (tmp = self->priv->not_rendered_tracks; tmp; tmp = tmp->next)
-        gst_element_set_locked_state (tmp->data, FALSE);
-    }
+      _unlock_unused_tracks (self);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      _stop_render_stats (self);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
     {
       GstElement *queue = gst_bin_get_by_name (GST_BIN (self->priv->playsink),
           "vqueue");
 
+      _start_render_stats (self);
+
       if (queue) {
         GST_INFO_OBJECT (self, "Setting playsink video queue max-size-time to"
             " 2 seconds.");
@@ -651,6 +1813,11 @@ ges_pipeline_change_state (GstElement * element, GstStateChange transition)
       (element, transition);
 
   switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (ret != GST_STATE_CHANGE_FAILURE && self->priv->splitmuxsink &&
+          self->priv->resume_position)
+        _checkpoint_seek_resume_position (self);
+      break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
     case GST_STATE_CHANGE_READY_TO_NULL:
     case GST_STATE_CHANGE_NULL_TO_NULL:
@@ -751,6 +1918,373 @@ no_track:
   }
 }
 
+static GESTrack *
+_get_video_track (GESPipeline * self)
+{
+  GList *tmp;
+
+  if (!self->priv->timeline)
+    return NULL;
+
+  for (tmp = self->priv->timeline->tracks; tmp; tmp = tmp->next) {
+    if (GES_TRACK (tmp->data)->type == GES_TRACK_TYPE_VIDEO)
+      return tmp->data;
+  }
+
+  return NULL;
+}
+
+static void
+_set_decoder_skip_frame (const GValue * item, gpointer skip)
+{
+  GstElement *element = g_value_get_object (item);
+  const gchar *klass = gst_element_class_get_metadata (GST_ELEMENT_GET_CLASS
+      (element), GST_ELEMENT_METADATA_KLASS);
+
+  if (!klass || !strstr (klass, "Decoder") ||
+      !g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+          "skip-frame"))
+    return;
+
+  GST_DEBUG_OBJECT (element, "Setting skip-frame to %d",
+      GPOINTER_TO_INT (skip));
+  g_object_set (element, "skip-frame", GPOINTER_TO_INT (skip), NULL);
+}
+
+/* Gives back to the fields lowered by the preview quality the value the user
+ * set, unless the user changed them meanwhile */
+static GstCaps *
+_restore_preview_fields (GstCaps * caps, const GstCaps * full_quality,
+    const GstCaps * lowered)
+{
+  guint i, j;
+  const gchar *fields[] = { "width", "height", "framerate", NULL };
+
+  caps = gst_caps_make_writable (caps);
+  for (i = 0; i < gst_caps_get_size (caps); i++) {
+    GstStructure *structure = gst_caps_get_structure (caps, i);
+    const GstStructure *full = full_quality &&
+        i < gst_caps_get_size (full_quality) ?
+        gst_caps_get_structure (full_quality, i) : NULL;
+    const GstStructure *low = lowered && i < gst_caps_get_size (lowered) ?
+        gst_caps_get_structure (lowered, i) : NULL;
+
+    for (j = 0; fields[j]; j++) {
+      const GValue *value = gst_structure_get_value (structure, fields[j]);
+      const GValue *low_value =
+          low ? gst_structure_get_value (low, fields[j]) : NULL;
+      const GValue *full_value =
+          full ? gst_structure_get_value (full, fields[j]) : NULL;
+
+      if (!value || !low_value ||
+          gst_value_compare (value, low_value) != GST_VALUE_EQUAL)
+        continue;
+
+      if (full_value)
+        gst_structure_set_value (structure, fields[j], full_value);
+      else
+        gst_structure_remove_field (structure, fields[j]);
+    }
+  }
+
+  return caps;
+}
+
+/* The video format at full quality: the fields fixed in the restriction
+ * caps, completed with the format negotiated on the output of @track as the
+ * restriction caps usually do not specify them all */
+static GstCaps *
+_get_full_quality_caps (GESPipeline * self, GESTrack * track,
+    const GstCaps * restriction)
+{
+  guint i;
+  GstPad *pad;
+  GstCaps *negotiated = NULL;
+  const GstStructure *negotiated_structure = NULL;
+  const GstStructure *restriction_structure = NULL;
+  const gchar *fields[] = { "width", "height", "framerate", NULL };
+  GstStructure *structure = gst_structure_new_empty ("video/x-raw");
+
+  pad = ges_timeline_get_pad_for_track (self->priv->timeline, track);
+  if (pad)
+    negotiated = gst_pad_get_current_caps (pad);
+  if (negotiated && gst_caps_get_size (negotiated))
+    negotiated_structure = gst_caps_get_structure (negotiated, 0);
+  if (restriction && gst_caps_get_size (restriction))
+    restriction_structure = gst_caps_get_structure (restriction, 0);
+
+  for (i = 0; fields[i]; i++) {
+    const GValue *value = restriction_structure ?
+        gst_structure_get_value (restriction_structure, fields[i]) : NULL;
+
+    if ((!value || !gst_value_is_fixed (value)) && negotiated_structure)
+      value = gst_structure_get_value (negotiated_structure, fields[i]);
+
+    if (value && gst_value_is_fixed (value))
+      gst_structure_set_value (structure, fields[i], value);
+  }
+
+  gst_clear_caps (&negotiated);
+
+  return gst_caps_new_full (structure, NULL);
+}
+
+static void
+_set_preview_quality (GESPipeline * self, guint level)
+{
+  GstIterator *it;
+  GESTrack *track = _get_video_track (self);
+
+  if (level == self->priv->preview_quality)
+    return;
+
+  if (!track) {
+    GST_OBJECT_LOCK (self);
+    self->priv->preview_quality = 0;
+    GST_OBJECT_UNLOCK (self);
+    gst_caps_replace (&self->priv->preview_restriction_caps, NULL);
+    gst_caps_replace (&self->priv->preview_lowered_caps, NULL);
+    gst_caps_replace (&self->priv->preview_full_caps, NULL);
+
+    return;
+  }
+
+  if (self->priv->preview_quality == 0) {
+    g_object_get (track, "restriction-caps",
+        &self->priv->preview_restriction_caps, NULL);
+    gst_caps_replace (&self->priv->preview_full_caps, NULL);
+    self->priv->preview_full_caps = _get_full_quality_caps (self, track,
+        self->priv->preview_restriction_caps);
+  }
+
+  GST_INFO_OBJECT (self, "Setting preview quality level to %d", level);
+  if (level == 0) {
+    GstCaps *caps;
+
+    /* Only the fields we lowered are restored, other changes the user made
+     * to the restriction caps in the meantime are kept */
+    g_object_get (track, "restriction-caps", &caps, NULL);
+    if (caps) {
+      caps = _restore_preview_fields (caps,
+          self->priv->preview_restriction_caps,
+          self->priv->preview_lowered_caps);
+      ges_track_set_restriction_caps (track, caps);
+      gst_caps_unref (caps);
+    }
+    gst_caps_replace (&self->priv->preview_restriction_caps, NULL);
+    gst_caps_replace (&self->priv->preview_lowered_caps, NULL);
+    gst_caps_replace (&self->priv->preview_full_caps, NULL);
+  } else {
+    gint width, height, fps_n, fps_d;
+    GstStructure *structure =
+        gst_caps_get_structure (self->priv->preview_full_caps, 0);
+    GstCaps *caps = gst_caps_new_empty_simple ("video/x-raw");
+    guint shift = level >= 3 ? 2 : 1;
+
+    if (gst_structure_get_int (structure, "width", &width) &&
+        gst_structure_get_int (structure, "height", &height))
+      gst_caps_set_simple (caps, "width", G_TYPE_INT,
+          MAX ((width >> shift) & ~1, 2), "height", G_TYPE_INT,
+          MAX ((height >> shift) & ~1, 2), NULL);
+
+    if (gst_structure_get_fraction (structure, "framerate", &fps_n, &fps_d)
+        && fps_n > 0) {
+      if (level >= 2)
+        fps_d *= 2;
+      gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION, fps_n, fps_d,
+          NULL);
+    }
+
+    /* Merges the lowered fields into the restriction caps */
+    ges_track_update_restriction_caps (track, caps);
+    gst_caps_unref (caps);
+
+    gst_caps_replace (&self->priv->preview_lowered_caps, NULL);
+    g_object_get (track, "restriction-caps",
+        &self->priv->preview_lowered_caps, NULL);
+  }
+
+  it = gst_bin_iterate_recurse (GST_BIN (track));
+  gst_iterator_foreach (it, _set_decoder_skip_frame,
+      GINT_TO_POINTER (level >= 3 ? 1 : 0));
+  gst_iterator_free (it);
+
+  GST_OBJECT_LOCK (self);
+  self->priv->preview_quality = level;
+  self->priv->n_late_qos = self->priv->n_headroom_qos = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PREVIEW_QUALITY]);
+}
+
+static gboolean
+_update_preview_quality (PreviewQualityUpdate * update)
+{
+  GESPipeline *self = update->pipeline;
+  gint level;
+
+  GST_OBJECT_LOCK (self);
+  level = (gint) self->priv->preview_quality + update->step;
+  self->priv->preview_quality_update_pending = FALSE;
+  /* Back to full quality when adaptive preview got disabled */
+  if (!self->priv->adaptive_preview)
+    level = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  if (self->priv->mode & GES_PIPELINE_MODE_PREVIEW_VIDEO || level == 0)
+    _set_preview_quality (self, CLAMP (level, 0,
+            ADAPTIVE_PREVIEW_MAX_QUALITY_LEVEL));
+
+  gst_object_unref (self);
+  g_slice_free (PreviewQualityUpdate, update);
+
+  return G_SOURCE_REMOVE;
+}
+
+static GstPadProbeReturn
+_video_qos_probe_cb (GstPad * pad, GstPadProbeInfo * info, GESPipeline * self)
+{
+  gdouble proportion;
+  GstClockTimeDiff diff;
+  gint step = 0;
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_QOS)
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_qos (event, NULL, &proportion, &diff, NULL);
+
+  GST_OBJECT_LOCK (self);
+  if (!self->priv->adaptive_preview ||
+      self->priv->preview_quality_update_pending)
+    goto done;
+
+  if (diff > 0) {
+    self->priv->n_headroom_qos = 0;
+    if (++self->priv->n_late_qos >= ADAPTIVE_PREVIEW_LATE_THRESHOLD &&
+        self->priv->preview_quality < ADAPTIVE_PREVIEW_MAX_QUALITY_LEVEL)
+      step = 1;
+  } else if (proportion < ADAPTIVE_PREVIEW_HEADROOM_PROPORTION) {
+    self->priv->n_late_qos = 0;
+    if (++self->priv->n_headroom_qos >= ADAPTIVE_PREVIEW_HEADROOM_THRESHOLD &&
+        self->priv->preview_quality > 0)
+      step = -1;
+  } else {
+    self->priv->n_late_qos = self->priv->n_headroom_qos = 0;
+  }
+
+  if (step) {
+    PreviewQualityUpdate *update = g_slice_new (PreviewQualityUpdate);
+
+    GST_DEBUG_OBJECT (self, "%s preview quality (proportion: %f, diff: %"
+        G_GINT64_FORMAT ")", step > 0 ? "Lowering" : "Raising", proportion,
+        diff);
+
+    update->pipeline = gst_object_ref (self);
+    update->step = step;
+    self->priv->preview_quality_update_pending = TRUE;
+    self->priv->n_late_qos = self->priv->n_headroom_qos = 0;
+    g_idle_add ((GSourceFunc) _update_preview_quality, update);
+  }
+
+done:
+  GST_OBJECT_UNLOCK (self);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Keeps @track in READY until the pipeline goes back to READY, at which
+ * point tracks are relinked (or not) according to the new mode */
+static void
+_lock_unused_track (GESPipeline * self, GESTrack * track)
+{
+  if (g_list_find (self->priv->not_rendered_tracks, track))
+    return;
+
+  gst_element_set_locked_state (GST_ELEMENT (track), TRUE);
+  gst_element_set_state (GST_ELEMENT (track), GST_STATE_READY);
+
+  self->priv->not_rendered_tracks =
+      g_list_append (self->priv->not_rendered_tracks, track);
+}
+
+static void
+_unlock_unused_tracks (GESPipeline * self)
+{
+  GList *tmp;
+
+  for (tmp = self->priv->not_rendered_tracks; tmp; tmp = tmp->next)
+    gst_element_set_locked_state (tmp->data, FALSE);
+
+  g_list_free (self->priv->not_rendered_tracks);
+  self->priv->not_rendered_tracks = NULL;
+}
+
+static void
+_remove_fragment_encoder (GESPipeline * self, OutputChain * chain)
+{
+  if (chain->splitmuxpad) {
+    GstPad *peer = gst_pad_get_peer (chain->splitmuxpad);
+
+    if (peer) {
+      gst_pad_unlink (peer, chain->splitmuxpad);
+      gst_object_unref (peer);
+    }
+    gst_element_release_request_pad (self->priv->splitmuxsink,
+        chain->splitmuxpad);
+    gst_clear_object (&chain->splitmuxpad);
+  }
+
+  if (chain->encodebin) {
+    gst_element_set_state (chain->encodebin, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN_CAST (self), chain->encodebin);
+    chain->encodebin = NULL;
+  }
+}
+
+/* Encodes the track of @chain on its own, so the encoded stream can be
+ * fragmented by the splitmuxsink */
+static GstElement *
+_add_fragment_encoder (GESPipeline * self, OutputChain * chain)
+{
+  GstPad *srcpad;
+  const GList *tmp;
+  GstEncodingProfile *prof = NULL;
+
+  for (tmp = gst_encoding_container_profile_get_profiles
+      (GST_ENCODING_CONTAINER_PROFILE (self->priv->profile)); tmp;
+      tmp = tmp->next) {
+    if (TRACK_COMPATIBLE_PROFILE (chain->track->type, tmp->data)) {
+      prof = tmp->data;
+      break;
+    }
+  }
+
+  if (!prof)
+    return NULL;
+
+  chain->encodebin = gst_element_factory_make ("encodebin", NULL);
+  g_object_set (chain->encodebin, "profile", prof, NULL);
+  gst_bin_add (GST_BIN_CAST (self), chain->encodebin);
+
+  chain->splitmuxpad = gst_element_get_request_pad (self->priv->splitmuxsink,
+      chain->track->type == GES_TRACK_TYPE_VIDEO ? "video" : "audio_%u");
+  srcpad = gst_element_get_static_pad (chain->encodebin, "src");
+  if (!chain->splitmuxpad || !srcpad ||
+      gst_pad_link (srcpad, chain->splitmuxpad) != GST_PAD_LINK_OK) {
+    GST_ERROR_OBJECT (self, "Could not link %" GST_PTR_FORMAT
+        " to splitmuxsink", chain->encodebin);
+    gst_clear_object (&srcpad);
+    _remove_fragment_encoder (self, chain);
+
+    return NULL;
+  }
+  gst_object_unref (srcpad);
+  gst_element_sync_state_with_parent (chain->encodebin);
+
+  return chain->encodebin;
+}
+
 static void
 _link_track (GESPipeline * self, GESTrack * track)
 {
@@ -776,18 +2310,23 @@ _link_track (GESPipeline * self, GESTrack * track)
     return;
   }
 
-  /* Don't connect track if it's not going to be used */
-  if (track->type == GES_TRACK_TYPE_VIDEO &&
-      !(self->priv->mode & GES_PIPELINE_MODE_PREVIEW_VIDEO) &&
-      !(self->priv->mode & GES_PIPELINE_MODE_RENDER) &&
-      !(self->priv->mode & GES_PIPELINE_MODE_SMART_RENDER)) {
-    GST_DEBUG_OBJECT (self, "Video track... but we don't need it. Not linking");
-  }
-  if (track->type == GES_TRACK_TYPE_AUDIO &&
-      !(self->priv->mode & GES_PIPELINE_MODE_PREVIEW_AUDIO) &&
-      !(self->priv->mode & GES_PIPELINE_MODE_RENDER) &&
-      !(self->priv->mode & GES_PIPELINE_MODE_SMART_RENDER)) {
-    GST_DEBUG_OBJECT (self, "Audio track... but we don't need it. Not linking");
+  track_set_resample_quality (track, IN_RENDERING_MODE (self) ?
+      RENDER_RESAMPLE_QUALITY : PREVIEW_RESAMPLE_QUALITY);
+
+  /* Don't connect track if it's not going to be used, and keep it in READY
+   * so none of its sources get prerolled (nor decoders instantiated) */
+  if ((track->type == GES_TRACK_TYPE_VIDEO &&
+          !(self->priv->mode & GES_PIPELINE_MODE_PREVIEW_VIDEO) &&
+          !IN_RENDERING_MODE (self)) ||
+      (track->type == GES_TRACK_TYPE_AUDIO &&
+          !(self->priv->mode & GES_PIPELINE_MODE_PREVIEW_AUDIO) &&
+          !IN_RENDERING_MODE (self))) {
+    GST_DEBUG_OBJECT (self, "%" GST_PTR_FORMAT " not needed, not linking",
+        track);
+    _lock_unused_track (self, track);
+    gst_object_unref (pad);
+
+    return;
   }
 
   /* Get an existing chain or create it */
@@ -872,29 +2411,41 @@ _link_track (GESPipeline * self, GESTrack * track)
 
     /* We still hold a reference on the sinkpad */
     chain->playsinkpad = sinkpad;
+
+    if (track->type == GES_TRACK_TYPE_VIDEO)
+      chain->qos_probe_id = gst_pad_add_probe (pad,
+          GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+          (GstPadProbeCallback) _video_qos_probe_cb, self, NULL);
   }
 
   /* Connect to encodebin */
   if (IN_RENDERING_MODE (self)) {
     GstPad *tmppad;
+    GstElement *encodebin = self->priv->encodebin;
+
     GST_DEBUG_OBJECT (self, "Connecting to encodebin");
 
+    if (self->priv->splitmuxsink &&
+        !(encodebin = _add_fragment_encoder (self, chain))) {
+      _lock_unused_track (self, track);
+      GST_INFO_OBJECT (self, "No fragment encoder for %" GST_PTR_FORMAT,
+          track);
+      sinkpad = NULL;
+      goto error;
+    }
+
     if (!chain->encodebinpad) {
       /* Check for unused static pads */
-      sinkpad = get_compatible_unlinked_pad (self->priv->encodebin, track);
+      sinkpad = get_compatible_unlinked_pad (encodebin, track);
 
       if (sinkpad == NULL) {
         GstCaps *caps = gst_pad_query_caps (pad, NULL);
 
         /* If no compatible static pad is available, request a pad */
-        g_signal_emit_by_name (self->priv->encodebin, "request-pad", caps,
-            &sinkpad);
+        g_signal_emit_by_name (encodebin, "request-pad", caps, &sinkpad);
 
         if (G_UNLIKELY (sinkpad == NULL)) {
-          gst_element_set_locked_state (GST_ELEMENT (track), TRUE);
-
-          self->priv->not_rendered_tracks =
-              g_list_append (self->priv->not_rendered_tracks, track);
+          _lock_unused_track (self, track);
 
           GST_INFO_OBJECT (self,
               "Couldn't get a pad from encodebin for: %" GST_PTR_FORMAT, caps);
@@ -919,14 +2470,20 @@ _link_track (GESPipeline * self, GESTrack * track)
   }
 
   /* If chain wasn't already present, insert it in list */
-  if (!get_output_chain_for_track (self, track))
+  if (!get_output_chain_for_track (self, track)) {
+    g_mutex_lock (&self->priv->dyn_mutex);
     self->priv->chains = g_list_append (self->priv->chains, chain);
+    g_mutex_unlock (&self->priv->dyn_mutex);
+  }
 
   GST_DEBUG ("done");
   return;
 
 error:
   {
+    if (chain->qos_probe_id)
+      gst_pad_remove_probe (pad, chain->qos_probe_id);
+    _remove_fragment_encoder (self, chain);
     if (chain->tee) {
       gst_element_set_state (chain->tee, GST_STATE_NULL);
       gst_bin_remove (GST_BIN_CAST (self), chain->tee);
@@ -945,20 +2502,34 @@ _unlink_track (GESPipeline * self, GESTrack * track)
 
   GST_DEBUG_OBJECT (self, "Unlinking removed %" GST_PTR_FORMAT, track);
 
+  if (g_list_find (self->priv->not_rendered_tracks, track)) {
+    gst_element_set_locked_state (GST_ELEMENT (track), FALSE);
+    self->priv->not_rendered_tracks =
+        g_list_remove (self->priv->not_rendered_tracks, track);
+  }
+
   if (G_UNLIKELY (!(chain = get_output_chain_for_track (self, track)))) {
     GST_DEBUG_OBJECT (self, "Track wasn't used");
     return;
   }
 
+  if (chain->qos_probe_id)
+    gst_pad_remove_probe (chain->srcpad, chain->qos_probe_id);
+  if (chain->resume_probe_id)
+    gst_pad_remove_probe (chain->srcpad, chain->resume_probe_id);
+  if (chain->stats_probe_id)
+    gst_pad_remove_probe (chain->srcpad, chain->stats_probe_id);
+
   /* Unlink encodebin */
   if (chain->encodebinpad) {
     GstPad *peer = gst_pad_get_peer (chain->encodebinpad);
     gst_pad_unlink (peer, chain->encodebinpad);
     gst_object_unref (peer);
-    gst_element_release_request_pad (self->priv->encodebin,
-        chain->encodebinpad);
+    gst_element_release_request_pad (chain->encodebin ? chain->encodebin :
+        self->priv->encodebin, chain->encodebinpad);
     gst_object_unref (chain->encodebinpad);
   }
+  _remove_fragment_encoder (self, chain);
 
   /* Unlink playsink */
   if (chain->playsinkpad) {
@@ -972,8 +2543,10 @@ _unlink_track (GESPipeline * self, GESTrack * track)
   gst_element_set_state (chain->tee, GST_STATE_NULL);
   gst_bin_remove (GST_BIN (self), chain->tee);
 
+  g_mutex_lock (&self->priv->dyn_mutex);
   self->priv->chains = g_list_remove (self->priv->chains, chain);
   g_free (chain);
+  g_mutex_unlock (&self->priv->dyn_mutex);
 
   GST_DEBUG ("done");
 }
@@ -1106,6 +2679,9 @@ ges_pipeline_set_render_settings (GESPipeline * pipeline,
   /* We got a referencer when getting back the profile */
   pipeline->priv->profile = profile;
 
+  g_free (pipeline->priv->output_uri);
+  pipeline->priv->output_uri = g_strdup (output_uri);
+
   return TRUE;
 }
 
@@ -1129,6 +2705,11 @@ ges_pipeline_get_mode (GESPipeline * pipeline)
  * switches the @pipeline to the specified @mode. The default mode when
  * creating a #GESPipeline is #GES_PIPELINE_MODE_PREVIEW.
  *
+ * In preview modes, #GESUriClip-s play the proxy of their asset if one is
+ * set (see #ges_asset_set_proxy and #ges_uri_clip_asset_generate_proxy),
+ * while the original media is played in render modes. The asset of the
+ * clips is not changed.
+ *
  * Note: The @pipeline will be set to #GST_STATE_NULL during this call due to
  * the internal changes that happen. The caller will therefore have to
  * set the @pipeline to the requested state after calling this method.
@@ -1157,6 +2738,9 @@ ges_pipeline_set_mode (GESPipeline * pipeline, GESPipelineFlags mode)
   /* Switch pipeline to NULL since we're changing the configuration */
   gst_element_set_state (GST_ELEMENT_CAST (pipeline), GST_STATE_NULL);
 
+  /* Never render with a degraded preview quality */
+  _set_preview_quality (pipeline, 0);
+
 
   if (pipeline->priv->timeline) {
     gboolean disabled =
@@ -1196,10 +2780,15 @@ ges_pipeline_set_mode (GESPipeline * pipeline, GESPipelineFlags mode)
 
     /* Disable render bin */
     GST_DEBUG ("Disabling rendering bin");
-    gst_object_ref (pipeline->priv->encodebin);
-    gst_object_ref (pipeline->priv->urisink);
-    gst_bin_remove_many (GST_BIN_CAST (pipeline),
-        pipeline->priv->encodebin, pipeline->priv->urisink, NULL);
+    if (pipeline->priv->splitmuxsink) {
+      gst_bin_remove (GST_BIN_CAST (pipeline), pipeline->priv->splitmuxsink);
+      gst_clear_object (&pipeline->priv->splitmuxsink);
+    } else {
+      gst_object_ref (pipeline->priv->encodebin);
+      gst_object_ref (pipeline->priv->urisink);
+      gst_bin_remove_many (GST_BIN_CAST (pipeline),
+          pipeline->priv->encodebin, pipeline->priv->urisink, NULL);
+    }
   }
 
   /* Add new elements */
@@ -1222,6 +2811,18 @@ ges_pipeline_set_mode (GESPipeline * pipeline, GESPipelineFlags mode)
       GST_ERROR_OBJECT (pipeline, "Output URI not set !");
       return FALSE;
     }
+
+    if (_checkpoint_setup (pipeline, mode)) {
+      GST_DEBUG ("Rendering with checkpoints");
+      if (!gst_bin_add (GST_BIN_CAST (pipeline),
+              pipeline->priv->splitmuxsink)) {
+        GST_ERROR_OBJECT (pipeline, "Couldn't add splitmuxsink");
+        gst_clear_object (&pipeline->priv->splitmuxsink);
+        return FALSE;
+      }
+      goto done;
+    }
+
     if (!gst_bin_add (GST_BIN_CAST (pipeline), pipeline->priv->encodebin)) {
       GST_ERROR_OBJECT (pipeline, "Couldn't add encodebin");
       return FALSE;
@@ -1237,6 +2838,7 @@ ges_pipeline_set_mode (GESPipeline * pipeline, GESPipelineFlags mode)
         pipeline->priv->urisink, "sink", GST_PAD_LINK_CHECK_NOTHING);
   }
 
+done:
   /* FIXUPS */
   /* FIXME
    * If we are rendering, set playsink to sync=False,
@@ -1462,3 +3064,30 @@ ges_pipeline_preview_set_audio_sink (GESPipeline * self, GstElement * sink)
 
   g_object_set (self->priv->playsink, "audio-sink", sink, NULL);
 };
+
+/**
+ * ges_pipeline_get_render_stats:
+ * @self: a #GESPipeline
+ *
+ * Gets the last render statistics sampled while rendering, see
+ * #GESPipeline:render-stats-interval for their content.
+ *
+ * Returns: (transfer full) (nullable): the last "ges-render-stats"
+ * #GstStructure, or %NULL if none has been sampled yet.
+ *
+ * Since: 1.16
+ */
+GstStructure *
+ges_pipeline_get_render_stats (GESPipeline * self)
+{
+  GstStructure *stats = NULL;
+
+  g_return_val_if_fail (GES_IS_PIPELINE (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  if (self->priv->render_stats)
+    stats = gst_structure_copy (self->priv->render_stats);
+  GST_OBJECT_UNLOCK (self);
+
+  return stats;
+}
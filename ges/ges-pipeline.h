@@ -122,6 +122,9 @@ GES_API void
 ges_pipeline_preview_set_audio_sink (GESPipeline * self,
     GstElement * sink);
 
+GES_API GstStructure *
+ges_pipeline_get_render_stats (GESPipeline * self);
+
 G_END_DECLS
 
 #endif /* _GES_PIPELINE */
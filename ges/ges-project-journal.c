@@ -0,0 +1,1828 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Journal of the changes made to a timeline since its project was saved.
+ *
+ * The journal is a file next to the project file, named after it with a
+ * ".journal" suffix, to which records are appended as the timeline gets
+ * edited: the state of the clips that were created or modified, the names
+ * of the clips that were removed, the layers, the groups and the
+ * metadatas. Changes are coalesced per element until the next removal and
+ * written from an idle callback, so that editing a clip of a huge timeline
+ * only costs writing that clip while records are still replayed in the
+ * order of the operations.
+ *
+ * Each record is a "(yv)" GVariant, the type of the record and its content,
+ * prefixed with its little endian 32 bits size and padded to 8 bytes. The
+ * first one identifies the version of the project file the journal applies
+ * to, using its etag.
+ *
+ * Loading a project replays its journal on top of what was saved. Saving
+ * the project restarts the journal, which happens in the background once
+ * the journal gets bigger than the project file. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
+#include <gst/controller/gstdirectcontrolbinding.h>
+
+#include "ges.h"
+#include "ges-internal.h"
+
+/* Bump when the format of the records changes */
+#define JOURNAL_VERSION 1
+#define JOURNAL_SUFFIX ".journal"
+/* Below that, rewriting the project is not worth it */
+#define MIN_COMPACT_SIZE (1024 * 1024)
+
+/* version, etag of the project file */
+#define HEADER_FORMAT "(us)"
+/* name, type name, asset id, layer priority, start, inpoint, duration,
+ * track types, properties, children properties, metadatas, and the track
+ * elements as: type name (empty for sources), asset id, track index,
+ * properties, children properties, metadatas, and the bindings as:
+ * property, binding type, interpolation mode, keyframes */
+#define CLIP_FORMAT "(sssutttusssa(ssisssa(ssia(td))))"
+#define BINDINGS_FORMAT "a(ssia(td))"
+/* priority, properties, metadatas */
+#define LAYER_FORMAT "(uss)"
+/* "project" or "timeline", metadatas */
+#define METAS_FORMAT "(ss)"
+/* Each group, after the groups it contains, as the names of its clips and
+ * the indexes of its groups */
+#define GROUPS_FORMAT "a(asai)"
+
+enum
+{
+  RECORD_HEADER = 'h',
+  RECORD_CLIP = 'c',
+  RECORD_CLIP_REMOVED = 'r',
+  RECORD_LAYER = 'l',
+  RECORD_LAYER_REMOVED = 'L',
+  RECORD_METAS = 'm',
+  RECORD_GROUPS = 'g',
+};
+
+struct _GESProjectJournal
+{
+  GESProject *project;
+  GESTimeline *timeline;
+  GESAsset *formatter_asset;
+  gchar *uri;
+  GFile *file;
+
+  GOutputStream *stream;
+  guint64 size;
+  /* The journal is compacted once bigger than that */
+  guint64 compact_size;
+  /* A full save of the project is in progress */
+  gboolean saving;
+  /* What was journaled meanwhile, to be journaled again for the saved
+   * project as it might not be in it */
+  GByteArray *saving_records;
+
+  /* Records not written yet, in the order of the operations */
+  GByteArray *pending;
+  /* Clips and layers whose state needs to be written after the pending
+   * records, in the order they changed */
+  GQueue dirty;
+  GHashTable *dirty_set;
+  gboolean groups_dirty;
+  gboolean project_metas_dirty;
+  gboolean timeline_metas_dirty;
+  guint idle_id;
+
+  /* Clip -> name it was journaled with */
+  GHashTable *names;
+  /* Control source -> track element */
+  GHashTable *sources;
+};
+
+/***********************************************
+ *                                             *
+ *                File handling                *
+ *                                             *
+ ***********************************************/
+
+/* Returns the etag of the project file */
+static gchar *
+get_project_stamp (const gchar * uri, guint64 * size)
+{
+  gchar *etag;
+  GFileInfo *info;
+  GFile *file = g_file_new_for_uri (uri);
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_ETAG_VALUE ","
+      G_FILE_ATTRIBUTE_STANDARD_SIZE, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  g_object_unref (file);
+
+  if (!info)
+    return NULL;
+
+  etag = g_strdup (g_file_info_get_etag (info));
+  if (size)
+    *size = g_file_info_get_size (info);
+  g_object_unref (info);
+
+  return etag;
+}
+
+static GFile *
+get_journal_file (const gchar * uri)
+{
+  GFile *file;
+  gchar *journal_uri = g_strconcat (uri, JOURNAL_SUFFIX, NULL);
+
+  file = g_file_new_for_uri (journal_uri);
+  g_free (journal_uri);
+
+  return file;
+}
+
+static void
+append_record (GByteArray * buffer, gchar type, GVariant * value)
+{
+  gsize size;
+  GVariant *record;
+  guint32 header[2] = { 0, };
+  static const guint8 padding[8] = { 0, };
+
+  record = g_variant_ref_sink (g_variant_new ("(yv)", type, value));
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+  {
+    GVariant *swapped = g_variant_byteswap (record);
+
+    g_variant_unref (record);
+    record = swapped;
+  }
+#endif
+
+  size = g_variant_get_size (record);
+  header[0] = GUINT32_TO_LE (size);
+  g_byte_array_append (buffer, (const guint8 *) header, sizeof (header));
+  g_byte_array_append (buffer, g_variant_get_data (record), size);
+  g_byte_array_append (buffer, padding, GST_ROUND_UP_8 (size) - size);
+  g_variant_unref (record);
+}
+
+/* Returns the record at @offset in @data, moving @offset to the next one,
+ * or %NULL at the end of the journal or if the record is truncated */
+static GVariant *
+read_record (const guint8 * data, gsize length, gsize * offset,
+    gchar * type)
+{
+  guint32 size;
+  guchar record_type;
+  GVariant *record, *value;
+
+  if (length - *offset < 2 * sizeof (guint32))
+    return NULL;
+
+  memcpy (&size, data + *offset, sizeof (size));
+  size = GUINT32_FROM_LE (size);
+  if (length - *offset - 2 * sizeof (guint32) < GST_ROUND_UP_8 (size))
+    return NULL;
+
+  record = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE
+          ("(yv)"), data + *offset + 2 * sizeof (guint32), size, FALSE, NULL,
+          NULL));
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+  {
+    GVariant *swapped = g_variant_byteswap (record);
+
+    g_variant_unref (record);
+    record = swapped;
+  }
+#endif
+
+  g_variant_get (record, "(yv)", &record_type, &value);
+  g_variant_unref (record);
+
+  *type = record_type;
+  *offset += 2 * sizeof (guint32) + GST_ROUND_UP_8 (size);
+
+  return value;
+}
+
+/* Loads the journal of @uri if it applies to the current project file */
+static gboolean
+load_journal (GFile * file, const gchar * etag, gchar ** contents,
+    gsize * length)
+{
+  gchar type;
+  gsize offset = 0;
+  guint version;
+  const gchar *journal_etag;
+  GVariant *header;
+  gboolean ret = FALSE;
+
+  if (!etag || !g_file_load_contents (file, NULL, contents, length, NULL,
+          NULL))
+    return FALSE;
+
+  header = read_record ((const guint8 *) * contents, *length, &offset, &type);
+  if (header && type == RECORD_HEADER &&
+      g_variant_is_of_type (header, G_VARIANT_TYPE (HEADER_FORMAT))) {
+    g_variant_get (header, "(u&s)", &version, &journal_etag);
+    ret = version == JOURNAL_VERSION && !g_strcmp0 (journal_etag, etag);
+  }
+
+  if (header)
+    g_variant_unref (header);
+
+  if (!ret)
+    g_free (*contents);
+
+  return ret;
+}
+
+/* Restarts the journal unless @restart is %FALSE and it applies to the
+ * project file, in which case what is valid in it is kept */
+static gboolean
+open_journal (GESProjectJournal * journal, gboolean restart, GError ** error)
+{
+  gchar type;
+  gsize length, offset = 0;
+  gchar *contents = NULL;
+  guint64 project_size = 0;
+  GByteArray *buffer = g_byte_array_new ();
+  gchar *etag = get_project_stamp (journal->uri, &project_size);
+
+  if (!etag) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+        "Project %s has not been saved", journal->uri);
+    g_byte_array_unref (buffer);
+
+    return FALSE;
+  }
+
+  if (!restart && load_journal (journal->file, etag, &contents, &length)) {
+    GVariant *value;
+
+    /* A record could have been partly written */
+    while ((value = read_record ((const guint8 *) contents, length, &offset,
+                &type)))
+      g_variant_unref (value);
+    g_byte_array_append (buffer, (const guint8 *) contents, offset);
+    g_free (contents);
+  } else {
+    append_record (buffer, RECORD_HEADER, g_variant_new (HEADER_FORMAT,
+            JOURNAL_VERSION, etag));
+  }
+  g_free (etag);
+
+  g_clear_object (&journal->stream);
+  journal->stream = G_OUTPUT_STREAM (g_file_replace (journal->file, NULL,
+          FALSE, G_FILE_CREATE_NONE, NULL, error));
+  if (journal->stream && (!g_output_stream_write_all (journal->stream,
+              buffer->data, buffer->len, NULL, NULL, error) ||
+          !g_output_stream_flush (journal->stream, NULL, error)))
+    g_clear_object (&journal->stream);
+
+  journal->size = buffer->len;
+  journal->compact_size = MAX (project_size, MIN_COMPACT_SIZE);
+  g_byte_array_unref (buffer);
+
+  return journal->stream != NULL;
+}
+
+/***********************************************
+ *                                             *
+ *                Serialization                *
+ *                                             *
+ ***********************************************/
+
+static GVariant *
+serialize_bindings (GESTrackElement * element)
+{
+  gpointer key, value;
+  GHashTableIter iter;
+  GVariantBuilder builder;
+
+  /* Same bindings as the ones saved in xges files */
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (BINDINGS_FORMAT));
+  g_hash_table_iter_init (&iter,
+      ges_track_element_get_all_control_bindings (element));
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    GList *values, *tmp;
+    GstControlSource *source;
+    GstInterpolationMode mode;
+    gboolean absolute = FALSE;
+
+    if (!GST_IS_DIRECT_CONTROL_BINDING (value))
+      continue;
+
+    g_object_get (value, "control-source", &source, "absolute", &absolute,
+        NULL);
+    if (!GST_IS_INTERPOLATION_CONTROL_SOURCE (source)) {
+      gst_object_unref (source);
+      continue;
+    }
+
+    g_object_get (source, "mode", &mode, NULL);
+    g_variant_builder_open (&builder, G_VARIANT_TYPE ("(ssia(td))"));
+    g_variant_builder_add (&builder, "s", key);
+    g_variant_builder_add (&builder, "s",
+        absolute ? "direct-absolute" : "direct");
+    g_variant_builder_add (&builder, "i", mode);
+
+    g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(td)"));
+    values = gst_timed_value_control_source_get_all
+        (GST_TIMED_VALUE_CONTROL_SOURCE (source));
+    for (tmp = values; tmp; tmp = tmp->next) {
+      GstTimedValue *timed_value = tmp->data;
+
+      g_variant_builder_add (&builder, "(td)", timed_value->timestamp,
+          timed_value->value);
+    }
+    g_list_free (values);
+    g_variant_builder_close (&builder);
+
+    g_variant_builder_close (&builder);
+    gst_object_unref (source);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+static void
+add_track_element (GVariantBuilder * builder, GESTrackElement * element,
+    GList * tracks)
+{
+  gboolean serialize;
+  gchar *asset_id = NULL, *properties = NULL, *metas = NULL,
+      *children_properties;
+  GESTrack *track = ges_track_element_get_track (element);
+
+  g_object_get (element, "serialize", &serialize, NULL);
+  if (!serialize)
+    return;
+
+  if (GES_IS_BASE_EFFECT (element)) {
+    if (!track)
+      return;
+
+    asset_id = ges_extractable_get_id (GES_EXTRACTABLE (element));
+    properties = _serialize_properties (G_OBJECT (element), "start",
+        "in-point", "duration", "locked", "max-duration", "name", "priority",
+        NULL);
+    metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (element));
+  }
+  children_properties =
+      _serialize_children_properties (GES_TIMELINE_ELEMENT (element));
+
+  g_variant_builder_add (builder, "(ssisss@" BINDINGS_FORMAT ")",
+      GES_IS_BASE_EFFECT (element) ? g_type_name (G_OBJECT_TYPE (element)) :
+      "", asset_id ? asset_id : "", g_list_index (tracks, track),
+      properties ? properties : "", children_properties, metas ? metas : "",
+      serialize_bindings (element));
+
+  g_free (asset_id);
+  g_free (properties);
+  g_free (children_properties);
+  g_free (metas);
+}
+
+static GVariant *
+serialize_clip (GESProjectJournal * journal, GESClip * clip, guint priority)
+{
+  GList *tmp, *effects, *tracks;
+  GVariant *ret;
+  GVariantBuilder elements;
+  gchar *asset_id, *properties, *metas, *children_properties = NULL;
+
+  /* Same order as in xges files, effects first in their priority order */
+  tracks = ges_timeline_get_tracks (journal->timeline);
+  g_variant_builder_init (&elements, G_VARIANT_TYPE ("a(ssisssa(ssia(td)))"));
+  effects = ges_clip_get_top_effects (clip);
+  for (tmp = effects; tmp; tmp = tmp->next)
+    add_track_element (&elements, tmp->data, tracks);
+  g_list_free_full (effects, gst_object_unref);
+
+  for (tmp = GES_CONTAINER_CHILDREN (clip); tmp; tmp = tmp->next) {
+    if (GES_IS_SOURCE (tmp->data))
+      add_track_element (&elements, tmp->data, tracks);
+  }
+  g_list_free_full (tracks, gst_object_unref);
+
+  asset_id = ges_extractable_get_id (GES_EXTRACTABLE (clip));
+  properties = _serialize_properties (G_OBJECT (clip), "supported-formats",
+      "rate", "in-point", "start", "duration", "max-duration", "priority",
+      "vtype", "uri", NULL);
+  metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (clip));
+  if (GES_IS_TRANSITION_CLIP (clip))
+    children_properties =
+        _serialize_children_properties (GES_TIMELINE_ELEMENT (clip));
+
+  ret = g_variant_new (CLIP_FORMAT, GES_TIMELINE_ELEMENT_NAME (clip),
+      g_type_name (G_OBJECT_TYPE (clip)), asset_id, priority, _START (clip),
+      _INPOINT (clip), _DURATION (clip), ges_clip_get_supported_formats (clip),
+      properties, children_properties ? children_properties : "", metas,
+      &elements);
+
+  g_free (asset_id);
+  g_free (properties);
+  g_free (metas);
+  g_free (children_properties);
+
+  return ret;
+}
+
+static void
+add_group (GVariantBuilder * builder, GESGroup * group, GHashTable * indexes)
+{
+  GList *tmp;
+  gboolean serialize;
+  GVariantBuilder clips, groups;
+
+  g_object_get (group, "serialize", &serialize, NULL);
+  if (!serialize || g_hash_table_contains (indexes, group))
+    return;
+
+  for (tmp = GES_CONTAINER_CHILDREN (group); tmp; tmp = tmp->next) {
+    if (GES_IS_GROUP (tmp->data))
+      add_group (builder, tmp->data, indexes);
+  }
+
+  g_variant_builder_init (&clips, G_VARIANT_TYPE_STRING_ARRAY);
+  g_variant_builder_init (&groups, G_VARIANT_TYPE ("ai"));
+  for (tmp = GES_CONTAINER_CHILDREN (group); tmp; tmp = tmp->next) {
+    gpointer index;
+
+    if (!GES_IS_GROUP (tmp->data))
+      g_variant_builder_add (&clips, "s",
+          GES_TIMELINE_ELEMENT_NAME (tmp->data));
+    else if (g_hash_table_lookup_extended (indexes, tmp->data, NULL, &index))
+      g_variant_builder_add (&groups, "i", GPOINTER_TO_INT (index));
+  }
+
+  g_hash_table_insert (indexes, group,
+      GINT_TO_POINTER (g_hash_table_size (indexes)));
+  g_variant_builder_add (builder, "(asai)", &clips, &groups);
+}
+
+static GVariant *
+serialize_groups (GESProjectJournal * journal)
+{
+  GList *tmp;
+  GVariantBuilder builder;
+  GHashTable *indexes = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (GROUPS_FORMAT));
+  for (tmp = ges_timeline_get_groups (journal->timeline); tmp; tmp = tmp->next)
+    add_group (&builder, tmp->data, indexes);
+  g_hash_table_unref (indexes);
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+serialize_metas (const gchar * target, gpointer container)
+{
+  GVariant *ret;
+  gchar *metas = ges_meta_container_metas_to_string (container);
+
+  ret = g_variant_new (METAS_FORMAT, target, metas);
+  g_free (metas);
+
+  return ret;
+}
+
+static void
+append_dirty_record (GESProjectJournal * journal, GByteArray * buffer,
+    gpointer object)
+{
+  GESLayer *layer;
+  const gchar *old_name;
+
+  if (GES_IS_LAYER (object)) {
+    gchar *properties, *metas;
+
+    layer = object;
+    if (ges_layer_get_timeline (layer) != journal->timeline)
+      return;
+
+    properties = _serialize_properties (G_OBJECT (layer), "priority", NULL);
+    metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (layer));
+    append_record (buffer, RECORD_LAYER, g_variant_new (LAYER_FORMAT,
+            ges_layer_get_priority (layer), properties, metas));
+    g_free (properties);
+    g_free (metas);
+
+    return;
+  }
+
+  /* Clips removed since then have their own record */
+  layer = ges_clip_get_layer (object);
+  if (!layer)
+    return;
+
+  if (ges_layer_get_timeline (layer) == journal->timeline) {
+    old_name = g_hash_table_lookup (journal->names, object);
+    if (old_name && g_strcmp0 (old_name, GES_TIMELINE_ELEMENT_NAME (object))) {
+      append_record (buffer, RECORD_CLIP_REMOVED,
+          g_variant_new_string (old_name));
+      g_hash_table_insert (journal->names, object,
+          g_strdup (GES_TIMELINE_ELEMENT_NAME (object)));
+    }
+
+    append_record (buffer, RECORD_CLIP, serialize_clip (journal, object,
+            ges_layer_get_priority (layer)));
+  }
+  gst_object_unref (layer);
+}
+
+/* Serializes the state of the clips and layers that changed so far */
+static void
+append_dirty_records (GESProjectJournal * journal, GByteArray * buffer)
+{
+  gpointer object;
+
+  while ((object = g_queue_pop_head (&journal->dirty))) {
+    g_hash_table_remove (journal->dirty_set, object);
+    append_dirty_record (journal, buffer, object);
+    gst_object_unref (object);
+  }
+}
+
+static gboolean
+write_pending (GESProjectJournal * journal, GError ** error)
+{
+  gboolean ret = TRUE;
+  GByteArray *buffer = journal->pending;
+
+  if (!journal->stream || !journal->timeline)
+    return TRUE;
+
+  append_dirty_records (journal, buffer);
+
+  if (journal->groups_dirty)
+    append_record (buffer, RECORD_GROUPS, serialize_groups (journal));
+  if (journal->project_metas_dirty)
+    append_record (buffer, RECORD_METAS, serialize_metas ("project",
+            journal->project));
+  if (journal->timeline_metas_dirty)
+    append_record (buffer, RECORD_METAS, serialize_metas ("timeline",
+            journal->timeline));
+  journal->groups_dirty = journal->project_metas_dirty =
+      journal->timeline_metas_dirty = FALSE;
+
+  if (buffer->len) {
+    ret = g_output_stream_write_all (journal->stream, buffer->data,
+        buffer->len, NULL, NULL, error) &&
+        g_output_stream_flush (journal->stream, NULL, error);
+    journal->size += buffer->len;
+    if (journal->saving)
+      g_byte_array_append (journal->saving_records, buffer->data,
+          buffer->len);
+  }
+  g_byte_array_set_size (buffer, 0);
+
+  return ret;
+}
+
+static void
+compacted_cb (GESProject * project, GAsyncResult * result, gpointer unused)
+{
+  GError *err = NULL;
+
+  if (!ges_project_save_finish (project, result, &err)) {
+    GST_WARNING_OBJECT (project, "Could not compact the journal: %s",
+        err->message);
+    g_clear_error (&err);
+  }
+}
+
+static gboolean
+write_idle_cb (GESProjectJournal * journal)
+{
+  GError *err = NULL;
+
+  journal->idle_id = 0;
+  if (!write_pending (journal, &err)) {
+    GST_WARNING_OBJECT (journal->project, "Could not write the journal: %s",
+        err->message);
+    g_clear_error (&err);
+  }
+
+  /* Replaying it would now be slower than loading the whole project. The
+   * project is serialized from the main context a few clips at a time and
+   * written from another thread, the changes made meanwhile keep being
+   * journaled */
+  if (!journal->saving && journal->timeline && journal->stream &&
+      journal->size > journal->compact_size) {
+    GST_INFO_OBJECT (journal->project, "Journal is %" G_GUINT64_FORMAT
+        " bytes, saving the whole project", journal->size);
+    ges_project_save_async (journal->project, journal->timeline,
+        journal->uri, journal->formatter_asset ?
+        gst_object_ref (journal->formatter_asset) : NULL, TRUE, NULL,
+        (GAsyncReadyCallback) compacted_cb, NULL);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_write (GESProjectJournal * journal)
+{
+  if (!journal->idle_id)
+    journal->idle_id = g_idle_add_full (G_PRIORITY_LOW,
+        (GSourceFunc) write_idle_cb, journal, NULL);
+}
+
+static void
+mark_dirty (GESProjectJournal * journal, gpointer object)
+{
+  if (g_hash_table_contains (journal->dirty_set, object))
+    return;
+
+  g_hash_table_add (journal->dirty_set, object);
+  g_queue_push_tail (&journal->dirty, gst_object_ref (object));
+  schedule_write (journal);
+}
+
+/* What changed before gets serialized first, so that replaying does not
+ * apply it after the removal */
+static void
+add_removal (GESProjectJournal * journal, gchar type, GVariant * value)
+{
+  append_dirty_records (journal, journal->pending);
+  append_record (journal->pending, type, value);
+  schedule_write (journal);
+}
+
+/***********************************************
+ *                                             *
+ *                Notifications                *
+ *                                             *
+ ***********************************************/
+
+static void
+mark_parent_dirty (GESProjectJournal * journal, GESTrackElement * element)
+{
+  GESTimelineElement *parent = GES_TIMELINE_ELEMENT_PARENT (element);
+
+  if (GES_IS_CLIP (parent))
+    mark_dirty (journal, parent);
+}
+
+static void
+source_changed_cb (GstControlSource * source, gpointer unused,
+    GESProjectJournal * journal)
+{
+  GESTrackElement *element = g_hash_table_lookup (journal->sources, source);
+
+  if (element)
+    mark_parent_dirty (journal, element);
+}
+
+static void
+connect_binding (GESProjectJournal * journal, GESTrackElement * element,
+    GstControlBinding * binding)
+{
+  guint i;
+  GstControlSource *source;
+  const gchar *signals[] = { "value-added", "value-changed", "value-removed",
+    "notify::mode", NULL
+  };
+
+  g_object_get (binding, "control-source", &source, NULL);
+  if (!GST_IS_TIMED_VALUE_CONTROL_SOURCE (source) ||
+      g_hash_table_contains (journal->sources, source)) {
+    if (source)
+      gst_object_unref (source);
+
+    return;
+  }
+
+  for (i = 0; signals[i]; i++)
+    g_signal_connect (source, signals[i], G_CALLBACK (source_changed_cb),
+        journal);
+  g_hash_table_insert (journal->sources, source, element);
+}
+
+static void
+disconnect_binding (GESProjectJournal * journal, GstControlBinding * binding)
+{
+  GstControlSource *source;
+
+  g_object_get (binding, "control-source", &source, NULL);
+  if (!source)
+    return;
+
+  if (g_hash_table_contains (journal->sources, source)) {
+    g_signal_handlers_disconnect_by_data (source, journal);
+    g_hash_table_remove (journal->sources, source);
+  }
+  gst_object_unref (source);
+}
+
+static void
+track_element_changed_cb (GESTrackElement * element, gpointer unused,
+    GESProjectJournal * journal)
+{
+  mark_parent_dirty (journal, element);
+}
+
+static void
+track_element_deep_changed_cb (GESTrackElement * element, GObject * child,
+    GParamSpec * pspec, GESProjectJournal * journal)
+{
+  mark_parent_dirty (journal, element);
+}
+
+static void
+track_element_meta_changed_cb (GESTrackElement * element, const gchar * key,
+    const GValue * value, GESProjectJournal * journal)
+{
+  mark_parent_dirty (journal, element);
+}
+
+static void
+binding_added_cb (GESTrackElement * element, GstControlBinding * binding,
+    GESProjectJournal * journal)
+{
+  connect_binding (journal, element, binding);
+  mark_parent_dirty (journal, element);
+}
+
+static void
+binding_removed_cb (GESTrackElement * element, GstControlBinding * binding,
+    GESProjectJournal * journal)
+{
+  disconnect_binding (journal, binding);
+  mark_parent_dirty (journal, element);
+}
+
+static void
+connect_track_element (GESProjectJournal * journal, GESTrackElement * element)
+{
+  gpointer binding;
+  GHashTableIter iter;
+
+  g_signal_connect (element, "notify", G_CALLBACK (track_element_changed_cb),
+      journal);
+  g_signal_connect (element, "deep-notify",
+      G_CALLBACK (track_element_deep_changed_cb), journal);
+  g_signal_connect (element, "notify-meta",
+      G_CALLBACK (track_element_meta_changed_cb), journal);
+  g_signal_connect (element, "control-binding-added",
+      G_CALLBACK (binding_added_cb), journal);
+  g_signal_connect (element, "control-binding-removed",
+      G_CALLBACK (binding_removed_cb), journal);
+
+  g_hash_table_iter_init (&iter,
+      ges_track_element_get_all_control_bindings (element));
+  while (g_hash_table_iter_next (&iter, NULL, &binding))
+    connect_binding (journal, element, binding);
+}
+
+static void
+disconnect_track_element (GESProjectJournal * journal,
+    GESTrackElement * element)
+{
+  gpointer binding;
+  GHashTableIter iter;
+
+  g_signal_handlers_disconnect_by_data (element, journal);
+  g_hash_table_iter_init (&iter,
+      ges_track_element_get_all_control_bindings (element));
+  while (g_hash_table_iter_next (&iter, NULL, &binding))
+    disconnect_binding (journal, binding);
+}
+
+static void
+clip_changed_cb (GESClip * clip, gpointer unused, GESProjectJournal * journal)
+{
+  mark_dirty (journal, clip);
+}
+
+static void
+clip_meta_changed_cb (GESClip * clip, const gchar * key, const GValue * value,
+    GESProjectJournal * journal)
+{
+  mark_dirty (journal, clip);
+}
+
+static void
+clip_child_added_cb (GESClip * clip, GESTimelineElement * child,
+    GESProjectJournal * journal)
+{
+  if (GES_IS_TRACK_ELEMENT (child))
+    connect_track_element (journal, GES_TRACK_ELEMENT (child));
+  mark_dirty (journal, clip);
+}
+
+static void
+clip_child_removed_cb (GESClip * clip, GESTimelineElement * child,
+    GESProjectJournal * journal)
+{
+  if (GES_IS_TRACK_ELEMENT (child))
+    disconnect_track_element (journal, GES_TRACK_ELEMENT (child));
+  mark_dirty (journal, clip);
+}
+
+static void
+connect_clip (GESProjectJournal * journal, GESClip * clip)
+{
+  GList *tmp;
+
+  if (g_hash_table_contains (journal->names, clip))
+    return;
+
+  g_hash_table_insert (journal->names, clip,
+      g_strdup (GES_TIMELINE_ELEMENT_NAME (clip)));
+  g_signal_connect (clip, "notify", G_CALLBACK (clip_changed_cb), journal);
+  g_signal_connect (clip, "notify-meta", G_CALLBACK (clip_meta_changed_cb),
+      journal);
+  g_signal_connect (clip, "child-added", G_CALLBACK (clip_child_added_cb),
+      journal);
+  g_signal_connect (clip, "child-removed", G_CALLBACK (clip_child_removed_cb),
+      journal);
+
+  for (tmp = GES_CONTAINER_CHILDREN (clip); tmp; tmp = tmp->next) {
+    if (GES_IS_TRACK_ELEMENT (tmp->data))
+      connect_track_element (journal, tmp->data);
+  }
+}
+
+static void
+disconnect_clip (GESProjectJournal * journal, GESClip * clip)
+{
+  GList *tmp;
+
+  g_signal_handlers_disconnect_by_data (clip, journal);
+  for (tmp = GES_CONTAINER_CHILDREN (clip); tmp; tmp = tmp->next) {
+    if (GES_IS_TRACK_ELEMENT (tmp->data))
+      disconnect_track_element (journal, tmp->data);
+  }
+  g_hash_table_remove (journal->names, clip);
+}
+
+static void
+clip_added_cb (GESLayer * layer, GESClip * clip, GESProjectJournal * journal)
+{
+  connect_clip (journal, clip);
+  mark_dirty (journal, clip);
+}
+
+static void
+clip_removed_cb (GESLayer * layer, GESClip * clip,
+    GESProjectJournal * journal)
+{
+  const gchar *name;
+
+  /* It will be written with its new layer */
+  if (ges_clip_is_moving_from_layer (clip))
+    return;
+
+  name = g_hash_table_lookup (journal->names, clip);
+  add_removal (journal, RECORD_CLIP_REMOVED, g_variant_new_string (name ?
+          name : GES_TIMELINE_ELEMENT_NAME (clip)));
+  disconnect_clip (journal, clip);
+}
+
+static void
+layer_changed_cb (GESLayer * layer, GParamSpec * pspec,
+    GESProjectJournal * journal)
+{
+  mark_dirty (journal, layer);
+
+  /* Clips are journaled with the priority of their layer */
+  if (!g_strcmp0 (pspec->name, "priority")) {
+    GList *tmp, *clips = ges_layer_get_clips (layer);
+
+    for (tmp = clips; tmp; tmp = tmp->next)
+      mark_dirty (journal, tmp->data);
+    g_list_free_full (clips, gst_object_unref);
+  }
+}
+
+static void
+layer_meta_changed_cb (GESLayer * layer, const gchar * key,
+    const GValue * value, GESProjectJournal * journal)
+{
+  mark_dirty (journal, layer);
+}
+
+static void
+connect_layer (GESProjectJournal * journal, GESLayer * layer)
+{
+  GList *tmp, *clips;
+
+  g_signal_connect (layer, "clip-added", G_CALLBACK (clip_added_cb), journal);
+  g_signal_connect (layer, "clip-removed", G_CALLBACK (clip_removed_cb),
+      journal);
+  g_signal_connect (layer, "notify", G_CALLBACK (layer_changed_cb), journal);
+  g_signal_connect (layer, "notify-meta", G_CALLBACK (layer_meta_changed_cb),
+      journal);
+
+  clips = ges_layer_get_clips (layer);
+  for (tmp = clips; tmp; tmp = tmp->next)
+    connect_clip (journal, tmp->data);
+  g_list_free_full (clips, gst_object_unref);
+}
+
+static void
+disconnect_layer (GESProjectJournal * journal, GESLayer * layer)
+{
+  GList *tmp, *clips;
+
+  g_signal_handlers_disconnect_by_data (layer, journal);
+
+  clips = ges_layer_get_clips (layer);
+  for (tmp = clips; tmp; tmp = tmp->next)
+    disconnect_clip (journal, tmp->data);
+  g_list_free_full (clips, gst_object_unref);
+}
+
+static void
+layer_added_cb (GESTimeline * timeline, GESLayer * layer,
+    GESProjectJournal * journal)
+{
+  GList *tmp, *clips;
+
+  connect_layer (journal, layer);
+  mark_dirty (journal, layer);
+
+  clips = ges_layer_get_clips (layer);
+  for (tmp = clips; tmp; tmp = tmp->next)
+    mark_dirty (journal, tmp->data);
+  g_list_free_full (clips, gst_object_unref);
+}
+
+static void
+layer_removed_cb (GESTimeline * timeline, GESLayer * layer,
+    GESProjectJournal * journal)
+{
+  add_removal (journal, RECORD_LAYER_REMOVED,
+      g_variant_new_uint32 (ges_layer_get_priority (layer)));
+  disconnect_layer (journal, layer);
+}
+
+static void
+group_changed_cb (GESGroup * group, gpointer unused,
+    GESProjectJournal * journal)
+{
+  journal->groups_dirty = TRUE;
+  schedule_write (journal);
+}
+
+static void
+connect_group (GESProjectJournal * journal, GESGroup * group)
+{
+  g_signal_connect (group, "child-added", G_CALLBACK (group_changed_cb),
+      journal);
+  g_signal_connect (group, "child-removed", G_CALLBACK (group_changed_cb),
+      journal);
+}
+
+static void
+group_added_cb (GESTimeline * timeline, GESGroup * group,
+    GESProjectJournal * journal)
+{
+  connect_group (journal, group);
+  group_changed_cb (group, NULL, journal);
+}
+
+static void
+group_removed_cb (GESTimeline * timeline, GESGroup * group,
+    GPtrArray * children, GESProjectJournal * journal)
+{
+  g_signal_handlers_disconnect_by_data (group, journal);
+  group_changed_cb (group, NULL, journal);
+}
+
+static void
+timeline_meta_changed_cb (GESTimeline * timeline, const gchar * key,
+    const GValue * value, GESProjectJournal * journal)
+{
+  journal->timeline_metas_dirty = TRUE;
+  schedule_write (journal);
+}
+
+static void
+project_meta_changed_cb (GESProject * project, const gchar * key,
+    const GValue * value, GESProjectJournal * journal)
+{
+  journal->project_metas_dirty = TRUE;
+  schedule_write (journal);
+}
+
+static void
+disconnect_timeline (GESProjectJournal * journal)
+{
+  GList *tmp;
+  GHashTableIter iter;
+  gpointer source;
+
+  for (tmp = journal->timeline->layers; tmp; tmp = tmp->next)
+    disconnect_layer (journal, tmp->data);
+  for (tmp = ges_timeline_get_groups (journal->timeline); tmp; tmp = tmp->next)
+    g_signal_handlers_disconnect_by_data (tmp->data, journal);
+  g_signal_handlers_disconnect_by_data (journal->timeline, journal);
+
+  g_hash_table_iter_init (&iter, journal->sources);
+  while (g_hash_table_iter_next (&iter, &source, NULL))
+    g_signal_handlers_disconnect_by_data (source, journal);
+  g_hash_table_remove_all (journal->sources);
+}
+
+static gboolean
+release_timeline (GESTimeline * timeline)
+{
+  gst_object_unref (timeline);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+timeline_toggle_cb (GESProjectJournal * journal, GESTimeline * timeline,
+    gboolean is_last_ref)
+{
+  GError *err = NULL;
+
+  if (!is_last_ref)
+    return;
+
+  /* Nobody uses the timeline anymore, what happens while it gets destroyed
+   * should not be journaled */
+  if (!write_pending (journal, &err)) {
+    GST_WARNING_OBJECT (journal->project, "Could not write the journal: %s",
+        err->message);
+    g_clear_error (&err);
+  }
+  disconnect_timeline (journal);
+  journal->timeline = NULL;
+
+  /* Not destroyed from its own toggle notification */
+  gst_object_ref (timeline);
+  g_object_remove_toggle_ref (G_OBJECT (timeline),
+      (GToggleNotify) timeline_toggle_cb, journal);
+  g_idle_add ((GSourceFunc) release_timeline, timeline);
+}
+
+/***********************************************
+ *                                             *
+ *                   Replay                    *
+ *                                             *
+ ***********************************************/
+
+static void
+set_properties (gpointer object, const gchar * str, gboolean children)
+{
+  GstStructure *structure;
+
+  if (!*str)
+    return;
+
+  structure = gst_structure_from_string (str, NULL);
+  if (!structure) {
+    GST_WARNING_OBJECT (object, "Invalid properties: %s", str);
+
+    return;
+  }
+
+  /* Not serialized anymore, but it used to be */
+  if (GES_IS_TRACK_ELEMENT (object))
+    gst_structure_remove_field (structure, "priority");
+
+  gst_structure_foreach (structure, children ?
+      (GstStructureForeachFunc) set_child_property_foreach :
+      (GstStructureForeachFunc) set_property_foreach, object);
+  gst_structure_free (structure);
+}
+
+static void
+add_metas (gpointer container, const gchar * metas)
+{
+  if (*metas)
+    ges_meta_container_add_metas_from_string (container, metas);
+}
+
+static GESLayer *
+get_layer (GESTimeline * timeline, guint priority)
+{
+  GList *tmp;
+  GESLayer *layer;
+
+  for (tmp = timeline->layers; tmp; tmp = tmp->next) {
+    if (ges_layer_get_priority (tmp->data) == priority)
+      return tmp->data;
+  }
+
+  layer = ges_layer_new ();
+  ges_layer_set_priority (layer, priority);
+  ges_timeline_add_layer (timeline, layer);
+
+  return layer;
+}
+
+static void
+remove_clip (GESTimeline * timeline, const gchar * name)
+{
+  GESLayer *layer;
+  GESTimelineElement *element = ges_timeline_get_element (timeline, name);
+
+  if (!element)
+    return;
+
+  if (GES_IS_CLIP (element) &&
+      (layer = ges_clip_get_layer (GES_CLIP (element)))) {
+    ges_layer_remove_clip (layer, GES_CLIP (element));
+    gst_object_unref (layer);
+  }
+  gst_object_unref (element);
+}
+
+static void
+apply_bindings (GESTrackElement * element, GVariant * bindings)
+{
+  gint mode;
+  GVariantIter iter, *values;
+  const gchar *property, *binding_type;
+
+  g_variant_iter_init (&iter, bindings);
+  while (g_variant_iter_next (&iter, "(&s&sia(td))", &property, &binding_type,
+          &mode, &values)) {
+    gdouble value;
+    GstClockTime timestamp;
+    GstControlSource *source = gst_interpolation_control_source_new ();
+
+    ges_track_element_set_control_source (element, source, property,
+        binding_type);
+    g_object_set (source, "mode", mode, NULL);
+    while (g_variant_iter_next (values, "(td)", &timestamp, &value))
+      gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE
+          (source), timestamp, value);
+    g_variant_iter_free (values);
+  }
+}
+
+static GESTrackElement *
+get_source (GESClip * clip, GList * tracks, gint track_index)
+{
+  GList *tmp;
+  GESTrack *track;
+
+  if (track_index < 0 || !(track = g_list_nth_data (tracks, track_index)))
+    return NULL;
+
+  for (tmp = GES_CONTAINER_CHILDREN (clip); tmp; tmp = tmp->next) {
+    if (GES_IS_SOURCE (tmp->data) &&
+        ges_track_element_get_track (tmp->data) == track)
+      return tmp->data;
+  }
+
+  return NULL;
+}
+
+static void
+apply_track_elements (GESClip * clip, GVariant * elements)
+{
+  GList *tracks;
+  GVariantIter iter;
+  gint track_index;
+  GVariant *bindings;
+  const gchar *type_name, *asset_id, *properties, *children_properties,
+      *metas;
+
+  tracks = ges_timeline_get_tracks (GES_TIMELINE_ELEMENT_TIMELINE (clip));
+  g_variant_iter_init (&iter, elements);
+  while (g_variant_iter_next (&iter, "(&s&si&s&s&s@" BINDINGS_FORMAT ")",
+          &type_name, &asset_id, &track_index, &properties,
+          &children_properties, &metas, &bindings)) {
+    GESTrackElement *element = NULL;
+
+    if (*type_name) {
+      GError *err = NULL;
+      GESAsset *asset = NULL;
+      GType type = g_type_from_name (type_name);
+
+      if (g_type_is_a (type, GES_TYPE_BASE_EFFECT))
+        asset = ges_asset_request (type, asset_id, &err);
+
+      if (asset) {
+        element = GES_TRACK_ELEMENT (ges_asset_extract (asset, &err));
+        gst_object_unref (asset);
+      }
+
+      if (element) {
+        ges_container_add (GES_CONTAINER (clip),
+            GES_TIMELINE_ELEMENT (element));
+        set_properties (element, properties, FALSE);
+        add_metas (element, metas);
+      } else {
+        GST_WARNING_OBJECT (clip, "Could not create effect %s: %s", asset_id,
+            err ? err->message : "Unknown error");
+        g_clear_error (&err);
+      }
+    } else {
+      element = get_source (clip, tracks, track_index);
+    }
+
+    if (element) {
+      set_properties (element, children_properties, TRUE);
+      apply_bindings (element, bindings);
+    }
+    g_variant_unref (bindings);
+  }
+  g_list_free_full (tracks, gst_object_unref);
+}
+
+/* Returns %FALSE if the asset of the clip is not in @project yet, in which
+ * case nothing is applied */
+static gboolean
+apply_clip (GESProject * project, GESTimeline * timeline, GVariant * value)
+{
+  GType type;
+  GESClip *clip;
+  GESAsset *asset;
+  gboolean ret = TRUE;
+  guint priority, track_types;
+  GstClockTime start, inpoint, duration;
+  GVariant *elements;
+  const gchar *name, *type_name, *asset_id, *properties, *children_properties,
+      *metas;
+
+  g_variant_get (value, "(&s&s&sutttu&s&s&s@a(ssisssa(ssia(td))))", &name,
+      &type_name, &asset_id, &priority, &start, &inpoint, &duration,
+      &track_types, &properties, &children_properties, &metas, &elements);
+
+  type = g_type_from_name (type_name);
+  if (!g_type_is_a (type, GES_TYPE_CLIP)) {
+    GST_WARNING_OBJECT (project, "%s is not a clip type", type_name);
+    remove_clip (timeline, name);
+    goto done;
+  }
+
+  asset = ges_project_get_asset (project, asset_id, type);
+  if (!asset) {
+    ret = FALSE;
+    goto done;
+  }
+
+  remove_clip (timeline, name);
+  clip = ges_layer_add_asset (get_layer (timeline, priority), asset, start,
+      inpoint, duration, track_types);
+  gst_object_unref (asset);
+  if (!clip) {
+    GST_WARNING_OBJECT (project, "Could not add clip %s", name);
+    goto done;
+  }
+
+  add_metas (clip, metas);
+  set_properties (clip, properties, FALSE);
+  set_properties (clip, children_properties, TRUE);
+  apply_track_elements (clip, elements);
+
+done:
+  g_variant_unref (elements);
+
+  return ret;
+}
+
+static void
+apply_layer (GESTimeline * timeline, GVariant * value,
+    GHashTable * auto_transitions)
+{
+  guint priority;
+  GESLayer *layer;
+  GstStructure *structure;
+  gboolean auto_transition;
+  const gchar *properties, *metas;
+
+  g_variant_get (value, "(u&s&s)", &priority, &properties, &metas);
+  layer = get_layer (timeline, priority);
+  structure = gst_structure_from_string (properties, NULL);
+  if (structure) {
+    /* Set once everything is replayed, as when loading projects */
+    if (gst_structure_get_boolean (structure, "auto-transition",
+            &auto_transition)) {
+      gst_structure_remove_field (structure, "auto-transition");
+      g_hash_table_insert (auto_transitions, layer,
+          GINT_TO_POINTER (auto_transition));
+    }
+
+    gst_structure_foreach (structure,
+        (GstStructureForeachFunc) set_property_foreach, layer);
+    gst_structure_free (structure);
+  }
+  add_metas (layer, metas);
+}
+
+static void
+apply_layer_removed (GESTimeline * timeline, GVariant * value,
+    GHashTable * auto_transitions)
+{
+  GList *tmp;
+  guint priority = g_variant_get_uint32 (value);
+
+  for (tmp = timeline->layers; tmp; tmp = tmp->next) {
+    if (ges_layer_get_priority (tmp->data) == priority) {
+      g_hash_table_remove (auto_transitions, tmp->data);
+      ges_timeline_remove_layer (timeline, tmp->data);
+
+      return;
+    }
+  }
+}
+
+static void
+apply_groups (GESTimeline * timeline, GVariant * value)
+{
+  GList *tmp, *groups;
+  GVariantIter iter, *clips, *children;
+  GPtrArray *created = g_ptr_array_new ();
+
+  /* Groups are not named, they are all created again */
+  groups = g_list_copy_deep (ges_timeline_get_groups (timeline),
+      (GCopyFunc) gst_object_ref, NULL);
+  for (tmp = groups; tmp; tmp = tmp->next) {
+    if (GES_TIMELINE_ELEMENT_TIMELINE (tmp->data) == timeline)
+      g_list_free_full (ges_container_ungroup (tmp->data, FALSE),
+          gst_object_unref);
+  }
+  g_list_free_full (groups, gst_object_unref);
+
+  g_variant_iter_init (&iter, value);
+  while (g_variant_iter_next (&iter, "(asai)", &clips, &children)) {
+    gint index;
+    const gchar *name;
+    GESGroup *group = ges_group_new ();
+
+    timeline_add_group (timeline, group);
+    while (g_variant_iter_next (clips, "&s", &name)) {
+      GESTimelineElement *child = ges_timeline_get_element (timeline, name);
+
+      if (child) {
+        ges_container_add (GES_CONTAINER (group), child);
+        gst_object_unref (child);
+      }
+    }
+
+    while (g_variant_iter_next (children, "i", &index)) {
+      if (index >= 0 && index < created->len &&
+          g_ptr_array_index (created, index))
+        ges_container_add (GES_CONTAINER (group),
+            g_ptr_array_index (created, index));
+    }
+
+    if (!GES_CONTAINER_CHILDREN (group)) {
+      timeline_remove_group (timeline, group);
+      group = NULL;
+    }
+    g_ptr_array_add (created, group);
+
+    g_variant_iter_free (clips);
+    g_variant_iter_free (children);
+  }
+  g_ptr_array_free (created, TRUE);
+}
+
+static void
+apply_metas (GESProject * project, GESTimeline * timeline, GVariant * value)
+{
+  const gchar *target, *metas;
+
+  g_variant_get (value, "(&s&s)", &target, &metas);
+  if (!g_strcmp0 (target, "project"))
+    add_metas (project, metas);
+  else
+    add_metas (timeline, metas);
+}
+
+static const gchar *
+get_record_format (gchar type)
+{
+  switch (type) {
+    case RECORD_CLIP:
+      return CLIP_FORMAT;
+    case RECORD_CLIP_REMOVED:
+      return "s";
+    case RECORD_LAYER:
+      return LAYER_FORMAT;
+    case RECORD_LAYER_REMOVED:
+      return "u";
+    case RECORD_METAS:
+      return METAS_FORMAT;
+    case RECORD_GROUPS:
+      return GROUPS_FORMAT;
+    default:
+      return NULL;
+  }
+}
+
+typedef struct
+{
+  GESTimeline *timeline;
+  gchar *uri;
+  gchar *contents;
+  gsize length;
+  gsize offset;
+  guint n_records;
+  /* The clip record waiting for its asset to be loaded */
+  GVariant *pending_clip;
+  GHashTable *auto_transitions;
+  gboolean timeline_auto_transition;
+} Replay;
+
+static void
+replay_free (Replay * replay)
+{
+  if (replay->pending_clip)
+    g_variant_unref (replay->pending_clip);
+  g_hash_table_unref (replay->auto_transitions);
+  gst_object_unref (replay->timeline);
+  g_free (replay->contents);
+  g_free (replay->uri);
+  g_slice_free (Replay, replay);
+}
+
+static void
+replay_done (GTask * task)
+{
+  GHashTableIter iter;
+  gpointer layer, auto_transition;
+  Replay *replay = g_task_get_task_data (task);
+
+  ges_timeline_set_auto_transition (replay->timeline,
+      replay->timeline_auto_transition);
+  g_hash_table_iter_init (&iter, replay->auto_transitions);
+  while (g_hash_table_iter_next (&iter, &layer, &auto_transition))
+    ges_layer_set_auto_transition (layer, GPOINTER_TO_INT (auto_transition));
+
+  GST_INFO_OBJECT (g_task_get_source_object (task),
+      "Replayed %u journal records of %s", replay->n_records, replay->uri);
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+static void replay_records (GTask * task);
+
+static void
+clip_asset_loaded_cb (GObject * source, GAsyncResult * result, GTask * task)
+{
+  GError *err = NULL;
+  const gchar *name, *asset_id;
+  Replay *replay = g_task_get_task_data (task);
+  GESProject *project = g_task_get_source_object (task);
+  GESAsset *asset = ges_asset_request_finish (result, &err);
+
+  if (asset) {
+    ges_project_add_asset (project, asset);
+    gst_object_unref (asset);
+  }
+
+  if (!asset || !apply_clip (project, replay->timeline, replay->pending_clip)) {
+    g_variant_get_child (replay->pending_clip, 0, "&s", &name);
+    g_variant_get_child (replay->pending_clip, 2, "&s", &asset_id);
+    GST_WARNING_OBJECT (project, "Could not create asset %s: %s", asset_id,
+        err ? err->message : "Unknown error");
+    remove_clip (replay->timeline, name);
+  }
+  g_clear_error (&err);
+
+  g_clear_pointer (&replay->pending_clip, g_variant_unref);
+  replay->n_records++;
+  replay_records (task);
+}
+
+/* Applies the records from where the replay is, until one needs an asset
+ * that is not loaded yet */
+static void
+replay_records (GTask * task)
+{
+  gchar type;
+  GVariant *value;
+  Replay *replay = g_task_get_task_data (task);
+  GESProject *project = g_task_get_source_object (task);
+  GESTimeline *timeline = replay->timeline;
+  GHashTable *auto_transitions = replay->auto_transitions;
+
+  while ((value = read_record ((const guint8 *) replay->contents,
+              replay->length, &replay->offset, &type))) {
+    const gchar *format = get_record_format (type);
+
+    if (!format || !g_variant_is_of_type (value, G_VARIANT_TYPE (format))) {
+      GST_WARNING_OBJECT (project, "Invalid journal record '%c'", type);
+      g_variant_unref (value);
+      break;
+    }
+
+    switch (type) {
+      case RECORD_CLIP:
+        if (!apply_clip (project, timeline, value)) {
+          const gchar *type_name, *asset_id;
+
+          /* Loaded without blocking, what follows is applied once done */
+          g_variant_get_child (value, 1, "&s", &type_name);
+          g_variant_get_child (value, 2, "&s", &asset_id);
+          replay->pending_clip = value;
+          ges_asset_request_async (g_type_from_name (type_name), asset_id,
+              NULL, (GAsyncReadyCallback) clip_asset_loaded_cb, task);
+
+          return;
+        }
+        break;
+      case RECORD_CLIP_REMOVED:
+        remove_clip (timeline, g_variant_get_string (value, NULL));
+        break;
+      case RECORD_LAYER:
+        apply_layer (timeline, value, auto_transitions);
+        break;
+      case RECORD_LAYER_REMOVED:
+        apply_layer_removed (timeline, value, auto_transitions);
+        break;
+      case RECORD_METAS:
+        apply_metas (project, timeline, value);
+        break;
+      case RECORD_GROUPS:
+        apply_groups (timeline, value);
+        break;
+    }
+
+    g_variant_unref (value);
+    replay->n_records++;
+  }
+
+  replay_done (task);
+}
+
+/**
+ * ges_project_journal_replay_async:
+ * @project: The #GESProject being loaded
+ * @timeline: The #GESTimeline it was loaded in
+ * @callback: Called once the journal has been replayed
+ * @user_data: The data to pass to @callback
+ *
+ * Applies the changes journaled since @project was last saved to
+ * @timeline. The assets of the clips that were added meanwhile are loaded
+ * asynchronously, the records are applied in order as they get ready.
+ */
+void
+ges_project_journal_replay_async (GESProject * project,
+    GESTimeline * timeline, GAsyncReadyCallback callback, gpointer user_data)
+{
+  GList *tmp;
+  gchar type, *etag;
+  Replay *replay;
+  GFile *file;
+  GTask *task = g_task_new (project, NULL, callback, user_data);
+
+  replay = g_slice_new0 (Replay);
+  replay->uri = ges_project_get_uri (project);
+  replay->timeline = gst_object_ref (timeline);
+  replay->auto_transitions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_task_set_task_data (task, replay, (GDestroyNotify) replay_free);
+
+  if (!replay->uri) {
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+
+    return;
+  }
+
+  file = get_journal_file (replay->uri);
+  etag = get_project_stamp (replay->uri, NULL);
+  if (!load_journal (file, etag, &replay->contents, &replay->length)) {
+    replay->contents = NULL;
+    g_object_unref (file);
+    g_free (etag);
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+
+    return;
+  }
+  g_object_unref (file);
+  g_free (etag);
+
+  /* The header was checked */
+  g_variant_unref (read_record ((const guint8 *) replay->contents,
+          replay->length, &replay->offset, &type));
+
+  /* Transitions are journaled as the other clips */
+  replay->timeline_auto_transition =
+      ges_timeline_get_auto_transition (timeline);
+  for (tmp = timeline->layers; tmp; tmp = tmp->next)
+    g_hash_table_insert (replay->auto_transitions, tmp->data,
+        GINT_TO_POINTER (ges_layer_get_auto_transition (tmp->data)));
+  ges_timeline_set_auto_transition (timeline, FALSE);
+
+  replay_records (task);
+}
+
+/***********************************************
+ *                                             *
+ *                     API                     *
+ *                                             *
+ ***********************************************/
+
+/**
+ * ges_project_journal_new:
+ * @project: A saved #GESProject
+ * @timeline: The #GESTimeline of @project whose changes get journaled
+ * @uri: The uri of @project
+ * @formatter_asset: (allow-none): The formatter to save @project with
+ * @error: An error to be set in case something wrong happens or %NULL
+ *
+ * Starts journaling the changes made to @timeline, keeping what was
+ * already journaled since @project was saved.
+ *
+ * Returns: (transfer full) (nullable): A new #GESProjectJournal
+ */
+GESProjectJournal *
+ges_project_journal_new (GESProject * project, GESTimeline * timeline,
+    const gchar * uri, GESAsset * formatter_asset, GError ** error)
+{
+  GList *tmp;
+  GESProjectJournal *journal = g_slice_new0 (GESProjectJournal);
+
+  journal->project = project;
+  journal->uri = g_strdup (uri);
+  journal->file = get_journal_file (uri);
+  journal->formatter_asset = formatter_asset ?
+      gst_object_ref (formatter_asset) : NULL;
+  journal->pending = g_byte_array_new ();
+  journal->saving_records = g_byte_array_new ();
+  g_queue_init (&journal->dirty);
+  journal->dirty_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+  journal->names = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      g_free);
+  journal->sources = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      gst_object_unref, NULL);
+
+  if (!open_journal (journal, FALSE, error)) {
+    ges_project_journal_free (journal);
+
+    return NULL;
+  }
+
+  /* The timeline keeps the project alive, the journal is stopped once
+   * nobody else uses the timeline */
+  journal->timeline = timeline;
+  g_object_add_toggle_ref (G_OBJECT (timeline),
+      (GToggleNotify) timeline_toggle_cb, journal);
+
+  for (tmp = timeline->layers; tmp; tmp = tmp->next)
+    connect_layer (journal, tmp->data);
+  for (tmp = ges_timeline_get_groups (timeline); tmp; tmp = tmp->next)
+    connect_group (journal, tmp->data);
+  g_signal_connect (timeline, "layer-added", G_CALLBACK (layer_added_cb),
+      journal);
+  g_signal_connect (timeline, "layer-removed", G_CALLBACK (layer_removed_cb),
+      journal);
+  g_signal_connect (timeline, "group-added", G_CALLBACK (group_added_cb),
+      journal);
+  g_signal_connect (timeline, "group-removed", G_CALLBACK (group_removed_cb),
+      journal);
+  g_signal_connect (timeline, "notify-meta",
+      G_CALLBACK (timeline_meta_changed_cb), journal);
+  g_signal_connect (project, "notify-meta",
+      G_CALLBACK (project_meta_changed_cb), journal);
+
+  return journal;
+}
+
+void
+ges_project_journal_free (GESProjectJournal * journal)
+{
+  GError *err = NULL;
+
+  if (journal->idle_id)
+    g_source_remove (journal->idle_id);
+
+  if (journal->timeline) {
+    if (!write_pending (journal, &err)) {
+      GST_WARNING_OBJECT (journal->project, "Could not write the journal: %s",
+          err->message);
+      g_clear_error (&err);
+    }
+
+    disconnect_timeline (journal);
+    g_object_remove_toggle_ref (G_OBJECT (journal->timeline),
+        (GToggleNotify) timeline_toggle_cb, journal);
+  }
+  g_signal_handlers_disconnect_by_data (journal->project, journal);
+
+  g_byte_array_unref (journal->pending);
+  g_byte_array_unref (journal->saving_records);
+  g_queue_foreach (&journal->dirty, (GFunc) gst_object_unref, NULL);
+  g_queue_clear (&journal->dirty);
+  g_hash_table_unref (journal->dirty_set);
+  g_hash_table_unref (journal->names);
+  g_hash_table_unref (journal->sources);
+  g_clear_object (&journal->stream);
+  g_object_unref (journal->file);
+  if (journal->formatter_asset)
+    gst_object_unref (journal->formatter_asset);
+  g_free (journal->uri);
+  g_slice_free (GESProjectJournal, journal);
+}
+
+/**
+ * ges_project_journal_sync:
+ * @journal: A #GESProjectJournal
+ * @error: An error to be set in case something wrong happens or %NULL
+ *
+ * Writes what changed and was not journaled yet.
+ *
+ * Returns: %TRUE if the journal is up to date, %FALSE otherwise
+ */
+gboolean
+ges_project_journal_sync (GESProjectJournal * journal, GError ** error)
+{
+  if (journal->idle_id) {
+    g_source_remove (journal->idle_id);
+    journal->idle_id = 0;
+  }
+
+  if (!journal->stream) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED,
+        "Journal of %s could not be opened", journal->uri);
+
+    return FALSE;
+  }
+
+  return write_pending (journal, error);
+}
+
+/**
+ * ges_project_journal_begin_save:
+ * @journal: A #GESProjectJournal
+ * @timeline: The #GESTimeline about to be saved
+ * @uri: Where it is saved
+ *
+ * Called before @timeline gets serialized to be saved at @uri.
+ *
+ * Returns: %TRUE if that save restarts the journal, in which case
+ * ges_project_journal_end_save () should be called once saved
+ */
+gboolean
+ges_project_journal_begin_save (GESProjectJournal * journal,
+    GESTimeline * timeline, const gchar * uri)
+{
+  GError *err = NULL;
+
+  if (journal->saving || timeline != journal->timeline ||
+      g_strcmp0 (uri, journal->uri))
+    return FALSE;
+
+  /* Everything before is in the saved project */
+  if (!write_pending (journal, &err)) {
+    GST_WARNING_OBJECT (journal->project, "Could not write the journal: %s",
+        err->message);
+    g_clear_error (&err);
+  }
+  journal->saving = TRUE;
+
+  return TRUE;
+}
+
+void
+ges_project_journal_end_save (GESProjectJournal * journal, gboolean saved)
+{
+  GError *err = NULL;
+
+  if (!journal->saving)
+    return;
+
+  journal->saving = FALSE;
+  if (saved && !open_journal (journal, TRUE, &err)) {
+    GST_WARNING_OBJECT (journal->project, "Could not restart the journal: %s",
+        err->message);
+    g_clear_error (&err);
+  } else if (saved && journal->saving_records->len) {
+    /* Replaying records of changes the project already has is harmless */
+    if (!g_output_stream_write_all (journal->stream,
+            journal->saving_records->data, journal->saving_records->len,
+            NULL, NULL, &err)
+        || !g_output_stream_flush (journal->stream, NULL, &err)) {
+      GST_WARNING_OBJECT (journal->project, "Could not write the journal: %s",
+          err->message);
+      g_clear_error (&err);
+    }
+    journal->size += journal->saving_records->len;
+  }
+  g_byte_array_set_size (journal->saving_records, 0);
+
+  schedule_write (journal);
+}
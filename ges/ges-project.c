@@ -51,8 +51,17 @@
 #include "ges.h"
 #include "ges-internal.h"
 
+/* Maximum number of folders listed in parallel when indexing the folders
+ * passed to ges_add_missing_uri_relocation_uri() */
+#define RELOCATION_SCAN_THREADS 8
+
+/* Files found in the relocation folders: basename -> GPtrArray of URIs */
+static GHashTable *relocation_index = NULL;
+/* Relocation folders that could not be listed, missing files are looked
+ * for in them by their name */
 static GPtrArray *new_paths = NULL;
 static GHashTable *tried_uris = NULL;
+G_LOCK_DEFINE_STATIC (relocation_lock);
 
 /* TODO We should rely on both extractable_type and @id to identify
  * a Asset, not only @id
@@ -70,6 +79,9 @@ struct _GESProjectPrivate
   gchar *uri;
 
   GList *encoding_profiles;
+
+  /* Changes made to the timeline since the project was saved */
+  GESProjectJournal *journal;
 };
 
 typedef struct EmitLoadedInIdle
@@ -86,6 +98,8 @@ enum
   ASSET_REMOVED_SIGNAL,
   MISSING_URI_SIGNAL,
   ASSET_LOADING_SIGNAL,
+  LOADING_PROGRESS_SIGNAL,
+  ERROR_LOADING_SIGNAL,
   LAST_SIGNAL
 };
 
@@ -259,58 +273,260 @@ ges_project_extract (GESAsset * project, GError ** error)
   return NULL;
 }
 
+typedef struct
+{
+  GThreadPool *pool;
+  gboolean recurse;
+
+  GMutex lock;
+  GCond cond;
+  /* Folders queued and not listed yet */
+  guint pending;
+  /* File IDs of the queued folders, so that symlinks can not make us loop */
+  GHashTable *queued;
+} RelocationScan;
+
+/* Takes ownership of @basename and @uri, relocation_lock must be held */
+static void
+_index_relocation_candidate (gchar * basename, gchar * uri)
+{
+  guint i;
+  GPtrArray *candidates;
+
+  if (relocation_index == NULL)
+    relocation_index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_ptr_array_unref);
+
+  candidates = g_hash_table_lookup (relocation_index, basename);
+  if (candidates == NULL) {
+    candidates = g_ptr_array_new_with_free_func (g_free);
+    g_hash_table_insert (relocation_index, basename, candidates);
+  } else {
+    g_free (basename);
+  }
+
+  /* The same folder might have been added several times */
+  for (i = 0; i < candidates->len; i++) {
+    if (!g_strcmp0 (candidates->pdata[i], uri)) {
+      g_free (uri);
+      return;
+    }
+  }
+
+  g_ptr_array_add (candidates, uri);
+}
+
+static void
+_queue_relocation_folder (RelocationScan * scan, GFile * folder,
+    const gchar * file_id)
+{
+  g_mutex_lock (&scan->lock);
+  if (file_id && !g_hash_table_add (scan->queued, g_strdup (file_id))) {
+    g_mutex_unlock (&scan->lock);
+
+    return;
+  }
+  scan->pending++;
+  g_mutex_unlock (&scan->lock);
+
+  g_thread_pool_push (scan->pool, g_object_ref (folder), NULL);
+}
+
+/* Runs in the scan thread pool, lists one folder and queues its
+ * subfolders */
 static void
-_add_media_new_paths_recursing (const gchar * value)
+_scan_relocation_folder (GFile * folder, RelocationScan * scan)
 {
+  guint i;
   GFileInfo *info;
   GFileEnumerator *fenum;
-  GFile *file = g_file_new_for_uri (value);
+  /* basename, uri pairs */
+  GPtrArray *found = g_ptr_array_new ();
+
+  if (!(fenum = g_file_enumerate_children (folder,
+              G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE
+              "," G_FILE_ATTRIBUTE_ID_FILE, G_FILE_QUERY_INFO_NONE, NULL,
+              NULL))) {
+    gchar *uri = g_file_get_uri (folder);
 
-  if (!(fenum = g_file_enumerate_children (file,
-              "standard::*", G_FILE_QUERY_INFO_NONE, NULL, NULL))) {
-    GST_INFO ("%s is not a folder", value);
+    GST_INFO ("Could not list %s", uri);
+    g_free (uri);
 
     goto done;
   }
 
-  GST_INFO ("Adding folder: %s", value);
-  g_ptr_array_add (new_paths, g_strdup (value));
-  info = g_file_enumerator_next_file (fenum, NULL, NULL);
-  while (info != NULL) {
-    if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
-      GFile *f = g_file_enumerator_get_child (fenum, info);
-      gchar *uri = g_file_get_uri (f);
-
-      _add_media_new_paths_recursing (uri);
-      gst_object_unref (f);
-      g_free (uri);
+  while ((info = g_file_enumerator_next_file (fenum, NULL, NULL))) {
+    GFile *child = g_file_enumerator_get_child (fenum, info);
+
+    switch (g_file_info_get_file_type (info)) {
+      case G_FILE_TYPE_DIRECTORY:
+        if (scan->recurse)
+          _queue_relocation_folder (scan, child,
+              g_file_info_get_attribute_string (info,
+                  G_FILE_ATTRIBUTE_ID_FILE));
+        break;
+      case G_FILE_TYPE_REGULAR:
+        g_ptr_array_add (found, g_strdup (g_file_info_get_name (info)));
+        g_ptr_array_add (found, g_file_get_uri (child));
+        break;
+      default:
+        break;
     }
+
+    g_object_unref (child);
     g_object_unref (info);
-    info = g_file_enumerator_next_file (fenum, NULL, NULL);
   }
 
+  G_LOCK (relocation_lock);
+  for (i = 0; i < found->len; i += 2)
+    _index_relocation_candidate (found->pdata[i], found->pdata[i + 1]);
+  G_UNLOCK (relocation_lock);
+
 done:
-  gst_object_unref (file);
+  g_ptr_array_free (found, TRUE);
   if (fenum)
-    gst_object_unref (fenum);
+    g_object_unref (fenum);
+  g_object_unref (folder);
+
+  g_mutex_lock (&scan->lock);
+  if (--scan->pending == 0)
+    g_cond_signal (&scan->cond);
+  g_mutex_unlock (&scan->lock);
 }
 
 gboolean
 ges_add_missing_uri_relocation_uri (const gchar * uri, gboolean recurse)
 {
+  GFile *folder;
+  GFileInfo *info;
+  RelocationScan scan = { NULL, };
+
   g_return_val_if_fail (gst_uri_is_valid (uri), FALSE);
 
-  if (new_paths == NULL)
-    new_paths = g_ptr_array_new_with_free_func (g_free);
+  folder = g_file_new_for_uri (uri);
+  info = g_file_query_info (folder, G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+      G_FILE_ATTRIBUTE_ID_FILE, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (!info || g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY) {
+    GST_INFO ("%s is not a folder we can list", uri);
+
+    if (!recurse) {
+      G_LOCK (relocation_lock);
+      if (new_paths == NULL)
+        new_paths = g_ptr_array_new_with_free_func (g_free);
+      g_ptr_array_add (new_paths, g_strdup (uri));
+      G_UNLOCK (relocation_lock);
+    }
 
-  if (recurse)
-    _add_media_new_paths_recursing (uri);
-  else
-    g_ptr_array_add (new_paths, g_strdup (uri));
+    goto done;
+  }
+
+  /* Index all the files once so that missing assets get resolved with
+   * a lookup instead of guessing a path in each folder */
+  GST_INFO ("Indexing files in %s", uri);
+  g_mutex_init (&scan.lock);
+  g_cond_init (&scan.cond);
+  scan.recurse = recurse;
+  scan.queued = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  scan.pool = g_thread_pool_new ((GFunc) _scan_relocation_folder, &scan,
+      RELOCATION_SCAN_THREADS, FALSE, NULL);
+
+  _queue_relocation_folder (&scan, folder,
+      g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILE));
+
+  g_mutex_lock (&scan.lock);
+  while (scan.pending)
+    g_cond_wait (&scan.cond, &scan.lock);
+  g_mutex_unlock (&scan.lock);
+
+  g_thread_pool_free (scan.pool, FALSE, TRUE);
+  g_hash_table_unref (scan.queued);
+  g_cond_clear (&scan.cond);
+  g_mutex_clear (&scan.lock);
+
+done:
+  g_clear_object (&info);
+  g_object_unref (folder);
 
   return TRUE;
 }
 
+/* Number of folders, going up from the innermost one, that have the same
+ * name in both URIs */
+static guint
+_n_common_parent_folders (const gchar * uri1, const gchar * uri2)
+{
+  guint n = 0, len1, len2;
+  gchar **path1 = NULL, **path2 = NULL;
+  gchar *unescaped1 = g_uri_unescape_string (uri1, NULL);
+  gchar *unescaped2 = g_uri_unescape_string (uri2, NULL);
+
+  if (!unescaped1 || !unescaped2)
+    goto done;
+
+  path1 = g_strsplit (unescaped1, "/", -1);
+  path2 = g_strsplit (unescaped2, "/", -1);
+  len1 = g_strv_length (path1);
+  len2 = g_strv_length (path2);
+
+  /* Skip the basenames, they are the same */
+  while (n + 2 <= len1 && n + 2 <= len2 && path1[len1 - n - 2][0] &&
+      !g_strcmp0 (path1[len1 - n - 2], path2[len2 - n - 2]))
+    n++;
+
+done:
+  g_strfreev (path1);
+  g_strfreev (path2);
+  g_free (unescaped1);
+  g_free (unescaped2);
+
+  return n;
+}
+
+/* Picks the best indexed file for @old_uri which has not been tried yet:
+ * the one living in the folders named the most like the original ones,
+ * falling back to the smallest URI so the result does not depend on the
+ * order folders were listed in. relocation_lock must be held. */
+static gchar *
+_find_relocated_uri (const gchar * old_uri)
+{
+  guint i, best_score = 0;
+  gchar *basename;
+  GFile *file;
+  GPtrArray *candidates = NULL;
+  const gchar *best = NULL;
+
+  if (relocation_index == NULL)
+    return NULL;
+
+  file = g_file_new_for_uri (old_uri);
+  basename = g_file_get_basename (file);
+  g_object_unref (file);
+
+  if (basename)
+    candidates = g_hash_table_lookup (relocation_index, basename);
+  g_free (basename);
+
+  if (candidates == NULL)
+    return NULL;
+
+  for (i = 0; i < candidates->len; i++) {
+    guint score;
+    const gchar *uri = candidates->pdata[i];
+
+    if (!g_strcmp0 (uri, old_uri) || g_hash_table_contains (tried_uris, uri))
+      continue;
+
+    score = _n_common_parent_folders (old_uri, uri);
+    if (!best || score > best_score ||
+        (score == best_score && g_strcmp0 (uri, best) < 0)) {
+      best = uri;
+      best_score = score;
+    }
+  }
+
+  return g_strdup (best);
+}
+
 static gchar *
 ges_missing_uri_default (GESProject * self, GError * error,
     GESAsset * wrong_asset)
@@ -325,13 +541,12 @@ ges_missing_uri_default (GESProject * self, GError * error,
     return new_id;
   }
 
-  if (new_paths == NULL)
-    return NULL;
-
+  G_LOCK (relocation_lock);
   if (tried_uris == NULL)
     tried_uris = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
-  for (i = 0; i < new_paths->len; i++) {
+  new_id = _find_relocated_uri (old_uri);
+  for (i = 0; !new_id && new_paths && i < new_paths->len; i++) {
     gchar *basename, *res;
 
     basename = g_path_get_basename (old_uri);
@@ -344,13 +559,18 @@ ges_missing_uri_default (GESProject * self, GError * error,
       GST_DEBUG_OBJECT (self, "File already tried: %s", res);
       g_free (res);
     } else {
-      g_hash_table_add (tried_uris, g_strdup (res));
-      GST_DEBUG_OBJECT (self, "Trying: %s\n", res);
-      return res;
+      new_id = res;
     }
   }
 
-  return NULL;
+  if (new_id)
+    g_hash_table_add (tried_uris, g_strdup (new_id));
+  G_UNLOCK (relocation_lock);
+
+  if (new_id)
+    GST_DEBUG_OBJECT (self, "Trying: %s", new_id);
+
+  return new_id;
 }
 
 gchar *
@@ -362,8 +582,20 @@ ges_uri_asset_try_update_id (GError * error, GESAsset * wrong_asset)
 static void
 ges_uri_assets_validate_uri (const gchar * nid)
 {
+  G_LOCK (relocation_lock);
   if (tried_uris)
     g_hash_table_remove (tried_uris, nid);
+  G_UNLOCK (relocation_lock);
+}
+
+void
+ges_missing_uri_relocation_deinit (void)
+{
+  G_LOCK (relocation_lock);
+  g_clear_pointer (&relocation_index, g_hash_table_unref);
+  g_clear_pointer (&new_paths, g_ptr_array_unref);
+  g_clear_pointer (&tried_uris, g_hash_table_unref);
+  G_UNLOCK (relocation_lock);
 }
 
 /* GObject vmethod implementation */
@@ -373,6 +605,11 @@ _dispose (GObject * object)
   GList *tmp;
   GESProjectPrivate *priv = GES_PROJECT (object)->priv;
 
+  if (priv->journal) {
+    ges_project_journal_free (priv->journal);
+    priv->journal = NULL;
+  }
+
   if (priv->assets)
     g_hash_table_unref (priv->assets);
   if (priv->loading_assets)
@@ -543,6 +780,38 @@ ges_project_class_init (GESProjectClass * klass)
       NULL, NULL, g_cclosure_marshal_generic,
       G_TYPE_NONE, 3, G_TYPE_ERROR, G_TYPE_STRING, G_TYPE_GTYPE);
 
+  /**
+   * GESProject::loading-progress:
+   * @project: the #GESProject being loaded
+   * @progress: The fraction of the project file that has been parsed, from
+   * 0.0 to 1.0
+   *
+   * Emitted while the project file gets parsed, clips can be added to the
+   * timeline before it is fully parsed.
+   *
+   * Since: 1.16
+   */
+  _signals[LOADING_PROGRESS_SIGNAL] =
+      g_signal_new ("loading-progress", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 1, G_TYPE_DOUBLE);
+
+  /**
+   * GESProject::error-loading:
+   * @project: the #GESProject that failed loading
+   * @timeline: The #GESTimeline the project was being loaded into
+   * @error: The #GError defining the error that occured
+   *
+   * Informs you that the project file itself could not be fully loaded,
+   * what could be loaded before @error happened is kept in @timeline.
+   *
+   * Since: 1.16
+   */
+  _signals[ERROR_LOADING_SIGNAL] =
+      g_signal_new ("error-loading", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 2, GES_TYPE_TIMELINE, G_TYPE_ERROR);
+
   object_class->dispose = _dispose;
   object_class->finalize = _finalize;
 
@@ -662,8 +931,9 @@ new_asset_cb (GESAsset * source, GAsyncResult * res, GESProject * project)
  *
  * Returns: %TRUE if the signale could be emitted %FALSE otherwize
  */
-gboolean
-ges_project_set_loaded (GESProject * project, GESFormatter * formatter)
+static void
+_journal_replayed_cb (GESProject * project, GAsyncResult * result,
+    GESFormatter * formatter)
 {
   GST_INFO_OBJECT (project, "Emit project loaded");
   if (GST_STATE (formatter->timeline) < GST_STATE_PAUSED) {
@@ -676,9 +946,46 @@ ges_project_set_loaded (GESProject * project, GESFormatter * formatter)
 
   /* We are now done with that formatter */
   ges_project_remove_formatter (project, formatter);
+  gst_object_unref (formatter);
+}
+
+gboolean
+ges_project_set_loaded (GESProject * project, GESFormatter * formatter)
+{
+  /* The journal might need assets that are not loaded yet */
+  ges_project_journal_replay_async (project, formatter->timeline,
+      (GAsyncReadyCallback) _journal_replayed_cb, gst_object_ref (formatter));
+
   return TRUE;
 }
 
+void
+ges_project_set_loading_progress (GESProject * project, gdouble progress)
+{
+  g_signal_emit (project, _signals[LOADING_PROGRESS_SIGNAL], 0,
+      CLAMP (progress, 0.0, 1.0));
+}
+
+/* Reports that the project itself could not be fully loaded */
+void
+ges_project_set_loading_error (GESProject * project, GESTimeline * timeline,
+    GError * error)
+{
+  GST_WARNING_OBJECT (project, "Error loading project: %s", error->message);
+  g_signal_emit (project, _signals[ERROR_LOADING_SIGNAL], 0, timeline, error);
+}
+
+/* Reports an asset of the project being loaded that could not even be
+ * requested */
+void
+ges_project_set_asset_loading_error (GESProject * project, const gchar * id,
+    GType extractable_type, GError * error)
+{
+  g_hash_table_add (project->priv->loaded_with_error, g_strdup (id));
+  g_signal_emit (project, _signals[ERROR_LOADING_ASSET], 0, error, id,
+      extractable_type);
+}
+
 void
 ges_project_add_loading_asset (GESProject * project, GType extractable_type,
     const gchar * id)
@@ -930,6 +1237,57 @@ ges_project_list_assets (GESProject * project, GType filter)
   return ret;
 }
 
+/* Returns %FALSE if @timeline should not be saved as @project, in which
+ * case @ret is set to what saving it should return */
+static gboolean
+_check_timeline_for_save (GESProject * project, GESTimeline * timeline,
+    const gchar * uri, gboolean * ret)
+{
+  GESAsset *tl_asset = ges_extractable_get_asset (GES_EXTRACTABLE (timeline));
+
+  if (tl_asset == NULL && project->priv->uri == NULL) {
+    GESAsset *asset = ges_asset_cache_lookup (GES_TYPE_PROJECT, uri);
+
+    if (asset) {
+      GST_WARNING_OBJECT (project, "Trying to save project to %s but we already"
+          "have %" GST_PTR_FORMAT " for that uri, can not save", uri, asset);
+      *ret = TRUE;
+      return FALSE;
+    }
+
+    GST_DEBUG_OBJECT (project, "Timeline %" GST_PTR_FORMAT " has no asset"
+        " we have no uri set, so setting ourself as asset", timeline);
+
+    ges_extractable_set_asset (GES_EXTRACTABLE (timeline), GES_ASSET (project));
+  } else if (tl_asset != GES_ASSET (project)) {
+    GST_WARNING_OBJECT (project, "Timeline %" GST_PTR_FORMAT
+        " not created by this project can not save", timeline);
+
+    *ret = FALSE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GESFormatter *
+_create_formatter_for_save (GESProject * project, GESAsset ** formatter_asset,
+    GError ** error)
+{
+  GESFormatter *formatter;
+
+  if (*formatter_asset == NULL)
+    *formatter_asset = gst_object_ref (ges_formatter_get_default ());
+
+  formatter = GES_FORMATTER (ges_asset_extract (*formatter_asset, error));
+  if (formatter == NULL)
+    GST_WARNING_OBJECT (project, "Could not create the formatter %p %s: %s",
+        *formatter_asset, ges_asset_get_id (*formatter_asset),
+        (error && *error) ? (*error)->message : "Unknown Error");
+
+  return formatter;
+}
+
 /**
  * ges_project_save:
  * @project: A #GESProject to save
@@ -945,6 +1303,9 @@ ges_project_list_assets (GESProject * project, GType filter)
  * is one of the timelines that have been extracted from @project
  * (using ges_asset_extract (@project);)
  *
+ * The project is written to @uri as it gets serialized, xges projects are
+ * compressed with gzip if the name of the file ends with ".gz".
+ *
  * Returns: %TRUE if the project could be save, %FALSE otherwize
  */
 gboolean
@@ -952,8 +1313,7 @@ ges_project_save (GESProject * project, GESTimeline * timeline,
     const gchar * uri, GESAsset * formatter_asset, gboolean overwrite,
     GError ** error)
 {
-  GESAsset *tl_asset;
-  gboolean ret = TRUE;
+  gboolean ret = TRUE, journaled = FALSE;
   GESFormatter *formatter = NULL;
 
   g_return_val_if_fail (GES_IS_PROJECT (project), FALSE);
@@ -962,37 +1322,13 @@ ges_project_save (GESProject * project, GESTimeline * timeline,
           GES_TYPE_FORMATTER), FALSE);
   g_return_val_if_fail ((error == NULL || *error == NULL), FALSE);
 
-  tl_asset = ges_extractable_get_asset (GES_EXTRACTABLE (timeline));
-  if (tl_asset == NULL && project->priv->uri == NULL) {
-    GESAsset *asset = ges_asset_cache_lookup (GES_TYPE_PROJECT, uri);
-
-    if (asset) {
-      GST_WARNING_OBJECT (project, "Trying to save project to %s but we already"
-          "have %" GST_PTR_FORMAT " for that uri, can not save", uri, asset);
-      goto out;
-    }
-
-    GST_DEBUG_OBJECT (project, "Timeline %" GST_PTR_FORMAT " has no asset"
-        " we have no uri set, so setting ourself as asset", timeline);
-
-    ges_extractable_set_asset (GES_EXTRACTABLE (timeline), GES_ASSET (project));
-  } else if (tl_asset != GES_ASSET (project)) {
-    GST_WARNING_OBJECT (project, "Timeline %" GST_PTR_FORMAT
-        " not created by this project can not save", timeline);
-
-    ret = FALSE;
+  if (!_check_timeline_for_save (project, timeline, uri, &ret))
     goto out;
-  }
-
-  if (formatter_asset == NULL)
-    formatter_asset = gst_object_ref (ges_formatter_get_default ());
 
-  formatter = GES_FORMATTER (ges_asset_extract (formatter_asset, error));
+  journaled = project->priv->journal &&
+      ges_project_journal_begin_save (project->priv->journal, timeline, uri);
+  formatter = _create_formatter_for_save (project, &formatter_asset, error);
   if (formatter == NULL) {
-    GST_WARNING_OBJECT (project, "Could not create the formatter %p %s: %s",
-        formatter_asset, ges_asset_get_id (formatter_asset),
-        (error && *error) ? (*error)->message : "Unknown Error");
-
     ret = FALSE;
     goto out;
   }
@@ -1003,6 +1339,8 @@ ges_project_save (GESProject * project, GESTimeline * timeline,
     ges_project_set_uri (project, uri);
 
 out:
+  if (journaled)
+    ges_project_journal_end_save (project->priv->journal, ret);
   if (formatter_asset)
     gst_object_unref (formatter_asset);
   ges_project_remove_formatter (project, formatter);
@@ -1010,6 +1348,320 @@ out:
   return ret;
 }
 
+typedef struct
+{
+  gchar *uri;
+  GBytes *bytes;
+  gboolean overwrite;
+  /* The journal has to be restarted once saved */
+  gboolean journaled;
+  /* Serializing the project */
+  GESFormatter *formatter;
+} SaveData;
+
+static void
+_free_save_data (SaveData * data)
+{
+  g_free (data->uri);
+  if (data->bytes)
+    g_bytes_unref (data->bytes);
+  g_slice_free (SaveData, data);
+}
+
+static void
+_save_in_thread (GTask * task, gpointer source, SaveData * data,
+    GCancellable * cancellable)
+{
+  GError *err = NULL;
+
+  if (ges_base_xml_formatter_write_bytes (data->bytes, data->uri,
+          data->overwrite, cancellable, &err))
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, err);
+}
+
+static void
+_saved_cb (GESProject * project, GAsyncResult * result, GTask * task)
+{
+  GError *err = NULL;
+  SaveData *data = g_task_get_task_data (task);
+
+  if (g_task_propagate_boolean (G_TASK (result), &err)) {
+    if (project->priv->uri == NULL)
+      ges_project_set_uri (project, data->uri);
+    if (data->journaled && project->priv->journal)
+      ges_project_journal_end_save (project->priv->journal, TRUE);
+    g_task_return_boolean (task, TRUE);
+  } else {
+    if (data->journaled && project->priv->journal)
+      ges_project_journal_end_save (project->priv->journal, FALSE);
+    g_task_return_error (task, err);
+  }
+
+  g_object_unref (task);
+}
+
+static void
+_write_saved_bytes (GESProject * project, GTask * task, GBytes * bytes)
+{
+  GTask *write_task;
+  SaveData *data = g_task_get_task_data (task);
+
+  data->bytes = bytes;
+  write_task = g_task_new (project, g_task_get_cancellable (task),
+      (GAsyncReadyCallback) _saved_cb, task);
+  g_task_set_task_data (write_task, data, NULL);
+  g_task_run_in_thread (write_task, (GTaskThreadFunc) _save_in_thread);
+  g_object_unref (write_task);
+}
+
+static void
+_serialized_cb (GESXmlFormatter * formatter, GAsyncResult * result,
+    GTask * task)
+{
+  GBytes *bytes;
+  GError *err = NULL;
+  GESProject *project = g_task_get_source_object (task);
+  SaveData *data = g_task_get_task_data (task);
+
+  bytes = ges_xml_formatter_save_to_bytes_finish (formatter, result, &err);
+  ges_project_remove_formatter (project, data->formatter);
+  data->formatter = NULL;
+
+  if (bytes) {
+    _write_saved_bytes (project, task, bytes);
+
+    return;
+  }
+
+  if (data->journaled && project->priv->journal)
+    ges_project_journal_end_save (project->priv->journal, FALSE);
+  g_task_return_error (task, err);
+  g_object_unref (task);
+}
+
+/**
+ * ges_project_save_async:
+ * @project: A #GESProject to save
+ * @timeline: The #GESTimeline to save, it must have been extracted from @project
+ * @uri: The uri where to save @project and @timeline
+ * @formatter_asset: (allow-none): The formatter asset to use or %NULL
+ * @overwrite: %TRUE to overwrite file if it exists
+ * @cancellable: (allow-none): A #GCancellable or %NULL
+ * @callback: The function to call when the project has been saved
+ * @user_data: The data to pass to @callback
+ *
+ * Asynchronously does what ges_project_save () does, which should be
+ * preferred for autosaving large projects. xges projects are serialized
+ * from the main context a few clips at a time, then written and compressed
+ * on a worker thread. The layers and clips saved are the ones @timeline
+ * has when this is called, each clip is saved as it is when its turn
+ * comes, and not at all if it got removed meanwhile. Other formats are
+ * saved right away.
+ *
+ * Since: 1.16
+ */
+void
+ges_project_save_async (GESProject * project, GESTimeline * timeline,
+    const gchar * uri, GESAsset * formatter_asset, gboolean overwrite,
+    GCancellable * cancellable, GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  GTask *task;
+  SaveData *data;
+  GBytes *bytes;
+  gboolean ret = TRUE, journaled = FALSE;
+  GError *err = NULL;
+  GESFormatter *formatter = NULL;
+
+  g_return_if_fail (GES_IS_PROJECT (project));
+  g_return_if_fail (formatter_asset == NULL ||
+      g_type_is_a (ges_asset_get_extractable_type (formatter_asset),
+          GES_TYPE_FORMATTER));
+
+  task = g_task_new (project, cancellable, callback, user_data);
+  g_task_set_source_tag (task, ges_project_save_async);
+
+  if (!_check_timeline_for_save (project, timeline, uri, &ret))
+    goto done;
+
+  journaled = project->priv->journal &&
+      ges_project_journal_begin_save (project->priv->journal, timeline, uri);
+  formatter = _create_formatter_for_save (project, &formatter_asset, &err);
+  if (formatter == NULL) {
+    ret = FALSE;
+    goto done;
+  }
+
+  ges_project_add_formatter (project, formatter);
+  if (!GES_IS_BASE_XML_FORMATTER (formatter)) {
+    /* Only the formatters we know how to serialize up front can be saved from
+     * another thread */
+    ret = ges_formatter_save_to_uri (formatter, timeline, uri, overwrite,
+        &err);
+    if (ret && project->priv->uri == NULL)
+      ges_project_set_uri (project, uri);
+
+    goto done;
+  }
+
+  data = g_slice_new0 (SaveData);
+  data->uri = g_strdup (uri);
+  data->overwrite = overwrite;
+  data->journaled = journaled;
+  g_task_set_task_data (task, data, (GDestroyNotify) _free_save_data);
+
+  if (GES_IS_XML_FORMATTER (formatter)) {
+    /* The formatter is removed once done */
+    data->formatter = formatter;
+    formatter = NULL;
+    ges_xml_formatter_save_to_bytes_async (GES_XML_FORMATTER (data->formatter),
+        timeline, cancellable, (GAsyncReadyCallback) _serialized_cb, task);
+  } else {
+    bytes = ges_base_xml_formatter_save_to_bytes (GES_BASE_XML_FORMATTER
+        (formatter), timeline, &err);
+    if (!bytes) {
+      data->journaled = FALSE;
+      ret = FALSE;
+      goto done;
+    }
+    _write_saved_bytes (project, task, bytes);
+  }
+  journaled = FALSE;
+  task = NULL;
+
+done:
+  if (journaled)
+    ges_project_journal_end_save (project->priv->journal, ret);
+  if (formatter_asset)
+    gst_object_unref (formatter_asset);
+  ges_project_remove_formatter (project, formatter);
+
+  if (task) {
+    if (err)
+      g_task_return_error (task, err);
+    else
+      g_task_return_boolean (task, ret);
+    g_object_unref (task);
+  }
+}
+
+/**
+ * ges_project_save_finish:
+ * @project: A #GESProject
+ * @result: The #GAsyncResult passed to the callback
+ * @error: (out) (allow-none): An error to be set in case something wrong happens or %NULL
+ *
+ * Finishes saving a project started with ges_project_save_async ().
+ *
+ * Returns: %TRUE if the project could be saved, %FALSE otherwise
+ *
+ * Since: 1.16
+ */
+gboolean
+ges_project_save_finish (GESProject * project, GAsyncResult * result,
+    GError ** error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, project), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * ges_project_start_journal:
+ * @project: A saved #GESProject
+ * @timeline: The #GESTimeline of @project to journal the changes of
+ * @error: (out) (allow-none): An error to be set in case something wrong happens or %NULL
+ *
+ * Starts recording the changes made to @timeline in a journal next to the
+ * project file, named after it with a ".journal" suffix. Recording a change
+ * only costs writing the elements that changed, which makes it a cheap
+ * alternative to regularly saving large projects.
+ *
+ * Loading the project applies the changes that were journaled since it was
+ * last saved. Saving @timeline to the uri of @project restarts the journal,
+ * which happens automatically once the journal gets bigger than the project
+ * file.
+ *
+ * Changes are written to the journal from the main loop, use
+ * ges_project_sync_journal () to write them right away.
+ *
+ * Returns: %TRUE if the journal could be started, %FALSE otherwise
+ *
+ * Since: 1.16
+ */
+gboolean
+ges_project_start_journal (GESProject * project, GESTimeline * timeline,
+    GError ** error)
+{
+  GESProjectPrivate *priv;
+
+  g_return_val_if_fail (GES_IS_PROJECT (project), FALSE);
+  g_return_val_if_fail (GES_IS_TIMELINE (timeline), FALSE);
+  g_return_val_if_fail ((error == NULL || *error == NULL), FALSE);
+
+  priv = project->priv;
+  g_return_val_if_fail (priv->uri != NULL, FALSE);
+  g_return_val_if_fail (ges_extractable_get_asset (GES_EXTRACTABLE (timeline))
+      == GES_ASSET (project), FALSE);
+
+  ges_project_stop_journal (project);
+  priv->journal = ges_project_journal_new (project, timeline, priv->uri,
+      priv->formatter_asset, error);
+
+  return priv->journal != NULL;
+}
+
+/**
+ * ges_project_stop_journal:
+ * @project: A #GESProject
+ *
+ * Writes the pending changes to the journal of @project and stops recording
+ * them. The journal is kept, and applied the next time the project is
+ * loaded.
+ *
+ * Since: 1.16
+ */
+void
+ges_project_stop_journal (GESProject * project)
+{
+  g_return_if_fail (GES_IS_PROJECT (project));
+
+  if (project->priv->journal) {
+    ges_project_journal_free (project->priv->journal);
+    project->priv->journal = NULL;
+  }
+}
+
+/**
+ * ges_project_sync_journal:
+ * @project: A #GESProject
+ * @error: (out) (allow-none): An error to be set in case something wrong happens or %NULL
+ *
+ * Writes the changes that have not been recorded yet to the journal of
+ * @project, see ges_project_start_journal ().
+ *
+ * Returns: %TRUE if the journal is up to date, %FALSE otherwise
+ *
+ * Since: 1.16
+ */
+gboolean
+ges_project_sync_journal (GESProject * project, GError ** error)
+{
+  g_return_val_if_fail (GES_IS_PROJECT (project), FALSE);
+  g_return_val_if_fail ((error == NULL || *error == NULL), FALSE);
+
+  if (!project->priv->journal) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED,
+        "Project %s is not being journaled", project->priv->uri);
+
+    return FALSE;
+  }
+
+  return ges_project_journal_sync (project->priv->journal, error);
+}
+
 /**
  * ges_project_new:
  * @uri: (allow-none): The uri to be set after creating the project.
@@ -92,6 +92,28 @@ gboolean  ges_project_save         (GESProject * project,
                                     gboolean overwrite,
                                     GError **error);
 GES_API
+void      ges_project_save_async   (GESProject * project,
+                                    GESTimeline * timeline,
+                                    const gchar *uri,
+                                    GESAsset * formatter_asset,
+                                    gboolean overwrite,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data);
+GES_API
+gboolean  ges_project_save_finish  (GESProject * project,
+                                    GAsyncResult *result,
+                                    GError **error);
+GES_API
+gboolean  ges_project_start_journal (GESProject * project,
+                                     GESTimeline * timeline,
+                                     GError **error);
+GES_API
+void      ges_project_stop_journal  (GESProject * project);
+GES_API
+gboolean  ges_project_sync_journal  (GESProject * project,
+                                     GError **error);
+GES_API
 gboolean  ges_project_load         (GESProject * project,
                                     GESTimeline * timeline,
                                     GError **error);
@@ -22,6 +22,8 @@
 #endif
 
 #include <gst/audio/audio.h>
+#include <gst/audio/gstaudioaggregator.h>
+#include <gst/base/gstaggregator.h>
 
 #include "ges-types.h"
 #include "ges-internal.h"
@@ -55,13 +57,37 @@ typedef struct _PadInfos
 {
   GESSmartAdder *self;
   GstPad *adder_pad;
+
+  /* audioconvert ! audioresample, only plugged when the input needs to be
+   * resampled or the adder pad can not convert it, see convert_probe_cb () */
   GstElement *bin;
+  GstElement *resample;
+  gulong convert_probe_id;
+  /* Internal pad of the ghost, blocked to plug the bin, see replug_cb () */
+  GstPad *proxy;
+  gulong replug_probe_id;
+
+  /* Single input bypass of the adder, see bypass_adder_cb () */
+  GstPad *ghost;
+  gulong bypass_probe_id;
+  gboolean bypass_check_caps;
+  gboolean bypass_caps_ok;
 } PadInfos;
 
 static void
 destroy_pad (PadInfos * infos)
 {
-  if (G_LIKELY (infos->bin)) {
+  if (infos->bypass_probe_id)
+    gst_pad_remove_probe (infos->ghost, infos->bypass_probe_id);
+
+  if (infos->convert_probe_id)
+    gst_pad_remove_probe (infos->ghost, infos->convert_probe_id);
+
+  if (infos->replug_probe_id)
+    gst_pad_remove_probe (infos->proxy, infos->replug_probe_id);
+  gst_clear_object (&infos->proxy);
+
+  if (infos->bin) {
     gst_element_set_state (infos->bin, GST_STATE_NULL);
     gst_element_unlink (infos->bin, infos->self->adder);
     gst_bin_remove (GST_BIN (infos->self), infos->bin);
@@ -74,6 +100,194 @@ destroy_pad (PadInfos * infos)
   g_slice_free (PadInfos, infos);
 }
 
+/* Checks whether @buffer can be pushed as is on our srcpad: the pad has to
+ * be our only input and its format has to match the restriction caps and be
+ * accepted downstream. */
+static gboolean
+can_bypass_adder (PadInfos * infos)
+{
+  GESSmartAdder *self = infos->self;
+
+  if (g_atomic_int_get (&self->n_pads) != 1)
+    return FALSE;
+
+  if (infos->bypass_check_caps) {
+    GstCaps *filter_caps = NULL;
+    GstCaps *caps = gst_pad_get_current_caps (infos->ghost);
+
+    g_object_get (self->capsfilter, "caps", &filter_caps, NULL);
+    infos->bypass_check_caps = FALSE;
+    infos->bypass_caps_ok = caps && gst_caps_is_fixed (caps)
+        && (!filter_caps || gst_caps_is_subset (caps, filter_caps))
+        && gst_pad_peer_query_accept_caps (self->srcpad, caps);
+    gst_clear_caps (&filter_caps);
+    gst_clear_caps (&caps);
+  }
+
+  return infos->bypass_caps_ok;
+}
+
+/* When a single input is mixed, the adder is useless and its buffers are
+ * output as is, see ges-mixer-bypass.c */
+static GstPadProbeReturn
+bypass_adder_cb (GstPad * pad, GstPadProbeInfo * info, PadInfos * infos)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_CAPS)
+      infos->bypass_check_caps = TRUE;
+
+    return ges_mixer_bypass_probe (infos->self->bypass, pad, info, FALSE);
+  }
+
+  return ges_mixer_bypass_probe (infos->self->bypass, pad, info,
+      can_bypass_adder (infos));
+}
+
+static void
+update_resample_quality (PadInfos * infos)
+{
+  gint quality, current;
+
+  if (!infos->resample || !infos->self->track)
+    return;
+
+  quality = track_get_resample_quality (infos->self->track);
+  if (quality < 0)
+    return;
+
+  g_object_get (infos->resample, "quality", &current, NULL);
+  if (current != quality) {
+    GST_DEBUG_OBJECT (infos->resample, "Using quality %d", quality);
+    g_object_set (infos->resample, "quality", quality, NULL);
+  }
+}
+
+/* Creates the audioconvert ! audioresample bin, linked to the adder pad and
+ * returns its sinkpad */
+static GstPad *
+create_convert_bin (PadInfos * infos)
+{
+  GstPad *audioresample_srcpad, *audioconvert_sinkpad, *sinkpad, *srcpad;
+  GstElement *audioconvert;
+
+  infos->bin = gst_bin_new (NULL);
+  audioconvert = gst_element_factory_make ("audioconvert", NULL);
+  infos->resample = gst_element_factory_make ("audioresample", NULL);
+  update_resample_quality (infos);
+
+  gst_bin_add_many (GST_BIN (infos->bin), audioconvert, infos->resample,
+      NULL);
+  gst_element_link_many (audioconvert, infos->resample, NULL);
+
+  audioconvert_sinkpad = gst_element_get_static_pad (audioconvert, "sink");
+  sinkpad = GST_PAD (gst_ghost_pad_new (NULL, audioconvert_sinkpad));
+  gst_object_unref (audioconvert_sinkpad);
+  gst_pad_set_active (sinkpad, TRUE);
+  gst_element_add_pad (GST_ELEMENT (infos->bin), gst_object_ref (sinkpad));
+
+  audioresample_srcpad = gst_element_get_static_pad (infos->resample, "src");
+  srcpad = GST_PAD (gst_ghost_pad_new (NULL, audioresample_srcpad));
+  gst_object_unref (audioresample_srcpad);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_element_add_pad (GST_ELEMENT (infos->bin), srcpad);
+
+  gst_bin_add (GST_BIN (infos->self), infos->bin);
+  gst_pad_link (srcpad, infos->adder_pad);
+
+  return sinkpad;
+}
+
+/* Whether audio in @caps needs to be resampled before getting to the adder,
+ * which only converts the format and the channels of its inputs */
+static gboolean
+needs_resampling (PadInfos * infos, GstCaps * caps)
+{
+  gint rate, out_rate;
+  GstCaps *filter_caps = NULL;
+  gboolean res = TRUE;
+
+  g_object_get (infos->self->capsfilter, "caps", &filter_caps, NULL);
+  if (filter_caps && gst_caps_get_size (filter_caps) == 1
+      && gst_structure_get_int (gst_caps_get_structure (filter_caps, 0),
+          "rate", &out_rate)
+      && gst_structure_get_int (gst_caps_get_structure (caps, 0), "rate",
+          &rate))
+    res = rate != out_rate;
+  gst_clear_caps (&filter_caps);
+
+  return res;
+}
+
+/* Called when the data flow is blocked on the internal pad of the ghost,
+ * before the item gets to the adder pad: the bin is plugged in between and
+ * the sticky events are sent to it before the item */
+static GstPadProbeReturn
+replug_cb (GstPad * pad, GstPadProbeInfo * info, PadInfos * infos)
+{
+  GstPad *sinkpad;
+
+  LOCK (infos->self);
+  infos->replug_probe_id = 0;
+  UNLOCK (infos->self);
+
+  if (infos->bin)
+    return GST_PAD_PROBE_REMOVE;
+
+  GST_INFO_OBJECT (infos->ghost, "Plugging resampler");
+  gst_pad_unlink (pad, infos->adder_pad);
+  sinkpad = create_convert_bin (infos);
+  gst_element_sync_state_with_parent (infos->bin);
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_ERROR_OBJECT (infos->ghost, "Could not link resampler");
+  gst_object_unref (sinkpad);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Called with the lock taken */
+static void
+schedule_replug (PadInfos * infos)
+{
+  if (infos->bin || infos->replug_probe_id)
+    return;
+
+  infos->replug_probe_id = gst_pad_add_probe (infos->proxy,
+      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM, (GstPadProbeCallback) replug_cb,
+      infos, NULL);
+}
+
+/* Plugs audioconvert ! audioresample in front of the adder pad the first
+ * time the input caps have a rate different from the output one, also when
+ * the output rate changes with the restriction caps, see
+ * restriction_caps_cb (). Inputs already at the output rate go straight to
+ * the adder pad, which converts their format and channels while mixing, if
+ * needed. */
+static GstPadProbeReturn
+convert_probe_cb (GstPad * pad, GstPadProbeInfo * info, PadInfos * infos)
+{
+  GstCaps *caps;
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+    return GST_PAD_PROBE_OK;
+
+  if (infos->bin) {
+    update_resample_quality (infos);
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  gst_event_parse_caps (event, &caps);
+  if (needs_resampling (infos, caps)) {
+    GST_INFO_OBJECT (pad, "Resampling needed for %" GST_PTR_FORMAT, caps);
+    LOCK (infos->self);
+    schedule_replug (infos);
+    UNLOCK (infos->self);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
 /****************************************************
  *              GstElement vmetods                  *
  ****************************************************/
@@ -81,9 +295,7 @@ static GstPad *
 _request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
-  GstPad *audioresample_srcpad, *audioconvert_sinkpad, *tmpghost;
-  GstPad *ghost;
-  GstElement *audioconvert, *audioresample;
+  GstPad *ghost, *target;
   PadInfos *infos = g_slice_new0 (PadInfos);
   GESSmartAdder *self = GES_SMART_ADDER (element);
 
@@ -100,34 +312,34 @@ _request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   infos->self = self;
 
-  infos->bin = gst_bin_new (NULL);
-  audioconvert = gst_element_factory_make ("audioconvert", NULL);
-  audioresample = gst_element_factory_make ("audioresample", NULL);
-
-  gst_bin_add_many (GST_BIN (infos->bin), audioconvert, audioresample, NULL);
-  gst_element_link_many (audioconvert, audioresample, NULL);
-
-  audioconvert_sinkpad = gst_element_get_static_pad (audioconvert, "sink");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, audioconvert_sinkpad));
-  gst_object_unref (audioconvert_sinkpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
+  if (GST_IS_AUDIO_AGGREGATOR_CONVERT_PAD (infos->adder_pad))
+    target = gst_object_ref (infos->adder_pad);
+  else
+    target = create_convert_bin (infos);
 
-  gst_bin_add (GST_BIN (self), infos->bin);
-  ghost = gst_ghost_pad_new (NULL, tmpghost);
+  ghost = gst_ghost_pad_new (NULL, target);
+  gst_object_unref (target);
   gst_pad_set_active (ghost, TRUE);
   if (!gst_element_add_pad (GST_ELEMENT (self), ghost))
     goto could_not_add;
 
-  audioresample_srcpad = gst_element_get_static_pad (audioresample, "src");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, audioresample_srcpad));
-  gst_object_unref (audioresample_srcpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
-  gst_pad_link (tmpghost, infos->adder_pad);
+  infos->ghost = ghost;
+  infos->proxy = GST_PAD (gst_proxy_pad_get_internal (GST_PROXY_PAD (ghost)));
+  infos->convert_probe_id = gst_pad_add_probe (ghost,
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) convert_probe_cb, infos, NULL);
+
+  if (self->bypass) {
+    infos->bypass_check_caps = TRUE;
+    infos->bypass_probe_id = gst_pad_add_probe (ghost,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+        GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+        (GstPadProbeCallback) bypass_adder_cb, infos, NULL);
+  }
 
   LOCK (self);
   g_hash_table_insert (self->pads_infos, ghost, infos);
+  g_atomic_int_set (&self->n_pads, g_hash_table_size (self->pads_infos));
   UNLOCK (self);
 
   GST_DEBUG_OBJECT (self, "Returning new pad %" GST_PTR_FORMAT, ghost);
@@ -148,9 +360,30 @@ _release_pad (GstElement * element, GstPad * pad)
 
   LOCK (element);
   g_hash_table_remove (GES_SMART_ADDER (element)->pads_infos, pad);
+  g_atomic_int_set (&GES_SMART_ADDER (element)->n_pads,
+      g_hash_table_size (GES_SMART_ADDER (element)->pads_infos));
   UNLOCK (element);
 }
 
+static GstStateChangeReturn
+ges_smart_adder_change_state (GstElement * element, GstStateChange transition)
+{
+  GESSmartAdder *self = GES_SMART_ADDER (element);
+  GstStateChangeReturn ret;
+
+  /* Deactivating the pads needs the streaming threads */
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY && self->bypass)
+    ges_mixer_bypass_unlock (self->bypass);
+
+  ret = GST_ELEMENT_CLASS (ges_smart_adder_parent_class)->change_state (element,
+      transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY && self->bypass)
+    ges_mixer_bypass_reset (self->bypass);
+
+  return ret;
+}
+
 /****************************************************
  *              GObject vmethods                    *
  ****************************************************/
@@ -164,6 +397,8 @@ ges_smart_adder_dispose (GObject * object)
     self->pads_infos = NULL;
   }
 
+  g_clear_pointer (&self->bypass, ges_mixer_bypass_free);
+
   G_OBJECT_CLASS (ges_smart_adder_parent_class)->dispose (object);
 }
 
@@ -195,6 +430,8 @@ ges_smart_adder_class_init (GESSmartAdderClass * klass)
 
   element_class->request_new_pad = GST_DEBUG_FUNCPTR (_request_new_pad);
   element_class->release_pad = GST_DEBUG_FUNCPTR (_release_pad);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (ges_smart_adder_change_state);
 
   object_class->dispose = ges_smart_adder_dispose;
   object_class->finalize = ges_smart_adder_finalize;
@@ -217,6 +454,14 @@ ges_smart_adder_init (GESSmartAdder * self)
   gst_element_link (self->adder, self->capsfilter);
 
   pad = gst_element_get_static_pad (self->capsfilter, "src");
+  if (GST_IS_AGGREGATOR (self->adder)) {
+    self->bypass = ges_mixer_bypass_new (GST_BIN (self), pad);
+    if (self->bypass) {
+      gst_object_unref (pad);
+      pad = ges_mixer_bypass_get_srcpad (self->bypass);
+    }
+  }
+
   self->srcpad = gst_ghost_pad_new ("src", pad);
   gst_pad_set_active (self->srcpad, TRUE);
   gst_object_unref (pad);
@@ -232,6 +477,8 @@ restriction_caps_cb (GESTrack * track,
     GParamSpec * arg G_GNUC_UNUSED, GESSmartAdder * self)
 {
   GstCaps *caps;
+  PadInfos *infos;
+  GHashTableIter iter;
 
   g_object_get (track, "restriction-caps", &caps, NULL);
 
@@ -241,6 +488,22 @@ restriction_caps_cb (GESTrack * track,
   GST_DEBUG_OBJECT (self, "Setting adder caps to %" GST_PTR_FORMAT, caps);
   g_object_set (self->capsfilter, "caps", caps, NULL);
   gst_caps_unref (caps);
+
+  /* Inputs at the previous output rate might need to be resampled now */
+  LOCK (self);
+  g_hash_table_iter_init (&iter, self->pads_infos);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & infos)) {
+    GstCaps *input_caps;
+
+    if (infos->bin)
+      continue;
+
+    input_caps = gst_pad_get_current_caps (infos->ghost);
+    if (input_caps && needs_resampling (infos, input_caps))
+      schedule_replug (infos);
+    gst_clear_caps (&input_caps);
+  }
+  UNLOCK (self);
 }
 
 GstElement *
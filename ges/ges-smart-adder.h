@@ -58,6 +58,10 @@ struct _GESSmartAdder
 
   GESTrack *track;
 
+  /* Number of sinkpads, atomic */
+  gint n_pads;
+  struct _GESMixerBypass *bypass;
+
   gpointer _ges_reserved[GES_PADDING];
 };
 
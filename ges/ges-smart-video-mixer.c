@@ -20,10 +20,14 @@
 #include "config.h"
 #endif
 
+#include <gst/video/video.h>
+#include <gst/video/gstvideoaggregator.h>
+
 #include "gstframepositioner.h"
 #include "ges-types.h"
 #include "ges-internal.h"
 #include "ges-smart-video-mixer.h"
+#include <gst/base/gstaggregator.h>
 
 #define GES_TYPE_SMART_MIXER_PAD             (ges_smart_mixer_pad_get_type ())
 #define GES_SMART_MIXER_PAD(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GES_TYPE_SMART_MIXER_PAD, GESSmartMixerPad))
@@ -128,20 +132,148 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
     GST_STATIC_CAPS ("video/x-raw")
     );
 
+/* Properties of the mixer pads we set for every buffer from the
+ * GstFramePositionerMeta */
+typedef enum
+{
+  MIXER_PAD_ALPHA,
+  MIXER_PAD_ZORDER,
+  MIXER_PAD_XPOS,
+  MIXER_PAD_YPOS,
+  MIXER_PAD_WIDTH,
+  MIXER_PAD_HEIGHT,
+  MIXER_PAD_N_PROPERTIES
+} MixerPadProperty;
+
+static const gchar *mixer_pad_property_names[MIXER_PAD_N_PROPERTIES] = {
+  "alpha", "zorder", "xpos", "ypos", "width", "height"
+};
+
 typedef struct _PadInfos
 {
   GESSmartMixer *self;
   GstPad *mixer_pad;
   GstElement *bin;
   gulong probe_id;
+
+  GESSmartMixerPad *ghost;
+  /* Syncs the controlled properties of the ghost */
+  GESControlSync *control_sync;
+
+  /* Resolved once when the pad is requested so that the streaming thread
+   * does not need to lookup properties by name for every buffer, NULL if
+   * the mixer pad does not have the property */
+  GParamSpec *pspecs[MIXER_PAD_N_PROPERTIES];
+
+  /* Last values applied on the mixer pad, only accessed from the mixer pad
+   * streaming thread apart from @has_applied which is reset when the ghost
+   * gets unlinked so that everything is applied again on the new input */
+  gint has_applied;
+  gulong unlinked_id;
+  gdouble applied_alpha;
+  guint applied_zorder;
+  gint applied_posx;
+  gint applied_posy;
+  gint applied_width;
+  gint applied_height;
+
+  /* Single input bypass of the mixer, see bypass_mixer_cb () */
+  gulong bypass_probe_id;
+  gboolean bypass_check_caps;
+  gboolean bypass_caps_ok;
+  gint width;
+  gint height;
 } PadInfos;
 
+static void
+resolve_mixer_pad_properties (PadInfos * infos)
+{
+  guint i;
+  GObjectClass *klass = G_OBJECT_GET_CLASS (infos->mixer_pad);
+
+  for (i = 0; i < MIXER_PAD_N_PROPERTIES; i++) {
+    GParamSpec *pspec =
+        g_object_class_find_property (klass, mixer_pad_property_names[i]);
+
+    if (pspec && g_param_spec_get_redirect_target (pspec))
+      pspec = g_param_spec_get_redirect_target (pspec);
+
+    if (!pspec || !(pspec->flags & G_PARAM_WRITABLE)
+        || (pspec->flags & G_PARAM_CONSTRUCT_ONLY)) {
+      GST_INFO_OBJECT (infos->mixer_pad, "Can not set '%s'",
+          mixer_pad_property_names[i]);
+      continue;
+    }
+
+    infos->pspecs[i] = pspec;
+  }
+}
+
+/* Sets @value on the mixer pad, going through g_object_set_property() so
+ * that the usual validation, conversion and notification happen, we only
+ * avoid looking up whether the mixer pad has the property for every
+ * buffer */
+static inline void
+set_mixer_pad_property (PadInfos * infos, MixerPadProperty prop,
+    const GValue * value)
+{
+  GParamSpec *pspec = infos->pspecs[prop];
+
+  if (G_UNLIKELY (!pspec))
+    return;
+
+  g_object_set_property (G_OBJECT (infos->mixer_pad), pspec->name, value);
+}
+
+static inline void
+set_mixer_pad_double (PadInfos * infos, MixerPadProperty prop, gdouble v)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, G_TYPE_DOUBLE);
+  g_value_set_double (&value, v);
+  set_mixer_pad_property (infos, prop, &value);
+}
+
+static inline void
+set_mixer_pad_int (PadInfos * infos, MixerPadProperty prop, gint v)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, G_TYPE_INT);
+  g_value_set_int (&value, v);
+  set_mixer_pad_property (infos, prop, &value);
+}
+
+static inline void
+set_mixer_pad_uint (PadInfos * infos, MixerPadProperty prop, guint v)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, G_TYPE_UINT);
+  g_value_set_uint (&value, v);
+  set_mixer_pad_property (infos, prop, &value);
+}
+
+/* Whatever gets linked to the ghost next needs all the properties to be
+ * applied again. This also covers the pad being released as we unlink it
+ * from its peer first */
+static void
+ghost_unlinked_cb (GstPad * ghost, GstPad * peer, PadInfos * infos)
+{
+  g_atomic_int_set (&infos->has_applied, FALSE);
+}
+
 static void
 destroy_pad (PadInfos * infos)
 {
   gst_pad_remove_probe (infos->mixer_pad, infos->probe_id);
+  if (infos->unlinked_id)
+    g_signal_handler_disconnect (infos->ghost, infos->unlinked_id);
+  if (infos->bypass_probe_id)
+    gst_pad_remove_probe (GST_PAD (infos->ghost), infos->bypass_probe_id);
 
-  if (G_LIKELY (infos->bin)) {
+  if (infos->bin) {
     gst_element_set_state (infos->bin, GST_STATE_NULL);
     gst_element_unlink (infos->bin, infos->self->mixer);
     gst_bin_remove (GST_BIN (infos->self), infos->bin);
@@ -152,6 +284,9 @@ destroy_pad (PadInfos * infos)
     gst_object_unref (infos->mixer_pad);
   }
 
+  if (infos->control_sync)
+    ges_control_sync_free (infos->control_sync);
+
   g_slice_free (PadInfos, infos);
 }
 
@@ -172,14 +307,59 @@ ges_smart_mixer_get_mixer_pad (GESSmartMixer * self, GstPad ** mixerpad)
   return sinkpad;
 }
 
+/* Returns the alpha the frame described by @meta should be mixed with,
+ * taking the transition alpha into account when the mixer is used for
+ * transitions */
+static gdouble
+get_alpha (PadInfos * infos, GstFramePositionerMeta * meta, GstBuffer * buffer)
+{
+  gint64 stream_time;
+  gdouble transalpha;
+  GESSmartMixerPad *ghost = infos->ghost;
+
+  if (!infos->self->disable_zorder_alpha)
+    return meta->alpha;
+
+  GST_OBJECT_LOCK (ghost);
+  if (ghost->segment.format == GST_FORMAT_UNDEFINED) {
+    const GstSegment *seg;
+    GstEvent *segev;
+
+    GST_OBJECT_UNLOCK (ghost);
+    segev = gst_pad_get_sticky_event (GST_PAD (ghost), GST_EVENT_SEGMENT, 0);
+    gst_event_parse_segment (segev, &seg);
+    gst_event_unref (segev);
+    GST_OBJECT_LOCK (ghost);
+
+    ghost->segment = *seg;
+
+  }
+
+  stream_time = gst_segment_to_stream_time (&ghost->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffer));
+  GST_OBJECT_UNLOCK (ghost);
+
+  if (GST_CLOCK_TIME_IS_VALID (stream_time))
+    ges_control_sync_values (infos->control_sync, stream_time,
+        GST_BUFFER_DURATION (buffer));
+
+  GST_OBJECT_LOCK (ghost);
+  transalpha = ghost->alpha;
+  GST_OBJECT_UNLOCK (ghost);
+
+  return meta->alpha * transalpha;
+}
+
 /* These metadata will get set by the upstream framepositioner element,
-   added in the video sources' bin */
+   added in the video sources' bin. Most of the time they do not change from
+   one buffer to the other so we only set the mixer pad properties that
+   changed since the last buffer */
 static GstPadProbeReturn
-parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info,
-    GESSmartMixerPad * ghost)
+parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, PadInfos * infos)
 {
+  gdouble alpha;
   GstFramePositionerMeta *meta;
-  GESSmartMixer *self = GES_SMART_MIXER (GST_OBJECT_PARENT (ghost));
+  gboolean force = !g_atomic_int_get (&infos->has_applied);
 
   meta =
       (GstFramePositionerMeta *) gst_buffer_get_meta ((GstBuffer *) info->data,
@@ -190,43 +370,95 @@ parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info,
     return GST_PAD_PROBE_OK;
   }
 
-  if (!self->disable_zorder_alpha) {
-    g_object_set (mixer_pad, "alpha", meta->alpha,
-        "zorder", meta->zorder, NULL);
-  } else {
-    gint64 stream_time;
-    gdouble transalpha;
+  if (!infos->self->disable_zorder_alpha
+      && (force || meta->zorder != infos->applied_zorder)) {
+    set_mixer_pad_uint (infos, MIXER_PAD_ZORDER, meta->zorder);
+    infos->applied_zorder = meta->zorder;
+  }
 
-    GST_OBJECT_LOCK (ghost);
-    if (ghost->segment.format == GST_FORMAT_UNDEFINED) {
-      const GstSegment *seg;
-      GstEvent *segev;
+  alpha = get_alpha (infos, meta, info->data);
+  if (force || alpha != infos->applied_alpha) {
+    set_mixer_pad_double (infos, MIXER_PAD_ALPHA, alpha);
+    infos->applied_alpha = alpha;
+  }
 
-      GST_OBJECT_UNLOCK (ghost);
-      segev = gst_pad_get_sticky_event (GST_PAD (ghost), GST_EVENT_SEGMENT, 0);
-      gst_event_parse_segment (segev, &seg);
-      gst_event_unref (segev);
-      GST_OBJECT_LOCK (ghost);
+  if (force || meta->posx != infos->applied_posx) {
+    set_mixer_pad_int (infos, MIXER_PAD_XPOS, meta->posx);
+    infos->applied_posx = meta->posx;
+  }
 
-      ghost->segment = *seg;
+  if (force || meta->posy != infos->applied_posy) {
+    set_mixer_pad_int (infos, MIXER_PAD_YPOS, meta->posy);
+    infos->applied_posy = meta->posy;
+  }
 
-    }
+  if (force || meta->width != infos->applied_width) {
+    set_mixer_pad_int (infos, MIXER_PAD_WIDTH, meta->width);
+    infos->applied_width = meta->width;
+  }
 
-    stream_time = gst_segment_to_stream_time (&ghost->segment, GST_FORMAT_TIME,
-        GST_BUFFER_PTS (info->data));
-    GST_OBJECT_UNLOCK (ghost);
+  if (force || meta->height != infos->applied_height) {
+    set_mixer_pad_int (infos, MIXER_PAD_HEIGHT, meta->height);
+    infos->applied_height = meta->height;
+  }
 
-    if (GST_CLOCK_TIME_IS_VALID (stream_time))
-      gst_object_sync_values (GST_OBJECT (ghost), stream_time);
+  g_atomic_int_set (&infos->has_applied, TRUE);
 
-    g_object_get (ghost, "alpha", &transalpha, NULL);
-    g_object_set (mixer_pad, "alpha", meta->alpha * transalpha, NULL);
+  return GST_PAD_PROBE_OK;
+}
+
+/* Checks whether @buffer can be pushed as is on our srcpad: the pad has to
+ * be our only input and the frame has to cover the whole output, fully
+ * opaque, in a format accepted downstream. */
+static gboolean
+can_bypass_mixer (PadInfos * infos, GstBuffer * buffer)
+{
+  GstFramePositionerMeta *meta;
+  GESSmartMixer *self = infos->self;
+
+  if (g_atomic_int_get (&self->n_pads) != 1)
+    return FALSE;
+
+  if (infos->bypass_check_caps) {
+    GstVideoInfo vinfo;
+    GstCaps *caps = gst_pad_get_current_caps (GST_PAD (infos->ghost));
+
+    infos->bypass_check_caps = FALSE;
+    infos->bypass_caps_ok = caps && gst_video_info_from_caps (&vinfo, caps)
+        && gst_pad_peer_query_accept_caps (self->srcpad, caps);
+    if (infos->bypass_caps_ok) {
+      infos->width = GST_VIDEO_INFO_WIDTH (&vinfo);
+      infos->height = GST_VIDEO_INFO_HEIGHT (&vinfo);
+    }
+    gst_clear_caps (&caps);
   }
 
-  g_object_set (mixer_pad, "xpos", meta->posx, "ypos",
-      meta->posy, "width", meta->width, "height", meta->height, NULL);
+  if (!infos->bypass_caps_ok)
+    return FALSE;
 
-  return GST_PAD_PROBE_OK;
+  meta = (GstFramePositionerMeta *) gst_buffer_get_meta (buffer,
+      gst_frame_positioner_meta_api_get_type ());
+  if (!meta || meta->posx != 0 || meta->posy != 0
+      || meta->width != infos->width || meta->height != infos->height)
+    return FALSE;
+
+  return get_alpha (infos, meta, buffer) == 1.0;
+}
+
+/* When a single input is mixed, fully covering the output, the mixer is
+ * useless and its buffers are output as is, see ges-mixer-bypass.c */
+static GstPadProbeReturn
+bypass_mixer_cb (GstPad * pad, GstPadProbeInfo * info, PadInfos * infos)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_CAPS)
+      infos->bypass_check_caps = TRUE;
+
+    return ges_mixer_bypass_probe (infos->self->bypass, pad, info, FALSE);
+  }
+
+  return ges_mixer_bypass_probe (infos->self->bypass, pad, info,
+      can_bypass_mixer (infos, GST_PAD_PROBE_INFO_BUFFER (info)));
 }
 
 /****************************************************
@@ -236,11 +468,10 @@ static GstPad *
 _request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
-  GstPad *videoconvert_srcpad, *videoconvert_sinkpad, *tmpghost;
+  GstPad *target;
   PadInfos *infos = g_slice_new0 (PadInfos);
   GESSmartMixer *self = GES_SMART_MIXER (element);
   GstPad *ghost;
-  GstElement *videoconvert;
 
   infos->mixer_pad = gst_element_request_pad (self->mixer,
       gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self->mixer),
@@ -254,40 +485,66 @@ _request_new_pad (GstElement * element, GstPadTemplate * templ,
   }
 
   infos->self = self;
+  resolve_mixer_pad_properties (infos);
 
-  infos->bin = gst_bin_new (NULL);
-  videoconvert = gst_element_factory_make ("videoconvert", NULL);
+  if (GST_IS_VIDEO_AGGREGATOR_CONVERT_PAD (infos->mixer_pad)) {
+    /* The mixer pad converts and scales the frames to the output format and
+     * to the size set from the GstFramePositionerMeta while blending them,
+     * no need to convert them beforehand */
+    target = gst_object_ref (infos->mixer_pad);
+  } else {
+    GstPad *videoconvert_srcpad, *videoconvert_sinkpad, *tmpghost;
+    GstElement *videoconvert;
 
-  gst_bin_add (GST_BIN (infos->bin), videoconvert);
+    infos->bin = gst_bin_new (NULL);
+    videoconvert = gst_element_factory_make ("videoconvert", NULL);
 
-  videoconvert_sinkpad = gst_element_get_static_pad (videoconvert, "sink");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_sinkpad));
-  gst_object_unref (videoconvert_sinkpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
+    gst_bin_add (GST_BIN (infos->bin), videoconvert);
+
+    videoconvert_sinkpad = gst_element_get_static_pad (videoconvert, "sink");
+    target = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_sinkpad));
+    gst_object_unref (videoconvert_sinkpad);
+    gst_pad_set_active (target, TRUE);
+    gst_element_add_pad (GST_ELEMENT (infos->bin), gst_object_ref (target));
+
+    videoconvert_srcpad = gst_element_get_static_pad (videoconvert, "src");
+    tmpghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_srcpad));
+    gst_object_unref (videoconvert_srcpad);
+    gst_pad_set_active (tmpghost, TRUE);
+    gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
+
+    gst_bin_add (GST_BIN (self), infos->bin);
+    gst_pad_link (tmpghost, infos->mixer_pad);
+  }
 
-  gst_bin_add (GST_BIN (self), infos->bin);
   ghost = g_object_new (ges_smart_mixer_pad_get_type (), "name", name,
-      "direction", GST_PAD_DIRECTION (tmpghost), NULL);
+      "direction", GST_PAD_SINK, NULL);
   gst_ghost_pad_construct (GST_GHOST_PAD (ghost));
-  gst_ghost_pad_set_target (GST_GHOST_PAD_CAST (ghost), tmpghost);
+  gst_ghost_pad_set_target (GST_GHOST_PAD_CAST (ghost), target);
+  gst_object_unref (target);
   gst_pad_set_active (ghost, TRUE);
   if (!gst_element_add_pad (GST_ELEMENT (self), ghost))
     goto could_not_add;
 
-  videoconvert_srcpad = gst_element_get_static_pad (videoconvert, "src");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_srcpad));
-  gst_object_unref (videoconvert_srcpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
-  gst_pad_link (tmpghost, infos->mixer_pad);
-
+  infos->ghost = GES_SMART_MIXER_PAD (ghost);
+  infos->control_sync = ges_control_sync_new (GST_OBJECT (ghost));
+  infos->unlinked_id = g_signal_connect (ghost, "unlinked",
+      G_CALLBACK (ghost_unlinked_cb), infos);
   infos->probe_id =
       gst_pad_add_probe (infos->mixer_pad, GST_PAD_PROBE_TYPE_BUFFER,
-      (GstPadProbeCallback) parse_metadata, ghost, NULL);
+      (GstPadProbeCallback) parse_metadata, infos, NULL);
+
+  if (self->bypass) {
+    infos->bypass_check_caps = TRUE;
+    infos->bypass_probe_id = gst_pad_add_probe (ghost,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+        GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+        (GstPadProbeCallback) bypass_mixer_cb, infos, NULL);
+  }
 
   LOCK (self);
   g_hash_table_insert (self->pads_infos, ghost, infos);
+  g_atomic_int_set (&self->n_pads, g_hash_table_size (self->pads_infos));
   UNLOCK (self);
 
   GST_DEBUG_OBJECT (self, "Returning new pad %" GST_PTR_FORMAT, ghost);
@@ -309,6 +566,8 @@ _release_pad (GstElement * element, GstPad * pad)
 
   LOCK (element);
   g_hash_table_remove (GES_SMART_MIXER (element)->pads_infos, pad);
+  g_atomic_int_set (&GES_SMART_MIXER (element)->n_pads,
+      g_hash_table_size (GES_SMART_MIXER (element)->pads_infos));
   peer = gst_pad_get_peer (pad);
   if (peer) {
     gst_pad_unlink (peer, pad);
@@ -320,6 +579,25 @@ _release_pad (GstElement * element, GstPad * pad)
   UNLOCK (element);
 }
 
+static GstStateChangeReturn
+ges_smart_mixer_change_state (GstElement * element, GstStateChange transition)
+{
+  GESSmartMixer *self = GES_SMART_MIXER (element);
+  GstStateChangeReturn ret;
+
+  /* Deactivating the pads needs the streaming threads */
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY && self->bypass)
+    ges_mixer_bypass_unlock (self->bypass);
+
+  ret = GST_ELEMENT_CLASS (ges_smart_mixer_parent_class)->change_state (element,
+      transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY && self->bypass)
+    ges_mixer_bypass_reset (self->bypass);
+
+  return ret;
+}
+
 /****************************************************
  *              GObject vmethods                    *
  ****************************************************/
@@ -333,6 +611,8 @@ ges_smart_mixer_dispose (GObject * object)
     self->pads_infos = NULL;
   }
 
+  g_clear_pointer (&self->bypass, ges_mixer_bypass_free);
+
   G_OBJECT_CLASS (ges_smart_mixer_parent_class)->dispose (object);
 }
 
@@ -370,6 +650,14 @@ ges_smart_mixer_constructed (GObject * obj)
   gst_element_link (self->mixer, identity);
 
   pad = gst_element_get_static_pad (identity, "src");
+  if (GST_IS_AGGREGATOR (self->mixer)) {
+    self->bypass = ges_mixer_bypass_new (GST_BIN (self), pad);
+    if (self->bypass) {
+      gst_object_unref (pad);
+      pad = ges_mixer_bypass_get_srcpad (self->bypass);
+    }
+  }
+
   self->srcpad = gst_ghost_pad_new ("src", pad);
   gst_pad_set_active (self->srcpad, TRUE);
   gst_object_unref (pad);
@@ -395,6 +683,8 @@ ges_smart_mixer_class_init (GESSmartMixerClass * klass)
 
   element_class->request_new_pad = GST_DEBUG_FUNCPTR (_request_new_pad);
   element_class->release_pad = GST_DEBUG_FUNCPTR (_release_pad);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (ges_smart_mixer_change_state);
 
   object_class->dispose = ges_smart_mixer_dispose;
   object_class->finalize = ges_smart_mixer_finalize;
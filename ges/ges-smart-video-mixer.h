@@ -56,6 +56,10 @@ struct _GESSmartMixer
   GstCaps *caps;
   gboolean disable_zorder_alpha;
 
+  /* Number of sinkpads, atomic */
+  gint n_pads;
+  struct _GESMixerBypass *bypass;
+
   gpointer _ges_reserved[GES_PADDING];
 };
 
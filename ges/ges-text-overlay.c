@@ -171,6 +171,7 @@ ges_text_overlay_create_element (GESTrackElement * track_element)
 
   ges_track_element_add_children_props (track_element, text, NULL, NULL,
       child_props);
+  ges_text_render_cache_attach (text, NULL, child_props);
 
   ret = gst_bin_new ("overlay-bin");
   gst_bin_add_many (GST_BIN (ret), text, iconv, oconv, NULL);
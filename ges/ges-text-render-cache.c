@@ -0,0 +1,494 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Avoids re-rendering text when nothing changed:
+ *
+ *  - textoverlay renders its text again each time any of its properties is
+ *    set, and controlled properties are set for every frame. We evaluate the
+ *    control bindings of the text element ourselves and only set the values
+ *    that actually changed, so the text is only rasterized again when its
+ *    rendering changes.
+ *  - textoverlay is made to attach the text it renders to the frames as a
+ *    GstVideoOverlayComposition meta instead of blending it itself. Those
+ *    compositions are cached by everything their rendering depends on (the
+ *    properties of the text element and the video caps), and frames for
+ *    which a composition is cached get it attached without going through
+ *    textoverlay at all. The compositions are blended on the frames when
+ *    they leave the text element, unless downstream handles the meta.
+ *  - When the text is rendered on top of a static background (as in title
+ *    sources), the whole output frame is the same as long as no property
+ *    changes, the last rendered frame is then reused with new timestamps
+ *    instead of filling the background and blending the text again.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ges-internal.h"
+#include "ges-enums.h"
+
+#include <gst/video/video.h>
+
+#define RENDER_CACHE_QUARK (g_quark_from_static_string ("ges-text-render-cache"))
+#define MAX_CACHED_COMPOSITIONS 32
+
+typedef struct
+{
+  GstElement *text;
+  GstElement *background;
+  gchar **props;
+
+  GstPad *srcpad;
+
+  /* Set from any thread whenever a property of the elements changes */
+  gint dirty;
+
+  /* Only accessed from the streaming thread */
+  GstBuffer *last_output;
+  gboolean capture;
+  /* Whether we pretend downstream handles the overlay composition meta, and
+   * blend the compositions ourselves */
+  gboolean blend;
+  GstVideoInfo info;
+  /* Render key -> GstVideoOverlayComposition, NULL when nothing is drawn */
+  GHashTable *compositions;
+  gchar *key;
+  gboolean capture_composition;
+  /* Bindings we disabled while the text element renders the current frame */
+  GPtrArray *disabled;
+} RenderCache;
+
+static void
+restore_bindings (RenderCache * cache)
+{
+  guint i;
+
+  for (i = 0; i < cache->disabled->len; i++)
+    gst_control_binding_set_disabled (g_ptr_array_index (cache->disabled, i),
+        FALSE);
+  g_ptr_array_set_size (cache->disabled, 0);
+}
+
+static void
+render_cache_free (RenderCache * cache)
+{
+  if (cache->background) {
+    g_signal_handlers_disconnect_by_data (cache->background, cache);
+    gst_object_unref (cache->background);
+  }
+
+  gst_clear_object (&cache->srcpad);
+  gst_buffer_replace (&cache->last_output, NULL);
+  g_hash_table_unref (cache->compositions);
+  g_free (cache->key);
+  g_strfreev (cache->props);
+  restore_bindings (cache);
+  g_ptr_array_unref (cache->disabled);
+
+  g_slice_free (RenderCache, cache);
+}
+
+static void
+notify_cb (GObject * object, GParamSpec * pspec, RenderCache * cache)
+{
+  g_atomic_int_set (&cache->dirty, TRUE);
+}
+
+/* Sets the values of the control bindings of the text element which
+ * changed since the last frame. The enabled bindings are disabled until the
+ * element is done with the frame so it does not set them all again itself,
+ * see restore_bindings() */
+static void
+sync_text_values (RenderCache * cache, GstClockTime stream_time)
+{
+  guint i;
+  GObject *text = G_OBJECT (cache->text);
+
+  if (!GST_CLOCK_TIME_IS_VALID (stream_time))
+    return;
+
+  for (i = 0; cache->props[i]; i++) {
+    GValue *value;
+    GValue current = G_VALUE_INIT;
+    GstControlBinding *binding =
+        gst_object_get_control_binding (GST_OBJECT (text), cache->props[i]);
+
+    if (!binding)
+      continue;
+
+    if (gst_control_binding_is_disabled (binding)) {
+      gst_object_unref (binding);
+      continue;
+    }
+
+    value = gst_control_binding_get_value (binding, stream_time);
+    gst_control_binding_set_disabled (binding, TRUE);
+    g_ptr_array_add (cache->disabled, binding);
+    if (!value)
+      continue;
+
+    g_value_init (&current, G_VALUE_TYPE (value));
+    g_object_get_property (text, cache->props[i], &current);
+    if (gst_value_compare (value, &current) != GST_VALUE_EQUAL)
+      g_object_set_property (text, cache->props[i], value);
+
+    g_value_unset (&current);
+    g_value_unset (value);
+    g_free (value);
+  }
+}
+
+static gboolean
+background_is_static (RenderCache * cache)
+{
+  gint pattern;
+
+  if (!cache->background
+      || gst_object_has_active_control_bindings (GST_OBJECT
+          (cache->background)))
+    return FALSE;
+
+  g_object_get (cache->background, "pattern", &pattern, NULL);
+
+  return pattern == GES_VIDEO_TEST_PATTERN_SOLID;
+}
+
+static void
+composition_unref (GstVideoOverlayComposition * composition)
+{
+  if (composition)
+    gst_video_overlay_composition_unref (composition);
+}
+
+/* Everything the text rendered by the text element depends on: the values of
+ * its own properties and the video caps */
+static gchar *
+get_render_key (RenderCache * cache, GstPad * pad)
+{
+  guint i, n_pspecs;
+  GParamSpec **pspecs;
+  GString *key = g_string_new (NULL);
+  GstCaps *caps = gst_pad_get_current_caps (pad);
+
+  if (caps) {
+    gchar *caps_str = gst_caps_to_string (caps);
+
+    g_string_append (key, caps_str);
+    g_free (caps_str);
+    gst_caps_unref (caps);
+  }
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (cache->text),
+      &n_pspecs);
+  for (i = 0; i < n_pspecs; i++) {
+    gchar *value_str;
+    GValue value = G_VALUE_INIT;
+
+    if (!(pspecs[i]->flags & G_PARAM_READABLE)
+        || g_type_is_a (GST_TYPE_ELEMENT, pspecs[i]->owner_type))
+      continue;
+
+    g_value_init (&value, pspecs[i]->value_type);
+    g_object_get_property (G_OBJECT (cache->text), pspecs[i]->name, &value);
+    value_str = gst_value_serialize (&value);
+    g_string_append_printf (key, "|%s=%s", pspecs[i]->name,
+        GST_STR_NULL (value_str));
+    g_free (value_str);
+    g_value_unset (&value);
+  }
+  g_free (pspecs);
+
+  return g_string_free (key, FALSE);
+}
+
+static GstCaps *
+strip_composition_feature (GstCaps * caps)
+{
+  guint i;
+
+  caps = gst_caps_copy (caps);
+  for (i = 0; i < gst_caps_get_size (caps); i++)
+    gst_caps_features_remove (gst_caps_get_features (caps, i),
+        GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION);
+
+  return caps;
+}
+
+static gboolean
+has_composition_feature (GstCaps * caps)
+{
+  guint i;
+
+  for (i = 0; i < gst_caps_get_size (caps); i++) {
+    if (gst_caps_features_contains (gst_caps_get_features (caps, i),
+            GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* textoverlay only attaches its compositions when downstream accepts caps
+ * with the overlay composition feature and the meta in the allocation query,
+ * answer that we do when downstream does not handle them itself */
+static GstPadProbeReturn
+handle_text_src_query (GstPad * pad, GstPadProbeInfo * info,
+    RenderCache * cache)
+{
+  GstCaps *caps;
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_ACCEPT_CAPS
+      && (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_PUSH)) {
+    GstCaps *stripped;
+    GstPad *peer;
+    gboolean res;
+
+    gst_query_parse_accept_caps (query, &caps);
+    if (!has_composition_feature (caps))
+      return GST_PAD_PROBE_OK;
+
+    peer = gst_pad_get_peer (pad);
+    if (!peer)
+      return GST_PAD_PROBE_OK;
+
+    if (gst_pad_query_accept_caps (peer, caps)) {
+      cache->blend = FALSE;
+      res = TRUE;
+    } else {
+      stripped = strip_composition_feature (caps);
+      res = cache->blend = gst_pad_query_accept_caps (peer, stripped);
+      gst_caps_unref (stripped);
+    }
+    gst_object_unref (peer);
+
+    gst_query_set_accept_caps_result (query, res);
+
+    return GST_PAD_PROBE_HANDLED;
+  }
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION && cache->blend
+      && (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_PULL)) {
+    gst_query_parse_allocation (query, &caps, NULL);
+    if (caps && has_composition_feature (caps)
+        && !gst_query_find_allocation_meta (query,
+            GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL))
+      gst_query_add_allocation_meta (query,
+          GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstBuffer *
+blend_composition (RenderCache * cache, GstBuffer * buffer)
+{
+  GstVideoFrame frame;
+  GstVideoOverlayCompositionMeta *meta;
+
+  buffer = gst_buffer_make_writable (buffer);
+  meta = gst_buffer_get_video_overlay_composition_meta (buffer);
+
+  if (gst_video_frame_map (&frame, &cache->info, buffer, GST_MAP_READWRITE)) {
+    gst_video_overlay_composition_blend (meta->overlay, &frame);
+    gst_video_frame_unmap (&frame);
+  } else {
+    GST_ERROR ("Could not map buffer to blend the text");
+  }
+  gst_buffer_remove_meta (buffer, GST_META_CAST (meta));
+
+  return buffer;
+}
+
+static GstPadProbeReturn
+text_sink_probe_cb (GstPad * pad, GstPadProbeInfo * info, RenderCache * cache)
+{
+  GstEvent *event;
+  GstBuffer *buffer, *outbuf;
+  gboolean dirty;
+  gpointer composition;
+  GstClockTime stream_time = GST_CLOCK_TIME_NONE;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      gst_buffer_replace (&cache->last_output, NULL);
+      g_hash_table_remove_all (cache->compositions);
+      g_clear_pointer (&cache->key, g_free);
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  /* In case the element did not output the previous frame */
+  restore_bindings (cache);
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (event) {
+    const GstSegment *segment;
+
+    gst_event_parse_segment (event, &segment);
+    stream_time = gst_segment_to_stream_time (segment, GST_FORMAT_TIME,
+        GST_BUFFER_PTS (buffer));
+    gst_event_unref (event);
+  }
+
+  sync_text_values (cache, stream_time);
+
+  dirty = g_atomic_int_compare_and_exchange (&cache->dirty, TRUE, FALSE);
+  if (!dirty && cache->last_output) {
+    outbuf = gst_buffer_copy (cache->last_output);
+    gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_FLAGS |
+        GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    gst_buffer_unref (buffer);
+    restore_bindings (cache);
+
+    GST_PAD_PROBE_INFO_FLOW_RETURN (info) = gst_pad_push (cache->srcpad,
+        outbuf);
+    GST_PAD_PROBE_INFO_DATA (info) = NULL;
+
+    return GST_PAD_PROBE_HANDLED;
+  }
+
+  gst_buffer_replace (&cache->last_output, NULL);
+  cache->capture = background_is_static (cache);
+
+  if (dirty || !cache->key) {
+    g_free (cache->key);
+    cache->key = get_render_key (cache, pad);
+  }
+
+  if (cache->blend && g_hash_table_lookup_extended (cache->compositions,
+          cache->key, NULL, &composition)) {
+    if (composition) {
+      buffer = gst_buffer_make_writable (buffer);
+      gst_buffer_add_video_overlay_composition_meta (buffer, composition);
+    }
+    restore_bindings (cache);
+
+    GST_PAD_PROBE_INFO_FLOW_RETURN (info) = gst_pad_push (cache->srcpad,
+        buffer);
+    GST_PAD_PROBE_INFO_DATA (info) = NULL;
+
+    return GST_PAD_PROBE_HANDLED;
+  }
+
+  /* Let the text element render the text and keep its composition */
+  cache->capture_composition = TRUE;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+text_src_probe_cb (GstPad * pad, GstPadProbeInfo * info, RenderCache * cache)
+{
+  GstBuffer *buffer;
+  GstVideoOverlayCompositionMeta *meta;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM)
+    return handle_text_src_query (pad, info, cache);
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstCaps *caps;
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+      return GST_PAD_PROBE_OK;
+
+    gst_event_parse_caps (event, &caps);
+    gst_video_info_from_caps (&cache->info, caps);
+    if (cache->blend && has_composition_feature (caps)) {
+      caps = strip_composition_feature (caps);
+      GST_PAD_PROBE_INFO_DATA (info) = gst_event_new_caps (caps);
+      gst_caps_unref (caps);
+      gst_event_unref (event);
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  restore_bindings (cache);
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  meta = gst_buffer_get_video_overlay_composition_meta (buffer);
+  if (cache->capture_composition) {
+    cache->capture_composition = FALSE;
+
+    /* Do not cache what was rendered with properties set after the key was
+     * computed */
+    if (cache->blend && cache->key && !g_atomic_int_get (&cache->dirty)) {
+      if (g_hash_table_size (cache->compositions) >= MAX_CACHED_COMPOSITIONS)
+        g_hash_table_remove_all (cache->compositions);
+
+      g_hash_table_insert (cache->compositions, g_strdup (cache->key),
+          meta ? gst_video_overlay_composition_ref (meta->overlay) : NULL);
+    }
+  }
+
+  if (meta && cache->blend) {
+    buffer = blend_composition (cache, buffer);
+    GST_PAD_PROBE_INFO_DATA (info) = buffer;
+  }
+
+  if (cache->capture) {
+    gst_buffer_replace (&cache->last_output, buffer);
+    cache->capture = FALSE;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* @background is the videotestsrc generating the frames @text renders on, if
+ * any, and @props the properties of @text that can be controlled */
+void
+ges_text_render_cache_attach (GstElement * text, GstElement * background,
+    const gchar ** props)
+{
+  GstPad *sinkpad;
+  RenderCache *cache = g_slice_new0 (RenderCache);
+
+  cache->text = text;
+  cache->props = g_strdupv ((gchar **) props);
+  cache->srcpad = gst_element_get_static_pad (text, "src");
+  cache->dirty = TRUE;
+  cache->disabled = g_ptr_array_new_with_free_func (gst_object_unref);
+  cache->compositions = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) composition_unref);
+  gst_video_info_init (&cache->info);
+
+  g_signal_connect (text, "notify", G_CALLBACK (notify_cb), cache);
+  if (background) {
+    cache->background = gst_object_ref (background);
+    g_signal_connect (background, "notify", G_CALLBACK (notify_cb), cache);
+  }
+
+  g_object_set_qdata_full (G_OBJECT (text), RENDER_CACHE_QUARK, cache,
+      (GDestroyNotify) render_cache_free);
+
+  sinkpad = gst_element_get_static_pad (text, "video_sink");
+  gst_pad_add_probe (sinkpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) text_sink_probe_cb, cache, NULL);
+  gst_object_unref (sinkpad);
+
+  gst_pad_add_probe (cache->srcpad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM,
+      (GstPadProbeCallback) text_src_probe_cb, cache, NULL);
+}
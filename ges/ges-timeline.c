@@ -214,6 +214,10 @@ struct _GESTimelinePrivate
   GCond commited_cond;
 
   GThread *valid_thread;
+
+  /* Whether uri sources play the proxies of their media, set by the
+   * pipeline depending on its mode */
+  gboolean use_proxies;
 };
 
 /* private structure to contain our track-related information */
@@ -2831,6 +2835,32 @@ timeline_fill_gaps (GESTimeline * timeline)
   }
 }
 
+void
+timeline_set_use_proxies (GESTimeline * timeline, gboolean use_proxies)
+{
+  GList *tmp, *elements, *etmp;
+
+  timeline->priv->use_proxies = use_proxies;
+
+  for (tmp = timeline->tracks; tmp; tmp = tmp->next) {
+    elements = ges_track_get_elements (tmp->data);
+
+    for (etmp = elements; etmp; etmp = etmp->next) {
+      if (GES_IS_VIDEO_URI_SOURCE (etmp->data))
+        ges_video_uri_source_update_playback_uri (etmp->data);
+      else if (GES_IS_AUDIO_URI_SOURCE (etmp->data))
+        ges_audio_uri_source_update_playback_uri (etmp->data);
+    }
+    g_list_free_full (elements, gst_object_unref);
+  }
+}
+
+gboolean
+timeline_get_use_proxies (GESTimeline * timeline)
+{
+  return timeline->priv->use_proxies;
+}
+
 /**** API *****/
 /**
  * ges_timeline_new:
@@ -291,6 +291,7 @@ ges_title_source_create_source (GESTrackElement * object)
   ges_track_element_add_children_props (object, text, NULL, NULL, text_props);
   ges_track_element_add_children_props (object, background, NULL, NULL,
       bg_props);
+  ges_text_render_cache_attach (text, background, text_props);
 
   return topbin;
 }
@@ -80,6 +80,10 @@ struct _GESTrackPrivate
   GstElement *mixing_operation;
   GstElement *capsfilter;
 
+  /* Quality of the resamplers of the mixer inputs, -1 for the default of
+   * audioresample, atomic */
+  gint resample_quality;
+
   /* Virtual method to create GstElement that fill gaps */
   GESCreateElementForGapFunc create_element_for_gaps;
 
@@ -261,6 +265,20 @@ track_disable_last_gap (GESTrack * track, gboolean disabled)
   update_gaps (track);
 }
 
+/* Sets the quality used by the mixer when it needs to resample its inputs,
+ * it is taken into account when the mixer inputs get new caps */
+void
+track_set_resample_quality (GESTrack * track, gint quality)
+{
+  g_atomic_int_set (&track->priv->resample_quality, quality);
+}
+
+gint
+track_get_resample_quality (GESTrack * track)
+{
+  return g_atomic_int_get (&track->priv->resample_quality);
+}
+
 void
 track_resort_and_fill_gaps (GESTrack * track)
 {
@@ -702,6 +720,7 @@ ges_track_init (GESTrack * self)
   self->priv->gaps = NULL;
   self->priv->mixing = TRUE;
   self->priv->restriction_caps = NULL;
+  self->priv->resample_quality = -1;
 
   g_signal_connect (G_OBJECT (self->priv->composition), "notify::duration",
       G_CALLBACK (composition_duration_cb), self);
@@ -27,6 +27,23 @@
  * the media file to use inside the GStreamer Editing Services. It has APIs that
  * let you get information about the medias. Also, the tags found in the media file are
  * set as Metadata of the Asset.
+ *
+ * Media files are discovered in parallel by a pool of #GstDiscoverer, with
+ * one discoverer per processor, up to 8. The size of that pool can be set
+ * with the GES_DISCOVERY_POOL_SIZE environment variable.
+ *
+ * Discovery results are cached on disk, in the user cache directory, and
+ * reused as long as the modification time and the size of the files do not
+ * change. The GES_DISCOVERY_CACHE_DIR environment variable can be used to
+ * set another cache directory, or to disable that cache by setting it to
+ * an empty string.
+ *
+ * When a project stores what was discovered about its media, as the xges
+ * formatter does, the assets are created right away from that information
+ * and the files are discovered again in the background. If the media
+ * turned out to differ, the asset is updated and emits
+ * #GESUriClipAsset::media-changed, which makes the #GESUriClip-s using it
+ * update their children.
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -39,10 +56,34 @@
 #include "ges-track-element-asset.h"
 
 #define DEFAULT_DISCOVERY_TIMEOUT (60 * GST_SECOND)
+#define DEFAULT_MAX_PROXY_JOBS 2
+#define DEFAULT_PROXY_HEIGHT 540
+/* Maximum default number of discoverers working in parallel, one per
+ * processor otherwise */
+#define DEFAULT_MAX_DISCOVERERS 8
 
 static GHashTable *parent_newparent_table = NULL;
 
-static GstDiscoverer *discoverer = NULL;
+/* GstDiscoverer only discovers one URI at a time, assets are spread across
+ * a pool of them so that they get discovered in parallel. They all emit
+ * "discovered" on the main context GES was initialized from. */
+typedef struct
+{
+  GstDiscoverer *discoverer;
+
+  /* Number of URIs being discovered, atomic */
+  gint n_pending;
+} PooledDiscoverer;
+
+static PooledDiscoverer *discoverers = NULL;
+static guint n_discoverers = 0;
+/* The context the discoverers emit "discovered" on */
+static GMainContext *discovery_context = NULL;
+
+/* URI -> GstDiscovererInfo stored in a project, used instead of discovering
+ * the asset when it gets loaded. Protected by provisional_infos_lock */
+G_LOCK_DEFINE_STATIC (provisional_infos_lock);
+static GHashTable *provisional_infos = NULL;
 
 static void
 initable_iface_init (GInitableIface * initable_iface)
@@ -62,6 +103,13 @@ enum
 };
 static GParamSpec *properties[PROP_LAST];
 
+enum
+{
+  MEDIA_CHANGED_SIGNAL,
+  LAST_SIGNAL
+};
+static guint signals[LAST_SIGNAL] = { 0 };
+
 static void discoverer_discovered_cb (GstDiscoverer * discoverer,
     GstDiscovererInfo * info, GError * err, gpointer user_data);
 
@@ -71,6 +119,10 @@ struct _GESUriClipAssetPrivate
   GstClockTime duration;
   gboolean is_image;
 
+  /* Set when the asset got loaded from information stored in a project,
+   * until the file is discovered again */
+  gboolean provisional;
+
   GList *asset_trackfilesources;
 };
 
@@ -81,6 +133,26 @@ typedef struct
   GError *error;
 } RequestSyncData;
 
+/* A proxy transcoding job, see ges_uri_clip_asset_generate_proxy() */
+typedef struct
+{
+  GESUriClipAsset *asset;
+  gchar *proxy_uri;
+  GstEncodingProfile *profile;
+  GTask *task;
+
+  GstElement *pipeline;
+  GstElement *encodebin;
+  guint bus_watch_id;
+  gulong cancelled_id;
+} ProxyJob;
+
+/* Protects the proxy job queue */
+G_LOCK_DEFINE_STATIC (proxy_jobs_lock);
+static GQueue proxy_jobs = G_QUEUE_INIT;
+static guint n_running_proxy_jobs = 0;
+static guint max_proxy_jobs = DEFAULT_MAX_PROXY_JOBS;
+
 struct _GESUriSourceAssetPrivate
 {
   GstDiscovererStreamInfo *sinfo;
@@ -123,19 +195,159 @@ ges_uri_clip_asset_set_property (GObject * object, guint property_id,
   }
 }
 
+/* Returns the discoverer of the pool with the fewest URIs to discover, or
+ * NULL if the class discoverer has been replaced by a custom one */
+static PooledDiscoverer *
+_get_pooled_discoverer (GESUriClipAssetClass * class)
+{
+  guint i;
+  PooledDiscoverer *res;
+
+  if (!n_discoverers || class->discoverer != discoverers[0].discoverer)
+    return NULL;
+
+  res = &discoverers[0];
+  for (i = 1; i < n_discoverers; i++) {
+    if (g_atomic_int_get (&discoverers[i].n_pending) <
+        g_atomic_int_get (&res->n_pending))
+      res = &discoverers[i];
+  }
+
+  return res;
+}
+
+static void
+_pooled_discoverer_discovered_cb (GstDiscoverer * discoverer,
+    GstDiscovererInfo * info, GError * err, PooledDiscoverer * pooled)
+{
+  g_atomic_int_add (&pooled->n_pending, -1);
+}
+
+static gboolean
+_discover_uri (GESUriClipAssetClass * class, const gchar * uri)
+{
+  gboolean ret;
+  PooledDiscoverer *pooled = _get_pooled_discoverer (class);
+
+  if (!pooled)
+    return gst_discoverer_discover_uri_async (class->discoverer, uri);
+
+  g_atomic_int_inc (&pooled->n_pending);
+  ret = gst_discoverer_discover_uri_async (pooled->discoverer, uri);
+  if (!ret)
+    g_atomic_int_add (&pooled->n_pending, -1);
+
+  return ret;
+}
+
+typedef struct
+{
+  GESUriClipAssetClass *class;
+  GstDiscovererInfo *info;
+
+  /* Whether @info is provisional and the file needs to be discovered */
+  gboolean verify;
+} CachedDiscovery;
+
+static gboolean
+_emit_cached_discovery (CachedDiscovery * cached)
+{
+  GESUriClipAsset *asset;
+  const gchar *uri = gst_discoverer_info_get_uri (cached->info);
+
+  cached->class->discovered (cached->class->discoverer, cached->info, NULL,
+      NULL);
+
+  if (!cached->verify)
+    return G_SOURCE_REMOVE;
+
+  asset = GES_URI_CLIP_ASSET (ges_asset_cache_lookup (GES_TYPE_URI_CLIP, uri));
+  GST_DEBUG_OBJECT (asset, "Verifying provisional info");
+  if (!_discover_uri (cached->class, uri))
+    GST_WARNING_OBJECT (asset, "Could not start verifying provisional info");
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+_cached_discovery_free (CachedDiscovery * cached)
+{
+  gst_discoverer_info_unref (cached->info);
+  g_slice_free (CachedDiscovery, cached);
+}
+
+static GstDiscovererInfo *
+_steal_provisional_info (const gchar * uri)
+{
+  GstDiscovererInfo *info = NULL;
+
+  G_LOCK (provisional_infos_lock);
+  if (provisional_infos) {
+    info = g_hash_table_lookup (provisional_infos, uri);
+    if (info) {
+      gst_discoverer_info_ref (info);
+      g_hash_table_remove (provisional_infos, uri);
+    }
+  }
+  G_UNLOCK (provisional_infos_lock);
+
+  return info;
+}
+
+/* Missing files have to go through a discovery so that they can be
+ * relocated, see ges_uri_asset_try_update_id() */
+static gboolean
+_file_exists (const gchar * uri)
+{
+  gboolean res = TRUE;
+  GFile *file = g_file_new_for_uri (uri);
+
+  if (g_file_is_native (file))
+    res = g_file_query_exists (file, NULL);
+  g_object_unref (file);
+
+  return res;
+}
+
 static GESAssetLoadingReturn
 _start_loading (GESAsset * asset, GError ** error)
 {
-  gboolean ret;
   const gchar *uri;
+  GstDiscovererInfo *info, *provisional;
   GESUriClipAssetClass *class = GES_URI_CLIP_ASSET_GET_CLASS (asset);
 
   GST_DEBUG ("Started loading %p", asset);
 
   uri = ges_asset_get_id (asset);
 
-  ret = gst_discoverer_discover_uri_async (class->discoverer, uri);
-  if (ret)
+  provisional = _steal_provisional_info (uri);
+  info = ges_discovery_cache_lookup (uri);
+  if (info) {
+    GST_INFO_OBJECT (asset, "Using cached discovery info");
+  } else if (provisional && _file_exists (uri)) {
+    GST_INFO_OBJECT (asset, "Using provisional discovery info");
+    info = gst_discoverer_info_ref (provisional);
+  }
+
+  if (info) {
+    GSource *source = g_idle_source_new ();
+    CachedDiscovery *cached = g_slice_new (CachedDiscovery);
+
+    /* Loading has to complete asynchronously, as for a real discovery */
+    cached->class = class;
+    cached->info = info;
+    cached->verify = info == provisional;
+    GES_URI_CLIP_ASSET (asset)->priv->provisional = cached->verify;
+    g_source_set_callback (source, (GSourceFunc) _emit_cached_discovery,
+        cached, (GDestroyNotify) _cached_discovery_free);
+    g_source_attach (source, discovery_context);
+    g_source_unref (source);
+  }
+
+  if (provisional)
+    gst_discoverer_info_unref (provisional);
+
+  if (info || _discover_uri (class, uri))
     return GES_ASSET_LOADING_ASYNC;
 
   return GES_ASSET_LOADING_ERROR;
@@ -238,6 +450,20 @@ ges_uri_clip_asset_class_init (GESUriClipAssetClass * klass)
   g_object_class_install_property (object_class, PROP_DURATION,
       properties[PROP_DURATION]);
 
+  /**
+   * GESUriClipAsset::media-changed:
+   * @asset: The #GESUriClipAsset
+   *
+   * Emitted when the asset was created from the information stored in a
+   * project and the media turned out to differ from it once discovered
+   * again. The asset has already been updated from the media when it is
+   * emitted.
+   */
+  signals[MEDIA_CHANGED_SIGNAL] =
+      g_signal_new ("media-changed", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 0);
+
   _ges_uri_asset_ensure_setup (klass);
 }
 
@@ -279,6 +505,7 @@ _create_uri_source_asset (GESUriClipAsset * asset,
 
   priv_tckasset = GES_URI_SOURCE_ASSET (tck_filesource_asset)->priv;
   priv_tckasset->uri = ges_asset_get_id (GES_ASSET (asset));
+  gst_clear_object (&priv_tckasset->sinfo);
   priv_tckasset->sinfo = gst_object_ref (sinfo);
   priv_tckasset->parent_asset = asset;
   ges_track_element_asset_set_track_type (GES_TRACK_ELEMENT_ASSET
@@ -377,6 +604,91 @@ _set_meta_foreach (const GstTagList * tags, const gchar * tag,
   }
 }
 
+static gboolean
+_caps_equal (GstCaps * caps, GstCaps * other)
+{
+  gboolean res = caps == other || (caps && other
+      && gst_caps_is_equal (caps, other));
+
+  gst_clear_caps (&caps);
+  gst_clear_caps (&other);
+
+  return res;
+}
+
+/* Whether the streams the asset was created from are the ones of @info */
+static gboolean
+_info_matches (GESUriClipAsset * self, GstDiscovererInfo * info)
+{
+  GList *tmp, *other, *streams, *other_streams;
+  gboolean res = TRUE;
+
+  if (gst_discoverer_info_get_duration (self->priv->info) !=
+      gst_discoverer_info_get_duration (info))
+    return FALSE;
+
+  streams = gst_discoverer_info_get_stream_list (self->priv->info);
+  other_streams = gst_discoverer_info_get_stream_list (info);
+  for (tmp = streams, other = other_streams; res && tmp && other;
+      tmp = tmp->next, other = other->next) {
+    res = G_OBJECT_TYPE (tmp->data) == G_OBJECT_TYPE (other->data)
+        && !g_strcmp0 (gst_discoverer_stream_info_get_stream_id (tmp->data),
+        gst_discoverer_stream_info_get_stream_id (other->data))
+        && _caps_equal (gst_discoverer_stream_info_get_caps (tmp->data),
+        gst_discoverer_stream_info_get_caps (other->data));
+  }
+  res = res && !tmp && !other;
+
+  gst_discoverer_stream_info_list_free (streams);
+  gst_discoverer_stream_info_list_free (other_streams);
+
+  return res;
+}
+
+/* Called with the result of the discovery of an asset loaded from
+ * provisional information */
+static void
+_provisional_info_verified (GESUriClipAsset * self, GstDiscovererInfo * info,
+    GError * err)
+{
+  const GstTagList *tags;
+  GESUriClipAssetPrivate *priv = self->priv;
+
+  priv->provisional = FALSE;
+
+  if (gst_discoverer_info_get_result (info) != GST_DISCOVERER_OK) {
+    /* Keep what the project stored, the media did not necessarily change */
+    GST_WARNING_OBJECT (self, "Could not discover the media again: %s",
+        err ? err->message : "unknown error");
+
+    return;
+  }
+
+  tags = gst_discoverer_info_get_tags (info);
+  if (tags)
+    gst_tag_list_foreach (tags, (GstTagForeachFunc) _set_meta_foreach, self);
+  ges_discovery_cache_store (info);
+
+  if (_info_matches (self, info)) {
+    GST_DEBUG_OBJECT (self, "Provisional info verified");
+    gst_object_unref (priv->info);
+    priv->info = gst_object_ref (info);
+
+    return;
+  }
+
+  GST_INFO_OBJECT (self, "Media changed, updating asset");
+  g_list_free_full (priv->asset_trackfilesources, gst_object_unref);
+  priv->asset_trackfilesources = NULL;
+  gst_clear_object (&priv->info);
+  priv->is_image = FALSE;
+  priv->duration = GST_CLOCK_TIME_NONE;
+  ges_uri_clip_asset_set_info (self, info);
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_DURATION]);
+
+  g_signal_emit (self, signals[MEDIA_CHANGED_SIGNAL], 0);
+}
+
 static void
 discoverer_discovered_cb (GstDiscoverer * discoverer,
     GstDiscovererInfo * info, GError * err, gpointer user_data)
@@ -388,6 +700,12 @@ discoverer_discovered_cb (GstDiscoverer * discoverer,
   GESUriClipAsset *mfs =
       GES_URI_CLIP_ASSET (ges_asset_cache_lookup (GES_TYPE_URI_CLIP, uri));
 
+  if (mfs->priv->provisional && mfs->priv->info) {
+    _provisional_info_verified (mfs, info, err);
+
+    return;
+  }
+
   tags = gst_discoverer_info_get_tags (info);
   if (tags)
     gst_tag_list_foreach (tags, (GstTagForeachFunc) _set_meta_foreach, mfs);
@@ -396,6 +714,8 @@ discoverer_discovered_cb (GstDiscoverer * discoverer,
 
   if (gst_discoverer_info_get_result (info) == GST_DISCOVERER_OK) {
     ges_uri_clip_asset_set_info (mfs, info);
+    if (!mfs->priv->provisional)
+      ges_discovery_cache_store (info);
   } else {
     if (err) {
       error = g_error_copy (err);
@@ -603,9 +923,15 @@ void
 ges_uri_clip_asset_class_set_timeout (GESUriClipAssetClass * klass,
     GstClockTime timeout)
 {
+  guint i;
+
   g_return_if_fail (GES_IS_URI_CLIP_ASSET_CLASS (klass));
 
   g_object_set (klass->discoverer, "timeout", timeout, NULL);
+  if (_get_pooled_discoverer (klass)) {
+    for (i = 1; i < n_discoverers; i++)
+      g_object_set (discoverers[i].discoverer, "timeout", timeout, NULL);
+  }
 }
 
 /**
@@ -625,6 +951,477 @@ ges_uri_clip_asset_get_stream_assets (GESUriClipAsset * self)
   return self->priv->asset_trackfilesources;
 }
 
+/*****************************************************************
+ *                     Proxy generation                          *
+ *****************************************************************/
+static void _proxy_jobs_pump (void);
+
+static void
+_proxy_job_disconnect_cancellable (ProxyJob * job)
+{
+  if (job->cancelled_id) {
+    g_cancellable_disconnect (g_task_get_cancellable (job->task),
+        job->cancelled_id);
+    job->cancelled_id = 0;
+  }
+}
+
+static void
+_proxy_job_free (ProxyJob * job)
+{
+  _proxy_job_disconnect_cancellable (job);
+  if (job->pipeline) {
+    gst_element_set_state (job->pipeline, GST_STATE_NULL);
+    gst_object_unref (job->pipeline);
+  }
+
+  if (job->bus_watch_id)
+    g_source_remove (job->bus_watch_id);
+
+  gst_object_unref (job->asset);
+  gst_encoding_profile_unref (job->profile);
+  g_free (job->proxy_uri);
+  g_clear_object (&job->task);
+  g_slice_free (ProxyJob, job);
+}
+
+static void
+_proxy_job_done (ProxyJob * job, GESAsset * proxy, GError * error)
+{
+  GTask *task = job->task;
+
+  _proxy_job_disconnect_cancellable (job);
+  job->task = NULL;
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_pointer (task, proxy, gst_object_unref);
+  g_object_unref (task);
+
+  _proxy_job_free (job);
+
+  G_LOCK (proxy_jobs_lock);
+  n_running_proxy_jobs--;
+  G_UNLOCK (proxy_jobs_lock);
+
+  _proxy_jobs_pump ();
+}
+
+static void
+_proxy_asset_loaded_cb (GESAsset * source, GAsyncResult * res, ProxyJob * job)
+{
+  GError *error = NULL;
+  GESAsset *proxy = ges_asset_request_finish (res, &error);
+
+  if (!proxy) {
+    _proxy_job_done (job, NULL, error);
+
+    return;
+  }
+
+  if (!ges_asset_set_proxy (GES_ASSET (job->asset), proxy)) {
+    gst_object_unref (proxy);
+    _proxy_job_done (job, NULL, g_error_new (GES_ERROR,
+            GES_ERROR_ASSET_LOADING, "Could not use %s as a proxy for %s",
+            job->proxy_uri, ges_asset_get_id (GES_ASSET (job->asset))));
+
+    return;
+  }
+
+  GST_INFO_OBJECT (job->asset, "Proxy %s generated", job->proxy_uri);
+  _proxy_job_done (job, proxy, NULL);
+}
+
+static gboolean
+_proxy_job_bus_cb (GstBus * bus, GstMessage * message, ProxyJob * job)
+{
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_EOS:
+      job->bus_watch_id = 0;
+      _proxy_job_disconnect_cancellable (job);
+      gst_element_set_state (job->pipeline, GST_STATE_NULL);
+      gst_clear_object (&job->pipeline);
+
+      ges_asset_request_async (GES_TYPE_URI_CLIP, job->proxy_uri,
+          g_task_get_cancellable (job->task),
+          (GAsyncReadyCallback) _proxy_asset_loaded_cb, job);
+
+      return G_SOURCE_REMOVE;
+    case GST_MESSAGE_ERROR:
+    {
+      GError *error = NULL;
+
+      gst_message_parse_error (message, &error, NULL);
+      GST_WARNING_OBJECT (job->asset, "Could not generate proxy %s: %s",
+          job->proxy_uri, error->message);
+
+      job->bus_watch_id = 0;
+      _proxy_job_done (job, NULL, error);
+
+      return G_SOURCE_REMOVE;
+    }
+    case GST_MESSAGE_APPLICATION:
+    {
+      GFile *file;
+
+      if (!gst_message_has_name (message, "ges-proxy-job-cancelled"))
+        break;
+
+      GST_INFO_OBJECT (job->asset, "Generation of proxy %s cancelled",
+          job->proxy_uri);
+      job->bus_watch_id = 0;
+      gst_element_set_state (job->pipeline, GST_STATE_NULL);
+
+      /* Do not leave a truncated proxy behind */
+      file = g_file_new_for_uri (job->proxy_uri);
+      g_file_delete (file, NULL, NULL);
+      g_object_unref (file);
+
+      _proxy_job_done (job, NULL, g_error_new (G_IO_ERROR,
+              G_IO_ERROR_CANCELLED, "Generation of proxy %s cancelled",
+              job->proxy_uri));
+
+      return G_SOURCE_REMOVE;
+    }
+    default:
+      break;
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Can be called from any thread, the job is stopped from the bus watch */
+static void
+_proxy_job_cancelled_cb (GCancellable * cancellable, ProxyJob * job)
+{
+  gst_element_post_message (job->pipeline,
+      gst_message_new_application (GST_OBJECT (job->pipeline),
+          gst_structure_new_empty ("ges-proxy-job-cancelled")));
+}
+
+static void
+_proxy_job_pad_added_cb (GstElement * decodebin, GstPad * pad, ProxyJob * job)
+{
+  GstPad *sinkpad = NULL;
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+
+  g_signal_emit_by_name (job->encodebin, "request-pad", caps, &sinkpad);
+  gst_caps_unref (caps);
+
+  if (!sinkpad) {
+    GstElement *fakesink = gst_element_factory_make ("fakesink", NULL);
+
+    GST_DEBUG_OBJECT (job->asset, "Not transcoding stream from %" GST_PTR_FORMAT,
+        pad);
+    gst_bin_add (GST_BIN (job->pipeline), fakesink);
+    gst_element_sync_state_with_parent (fakesink);
+    sinkpad = gst_element_get_static_pad (fakesink, "sink");
+  }
+
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_ERROR_OBJECT (job->asset, "Could not link %" GST_PTR_FORMAT, pad);
+
+  gst_object_unref (sinkpad);
+}
+
+static gboolean
+_proxy_job_start (ProxyJob * job)
+{
+  GstBus *bus;
+  GError *error = NULL;
+  GstElement *decodebin, *sink;
+
+  if (g_task_return_error_if_cancelled (job->task))
+    return FALSE;
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  job->encodebin = gst_element_factory_make ("encodebin", NULL);
+  sink = gst_element_make_from_uri (GST_URI_SINK, job->proxy_uri, NULL,
+      &error);
+
+  if (!decodebin || !job->encodebin || !sink) {
+    gst_clear_object (&decodebin);
+    gst_clear_object (&job->encodebin);
+    gst_clear_object (&sink);
+    if (!error)
+      error = g_error_new (GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+          "Missing elements to generate proxy %s", job->proxy_uri);
+    g_task_return_error (job->task, error);
+
+    return FALSE;
+  }
+
+  job->pipeline = gst_pipeline_new (NULL);
+  g_object_set (decodebin, "uri", ges_asset_get_id (GES_ASSET (job->asset)),
+      NULL);
+  g_object_set (job->encodebin, "profile", job->profile, NULL);
+  gst_bin_add_many (GST_BIN (job->pipeline), decodebin, job->encodebin, sink,
+      NULL);
+  gst_element_link (job->encodebin, sink);
+  g_signal_connect (decodebin, "pad-added",
+      G_CALLBACK (_proxy_job_pad_added_cb), job);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (job->pipeline));
+  job->bus_watch_id = gst_bus_add_watch (bus, (GstBusFunc) _proxy_job_bus_cb,
+      job);
+  gst_object_unref (bus);
+
+  /* Stop transcoding as soon as the job gets cancelled */
+  if (g_task_get_cancellable (job->task))
+    job->cancelled_id =
+        g_cancellable_connect (g_task_get_cancellable (job->task),
+        G_CALLBACK (_proxy_job_cancelled_cb), job, NULL);
+
+  GST_INFO_OBJECT (job->asset, "Generating proxy %s", job->proxy_uri);
+  if (gst_element_set_state (job->pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE) {
+    g_task_return_new_error (job->task, GST_CORE_ERROR,
+        GST_CORE_ERROR_STATE_CHANGE, "Could not start generating proxy %s",
+        job->proxy_uri);
+
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Starts as many queued jobs as the concurrency limit allows */
+static void
+_proxy_jobs_pump (void)
+{
+  while (TRUE) {
+    ProxyJob *job;
+
+    G_LOCK (proxy_jobs_lock);
+    if (n_running_proxy_jobs >= max_proxy_jobs ||
+        !(job = g_queue_pop_head (&proxy_jobs))) {
+      G_UNLOCK (proxy_jobs_lock);
+      return;
+    }
+    n_running_proxy_jobs++;
+    G_UNLOCK (proxy_jobs_lock);
+
+    if (!_proxy_job_start (job)) {
+      _proxy_job_free (job);
+
+      G_LOCK (proxy_jobs_lock);
+      n_running_proxy_jobs--;
+      G_UNLOCK (proxy_jobs_lock);
+    }
+  }
+}
+
+static gchar *
+_default_proxy_uri (GESUriClipAsset * self)
+{
+  gchar *checksum, *basename, *dirname, *filename, *uri;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5,
+      ges_asset_get_id (GES_ASSET (self)), -1);
+  basename = g_strdup_printf ("%s.proxy.mkv", checksum);
+  dirname = g_build_filename (g_get_user_cache_dir (), "gstreamer-1.0",
+      "ges-proxies", NULL);
+  g_mkdir_with_parents (dirname, 0755);
+
+  filename = g_build_filename (dirname, basename, NULL);
+  uri = gst_filename_to_uri (filename, NULL);
+
+  g_free (checksum);
+  g_free (basename);
+  g_free (dirname);
+  g_free (filename);
+
+  return uri;
+}
+
+/* Low resolution, intra only (Motion JPEG) proxy in a Matroska container */
+static GstEncodingProfile *
+_default_proxy_profile (GESUriClipAsset * self)
+{
+  GList *tmp, *streams;
+  GstCaps *caps;
+  GstEncodingContainerProfile *container;
+
+  caps = gst_caps_new_empty_simple ("video/x-matroska");
+  container = gst_encoding_container_profile_new ("ges-proxy", NULL, caps,
+      NULL);
+  gst_caps_unref (caps);
+
+  streams = gst_discoverer_info_get_stream_list (self->priv->info);
+  for (tmp = streams; tmp; tmp = tmp->next) {
+    GstEncodingProfile *profile = NULL;
+
+    if (GST_IS_DISCOVERER_VIDEO_INFO (tmp->data)) {
+      GstCaps *restriction = NULL;
+      GstDiscovererVideoInfo *vinfo = tmp->data;
+      guint width = gst_discoverer_video_info_get_width (vinfo);
+      guint height = gst_discoverer_video_info_get_height (vinfo);
+
+      if (height > DEFAULT_PROXY_HEIGHT) {
+        width = gst_util_uint64_scale_int (width, DEFAULT_PROXY_HEIGHT,
+            height) & ~1;
+        restriction = gst_caps_new_simple ("video/x-raw",
+            "width", G_TYPE_INT, width,
+            "height", G_TYPE_INT, DEFAULT_PROXY_HEIGHT,
+            "pixel-aspect-ratio", GST_TYPE_FRACTION,
+            gst_discoverer_video_info_get_par_num (vinfo),
+            gst_discoverer_video_info_get_par_denom (vinfo), NULL);
+      }
+
+      caps = gst_caps_new_empty_simple ("image/jpeg");
+      profile = (GstEncodingProfile *)
+          gst_encoding_video_profile_new (caps, NULL, restriction, 1);
+      if (restriction)
+        gst_caps_unref (restriction);
+    } else if (GST_IS_DISCOVERER_AUDIO_INFO (tmp->data)) {
+      caps = gst_caps_new_empty_simple ("audio/x-vorbis");
+      profile = (GstEncodingProfile *)
+          gst_encoding_audio_profile_new (caps, NULL, NULL, 1);
+    } else {
+      continue;
+    }
+
+    gst_caps_unref (caps);
+    gst_encoding_container_profile_add_profile (container, profile);
+  }
+  gst_discoverer_stream_info_list_free (streams);
+
+  return GST_ENCODING_PROFILE (container);
+}
+
+/**
+ * ges_uri_clip_asset_generate_proxy:
+ * @self: The #GESUriClipAsset to generate a proxy for
+ * @proxy_uri: (allow-none): The URI where to write the proxy media or %NULL
+ * to write it into the user cache directory
+ * @profile: (allow-none): The #GstEncodingProfile to use to transcode the
+ * proxy media or %NULL to use a low resolution, intra only default profile
+ * @cancellable: (allow-none): optional %GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the proxy
+ * has been generated
+ * @user_data: The user data to pass when @callback is called
+ *
+ * Queues the transcoding of the media represented by @self into a proxy
+ * media. Proxy jobs are run in the background, at most
+ * #ges_uri_clip_asset_class_set_max_proxy_jobs at once (2 by default, can be
+ * overridden with the GES_MAX_PROXY_JOBS environment variable).
+ *
+ * Once the proxy media has been written, its #GESUriClipAsset is loaded and
+ * set as the default proxy of @self with #ges_asset_set_proxy. A #GESPipeline
+ * will then use it in preview modes, and the original media in render modes.
+ *
+ * Cancelling @cancellable stops the transcoding if it is already running,
+ * and removes the partially written proxy media.
+ *
+ * Since: 1.16
+ */
+void
+ges_uri_clip_asset_generate_proxy (GESUriClipAsset * self,
+    const gchar * proxy_uri, GstEncodingProfile * profile,
+    GCancellable * cancellable, GAsyncReadyCallback callback,
+    gpointer user_data)
+{
+  ProxyJob *job;
+
+  g_return_if_fail (GES_IS_URI_CLIP_ASSET (self));
+  g_return_if_fail (profile == NULL || GST_IS_ENCODING_PROFILE (profile));
+
+  job = g_slice_new0 (ProxyJob);
+  job->task = g_task_new (self, cancellable, callback, user_data);
+
+  if (!self->priv->info || self->priv->is_image) {
+    g_task_return_new_error (job->task, GES_ERROR, GES_ERROR_ASSET_LOADING,
+        "Can not generate a proxy for %s", ges_asset_get_id (GES_ASSET (self)));
+    g_object_unref (job->task);
+    g_slice_free (ProxyJob, job);
+
+    return;
+  }
+
+  job->asset = gst_object_ref (self);
+  job->proxy_uri =
+      proxy_uri ? g_strdup (proxy_uri) : _default_proxy_uri (self);
+  job->profile = profile ? gst_encoding_profile_ref (profile) :
+      _default_proxy_profile (self);
+
+  G_LOCK (proxy_jobs_lock);
+  g_queue_push_tail (&proxy_jobs, job);
+  G_UNLOCK (proxy_jobs_lock);
+
+  _proxy_jobs_pump ();
+}
+
+/**
+ * ges_uri_clip_asset_generate_proxy_finish:
+ * @self: The #GESUriClipAsset a proxy has been generated for
+ * @res: The #GAsyncResult passed to the #GAsyncReadyCallback
+ * @error: An error to be set in case something wrong happens or %NULL
+ *
+ * Finishes a proxy generation started with #ges_uri_clip_asset_generate_proxy
+ *
+ * Returns: (transfer full) (nullable): The #GESUriClipAsset of the generated
+ * proxy, or %NULL if an error happened
+ *
+ * Since: 1.16
+ */
+GESUriClipAsset *
+ges_uri_clip_asset_generate_proxy_finish (GESUriClipAsset * self,
+    GAsyncResult * res, GError ** error)
+{
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * ges_uri_clip_asset_class_set_max_proxy_jobs:
+ * @klass: The #GESUriClipAssetClass
+ * @max_jobs: The maximum number of proxies to generate simultaneously
+ *
+ * Sets how many proxy transcoding jobs can run at the same time
+ *
+ * Since: 1.16
+ */
+void
+ges_uri_clip_asset_class_set_max_proxy_jobs (GESUriClipAssetClass * klass,
+    guint max_jobs)
+{
+  g_return_if_fail (GES_IS_URI_CLIP_ASSET_CLASS (klass));
+  g_return_if_fail (max_jobs > 0);
+
+  G_LOCK (proxy_jobs_lock);
+  max_proxy_jobs = max_jobs;
+  G_UNLOCK (proxy_jobs_lock);
+
+  _proxy_jobs_pump ();
+}
+
+/* Returns the URI sources for @uri should play: the proxy of its media if
+ * @use_proxies, the original media otherwise. Clips keep their asset so
+ * projects always reference the media the user picked. */
+gchar *
+ges_uri_clip_asset_get_playback_uri (const gchar * uri, gboolean use_proxies)
+{
+  GESAsset *asset, *tmpasset;
+
+  asset = ges_asset_cache_lookup (GES_TYPE_URI_CLIP, uri);
+  if (!asset)
+    return g_strdup (uri);
+
+  if (use_proxies) {
+    while ((tmpasset = ges_asset_get_proxy (asset)))
+      asset = tmpasset;
+  } else {
+    /* Do not go back to targets that could not be loaded, those are
+     * missing files that have been relocated */
+    while ((tmpasset = ges_asset_get_proxy_target (asset)) &&
+        !ges_asset_get_error (tmpasset))
+      asset = tmpasset;
+  }
+
+  return g_strdup (ges_asset_get_id (asset));
+}
+
 /*****************************************************************
  *            GESUriSourceAsset implementation             *
  *****************************************************************/
@@ -753,10 +1550,44 @@ ges_uri_source_asset_get_filesource_asset (GESUriSourceAsset * asset)
   return asset->priv->parent_asset;
 }
 
+/**
+ * ges_uri_clip_asset_set_provisional_info:
+ * @info: The #GstDiscovererInfo stored for the media
+ *
+ * Makes the asset for the URI of @info get loaded from @info instead of
+ * waiting for the media to be discovered, if it is not loaded yet.
+ */
+void
+ges_uri_clip_asset_set_provisional_info (GstDiscovererInfo * info)
+{
+  const gchar *uri = gst_discoverer_info_get_uri (info);
+
+  if (ges_asset_cache_lookup (GES_TYPE_URI_CLIP, uri))
+    return;
+
+  G_LOCK (provisional_infos_lock);
+  if (!provisional_infos)
+    provisional_infos = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, (GDestroyNotify) gst_discoverer_info_unref);
+  g_hash_table_insert (provisional_infos, g_strdup (uri),
+      gst_discoverer_info_ref (info));
+  G_UNLOCK (provisional_infos_lock);
+}
+
 void
 _ges_uri_asset_cleanup (void)
 {
-  g_clear_object (&discoverer);
+  guint i;
+
+  for (i = 0; i < n_discoverers; i++)
+    gst_object_unref (discoverers[i].discoverer);
+  g_clear_pointer (&discoverers, g_free);
+  n_discoverers = 0;
+  g_clear_pointer (&discovery_context, g_main_context_unref);
+  G_LOCK (provisional_infos_lock);
+  g_clear_pointer (&provisional_infos, g_hash_table_unref);
+  G_UNLOCK (provisional_infos_lock);
+
   if (parent_newparent_table) {
     g_hash_table_destroy (parent_newparent_table);
     parent_newparent_table = NULL;
@@ -767,9 +1598,10 @@ gboolean
 _ges_uri_asset_ensure_setup (gpointer uriasset_class)
 {
   GESUriClipAssetClass *klass;
-  GError *err;
+  GError *err = NULL;
   GstClockTime timeout;
-  const gchar *timeout_str;
+  const gchar *timeout_str, *max_jobs_str, *pool_size_str;
+  guint i, pool_size;
 
   g_return_val_if_fail (GES_IS_URI_CLIP_ASSET_CLASS (uriasset_class), FALSE);
 
@@ -786,30 +1618,60 @@ _ges_uri_asset_ensure_setup (gpointer uriasset_class)
   if (errno)
     timeout = DEFAULT_DISCOVERY_TIMEOUT;
 
-  if (!discoverer) {
-    discoverer = gst_discoverer_new (timeout, &err);
-    if (!discoverer) {
-      GST_ERROR ("Could not create discoverer: %s", err->message);
-      g_error_free (err);
-      return FALSE;
+  max_jobs_str = g_getenv ("GES_MAX_PROXY_JOBS");
+  if (max_jobs_str) {
+    guint64 max_jobs = g_ascii_strtoull (max_jobs_str, NULL, 10);
+
+    if (max_jobs > 0 && max_jobs <= G_MAXUINT)
+      max_proxy_jobs = max_jobs;
+  }
+
+  pool_size = MIN (g_get_num_processors (), DEFAULT_MAX_DISCOVERERS);
+  pool_size_str = g_getenv ("GES_DISCOVERY_POOL_SIZE");
+  if (pool_size_str) {
+    guint64 size = g_ascii_strtoull (pool_size_str, NULL, 10);
+
+    if (size > 0 && size <= G_MAXUINT)
+      pool_size = size;
+  }
+
+  if (!discoverers) {
+    discoverers = g_new0 (PooledDiscoverer, pool_size);
+    for (i = 0; i < pool_size; i++) {
+      discoverers[i].discoverer = gst_discoverer_new (timeout, &err);
+      if (!discoverers[i].discoverer) {
+        GST_ERROR ("Could not create discoverer: %s", err->message);
+        g_error_free (err);
+        _ges_uri_asset_cleanup ();
+        return FALSE;
+      }
+      n_discoverers++;
     }
+    GST_INFO ("Discovering assets with %u discoverers", n_discoverers);
   }
 
-  /* The class structure keeps weak pointers on the discoverers so they
-   * can be properly cleaned up in _ges_uri_asset_cleanup(). */
+  /* The class structure keeps weak pointers on the first discoverer of the
+   * pool so they can be properly cleaned up in _ges_uri_asset_cleanup(). */
   if (!klass->discoverer) {
-    klass->discoverer = klass->sync_discoverer = discoverer;
-    g_object_add_weak_pointer (G_OBJECT (discoverer),
+    klass->discoverer = klass->sync_discoverer = discoverers[0].discoverer;
+    g_object_add_weak_pointer (G_OBJECT (klass->discoverer),
         (gpointer *) & klass->discoverer);
-    g_object_add_weak_pointer (G_OBJECT (discoverer),
+    g_object_add_weak_pointer (G_OBJECT (klass->sync_discoverer),
         (gpointer *) & klass->sync_discoverer);
 
-    g_signal_connect (klass->discoverer, "discovered",
-        G_CALLBACK (klass->discovered), NULL);
+    for (i = 0; i < n_discoverers; i++) {
+      g_signal_connect (discoverers[i].discoverer, "discovered",
+          G_CALLBACK (klass->discovered), NULL);
+      g_signal_connect (discoverers[i].discoverer, "discovered",
+          G_CALLBACK (_pooled_discoverer_discovered_cb), &discoverers[i]);
+    }
   }
 
-  /* We just start the discoverer and let it live */
-  gst_discoverer_start (klass->discoverer);
+  /* We just start the discoverers and let them live */
+  for (i = 0; i < n_discoverers; i++)
+    gst_discoverer_start (discoverers[i].discoverer);
+  if (!discovery_context)
+    discovery_context = g_main_context_ref_thread_default ();
   if (parent_newparent_table == NULL) {
     parent_newparent_table = g_hash_table_new_full (g_file_hash,
         (GEqualFunc) g_file_equal, g_object_unref, g_object_unref);
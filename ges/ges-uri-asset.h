@@ -23,6 +23,7 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <gst/pbutils/encoding-profile.h>
 #include <ges/ges-types.h>
 #include <ges/ges-asset.h>
 #include <ges/ges-clip-asset.h>
@@ -91,6 +92,20 @@ void ges_uri_clip_asset_class_set_timeout           (GESUriClipAssetClass *klass
                                                      GstClockTime timeout);
 GES_API
 const GList * ges_uri_clip_asset_get_stream_assets  (GESUriClipAsset *self);
+GES_API
+void ges_uri_clip_asset_generate_proxy              (GESUriClipAsset *self,
+                                                     const gchar *proxy_uri,
+                                                     GstEncodingProfile *profile,
+                                                     GCancellable *cancellable,
+                                                     GAsyncReadyCallback callback,
+                                                     gpointer user_data);
+GES_API
+GESUriClipAsset * ges_uri_clip_asset_generate_proxy_finish (GESUriClipAsset *self,
+                                                     GAsyncResult *res,
+                                                     GError **error);
+GES_API
+void ges_uri_clip_asset_class_set_max_proxy_jobs    (GESUriClipAssetClass *klass,
+                                                     guint max_jobs);
 
 #define GES_TYPE_URI_SOURCE_ASSET ges_uri_source_asset_get_type()
 #define GES_URI_SOURCE_ASSET(obj) \
@@ -55,6 +55,10 @@ struct _GESUriClipPrivate
 
   gboolean mute;
   gboolean is_image;
+
+  /* The asset whose media changes are followed */
+  GESAsset *watched_asset;
+  gulong media_changed_id;
 };
 
 enum
@@ -138,6 +142,10 @@ ges_uri_clip_finalize (GObject * object)
 
   if (priv->uri)
     g_free (priv->uri);
+  if (priv->watched_asset) {
+    g_signal_handler_disconnect (priv->watched_asset, priv->media_changed_id);
+    gst_object_unref (priv->watched_asset);
+  }
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -262,6 +270,37 @@ extractable_get_id (GESExtractable * self)
   return g_strdup (GES_URI_CLIP (self)->priv->uri);
 }
 
+static void
+_asset_media_changed_cb (GESAsset * asset, GESUriClip * self)
+{
+  GESTimeline *timeline = GES_TIMELINE_ELEMENT_TIMELINE (self);
+
+  GST_INFO_OBJECT (self, "Media of %s changed, updating",
+      ges_asset_get_id (asset));
+  /* Recreates the sources from the updated asset */
+  ges_extractable_set_asset (GES_EXTRACTABLE (self), asset);
+  if (timeline)
+    ges_timeline_commit (timeline);
+}
+
+static void
+_watch_asset (GESUriClip * self, GESAsset * asset)
+{
+  GESUriClipPrivate *priv = self->priv;
+
+  if (priv->watched_asset == asset)
+    return;
+
+  if (priv->watched_asset) {
+    g_signal_handler_disconnect (priv->watched_asset, priv->media_changed_id);
+    gst_object_unref (priv->watched_asset);
+  }
+
+  priv->watched_asset = gst_object_ref (asset);
+  priv->media_changed_id = g_signal_connect (asset, "media-changed",
+      G_CALLBACK (_asset_media_changed_cb), self);
+}
+
 static gboolean
 extractable_set_asset (GESExtractable * self, GESAsset * asset)
 {
@@ -276,6 +315,7 @@ extractable_set_asset (GESExtractable * self, GESAsset * asset)
   g_return_val_if_fail (GES_IS_URI_CLIP_ASSET (asset), FALSE);
 
   uri_clip_asset = GES_URI_CLIP_ASSET (asset);
+  _watch_asset (uriclip, asset);
   if (GST_CLOCK_TIME_IS_VALID (GES_TIMELINE_ELEMENT_DURATION (clip)) == FALSE)
     _set_duration0 (GES_TIMELINE_ELEMENT (uriclip),
         ges_uri_clip_asset_get_duration (uri_clip_asset));
@@ -166,6 +166,32 @@ ges_get_compositor_factory (void)
   return compositor_factory;
 }
 
+/* Pushes the sticky events of @from needed for @to to be able to push
+ * buffers: stream-start (if @to does not have one yet), caps and segment */
+void
+ges_pad_forward_sticky_events (GstPad * from, GstPad * to)
+{
+  guint i;
+  const GstEventType types[] =
+      { GST_EVENT_STREAM_START, GST_EVENT_CAPS, GST_EVENT_SEGMENT };
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++) {
+    GstEvent *event;
+
+    if (types[i] == GST_EVENT_STREAM_START) {
+      event = gst_pad_get_sticky_event (to, types[i], 0);
+      if (event) {
+        gst_event_unref (event);
+        continue;
+      }
+    }
+
+    event = gst_pad_get_sticky_event (from, types[i], 0);
+    if (event)
+      gst_pad_push_event (to, event);
+  }
+}
+
 gboolean
 ges_nle_composition_add_object (GstElement * comp, GstElement * object)
 {
@@ -86,7 +86,7 @@ create_element_for_raw_video_gap (GESTrack * track)
   GstElement *capsfilter;
 
   bin = gst_parse_bin_from_description
-      ("videotestsrc pattern=2 name=src ! videorate ! capsfilter name=gapfilter caps=video/x-raw",
+      ("gesgapsrc track-type=video name=src ! capsfilter name=gapfilter caps=video/x-raw",
       TRUE, NULL);
 
   capsfilter = gst_bin_get_by_name (GST_BIN (bin), "gapfilter");
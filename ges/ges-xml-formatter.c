@@ -34,8 +34,19 @@
 
 #define parent_class ges_xml_formatter_parent_class
 #define API_VERSION 0
-#define MINOR_VERSION 5
-#define VERSION 0.5
+#define MINOR_VERSION 6
+#define VERSION 0.6
+
+/* The minor version is patched in the header once known, as a single digit */
+G_STATIC_ASSERT (MINOR_VERSION < 10);
+
+/* What is serialized gets written to the output stream in chunks of that
+ * size at least */
+#define FLUSH_SIZE (64 * 1024)
+
+/* Maximum time spent serializing clips at once when saving from the main
+ * context, see ges_xml_formatter_save_to_bytes_async () */
+#define SAVE_SLICE_DURATION (5 * G_TIME_SPAN_MILLISECOND)
 
 #define COLLECT_STR_OPT (G_MARKUP_COLLECT_STRING | G_MARKUP_COLLECT_OPTIONAL)
 
@@ -47,6 +58,9 @@ struct _GESXmlFormatterPrivate
   gboolean project_opened;
 
   GString *str;
+  /* Where str is flushed to, if saving to a stream */
+  GOutputStream *stream;
+  GError *stream_error;
 
   GHashTable *element_id;
 
@@ -299,7 +313,7 @@ _parse_asset (GMarkupParseContext * context, const gchar * element_name,
 {
   GType extractable_type;
   const gchar *id, *extractable_type_name, *metadatas = NULL, *properties =
-      NULL, *proxy_id = NULL;
+      NULL, *proxy_id = NULL, *stream_info = NULL;
 
   if (!g_markup_collect_attributes (element_name, attribute_names,
           attribute_values, error, G_MARKUP_COLLECT_STRING, "id", &id,
@@ -307,7 +321,9 @@ _parse_asset (GMarkupParseContext * context, const gchar * element_name,
           &extractable_type_name,
           COLLECT_STR_OPT, "properties", &properties,
           COLLECT_STR_OPT, "metadatas", &metadatas,
-          COLLECT_STR_OPT, "proxy-id", &proxy_id, G_MARKUP_COLLECT_INVALID))
+          COLLECT_STR_OPT, "proxy-id", &proxy_id,
+          COLLECT_STR_OPT, "stream-info", &stream_info,
+          G_MARKUP_COLLECT_INVALID))
     return;
 
   extractable_type = g_type_from_name (extractable_type_name);
@@ -323,13 +339,30 @@ _parse_asset (GMarkupParseContext * context, const gchar * element_name,
         element_name, extractable_type_name);
   else {
     GstStructure *props = NULL;
+    GstDiscovererInfo *info = NULL;
+
     if (properties)
       props = gst_structure_from_string (properties, NULL);
 
+    if (stream_info) {
+      GVariant *variant = g_variant_parse (NULL, stream_info, NULL, NULL,
+          NULL);
+
+      /* Only an optimization, the media will be discovered otherwise */
+      if (variant) {
+        info = gst_discoverer_info_from_variant (variant);
+        g_variant_unref (variant);
+      }
+      if (!info)
+        GST_WARNING_OBJECT (self, "Invalid stream info for %s", id);
+    }
+
     ges_base_xml_formatter_add_asset (GES_BASE_XML_FORMATTER (self), id,
-        extractable_type, props, metadatas, proxy_id, error);
+        extractable_type, props, metadatas, proxy_id, info, error);
     if (props)
       gst_structure_free (props);
+    if (info)
+      gst_discoverer_info_unref (info);
   }
 }
 
@@ -896,54 +929,208 @@ _can_serialize_spec (GParamSpec * spec)
   return TRUE;
 }
 
-static inline void
-_init_value_from_spec_for_serialization (GValue * value, GParamSpec * spec)
+static inline GType
+_get_serialized_value_type (GParamSpec * spec)
 {
-
   if (g_type_is_a (spec->value_type, G_TYPE_ENUM) ||
       g_type_is_a (spec->value_type, G_TYPE_FLAGS))
-    g_value_init (value, G_TYPE_INT);
-  else
-    g_value_init (value, spec->value_type);
+    return G_TYPE_INT;
+
+  return spec->value_type;
 }
 
-static gchar *
-_serialize_properties (GObject * object, const gchar * fieldname, ...)
+/* Listing and filtering the properties of an object is much more expensive
+ * than serializing them, so how it is done is computed once per type, and
+ * once per children property */
+typedef struct
 {
-  gchar *ret;
-  guint n_props, j;
-  GParamSpec *spec, **pspecs;
-  GObjectClass *class = G_OBJECT_GET_CLASS (object);
-  GstStructure *structure = gst_structure_new_empty ("properties");
+  GParamSpec *pspec;
+  /* Name of the field in the serialized structure */
+  GQuark field;
+  /* Type of the serialized value, %G_TYPE_INVALID if it is not serialized,
+   * caps are serialized as strings */
+  GType value_type;
+} SerializedProperty;
+
+typedef struct
+{
+  SerializedProperty *properties;
+  guint n_properties;
+
+  /* Field quark -> #GParamSpec that can be set when loading */
+  GHashTable *settable;
+} SerializationPlan;
 
+/* Only taken to build the plans, once published in the type or #GParamSpec
+ * qdata they are read without locking: those qdata are read under the GType
+ * and datalist locks, which order the reads after the plan is built */
+G_LOCK_DEFINE_STATIC (serialization_plans);
+
+static GQuark
+_serialization_plan_quark (void)
+{
+  static gsize quark = 0;
+
+  if (g_once_init_enter (&quark))
+    g_once_init_leave (&quark,
+        g_quark_from_static_string ("ges-serialization-plan"));
+
+  return (GQuark) quark;
+}
+
+static const SerializationPlan *
+_get_serialization_plan (GObjectClass * class)
+{
+  guint i, n_props;
+  GParamSpec **pspecs;
+  SerializationPlan *plan;
+  GType type = G_OBJECT_CLASS_TYPE (class);
+
+  plan = g_type_get_qdata (type, _serialization_plan_quark ());
+  if (G_LIKELY (plan))
+    return plan;
+
+  G_LOCK (serialization_plans);
+  /* Built by another thread in the meantime */
+  plan = g_type_get_qdata (type, _serialization_plan_quark ());
+  if (plan)
+    goto done;
+
+  /* Types are never unloaded, neither is their plan */
   pspecs = g_object_class_list_properties (class, &n_props);
-  for (j = 0; j < n_props; j++) {
-    GValue val = { 0 };
+  plan = g_new0 (SerializationPlan, 1);
+  plan->properties = g_new0 (SerializedProperty, n_props);
+  plan->settable = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (i = 0; i < n_props; i++) {
+    GParamSpec *spec = pspecs[i];
+    GQuark field = g_quark_from_static_string (spec->name);
+
+    if ((spec->flags & G_PARAM_WRITABLE) &&
+        !(spec->flags & G_PARAM_CONSTRUCT_ONLY))
+      g_hash_table_insert (plan->settable, GUINT_TO_POINTER (field), spec);
 
-    spec = pspecs[j];
-    if (spec->value_type == GST_TYPE_CAPS) {
-      GstCaps *caps;
-      gchar *caps_str;
-
-      g_object_get (object, spec->name, &caps, NULL);
-      caps_str = gst_caps_to_string (caps);
-      gst_structure_set (structure, spec->name, G_TYPE_STRING, caps_str, NULL);
-      g_free (caps_str);
-    } else if (_can_serialize_spec (spec)) {
-      _init_value_from_spec_for_serialization (&val, spec);
-      g_object_get_property (object, spec->name, &val);
-      gst_structure_set_value (structure, spec->name, &val);
-      g_value_unset (&val);
+    if (spec->value_type == GST_TYPE_CAPS || _can_serialize_spec (spec)) {
+      SerializedProperty *property = &plan->properties[plan->n_properties++];
+
+      property->pspec = spec;
+      property->field = field;
+      property->value_type = _get_serialized_value_type (spec);
     }
   }
   g_free (pspecs);
 
-  if (fieldname) {
-    va_list varargs;
-    va_start (varargs, fieldname);
-    gst_structure_remove_fields_valist (structure, fieldname, varargs);
-    va_end (varargs);
+  g_type_set_qdata (type, _serialization_plan_quark (), plan);
+
+done:
+  G_UNLOCK (serialization_plans);
+
+  return plan;
+}
+
+static const SerializedProperty *
+_get_child_serialization_plan (GParamSpec * spec)
+{
+  SerializedProperty *property;
+
+  property = g_param_spec_get_qdata (spec, _serialization_plan_quark ());
+  if (G_LIKELY (property))
+    return property;
+
+  G_LOCK (serialization_plans);
+  property = g_param_spec_get_qdata (spec, _serialization_plan_quark ());
+  if (!property) {
+    property = g_new0 (SerializedProperty, 1);
+    property->pspec = spec;
+    if (_can_serialize_spec (spec)) {
+      gchar *field = g_strdup_printf ("%s::%s",
+          g_type_name (spec->owner_type), spec->name);
+
+      property->field = g_quark_from_string (field);
+      property->value_type = _get_serialized_value_type (spec);
+      g_free (field);
+    }
+
+    g_param_spec_set_qdata_full (spec, _serialization_plan_quark (),
+        property, g_free);
+  }
+  G_UNLOCK (serialization_plans);
+
+  return property;
+}
+
+/* Returns the property of @object serialized as @field_id if it can be set
+ * after construction */
+GParamSpec *
+_lookup_settable_property (GObject * object, GQuark field_id)
+{
+  GParamSpec *spec;
+  GObjectClass *class = G_OBJECT_GET_CLASS (object);
+  const SerializationPlan *plan = _get_serialization_plan (class);
+
+  spec = g_hash_table_lookup (plan->settable, GUINT_TO_POINTER (field_id));
+  if (spec)
+    return spec;
+
+  /* Not using the canonical name */
+  spec = g_object_class_find_property (class, g_quark_to_string (field_id));
+  if (spec && (spec->flags & G_PARAM_WRITABLE) &&
+      !(spec->flags & G_PARAM_CONSTRUCT_ONLY))
+    return spec;
+
+  return NULL;
+}
+
+static gboolean
+_is_excluded (const gchar * name, const gchar * fieldname, va_list varargs)
+{
+  va_list tmp;
+  gboolean ret = FALSE;
+
+  G_VA_COPY (tmp, varargs);
+  for (; fieldname; fieldname = va_arg (tmp, const gchar *)) {
+    if (!g_strcmp0 (name, fieldname)) {
+      ret = TRUE;
+      break;
+    }
+  }
+  va_end (tmp);
+
+  return ret;
+}
+
+gchar *
+_serialize_properties (GObject * object, const gchar * fieldname, ...)
+{
+  guint i;
+  gchar *ret;
+  va_list varargs;
+  const SerializationPlan *plan;
+  GstStructure *structure = gst_structure_new_empty ("properties");
+
+  plan = _get_serialization_plan (G_OBJECT_GET_CLASS (object));
+  va_start (varargs, fieldname);
+  for (i = 0; i < plan->n_properties; i++) {
+    GValue val = { 0 };
+    const SerializedProperty *property = &plan->properties[i];
+
+    if (_is_excluded (property->pspec->name, fieldname, varargs))
+      continue;
+
+    if (property->value_type == GST_TYPE_CAPS) {
+      GstCaps *caps = NULL;
+
+      g_object_get (object, property->pspec->name, &caps, NULL);
+      g_value_init (&val, G_TYPE_STRING);
+      g_value_take_string (&val, gst_caps_to_string (caps));
+      if (caps)
+        gst_caps_unref (caps);
+    } else {
+      g_value_init (&val, property->value_type);
+      g_object_get_property (object, property->pspec->name, &val);
+    }
+    gst_structure_id_take_value (structure, property->field, &val);
   }
+  va_end (varargs);
 
   ret = gst_structure_to_string (structure);
   gst_structure_free (structure);
@@ -951,6 +1138,24 @@ _serialize_properties (GObject * object, const gchar * fieldname, ...)
   return ret;
 }
 
+/* Writes what was serialized so far to the output stream, once there is
+ * enough of it or when @force is set */
+static void
+_flush (GESXmlFormatter * self, gboolean force)
+{
+  GESXmlFormatterPrivate *priv = self->priv;
+
+  if (!priv->stream || (!force && priv->str->len < FLUSH_SIZE))
+    return;
+
+  if (!priv->stream_error && !g_output_stream_write_all (priv->stream,
+          priv->str->str, priv->str->len, NULL, NULL, &priv->stream_error))
+    GST_WARNING_OBJECT (self, "Could not write project: %s",
+        priv->stream_error->message);
+
+  g_string_truncate (priv->str, 0);
+}
+
 static inline void
 _save_assets (GESXmlFormatter * self, GString * str, GESProject * project)
 {
@@ -985,9 +1190,29 @@ _save_assets (GESXmlFormatter * self, GString * str, GESProject * project)
 
       self->priv->min_version = MAX (self->priv->min_version, 3);
     }
+
+    /* What is needed to create the clips before the media is discovered
+     * again when loading */
+    if (GES_IS_URI_CLIP_ASSET (asset) &&
+        ges_uri_clip_asset_get_info (GES_URI_CLIP_ASSET (asset))) {
+      GVariant *variant =
+          g_variant_ref_sink (gst_discoverer_info_to_variant
+          (ges_uri_clip_asset_get_info (GES_URI_CLIP_ASSET (asset)),
+              GST_DISCOVERER_SERIALIZE_CAPS));
+      gchar *stream_info = g_variant_print (variant, TRUE);
+
+      append_escaped (str, g_markup_printf_escaped (" stream-info='%s' ",
+              stream_info));
+      g_variant_unref (variant);
+      g_free (stream_info);
+
+      self->priv->min_version = MAX (self->priv->min_version, 6);
+    }
     g_string_append (str, "/>\n");
     g_free (properties);
     g_free (metas);
+
+    _flush (self, FALSE);
   }
   g_list_free_full (assets, gst_object_unref);
 }
@@ -1019,41 +1244,45 @@ _save_tracks (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
   g_list_free_full (tracks, gst_object_unref);
 }
 
-static inline void
-_save_children_properties (GString * str, GESTimelineElement * element)
+gchar *
+_serialize_children_properties (GESTimelineElement * element)
 {
+  gchar *ret;
   GstStructure *structure;
   GParamSpec **pspecs, *spec;
   guint i, n_props;
-  gchar *struct_str;
 
   pspecs = ges_timeline_element_list_children_properties (element, &n_props);
 
   structure = gst_structure_new_empty ("properties");
   for (i = 0; i < n_props; i++) {
     GValue val = { 0 };
-    spec = pspecs[i];
-
-    if (_can_serialize_spec (spec)) {
-      gchar *spec_name =
-          g_strdup_printf ("%s::%s", g_type_name (spec->owner_type),
-          spec->name);
+    const SerializedProperty *property;
 
-      _init_value_from_spec_for_serialization (&val, spec);
+    spec = pspecs[i];
+    property = _get_child_serialization_plan (spec);
+    if (property->value_type != G_TYPE_INVALID) {
+      g_value_init (&val, property->value_type);
       ges_timeline_element_get_child_property_by_pspec (element, spec, &val);
-      gst_structure_set_value (structure, spec_name, &val);
-
-      g_free (spec_name);
-      g_value_unset (&val);
+      gst_structure_id_take_value (structure, property->field, &val);
     }
     g_param_spec_unref (spec);
   }
   g_free (pspecs);
 
-  struct_str = gst_structure_to_string (structure);
+  ret = gst_structure_to_string (structure);
+  gst_structure_free (structure);
+
+  return ret;
+}
+
+static inline void
+_save_children_properties (GString * str, GESTimelineElement * element)
+{
+  gchar *struct_str = _serialize_children_properties (element);
+
   append_escaped (str,
       g_markup_printf_escaped (" children-properties='%s'", struct_str));
-  gst_structure_free (structure);
   g_free (struct_str);
 }
 
@@ -1173,118 +1402,128 @@ _save_effect (GString * str, guint clip_id, GESTrackElement * trackelement,
   append_escaped (str, g_markup_printf_escaped ("          </effect>\n"));
 }
 
-static inline void
-_save_layers (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
+static void
+_save_layer_start (GString * str, GESLayer * layer)
 {
   gchar *properties, *metas;
-  GESLayer *layer;
-  GESClip *clip;
-  GList *tmplayer, *tmpclip, *clips;
+
+  properties = _serialize_properties (G_OBJECT (layer), "priority", NULL);
+  metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (layer));
+  append_escaped (str,
+      g_markup_printf_escaped
+      ("      <layer priority='%i' properties='%s' metadatas='%s'>\n",
+          ges_layer_get_priority (layer), properties, metas));
+  g_free (properties);
+  g_free (metas);
+}
+
+static void
+_save_clip (GESXmlFormatter * self, GString * str, GESTimeline * timeline,
+    GESClip * clip, guint priority)
+{
+  gchar *properties, *metas;
+  GList *effects, *tmpeffect;
+  GList *tmptrackelement;
+  GList *tracks;
+  gboolean serialize;
+  gchar *extractable_id;
   GESXmlFormatterPrivate *priv = self->priv;
 
-  for (tmplayer = timeline->layers; tmplayer; tmplayer = tmplayer->next) {
-    guint priority;
-    layer = GES_LAYER (tmplayer->data);
+  g_object_get (clip, "serialize", &serialize, NULL);
+  if (!serialize) {
+    GST_DEBUG_OBJECT (clip, "Should not be serialized");
+    return;
+  }
 
-    priority = ges_layer_get_priority (layer);
-    properties = _serialize_properties (G_OBJECT (layer), "priority", NULL);
-    metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (layer));
-    append_escaped (str,
-        g_markup_printf_escaped
-        ("      <layer priority='%i' properties='%s' metadatas='%s'>\n",
-            priority, properties, metas));
-    g_free (properties);
-    g_free (metas);
+  /* We escape all mandatrorry properties that are handled sparetely
+   * and vtype for StandarTransition as it is the asset ID */
+  properties = _serialize_properties (G_OBJECT (clip),
+      "supported-formats", "rate", "in-point", "start", "duration",
+      "max-duration", "priority", "vtype", "uri", NULL);
+  extractable_id = ges_extractable_get_id (GES_EXTRACTABLE (clip));
+  metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (clip));
+  append_escaped (str,
+      g_markup_printf_escaped ("        <clip id='%i' asset-id='%s'"
+          " type-name='%s' layer-priority='%i' track-types='%i' start='%"
+          G_GUINT64_FORMAT "' duration='%" G_GUINT64_FORMAT "' inpoint='%"
+          G_GUINT64_FORMAT "' rate='%d' properties='%s' metadatas='%s'",
+          priv->nbelements, extractable_id,
+          g_type_name (G_OBJECT_TYPE (clip)), priority,
+          ges_clip_get_supported_formats (clip), _START (clip),
+          _DURATION (clip), _INPOINT (clip), 0, properties, metas));
+
+  if (GES_IS_TRANSITION_CLIP (clip)) {
+    _save_children_properties (str, GES_TIMELINE_ELEMENT (clip));
+    self->priv->min_version = MAX (self->priv->min_version, 4);
+  }
+  g_string_append (str, ">\n");
 
-    clips = ges_layer_get_clips (layer);
-    for (tmpclip = clips; tmpclip; tmpclip = tmpclip->next) {
-      GList *effects, *tmpeffect;
-      GList *tmptrackelement;
-      GList *tracks;
-      gboolean serialize;
-      gchar *extractable_id;
-
-      clip = GES_CLIP (tmpclip->data);
-
-      g_object_get (clip, "serialize", &serialize, NULL);
-      if (!serialize) {
-        GST_DEBUG_OBJECT (clip, "Should not be serialized");
-        continue;
-      }
+  g_free (extractable_id);
+  g_free (properties);
 
-      /* We escape all mandatrorry properties that are handled sparetely
-       * and vtype for StandarTransition as it is the asset ID */
-      properties = _serialize_properties (G_OBJECT (clip),
-          "supported-formats", "rate", "in-point", "start", "duration",
-          "max-duration", "priority", "vtype", "uri", NULL);
-      extractable_id = ges_extractable_get_id (GES_EXTRACTABLE (clip));
-      metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (clip));
-      append_escaped (str,
-          g_markup_printf_escaped ("        <clip id='%i' asset-id='%s'"
-              " type-name='%s' layer-priority='%i' track-types='%i' start='%"
-              G_GUINT64_FORMAT "' duration='%" G_GUINT64_FORMAT "' inpoint='%"
-              G_GUINT64_FORMAT "' rate='%d' properties='%s' metadatas='%s'",
-              priv->nbelements, extractable_id,
-              g_type_name (G_OBJECT_TYPE (clip)), priority,
-              ges_clip_get_supported_formats (clip), _START (clip),
-              _DURATION (clip), _INPOINT (clip), 0, properties, metas));
-
-      if (GES_IS_TRANSITION_CLIP (clip)) {
-        _save_children_properties (str, GES_TIMELINE_ELEMENT (clip));
-        self->priv->min_version = MAX (self->priv->min_version, 4);
-      }
-      g_string_append (str, ">\n");
+  g_hash_table_insert (self->priv->element_id, clip,
+      GINT_TO_POINTER (priv->nbelements));
 
-      g_free (extractable_id);
-      g_free (properties);
 
-      g_hash_table_insert (self->priv->element_id, clip,
-          GINT_TO_POINTER (priv->nbelements));
+  /* Effects must always be serialized in the right priority order.
+   * List order is guaranteed by the fact that ges_clip_get_top_effects
+   * sorts the effects. */
+  effects = ges_clip_get_top_effects (clip);
+  for (tmpeffect = effects; tmpeffect; tmpeffect = tmpeffect->next) {
+    _save_effect (str, priv->nbelements,
+        GES_TRACK_ELEMENT (tmpeffect->data), timeline);
+  }
 
 
-      /* Effects must always be serialized in the right priority order.
-       * List order is guaranteed by the fact that ges_clip_get_top_effects
-       * sorts the effects. */
-      effects = ges_clip_get_top_effects (clip);
-      for (tmpeffect = effects; tmpeffect; tmpeffect = tmpeffect->next) {
-        _save_effect (str, priv->nbelements,
-            GES_TRACK_ELEMENT (tmpeffect->data), timeline);
-      }
+  tracks = ges_timeline_get_tracks (timeline);
 
+  for (tmptrackelement = GES_CONTAINER_CHILDREN (clip); tmptrackelement;
+      tmptrackelement = tmptrackelement->next) {
+    gint index;
+    gboolean serialize;
 
-      tracks = ges_timeline_get_tracks (timeline);
+    if (!GES_IS_SOURCE (tmptrackelement->data))
+      continue;
 
-      for (tmptrackelement = GES_CONTAINER_CHILDREN (clip); tmptrackelement;
-          tmptrackelement = tmptrackelement->next) {
-        gint index;
-        gboolean serialize;
+    g_object_get (tmptrackelement->data, "serialize", &serialize, NULL);
+    if (!serialize) {
+      GST_DEBUG_OBJECT (tmptrackelement->data, "Should not be serialized");
+      continue;
+    }
 
-        if (!GES_IS_SOURCE (tmptrackelement->data))
-          continue;
+    index =
+        g_list_index (tracks,
+        ges_track_element_get_track (tmptrackelement->data));
+    append_escaped (str,
+        g_markup_printf_escaped ("          <source track-id='%i'", index));
+    _save_children_properties (str, tmptrackelement->data);
+    append_escaped (str, g_markup_printf_escaped (">\n"));
+    _save_keyframes (str, tmptrackelement->data, index);
+    append_escaped (str, g_markup_printf_escaped ("          </source>\n"));
+  }
 
-        g_object_get (tmptrackelement->data, "serialize", &serialize, NULL);
-        if (!serialize) {
-          GST_DEBUG_OBJECT (tmptrackelement->data, "Should not be serialized");
-          continue;
-        }
+  g_list_free_full (tracks, gst_object_unref);
 
-        index =
-            g_list_index (tracks,
-            ges_track_element_get_track (tmptrackelement->data));
-        append_escaped (str,
-            g_markup_printf_escaped ("          <source track-id='%i'", index));
-        _save_children_properties (str, tmptrackelement->data);
-        append_escaped (str, g_markup_printf_escaped (">\n"));
-        _save_keyframes (str, tmptrackelement->data, index);
-        append_escaped (str, g_markup_printf_escaped ("          </source>\n"));
-      }
+  g_string_append (str, "        </clip>\n");
+
+  priv->nbelements++;
+  _flush (self, FALSE);
+}
 
-      g_list_free_full (tracks, gst_object_unref);
+static inline void
+_save_layers (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
+{
+  GESLayer *layer;
+  GList *tmplayer, *tmpclip, *clips;
 
-      g_string_append (str, "        </clip>\n");
+  for (tmplayer = timeline->layers; tmplayer; tmplayer = tmplayer->next) {
+    layer = GES_LAYER (tmplayer->data);
 
-      priv->nbelements++;
-    }
+    _save_layer_start (str, layer);
+    clips = ges_layer_get_clips (layer);
+    for (tmpclip = clips; tmpclip; tmpclip = tmpclip->next)
+      _save_clip (self, str, timeline, GES_CLIP (tmpclip->data),
+          ges_layer_get_priority (layer));
     g_list_free_full (clips, (GDestroyNotify) gst_object_unref);
     g_string_append (str, "      </layer>\n");
   }
@@ -1335,13 +1574,18 @@ _save_group (GESXmlFormatter * self, GString * str, GList ** seen_groups,
   self->priv->nbelements++;
 
   for (tmp = GES_CONTAINER_CHILDREN (group); tmp; tmp = tmp->next) {
-    gint id = GPOINTER_TO_INT (g_hash_table_lookup (self->priv->element_id,
-            tmp->data));
+    gpointer id;
 
-    g_string_append_printf (str, "          <child id='%d' name='%s'/>\n", id,
-        GES_TIMELINE_ELEMENT_NAME (tmp->data));
+    /* Not serialized, or added after the clips got serialized */
+    if (!g_hash_table_lookup_extended (self->priv->element_id, tmp->data,
+            NULL, &id))
+      continue;
+
+    g_string_append_printf (str, "          <child id='%d' name='%s'/>\n",
+        GPOINTER_TO_INT (id), GES_TIMELINE_ELEMENT_NAME (tmp->data));
   }
   g_string_append (str, "        </group>\n");
+  _flush (self, FALSE);
 }
 
 static void
@@ -1358,8 +1602,9 @@ _save_groups (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
   g_string_append (str, "      </groups>\n");
 }
 
-static inline void
-_save_timeline (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
+static void
+_save_timeline_start (GESXmlFormatter * self, GString * str,
+    GESTimeline * timeline)
 {
   gchar *properties = NULL, *metas = NULL;
 
@@ -1374,15 +1619,19 @@ _save_timeline (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
       ("    <timeline properties='%s' metadatas='%s'>\n", properties, metas));
 
   _save_tracks (self, str, timeline);
-  _save_layers (self, str, timeline);
-  _save_groups (self, str, timeline);
-
-  g_string_append (str, "    </timeline>\n");
 
   g_free (properties);
   g_free (metas);
 }
 
+static void
+_save_timeline_end (GESXmlFormatter * self, GString * str,
+    GESTimeline * timeline)
+{
+  _save_groups (self, str, timeline);
+  g_string_append (str, "    </timeline>\n");
+}
+
 static void
 _save_stream_profiles (GESXmlFormatter * self, GString * str,
     GstEncodingProfile * sprof, const gchar * profilename, guint id)
@@ -1551,23 +1800,13 @@ _save_encoding_profiles (GESXmlFormatter * self, GString * str,
   g_list_free (profiles);
 }
 
-static GString *
-_save (GESFormatter * formatter, GESTimeline * timeline, GError ** error)
+/* Serializes everything that comes before the layers */
+static void
+_save_project_start (GESXmlFormatter * self, GString * str,
+    GESTimeline * timeline)
 {
-  GString *str;
-  GESProject *project;
-
-  gchar *projstr = NULL, *version;
-  gchar *properties = NULL, *metas = NULL;
-  GESXmlFormatter *self = GES_XML_FORMATTER (formatter);
-  GESXmlFormatterPrivate *priv;
-
-
-  priv = _GET_PRIV (formatter);
-
-  priv->min_version = 1;
-  project = formatter->project;
-  str = priv->str = g_string_new (NULL);
+  gchar *properties, *metas;
+  GESProject *project = GES_FORMATTER (self)->project;
 
   properties = _serialize_properties (G_OBJECT (project), NULL);
   metas = ges_meta_container_metas_to_string (GES_META_CONTAINER (project));
@@ -1578,37 +1817,284 @@ _save (GESFormatter * formatter, GESTimeline * timeline, GError ** error)
   g_free (metas);
 
   g_string_append (str, "    <encoding-profiles>\n");
-  _save_encoding_profiles (GES_XML_FORMATTER (formatter), str, project);
+  _save_encoding_profiles (self, str, project);
   g_string_append (str, "    </encoding-profiles>\n");
 
   g_string_append (str, "    <ressources>\n");
   _save_assets (self, str, project);
   g_string_append (str, "    </ressources>\n");
 
-  _save_timeline (self, str, timeline);
+  _save_timeline_start (self, str, timeline);
+}
+
+static void
+_save_project_end (GESXmlFormatter * self, GString * str,
+    GESTimeline * timeline)
+{
+  _save_timeline_end (self, str, timeline);
   g_string_append (str, "</project>\n</ges>");
+}
 
-  projstr = g_strdup_printf ("<ges version='%i.%i'>\n", API_VERSION,
-      priv->min_version);
-  g_string_prepend (str, projstr);
-  g_free (projstr);
+static void
+_save_project (GESXmlFormatter * self, GString * str, GESTimeline * timeline)
+{
+  _save_project_start (self, str, timeline);
+  _save_layers (self, str, timeline);
+  _save_project_end (self, str, timeline);
+}
+
+static void
+_set_format_version (GESXmlFormatter * self)
+{
+  gchar *version;
+  GESProject *project = GES_FORMATTER (self)->project;
 
   ges_meta_container_set_int (GES_META_CONTAINER (project),
-      GES_META_FORMAT_VERSION, priv->min_version);
+      GES_META_FORMAT_VERSION, self->priv->min_version);
 
-  version = g_strdup_printf ("%d.%d", API_VERSION,
-      GES_XML_FORMATTER (formatter)->priv->min_version);
+  version = g_strdup_printf ("%d.%d", API_VERSION, self->priv->min_version);
 
   ges_meta_container_set_string (GES_META_CONTAINER (project),
       GES_META_FORMAT_VERSION, version);
 
   g_free (version);
+}
+
+static GString *
+_save (GESFormatter * formatter, GESTimeline * timeline, GError ** error)
+{
+  GString *str;
+  gchar *projstr;
+  GESXmlFormatter *self = GES_XML_FORMATTER (formatter);
+  GESXmlFormatterPrivate *priv = _GET_PRIV (formatter);
+
+  priv->min_version = 1;
+  str = priv->str = g_string_new (NULL);
+
+  _save_project (self, str, timeline);
+
+  projstr = g_strdup_printf ("<ges version='%i.%i'>\n", API_VERSION,
+      priv->min_version);
+  g_string_prepend (str, projstr);
+  g_free (projstr);
+
+  _set_format_version (self);
 
   priv->str = NULL;
 
   return str;
 }
 
+static gboolean
+_save_to_stream (GESFormatter * formatter, GESTimeline * timeline,
+    GOutputStream * stream, GError ** error)
+{
+  gchar *header;
+  goffset version_offset = -1;
+  GESXmlFormatter *self = GES_XML_FORMATTER (formatter);
+  GESXmlFormatterPrivate *priv = _GET_PRIV (formatter);
+
+  priv->min_version = 1;
+  priv->str = g_string_new (NULL);
+  priv->stream = stream;
+
+  /* The version is the one needed by what gets serialized, which is only
+   * known at the end, so the header is patched afterward when possible.
+   * Otherwise the current version is kept, as for compressed files which
+   * older versions can not load anyway */
+  header = g_strdup_printf ("<ges version='%i.", API_VERSION);
+  if (G_IS_SEEKABLE (stream) && g_seekable_can_seek (G_SEEKABLE (stream)))
+    version_offset = g_seekable_tell (G_SEEKABLE (stream)) + strlen (header);
+  g_string_append_printf (priv->str, "%s%i'>\n", header, MINOR_VERSION);
+  g_free (header);
+
+  _save_project (self, priv->str, timeline);
+  _flush (self, TRUE);
+
+  if (!priv->stream_error && version_offset >= 0) {
+    gchar minor = '0' + priv->min_version;
+
+    if (g_seekable_seek (G_SEEKABLE (stream), version_offset, G_SEEK_SET,
+            NULL, &priv->stream_error))
+      g_output_stream_write_all (stream, &minor, 1, NULL, NULL,
+          &priv->stream_error);
+    if (!priv->stream_error)
+      g_seekable_seek (G_SEEKABLE (stream), 0, G_SEEK_END, NULL,
+          &priv->stream_error);
+  }
+
+  _set_format_version (self);
+
+  g_string_free (priv->str, TRUE);
+  priv->str = NULL;
+  priv->stream = NULL;
+
+  if (priv->stream_error) {
+    g_propagate_error (error, priv->stream_error);
+    priv->stream_error = NULL;
+
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+typedef struct
+{
+  GESLayer *layer;
+  GList *clips;
+} LayerSnapshot;
+
+static void
+_free_layer_snapshot (LayerSnapshot * snapshot)
+{
+  gst_object_unref (snapshot->layer);
+  g_list_free_full (snapshot->clips, gst_object_unref);
+  g_slice_free (LayerSnapshot, snapshot);
+}
+
+typedef struct
+{
+  GESTimeline *timeline;
+  /* The layers and clips of the timeline when saving started */
+  GList *layers;
+  GList *layer;
+  /* The next clip of @layer to serialize */
+  gboolean layer_started;
+  GList *clip;
+} SlicedSave;
+
+static void
+_free_sliced_save (SlicedSave * save)
+{
+  gst_object_unref (save->timeline);
+  g_list_free_full (save->layers, (GDestroyNotify) _free_layer_snapshot);
+  g_slice_free (SlicedSave, save);
+}
+
+static gboolean
+_save_slice (GTask * task)
+{
+  gchar *header;
+  GESXmlFormatter *self = g_task_get_source_object (task);
+  GESXmlFormatterPrivate *priv = self->priv;
+  SlicedSave *save = g_task_get_task_data (task);
+  gint64 end_time = g_get_monotonic_time () + SAVE_SLICE_DURATION;
+
+  if (g_task_return_error_if_cancelled (task)) {
+    g_string_free (priv->str, TRUE);
+    priv->str = NULL;
+
+    return G_SOURCE_REMOVE;
+  }
+
+  while (save->layer && g_get_monotonic_time () < end_time) {
+    LayerSnapshot *snapshot = save->layer->data;
+
+    if (!save->layer_started) {
+      _save_layer_start (priv->str, snapshot->layer);
+      save->clip = snapshot->clips;
+      save->layer_started = TRUE;
+    } else if (save->clip) {
+      GESClip *clip = save->clip->data;
+      GESLayer *layer = ges_clip_get_layer (clip);
+
+      /* Clips are loaded in the layer they are in now, and not saved at all
+       * if they got removed meanwhile */
+      if (layer && ges_layer_get_timeline (layer) == save->timeline)
+        _save_clip (self, priv->str, save->timeline, clip,
+            ges_layer_get_priority (layer));
+      gst_clear_object (&layer);
+      save->clip = save->clip->next;
+    } else {
+      g_string_append (priv->str, "      </layer>\n");
+      save->layer_started = FALSE;
+      save->layer = save->layer->next;
+    }
+  }
+
+  if (save->layer)
+    return G_SOURCE_CONTINUE;
+
+  _save_project_end (self, priv->str, save->timeline);
+
+  header = g_strdup_printf ("<ges version='%i.%i'>\n", API_VERSION,
+      priv->min_version);
+  g_string_prepend (priv->str, header);
+  g_free (header);
+
+  _set_format_version (self);
+
+  g_task_return_pointer (task, g_string_free_to_bytes (priv->str),
+      (GDestroyNotify) g_bytes_unref);
+  priv->str = NULL;
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * ges_xml_formatter_save_to_bytes_async:
+ * @self: A #GESXmlFormatter
+ * @timeline: The #GESTimeline to save
+ * @cancellable: (allow-none): A #GCancellable or %NULL
+ * @callback: The function to call once serialized
+ * @user_data: The data to pass to @callback
+ *
+ * Serializes @timeline in memory from the main context, a few clips at a
+ * time, so that neither serializing nor writing a big project blocks it.
+ * The layers and clips saved are the ones @timeline has when this is
+ * called, each clip is saved as it is when its turn comes, and not at all
+ * if it got removed meanwhile.
+ */
+void
+ges_xml_formatter_save_to_bytes_async (GESXmlFormatter * self,
+    GESTimeline * timeline, GCancellable * cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GList *tmp;
+  GSource *source;
+  SlicedSave *save = g_slice_new0 (SlicedSave);
+  GTask *task = g_task_new (self, cancellable, callback, user_data);
+
+  save->timeline = gst_object_ref (timeline);
+  for (tmp = timeline->layers; tmp; tmp = tmp->next) {
+    LayerSnapshot *snapshot = g_slice_new (LayerSnapshot);
+
+    snapshot->layer = gst_object_ref (tmp->data);
+    snapshot->clips = ges_layer_get_clips (tmp->data);
+    save->layers = g_list_prepend (save->layers, snapshot);
+  }
+  save->layer = save->layers = g_list_reverse (save->layers);
+  g_task_set_task_data (task, save, (GDestroyNotify) _free_sliced_save);
+
+  self->priv->min_version = 1;
+  self->priv->str = g_string_new (NULL);
+  _save_project_start (self, self->priv->str, timeline);
+
+  source = g_idle_source_new ();
+  g_task_attach_source (task, source, (GSourceFunc) _save_slice);
+  g_source_unref (source);
+  g_object_unref (task);
+}
+
+/**
+ * ges_xml_formatter_save_to_bytes_finish:
+ * @self: A #GESXmlFormatter
+ * @result: The #GAsyncResult passed to the callback
+ * @error: (out) (allow-none): An error to be set in case something wrong
+ * happens or %NULL
+ *
+ * Returns: (transfer full) (nullable): The serialized project
+ */
+GBytes *
+ges_xml_formatter_save_to_bytes_finish (GESXmlFormatter * self,
+    GAsyncResult * result, GError ** error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /***********************************************
  *                                             *
  *   GObject virtual methods implementation    *
@@ -1671,6 +2157,7 @@ ges_xml_formatter_class_init (GESXmlFormatterClass * self_class)
       "xges", "application/ges", VERSION, GST_RANK_PRIMARY);
 
   basexmlformatter_class->save = _save;
+  basexmlformatter_class->save_to_stream = _save_to_stream;
 }
 
 #undef COLLECT_STR_OPT
@@ -18,14 +18,6 @@
  * Boston, MA 02110-1301, USA.
  */
 
-/* TODO
- * Add a deinit function
- *
- * Do not forget to
- *  + g_ptr_array_unref (new_paths);
- *  + g_hash_table_unref (tried_uris);
- */
-
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -33,6 +25,10 @@
 #include <stdlib.h>
 #include <ges/ges.h>
 #include "ges/gstframepositioner.h"
+#include "ges/gstgapsource.h"
+#include "ges/gstcachedimagesource.h"
+#include "ges/gstimagesequencesource.h"
+#include "ges/gstaudiofade.h"
 #include "ges-internal.h"
 
 #ifndef DISABLE_XPTV
@@ -114,6 +110,7 @@ ges_init_post (GOptionContext * context, GOptionGroup * group, gpointer data,
 #endif
   g_type_class_ref (GES_TYPE_COMMAND_LINE_FORMATTER);
   g_type_class_ref (GES_TYPE_XML_FORMATTER);
+  g_type_class_ref (GES_TYPE_BINARY_FORMATTER);
 
   /* Register track elements */
   g_type_class_ref (GES_TYPE_EFFECT);
@@ -122,6 +119,12 @@ ges_init_post (GOptionContext * context, GOptionGroup * group, gpointer data,
 
   gst_element_register (NULL, "framepositioner", 0, GST_TYPE_FRAME_POSITIONNER);
   gst_element_register (NULL, "gespipeline", 0, GES_TYPE_PIPELINE);
+  gst_element_register (NULL, "gesgapsrc", 0, GST_TYPE_GAP_SOURCE);
+  gst_element_register (NULL, "gescachedimagesrc", 0,
+      GST_TYPE_CACHED_IMAGE_SOURCE);
+  gst_element_register (NULL, "gesimagesequencesrc", 0,
+      GST_TYPE_IMAGE_SEQUENCE_SOURCE);
+  gst_element_register (NULL, "gesaudiofade", 0, GST_TYPE_AUDIO_FADE);
 
   /* TODO: user-defined types? */
   ges_initialized = TRUE;
@@ -187,6 +190,7 @@ ges_deinit (void)
   }
 
   _ges_uri_asset_cleanup ();
+  ges_missing_uri_relocation_deinit ();
 
   g_type_class_unref (g_type_class_peek (GES_TYPE_TEST_CLIP));
   g_type_class_unref (g_type_class_peek (GES_TYPE_URI_CLIP));
@@ -204,11 +208,14 @@ ges_deinit (void)
 
   g_type_class_unref (g_type_class_peek (GES_TYPE_COMMAND_LINE_FORMATTER));
   g_type_class_unref (g_type_class_peek (GES_TYPE_XML_FORMATTER));
+  g_type_class_unref (g_type_class_peek (GES_TYPE_BINARY_FORMATTER));
 
   /* Register track elements */
   g_type_class_unref (g_type_class_peek (GES_TYPE_EFFECT));
 
   ges_asset_cache_deinit ();
+  ges_image_cache_deinit ();
+  ges_discovery_cache_deinit ();
 
   ges_initialized = FALSE;
   G_UNLOCK (init_lock);
@@ -0,0 +1,382 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* Applies a linear fade, from "start-volume" to "end-volume" over
+ * "duration" of stream time, used by audio transitions.
+ *
+ * The gain of every sample of the fade is computed once per fade shape
+ * (duration, rate and volumes) and shared by all the fades with the same
+ * shape, applying it is then a plain multiplication loop instead of an
+ * interpolation of the controlled value for each sample. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstaudiofade.h"
+
+GST_DEBUG_CATEGORY_STATIC (audiofade_debug);
+#define GST_CAT_DEFAULT audiofade_debug
+
+/* Longer fades are computed for each buffer instead of being cached, 4MB
+ * per curve at most */
+#define MAX_CURVE_SAMPLES (1 << 20)
+
+#define ALLOWED_CAPS \
+    GST_AUDIO_CAPS_MAKE ("{ " GST_AUDIO_NE (F32) ", " GST_AUDIO_NE (F64) ", " \
+        GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (S32) " }") \
+    ", layout = (string) interleaved"
+
+enum
+{
+  PROP_0,
+  PROP_START_VOLUME,
+  PROP_END_VOLUME,
+  PROP_DURATION,
+};
+
+struct _GstAudioFadeCurve
+{
+  gint refcount;
+
+  guint64 n_samples;
+  gdouble start_volume;
+  gdouble end_volume;
+
+  gfloat *gains;
+};
+
+G_LOCK_DEFINE_STATIC (curves_lock);
+static GHashTable *curves = NULL;
+
+G_DEFINE_TYPE (GstAudioFade, gst_audio_fade, GST_TYPE_AUDIO_FILTER);
+
+static guint
+curve_hash (const GstAudioFadeCurve * curve)
+{
+  return g_int64_hash (&curve->n_samples) ^ g_double_hash (&curve->start_volume)
+      ^ (g_double_hash (&curve->end_volume) << 1);
+}
+
+static gboolean
+curve_equal (const GstAudioFadeCurve * a, const GstAudioFadeCurve * b)
+{
+  return a->n_samples == b->n_samples && a->start_volume == b->start_volume
+      && a->end_volume == b->end_volume;
+}
+
+static void
+fill_gains (gfloat * gains, guint64 offset, guint n_gains, guint64 n_samples,
+    gdouble start_volume, gdouble end_volume)
+{
+  guint i;
+  gfloat start = start_volume + (end_volume - start_volume) * offset /
+      n_samples;
+  gfloat step = (end_volume - start_volume) / n_samples;
+
+  for (i = 0; i < n_gains; i++)
+    gains[i] = start + step * i;
+}
+
+static GstAudioFadeCurve *
+curve_get (guint64 n_samples, gdouble start_volume, gdouble end_volume)
+{
+  GstAudioFadeCurve *curve, key = { 0, n_samples, start_volume, end_volume };
+
+  G_LOCK (curves_lock);
+  if (!curves)
+    curves = g_hash_table_new ((GHashFunc) curve_hash,
+        (GEqualFunc) curve_equal);
+
+  curve = g_hash_table_lookup (curves, &key);
+  if (curve) {
+    g_atomic_int_inc (&curve->refcount);
+    G_UNLOCK (curves_lock);
+
+    return curve;
+  }
+
+  GST_DEBUG ("Computing a fade of %" G_GUINT64_FORMAT " samples from %f to %f",
+      n_samples, start_volume, end_volume);
+  curve = g_slice_new (GstAudioFadeCurve);
+  *curve = key;
+  curve->refcount = 1;
+  curve->gains = g_new (gfloat, n_samples);
+  fill_gains (curve->gains, 0, n_samples, n_samples, start_volume, end_volume);
+  g_hash_table_add (curves, curve);
+  G_UNLOCK (curves_lock);
+
+  return curve;
+}
+
+static void
+curve_unref (GstAudioFadeCurve * curve)
+{
+  G_LOCK (curves_lock);
+  if (g_atomic_int_dec_and_test (&curve->refcount)) {
+    g_hash_table_remove (curves, curve);
+    if (!g_hash_table_size (curves))
+      g_clear_pointer (&curves, g_hash_table_unref);
+    g_free (curve->gains);
+    g_slice_free (GstAudioFadeCurve, curve);
+  }
+  G_UNLOCK (curves_lock);
+}
+
+/* Call with the object lock */
+static void
+gst_audio_fade_reset_curve (GstAudioFade * self)
+{
+  if (self->curve)
+    curve_unref (self->curve);
+  self->curve = NULL;
+}
+
+#define APPLY_GAINS(ctype) G_STMT_START {                               \
+  ctype *d = (ctype *) data;                                            \
+                                                                        \
+  for (i = 0; i < n_frames; i++) {                                      \
+    gfloat g = gains ? gains[i] : gain;                                 \
+                                                                        \
+    for (c = 0; c < channels; c++)                                      \
+      d[c] = (ctype) (d[c] * g);                                        \
+    d += channels;                                                      \
+  }                                                                     \
+} G_STMT_END
+
+/* Applies @gains, or @gain to all the frames when @gains is %NULL */
+static void
+apply_gains (GstAudioFormat format, gint channels, gpointer data,
+    guint n_frames, const gfloat * gains, gfloat gain)
+{
+  guint i;
+  gint c;
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      APPLY_GAINS (gfloat);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      APPLY_GAINS (gdouble);
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      APPLY_GAINS (gint16);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      APPLY_GAINS (gint32);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+#undef APPLY_GAINS
+
+static GstFlowReturn
+gst_audio_fade_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstMapInfo map;
+  guint64 offset, n_samples;
+  guint n_frames, n_fading = 0;
+  gfloat end_volume;
+  const gfloat *gains = NULL;
+  GstAudioFadeCurve *curve = NULL;
+  GstAudioFade *self = GST_AUDIO_FADE (trans);
+  GstAudioInfo *info = &GST_AUDIO_FILTER (trans)->info;
+  GstClockTime stream_time = gst_segment_to_stream_time (&trans->segment,
+      GST_FORMAT_TIME, GST_BUFFER_PTS (buf));
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP)
+      || !GST_CLOCK_TIME_IS_VALID (stream_time))
+    return GST_FLOW_OK;
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_READWRITE))
+    return GST_FLOW_ERROR;
+
+  n_frames = map.size / GST_AUDIO_INFO_BPF (info);
+  offset = gst_util_uint64_scale_round (stream_time,
+      GST_AUDIO_INFO_RATE (info), GST_SECOND);
+
+  GST_OBJECT_LOCK (self);
+  end_volume = self->end_volume;
+  n_samples = gst_util_uint64_scale_round (self->duration,
+      GST_AUDIO_INFO_RATE (info), GST_SECOND);
+
+  if (offset < n_samples) {
+    n_fading = MIN (n_frames, n_samples - offset);
+
+    if (n_samples <= MAX_CURVE_SAMPLES) {
+      if (!self->curve)
+        self->curve = curve_get (n_samples, self->start_volume,
+            self->end_volume);
+      curve = self->curve;
+      g_atomic_int_inc (&curve->refcount);
+      gains = curve->gains + offset;
+    } else {
+      if (self->n_gains < n_fading) {
+        self->gains = g_renew (gfloat, self->gains, n_fading);
+        self->n_gains = n_fading;
+      }
+      fill_gains (self->gains, offset, n_fading, n_samples,
+          self->start_volume, self->end_volume);
+      gains = self->gains;
+    }
+  }
+
+  /* Only the streaming thread uses the gains, the curve is kept alive by
+   * the reference we hold */
+  GST_OBJECT_UNLOCK (self);
+
+  if (n_fading)
+    apply_gains (GST_AUDIO_INFO_FORMAT (info), GST_AUDIO_INFO_CHANNELS (info),
+        map.data, n_fading, gains, 1.0);
+
+  if (n_fading < n_frames && end_volume != 1.0)
+    apply_gains (GST_AUDIO_INFO_FORMAT (info), GST_AUDIO_INFO_CHANNELS (info),
+        map.data + n_fading * GST_AUDIO_INFO_BPF (info), n_frames - n_fading,
+        NULL, end_volume);
+
+  gst_buffer_unmap (buf, &map);
+  if (curve)
+    curve_unref (curve);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_audio_fade_setup (GstAudioFilter * filter, const GstAudioInfo * info)
+{
+  GST_OBJECT_LOCK (filter);
+  gst_audio_fade_reset_curve (GST_AUDIO_FADE (filter));
+  GST_OBJECT_UNLOCK (filter);
+
+  return TRUE;
+}
+
+static void
+gst_audio_fade_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAudioFade *self = GST_AUDIO_FADE (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (property_id) {
+    case PROP_START_VOLUME:
+      g_value_set_double (value, self->start_volume);
+      break;
+    case PROP_END_VOLUME:
+      g_value_set_double (value, self->end_volume);
+      break;
+    case PROP_DURATION:
+      g_value_set_uint64 (value, self->duration);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_audio_fade_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAudioFade *self = GST_AUDIO_FADE (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (property_id) {
+    case PROP_START_VOLUME:
+      self->start_volume = g_value_get_double (value);
+      break;
+    case PROP_END_VOLUME:
+      self->end_volume = g_value_get_double (value);
+      break;
+    case PROP_DURATION:
+      self->duration = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  gst_audio_fade_reset_curve (self);
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_audio_fade_finalize (GObject * object)
+{
+  GstAudioFade *self = GST_AUDIO_FADE (object);
+
+  gst_audio_fade_reset_curve (self);
+  g_free (self->gains);
+
+  G_OBJECT_CLASS (gst_audio_fade_parent_class)->finalize (object);
+}
+
+static void
+gst_audio_fade_class_init (GstAudioFadeClass * klass)
+{
+  GstCaps *caps;
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+  GstAudioFilterClass *filter_class = GST_AUDIO_FILTER_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (audiofade_debug, "gesaudiofade",
+      GST_DEBUG_FG_YELLOW, "ges audio fade");
+
+  gobject_class->get_property = gst_audio_fade_get_property;
+  gobject_class->set_property = gst_audio_fade_set_property;
+  gobject_class->finalize = gst_audio_fade_finalize;
+
+  trans_class->transform_ip = GST_DEBUG_FUNCPTR (gst_audio_fade_transform_ip);
+  filter_class->setup = GST_DEBUG_FUNCPTR (gst_audio_fade_setup);
+
+  g_object_class_install_property (gobject_class, PROP_START_VOLUME,
+      g_param_spec_double ("start-volume", "Start volume",
+          "Volume at the beginning of the fade", 0.0, 1.0, 1.0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_END_VOLUME,
+      g_param_spec_double ("end-volume", "End volume",
+          "Volume at the end of the fade, kept afterward", 0.0, 1.0, 1.0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DURATION,
+      g_param_spec_uint64 ("duration", "Duration",
+          "Duration of the fade, in stream time", 0, G_MAXUINT64, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  caps = gst_caps_from_string (ALLOWED_CAPS);
+  gst_audio_filter_class_add_pad_templates (filter_class, caps);
+  gst_caps_unref (caps);
+
+  gst_element_class_set_static_metadata (element_class, "GES audio fade",
+      "Filter/Effect/Audio", "Applies a linear fade shared between streams",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_audio_fade_init (GstAudioFade * self)
+{
+  self->start_volume = 1.0;
+  self->end_volume = 1.0;
+
+  gst_base_transform_set_in_place (GST_BASE_TRANSFORM (self), TRUE);
+  gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (self), TRUE);
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_AUDIO_FADE_H_
+#define _GST_AUDIO_FADE_H_
+
+#include <gst/audio/gstaudiofilter.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_AUDIO_FADE   (gst_audio_fade_get_type())
+#define GST_AUDIO_FADE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_AUDIO_FADE,GstAudioFade))
+#define GST_AUDIO_FADE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_AUDIO_FADE,GstAudioFadeClass))
+#define GST_IS_AUDIO_FADE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_AUDIO_FADE))
+#define GST_IS_AUDIO_FADE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_AUDIO_FADE))
+
+typedef struct _GstAudioFade GstAudioFade;
+typedef struct _GstAudioFadeClass GstAudioFadeClass;
+typedef struct _GstAudioFadeCurve GstAudioFadeCurve;
+
+struct _GstAudioFade
+{
+  GstAudioFilter parent;
+
+  /* Properties, protected by the object lock */
+  gdouble start_volume;
+  gdouble end_volume;
+  GstClockTime duration;
+
+  /* Gain of each sample of the fade, shared with all the fades with the
+   * same shape, NULL when it needs to be looked up again */
+  GstAudioFadeCurve *curve;
+
+  /* Gains computed for the current buffer when the fade is too long to be
+   * kept in a curve */
+  gfloat *gains;
+  guint n_gains;
+};
+
+struct _GstAudioFadeClass
+{
+  GstAudioFilterClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_audio_fade_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_AUDIO_FADE_H_ */
@@ -0,0 +1,217 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* Source outputting a still image: the picture is taken, already converted
+ * to the negotiated caps, from the process wide image cache and all the
+ * buffers pushed share its memory, no decoder nor converter is needed in
+ * the pipeline. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcachedimagesource.h"
+#include "ges-internal.h"
+
+GST_DEBUG_CATEGORY_STATIC (cachedimagesource_debug);
+#define GST_CAT_DEFAULT cachedimagesource_debug
+
+enum
+{
+  PROP_0,
+  PROP_URI,
+};
+
+G_DEFINE_TYPE (GstCachedImageSource, gst_cached_image_source,
+    GST_TYPE_GAP_SOURCE);
+
+static GstSample *
+get_sample (GstCachedImageSource * self, GstCaps * caps)
+{
+  gchar *uri;
+  GstSample *sample;
+  GError *error = NULL;
+
+  GST_OBJECT_LOCK (self);
+  uri = g_strdup (self->uri);
+  GST_OBJECT_UNLOCK (self);
+
+  if (!uri) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, (NULL),
+        ("No URI to read the image from"));
+
+    return NULL;
+  }
+
+  sample = ges_image_cache_get_sample (uri, caps, &error);
+  if (!sample) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
+        ("Could not get image from %s: %s", uri,
+            error ? error->message : "unknown error"));
+    g_clear_error (&error);
+  }
+  g_free (uri);
+
+  return sample;
+}
+
+/* Prefer the format and size of the decoded image so that, in the common
+ * case, no conversion happens at all */
+static GstCaps *
+gst_cached_image_source_fixate (GstBaseSrc * bsrc, GstCaps * caps)
+{
+  GstVideoInfo info;
+  GstStructure *structure;
+  GstSample *sample = get_sample (GST_CACHED_IMAGE_SOURCE (bsrc), NULL);
+
+  if (sample && gst_video_info_from_caps (&info, gst_sample_get_caps (sample))) {
+    caps = gst_caps_make_writable (caps);
+    caps = gst_caps_truncate (caps);
+    structure = gst_caps_get_structure (caps, 0);
+
+    gst_structure_fixate_field_string (structure, "format",
+        GST_VIDEO_INFO_NAME (&info));
+    gst_structure_fixate_field_nearest_int (structure, "width",
+        GST_VIDEO_INFO_WIDTH (&info));
+    gst_structure_fixate_field_nearest_int (structure, "height",
+        GST_VIDEO_INFO_HEIGHT (&info));
+    if (gst_structure_has_field (structure, "pixel-aspect-ratio"))
+      gst_structure_fixate_field_nearest_fraction (structure,
+          "pixel-aspect-ratio", GST_VIDEO_INFO_PAR_N (&info),
+          GST_VIDEO_INFO_PAR_D (&info));
+  }
+
+  if (sample)
+    gst_sample_unref (sample);
+
+  return
+      GST_BASE_SRC_CLASS (gst_cached_image_source_parent_class)->fixate (bsrc,
+      caps);
+}
+
+static GstBuffer *
+gst_cached_image_source_create_frame (GstGapSource * source, GstCaps * caps,
+    GstVideoInfo * vinfo)
+{
+  GstBuffer *buffer;
+  GstCaps *frame_caps;
+  GstSample *sample;
+
+  /* The framerate does not change the picture, do not cache one frame per
+   * framerate */
+  frame_caps = gst_caps_copy (caps);
+  gst_structure_remove_field (gst_caps_get_structure (frame_caps, 0),
+      "framerate");
+  sample = get_sample (GST_CACHED_IMAGE_SOURCE (source), frame_caps);
+  gst_caps_unref (frame_caps);
+
+  if (!sample)
+    return NULL;
+
+  buffer = gst_buffer_ref (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+
+  return buffer;
+}
+
+static void
+gst_cached_image_source_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCachedImageSource *self = GST_CACHED_IMAGE_SOURCE (object);
+
+  switch (property_id) {
+    case PROP_URI:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->uri);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cached_image_source_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCachedImageSource *self = GST_CACHED_IMAGE_SOURCE (object);
+
+  switch (property_id) {
+    case PROP_URI:
+      GST_OBJECT_LOCK (self);
+      g_free (self->uri);
+      self->uri = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cached_image_source_finalize (GObject * object)
+{
+  GstCachedImageSource *self = GST_CACHED_IMAGE_SOURCE (object);
+
+  g_free (self->uri);
+
+  G_OBJECT_CLASS (gst_cached_image_source_parent_class)->finalize (object);
+}
+
+static void
+gst_cached_image_source_class_init (GstCachedImageSourceClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSrcClass *base_src_class = GST_BASE_SRC_CLASS (klass);
+  GstGapSourceClass *gap_source_class = GST_GAP_SOURCE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (cachedimagesource_debug, "gescachedimagesrc",
+      GST_DEBUG_FG_YELLOW, "ges cached image source");
+
+  gobject_class->get_property = gst_cached_image_source_get_property;
+  gobject_class->set_property = gst_cached_image_source_set_property;
+  gobject_class->finalize = gst_cached_image_source_finalize;
+
+  base_src_class->fixate = GST_DEBUG_FUNCPTR (gst_cached_image_source_fixate);
+  gap_source_class->create_frame =
+      GST_DEBUG_FUNCPTR (gst_cached_image_source_create_frame);
+
+  /**
+   * GstCachedImageSource:uri:
+   *
+   * The URI of the image to output
+   */
+  g_object_class_install_property (gobject_class, PROP_URI,
+      g_param_spec_string ("uri", "URI", "URI of the image", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (element_class,
+      "GES cached image source", "Source/Video",
+      "Outputs a still image shared with all the sources using it",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_cached_image_source_init (GstCachedImageSource * self)
+{
+  GST_GAP_SOURCE (self)->track_type = GES_TRACK_TYPE_VIDEO;
+}
@@ -0,0 +1,51 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_CACHED_IMAGE_SOURCE_H_
+#define _GST_CACHED_IMAGE_SOURCE_H_
+
+#include "gstgapsource.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CACHED_IMAGE_SOURCE   (gst_cached_image_source_get_type())
+#define GST_CACHED_IMAGE_SOURCE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_CACHED_IMAGE_SOURCE,GstCachedImageSource))
+#define GST_CACHED_IMAGE_SOURCE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_CACHED_IMAGE_SOURCE,GstCachedImageSourceClass))
+#define GST_IS_CACHED_IMAGE_SOURCE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_CACHED_IMAGE_SOURCE))
+#define GST_IS_CACHED_IMAGE_SOURCE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_CACHED_IMAGE_SOURCE))
+
+typedef struct _GstCachedImageSource GstCachedImageSource;
+typedef struct _GstCachedImageSourceClass GstCachedImageSourceClass;
+
+struct _GstCachedImageSource
+{
+  GstGapSource parent;
+
+  gchar *uri;
+};
+
+struct _GstCachedImageSourceClass
+{
+  GstGapSourceClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_cached_image_source_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_CACHED_IMAGE_SOURCE_H_ */
@@ -25,6 +25,7 @@
 #include <gst/video/video.h>
 
 #include "gstframepositioner.h"
+#include "ges-internal.h"
 
 /* We  need to define a max number of pixel so we can interpolate them */
 #define MAX_PIXELS 100000
@@ -250,6 +251,16 @@ gst_frame_positioner_dispose (GObject * object)
   G_OBJECT_CLASS (gst_frame_positioner_parent_class)->dispose (object);
 }
 
+static void
+gst_frame_positioner_finalize (GObject * object)
+{
+  GstFramePositioner *pos = GST_FRAME_POSITIONNER (object);
+
+  ges_control_sync_free (pos->control_sync);
+
+  G_OBJECT_CLASS (gst_frame_positioner_parent_class)->finalize (object);
+}
+
 static void
 gst_frame_positioner_class_init (GstFramePositionerClass * klass)
 {
@@ -265,6 +276,7 @@ gst_frame_positioner_class_init (GstFramePositionerClass * klass)
   gobject_class->set_property = gst_frame_positioner_set_property;
   gobject_class->get_property = gst_frame_positioner_get_property;
   gobject_class->dispose = gst_frame_positioner_dispose;
+  gobject_class->finalize = gst_frame_positioner_finalize;
   base_transform_class->transform_ip =
       GST_DEBUG_FUNCPTR (gst_frame_positioner_transform_ip);
 
@@ -353,6 +365,9 @@ gst_frame_positioner_init (GstFramePositioner * framepositioner)
 
   framepositioner->par_n = -1;
   framepositioner->par_d = 1;
+
+  framepositioner->control_sync =
+      ges_control_sync_new (GST_OBJECT (framepositioner));
 }
 
 void
@@ -510,7 +525,8 @@ gst_frame_positioner_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   GstClockTime timestamp = GST_BUFFER_PTS (buf);
 
   if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
-    gst_object_sync_values (GST_OBJECT (trans), timestamp);
+    ges_control_sync_values (framepositioner->control_sync, timestamp,
+        GST_BUFFER_DURATION (buf));
   }
 
   meta =
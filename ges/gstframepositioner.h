@@ -60,6 +60,9 @@ struct _GstFramePositioner
   gint par_n;
   gint par_d;
 
+  /* Syncs the controlled properties, see ges-control-sync.c */
+  struct _GESControlSync *control_sync;
+
   /*  This should never be made public, no padding needed */
 };
 
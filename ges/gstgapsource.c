@@ -0,0 +1,456 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* Source used by tracks to fill gaps: it outputs black frames or silence
+ * without allocating nor filling any memory once it has been negotiated,
+ * all the buffers it outputs share the memory of a single, read only, black
+ * frame or silence buffer. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstgapsource.h"
+
+GST_DEBUG_CATEGORY_STATIC (gapsource_debug);
+#define GST_CAT_DEFAULT gapsource_debug
+
+/* Big enough so that the per buffer overhead stays low, audio sinks and
+ * mixers can handle buffers of any size anyway */
+#define AUDIO_BUFFER_DURATION (100 * GST_MSECOND)
+
+enum
+{
+  PROP_0,
+  PROP_TRACK_TYPE,
+};
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_VIDEO_FORMATS_ALL) ";"
+        GST_AUDIO_CAPS_MAKE (GST_AUDIO_FORMATS_ALL)
+        ", layout=(string)interleaved")
+    );
+
+G_DEFINE_TYPE (GstGapSource, gst_gap_source, GST_TYPE_PUSH_SRC);
+
+static GstClockTime
+gst_gap_source_unit_time (GstGapSource * self, guint64 n_units)
+{
+  if (self->is_video && GST_VIDEO_INFO_FPS_N (&self->vinfo) == 0)
+    return n_units == 0 ? 0 : GST_CLOCK_TIME_NONE;
+
+  if (self->is_video)
+    return gst_util_uint64_scale (n_units,
+        GST_VIDEO_INFO_FPS_D (&self->vinfo) * GST_SECOND,
+        GST_VIDEO_INFO_FPS_N (&self->vinfo));
+
+  return gst_util_uint64_scale_int (n_units, GST_SECOND,
+      GST_AUDIO_INFO_RATE (&self->ainfo));
+}
+
+static guint64
+gst_gap_source_time_unit (GstGapSource * self, GstClockTime time)
+{
+  if (self->is_video) {
+    if (GST_VIDEO_INFO_FPS_N (&self->vinfo) == 0)
+      return 0;
+
+    return gst_util_uint64_scale (time, GST_VIDEO_INFO_FPS_N (&self->vinfo),
+        GST_VIDEO_INFO_FPS_D (&self->vinfo) * GST_SECOND);
+  }
+
+  return gst_util_uint64_scale_int_ceil (time,
+      GST_AUDIO_INFO_RATE (&self->ainfo), GST_SECOND);
+}
+
+/* Packs lines of opaque black, in the unpack format of the frame format,
+ * in all the lines of @frame */
+static void
+fill_black_frame (GstVideoFrame * frame)
+{
+  gint i, y;
+  gpointer lines;
+  guint pixel_stride;
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gint width = GST_VIDEO_FRAME_WIDTH (frame);
+  gint height = GST_VIDEO_FRAME_HEIGHT (frame);
+  guint n_lines = MAX (finfo->pack_lines, 1);
+
+  switch (finfo->unpack_format) {
+    case GST_VIDEO_FORMAT_AYUV:
+    case GST_VIDEO_FORMAT_ARGB:
+    {
+      guint8 black[4] = { 0xff, 0, 0, 0 };
+
+      if (finfo->unpack_format == GST_VIDEO_FORMAT_AYUV) {
+        black[1] = 16;
+        black[2] = black[3] = 128;
+      }
+
+      pixel_stride = 4;
+      lines = g_malloc (pixel_stride * width * n_lines);
+      for (i = 0; i < width * n_lines; i++)
+        memcpy ((guint8 *) lines + i * pixel_stride, black, pixel_stride);
+      break;
+    }
+    case GST_VIDEO_FORMAT_AYUV64:
+    case GST_VIDEO_FORMAT_ARGB64:
+    {
+      guint16 black[4] = { 0xffff, 0, 0, 0 };
+
+      if (finfo->unpack_format == GST_VIDEO_FORMAT_AYUV64) {
+        black[1] = 16 << 8;
+        black[2] = black[3] = 128 << 8;
+      }
+
+      pixel_stride = 8;
+      lines = g_malloc (pixel_stride * width * n_lines);
+      for (i = 0; i < width * n_lines; i++)
+        memcpy ((guint8 *) lines + i * pixel_stride, black, pixel_stride);
+      break;
+    }
+    default:
+      GST_FIXME ("Unsupported unpack format %s",
+          gst_video_format_to_string (finfo->unpack_format));
+      return;
+  }
+
+  for (y = 0; y < height; y += n_lines)
+    finfo->pack_func (finfo, GST_VIDEO_PACK_FLAG_NONE, lines,
+        pixel_stride * width, frame->data, frame->info.stride,
+        frame->info.chroma_site, y, width);
+
+  g_free (lines);
+}
+
+static GstBuffer *
+create_black_frame (GstGapSource * self, GstCaps * caps, GstVideoInfo * vinfo)
+{
+  GstVideoFrame frame;
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, vinfo->size, NULL);
+
+  if (!gst_video_frame_map (&frame, vinfo, buffer, GST_MAP_WRITE)) {
+    gst_buffer_unref (buffer);
+
+    return NULL;
+  }
+
+  fill_black_frame (&frame);
+  gst_video_frame_unmap (&frame);
+
+  return buffer;
+}
+
+static GstBuffer *
+create_silence (GstAudioInfo * ainfo, guint n_samples)
+{
+  GstMapInfo map;
+  GstBuffer *buffer =
+      gst_buffer_new_allocate (NULL, n_samples * GST_AUDIO_INFO_BPF (ainfo),
+      NULL);
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  gst_audio_format_fill_silence (ainfo->finfo, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+static GstCaps *
+gst_gap_source_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
+{
+  guint i;
+  GstCaps *caps;
+  GstGapSource *self = GST_GAP_SOURCE (bsrc);
+
+  caps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (bsrc));
+  caps = gst_caps_make_writable (caps);
+  for (i = gst_caps_get_size (caps); i > 0; i--) {
+    GstStructure *structure = gst_caps_get_structure (caps, i - 1);
+
+    if (gst_structure_has_name (structure, "video/x-raw") ?
+        !(self->track_type & GES_TRACK_TYPE_VIDEO) :
+        !(self->track_type & GES_TRACK_TYPE_AUDIO))
+      gst_caps_remove_structure (caps, i - 1);
+  }
+
+  if (filter) {
+    GstCaps *tmp =
+        gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+
+    gst_caps_unref (caps);
+    caps = tmp;
+  }
+
+  return caps;
+}
+
+static GstCaps *
+gst_gap_source_fixate (GstBaseSrc * bsrc, GstCaps * caps)
+{
+  GstStructure *structure;
+
+  caps = gst_caps_make_writable (caps);
+  caps = gst_caps_truncate (caps);
+  structure = gst_caps_get_structure (caps, 0);
+
+  if (gst_structure_has_name (structure, "video/x-raw")) {
+    gst_structure_fixate_field_nearest_int (structure, "width", 320);
+    gst_structure_fixate_field_nearest_int (structure, "height", 240);
+    gst_structure_fixate_field_nearest_fraction (structure, "framerate", 30,
+        1);
+    if (gst_structure_has_field (structure, "pixel-aspect-ratio"))
+      gst_structure_fixate_field_nearest_fraction (structure,
+          "pixel-aspect-ratio", 1, 1);
+  } else {
+    gint channels;
+
+    gst_structure_fixate_field_nearest_int (structure, "rate", 44100);
+    gst_structure_fixate_field_nearest_int (structure, "channels", 2);
+    if (gst_structure_get_int (structure, "channels", &channels)
+        && channels > 2 && !gst_structure_has_field (structure, "channel-mask"))
+      gst_structure_set (structure, "channel-mask", GST_TYPE_BITMASK,
+          gst_audio_channel_get_fallback_mask (channels), NULL);
+  }
+
+  return GST_BASE_SRC_CLASS (gst_gap_source_parent_class)->fixate (bsrc, caps);
+}
+
+static gboolean
+gst_gap_source_set_caps (GstBaseSrc * bsrc, GstCaps * caps)
+{
+  guint i;
+  GstBuffer *buffer;
+  GstGapSource *self = GST_GAP_SOURCE (bsrc);
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+
+  if (gst_structure_has_name (structure, "video/x-raw")) {
+    GstVideoInfo vinfo;
+
+    if (!gst_video_info_from_caps (&vinfo, caps))
+      goto invalid_caps;
+
+    buffer = GST_GAP_SOURCE_GET_CLASS (self)->create_frame (self, caps, &vinfo);
+    if (!buffer)
+      return FALSE;
+
+    GST_OBJECT_LOCK (self);
+    self->vinfo = vinfo;
+    self->is_video = TRUE;
+  } else {
+    GstAudioInfo ainfo;
+    guint samples_per_buffer;
+
+    if (!gst_audio_info_from_caps (&ainfo, caps))
+      goto invalid_caps;
+
+    samples_per_buffer = MAX (1, gst_util_uint64_scale_int (GST_AUDIO_INFO_RATE
+            (&ainfo), AUDIO_BUFFER_DURATION, GST_SECOND));
+    buffer = create_silence (&ainfo, samples_per_buffer);
+
+    GST_OBJECT_LOCK (self);
+    self->ainfo = ainfo;
+    self->samples_per_buffer = samples_per_buffer;
+    self->is_video = FALSE;
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
+  }
+
+  /* Make sure nobody ever writes into the memory we share */
+  for (i = 0; i < gst_buffer_n_memory (buffer); i++)
+    GST_MEMORY_FLAG_SET (gst_buffer_peek_memory (buffer, i),
+        GST_MEMORY_FLAG_READONLY);
+  gst_buffer_replace (&self->buffer, buffer);
+  GST_OBJECT_UNLOCK (self);
+  gst_buffer_unref (buffer);
+
+  return TRUE;
+
+invalid_caps:
+  {
+    GST_ERROR_OBJECT (self, "Unsupported caps %" GST_PTR_FORMAT, caps);
+
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_gap_source_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_gap_source_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  GstGapSource *self = GST_GAP_SOURCE (bsrc);
+
+  segment->time = segment->start;
+
+  GST_OBJECT_LOCK (self);
+  self->n_units = self->buffer ?
+      gst_gap_source_time_unit (self, segment->position) : 0;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_gap_source_create (GstPushSrc * psrc, GstBuffer ** buffer)
+{
+  GstBuffer *outbuf;
+  guint64 next_unit;
+  GstClockTime pts, next_pts, stop;
+  GstGapSource *self = GST_GAP_SOURCE (psrc);
+
+  GST_OBJECT_LOCK (psrc);
+  stop = GST_BASE_SRC (psrc)->segment.stop;
+  GST_OBJECT_UNLOCK (psrc);
+
+  GST_OBJECT_LOCK (self);
+  if (G_UNLIKELY (!self->buffer)) {
+    GST_OBJECT_UNLOCK (self);
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
+        ("format wasn't negotiated before create function"));
+
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  next_unit = self->n_units + (self->is_video ? 1 : self->samples_per_buffer);
+  pts = gst_gap_source_unit_time (self, self->n_units);
+  next_pts = gst_gap_source_unit_time (self, next_unit);
+
+  /* A still picture only has one frame */
+  if (!GST_CLOCK_TIME_IS_VALID (pts)
+      || (GST_CLOCK_TIME_IS_VALID (stop) && pts >= stop)) {
+    GST_OBJECT_UNLOCK (self);
+
+    return GST_FLOW_EOS;
+  }
+
+  /* Only copies the buffer metadata and references its memory */
+  outbuf = gst_buffer_copy (self->buffer);
+  GST_BUFFER_PTS (outbuf) = pts;
+  GST_BUFFER_DURATION (outbuf) = GST_CLOCK_TIME_IS_VALID (next_pts) ?
+      next_pts - pts : GST_CLOCK_TIME_NONE;
+  GST_BUFFER_OFFSET (outbuf) = self->n_units;
+  GST_BUFFER_OFFSET_END (outbuf) = next_unit;
+  self->n_units = next_unit;
+  GST_OBJECT_UNLOCK (self);
+
+  *buffer = outbuf;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_gap_source_stop (GstBaseSrc * bsrc)
+{
+  GstGapSource *self = GST_GAP_SOURCE (bsrc);
+
+  GST_OBJECT_LOCK (self);
+  gst_buffer_replace (&self->buffer, NULL);
+  self->n_units = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static void
+gst_gap_source_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGapSource *self = GST_GAP_SOURCE (object);
+
+  switch (property_id) {
+    case PROP_TRACK_TYPE:
+      g_value_set_flags (value, self->track_type);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gap_source_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGapSource *self = GST_GAP_SOURCE (object);
+
+  switch (property_id) {
+    case PROP_TRACK_TYPE:
+      self->track_type = g_value_get_flags (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gap_source_class_init (GstGapSourceClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSrcClass *base_src_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *push_src_class = GST_PUSH_SRC_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (gapsource_debug, "gesgapsrc",
+      GST_DEBUG_FG_YELLOW, "ges gap source");
+
+  gobject_class->get_property = gst_gap_source_get_property;
+  gobject_class->set_property = gst_gap_source_set_property;
+
+  base_src_class->get_caps = GST_DEBUG_FUNCPTR (gst_gap_source_get_caps);
+  base_src_class->fixate = GST_DEBUG_FUNCPTR (gst_gap_source_fixate);
+  base_src_class->set_caps = GST_DEBUG_FUNCPTR (gst_gap_source_set_caps);
+  base_src_class->is_seekable = GST_DEBUG_FUNCPTR (gst_gap_source_is_seekable);
+  base_src_class->do_seek = GST_DEBUG_FUNCPTR (gst_gap_source_do_seek);
+  base_src_class->stop = GST_DEBUG_FUNCPTR (gst_gap_source_stop);
+  push_src_class->create = GST_DEBUG_FUNCPTR (gst_gap_source_create);
+
+  klass->create_frame = create_black_frame;
+
+  /**
+   * GstGapSource:track-type:
+   *
+   * The type of track the gap is filled for, restricts the output caps
+   */
+  g_object_class_install_property (gobject_class, PROP_TRACK_TYPE,
+      g_param_spec_flags ("track-type", "Track type",
+          "The type of track to fill gaps for", GES_TYPE_TRACK_TYPE,
+          GES_TRACK_TYPE_AUDIO | GES_TRACK_TYPE_VIDEO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class, "GES gap source",
+      "Source/Audio/Video", "Fills gaps with black frames or silence",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_gap_source_init (GstGapSource * self)
+{
+  self->track_type = GES_TRACK_TYPE_AUDIO | GES_TRACK_TYPE_VIDEO;
+
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+}
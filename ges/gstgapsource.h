@@ -0,0 +1,71 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_GAP_SOURCE_H_
+#define _GST_GAP_SOURCE_H_
+
+#include <gst/base/gstpushsrc.h>
+#include <gst/video/video.h>
+#include <gst/audio/audio.h>
+#include <ges/ges-enums.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GAP_SOURCE   (gst_gap_source_get_type())
+#define GST_GAP_SOURCE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GAP_SOURCE,GstGapSource))
+#define GST_GAP_SOURCE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_GAP_SOURCE,GstGapSourceClass))
+#define GST_IS_GAP_SOURCE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GAP_SOURCE))
+#define GST_GAP_SOURCE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj),GST_TYPE_GAP_SOURCE,GstGapSourceClass))
+#define GST_IS_GAP_SOURCE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_GAP_SOURCE))
+
+typedef struct _GstGapSource GstGapSource;
+typedef struct _GstGapSourceClass GstGapSourceClass;
+
+struct _GstGapSource
+{
+  GstPushSrc parent;
+
+  GESTrackType track_type;
+
+  /* The black frame or silence pushed for every output buffer, its memory
+   * is shared by all the buffers we output */
+  GstBuffer *buffer;
+  gboolean is_video;
+  GstVideoInfo vinfo;
+  GstAudioInfo ainfo;
+  guint samples_per_buffer;
+
+  /* Index of the next frame or sample to output */
+  guint64 n_units;
+};
+
+struct _GstGapSourceClass
+{
+  GstPushSrcClass parent_class;
+
+  /* Returns the frame to output for the negotiated @caps, a black frame by
+   * default */
+  GstBuffer * (*create_frame) (GstGapSource * self, GstCaps * caps,
+                               GstVideoInfo * vinfo);
+};
+
+G_GNUC_INTERNAL GType gst_gap_source_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GAP_SOURCE_H_ */
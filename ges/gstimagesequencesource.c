@@ -0,0 +1,601 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* Source outputting the decoded frames of an image sequence.
+ *
+ * The frames following the current position are decoded in parallel by a
+ * pool of workers into a ring of "window-size" frames, the streaming thread
+ * only waits for the next frame to be ready. Seeking discards the window and
+ * restarts decoding from the new position. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstimagesequencesource.h"
+#include "ges-internal.h"
+
+GST_DEBUG_CATEGORY_STATIC (imagesequencesource_debug);
+#define GST_CAT_DEFAULT imagesequencesource_debug
+
+#define DEFAULT_START_INDEX 0
+#define DEFAULT_STOP_INDEX -1
+#define DEFAULT_N_THREADS 0
+#define DEFAULT_WINDOW_SIZE 8
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_START_INDEX,
+  PROP_STOP_INDEX,
+  PROP_FRAMERATE,
+  PROP_N_THREADS,
+  PROP_WINDOW_SIZE,
+};
+
+typedef struct
+{
+  gint64 index;
+  guint generation;
+} DecodeJob;
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw")
+    );
+
+G_DEFINE_TYPE (GstImageSequenceSource, gst_image_sequence_source,
+    GST_TYPE_PUSH_SRC);
+
+static void
+clear_slot (GstImageSequenceSlot * slot)
+{
+  slot->index = -1;
+  slot->done = FALSE;
+  if (slot->sample)
+    gst_sample_unref (slot->sample);
+  slot->sample = NULL;
+  g_clear_error (&slot->error);
+}
+
+static gchar *
+get_filename (GstImageSequenceSource * self, gint64 index)
+{
+  gchar *filename;
+
+  GST_OBJECT_LOCK (self);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+  filename = g_strdup_printf (self->location, (gint) index);
+#pragma GCC diagnostic pop
+  GST_OBJECT_UNLOCK (self);
+
+  return filename;
+}
+
+/* Runs in the worker threads */
+static void
+decode_frame (DecodeJob * job, GstImageSequenceSource * self)
+{
+  gchar *filename;
+  gboolean missing = FALSE;
+  GstSample *sample = NULL;
+  GError *error = NULL;
+  GESImageDecoder *decoder;
+  GstImageSequenceSlot *slot;
+
+  g_mutex_lock (&self->lock);
+  if (job->generation != self->generation) {
+    g_mutex_unlock (&self->lock);
+    goto done;
+  }
+  /* At most one decoder per worker thread, reused from frame to frame */
+  decoder = g_queue_pop_head (&self->decoders);
+  g_mutex_unlock (&self->lock);
+
+  if (!decoder)
+    decoder = ges_image_decoder_new ();
+
+  filename = get_filename (self, job->index);
+  if (g_file_test (filename, G_FILE_TEST_EXISTS)) {
+    GST_LOG_OBJECT (self, "Decoding frame %" G_GINT64_FORMAT, job->index);
+    sample = ges_image_decoder_decode (decoder, filename, &error);
+  } else {
+    GST_DEBUG_OBJECT (self, "%s does not exist, the sequence ends at %"
+        G_GINT64_FORMAT, filename, job->index);
+    missing = TRUE;
+  }
+  g_free (filename);
+
+  g_mutex_lock (&self->lock);
+  g_queue_push_head (&self->decoders, decoder);
+  slot = &self->slots[job->index % self->n_slots];
+  if (job->generation == self->generation && slot->index == job->index) {
+    slot->done = TRUE;
+    slot->sample = sample;
+    slot->error = error;
+    if (missing)
+      self->end_index = MIN (self->end_index, job->index);
+    g_cond_broadcast (&self->cond);
+  } else {
+    if (sample)
+      gst_sample_unref (sample);
+    g_clear_error (&error);
+  }
+  g_mutex_unlock (&self->lock);
+
+done:
+  g_slice_free (DecodeJob, job);
+}
+
+/* Called with the lock taken */
+static void
+fill_window (GstImageSequenceSource * self)
+{
+  gint stop_index;
+
+  GST_OBJECT_LOCK (self);
+  stop_index = self->stop_index;
+  GST_OBJECT_UNLOCK (self);
+
+  while (self->queued_index < self->next_index + self->n_slots
+      && self->queued_index < self->end_index
+      && (stop_index < 0 || self->queued_index <= stop_index)) {
+    DecodeJob *job = g_slice_new (DecodeJob);
+    GstImageSequenceSlot *slot =
+        &self->slots[self->queued_index % self->n_slots];
+
+    clear_slot (slot);
+    slot->index = self->queued_index;
+    job->index = self->queued_index;
+    job->generation = self->generation;
+    g_thread_pool_push (self->pool, job, NULL);
+    self->queued_index++;
+  }
+}
+
+/* Called with the lock taken */
+static void
+reset_window (GstImageSequenceSource * self, gint64 index)
+{
+  guint i;
+
+  self->generation++;
+  for (i = 0; i < self->n_slots; i++)
+    clear_slot (&self->slots[i]);
+  self->next_index = self->queued_index = index;
+  self->end_index = G_MAXINT64;
+}
+
+static gboolean
+gst_image_sequence_source_start (GstBaseSrc * bsrc)
+{
+  gint start_index;
+  guint i, n_threads, window_size;
+  GError *error = NULL;
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (bsrc);
+
+  GST_OBJECT_LOCK (self);
+  if (!self->location) {
+    GST_OBJECT_UNLOCK (self);
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, (NULL),
+        ("No location set for the image sequence"));
+
+    return FALSE;
+  }
+  n_threads = self->n_threads ? self->n_threads : g_get_num_processors ();
+  window_size = self->window_size;
+  start_index = self->start_index;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+  self->n_slots = window_size;
+  self->slots = g_new0 (GstImageSequenceSlot, self->n_slots);
+  for (i = 0; i < self->n_slots; i++)
+    self->slots[i].index = -1;
+  reset_window (self, start_index);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  self->pool = g_thread_pool_new ((GFunc) decode_frame, self, n_threads,
+      FALSE, &error);
+  if (!self->pool) {
+    GST_ELEMENT_ERROR (self, RESOURCE, FAILED, (NULL),
+        ("Could not create decoding threads: %s", error->message));
+    g_clear_error (&error);
+
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_image_sequence_source_stop (GstBaseSrc * bsrc)
+{
+  guint i;
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (bsrc);
+
+  g_mutex_lock (&self->lock);
+  self->generation++;
+  g_mutex_unlock (&self->lock);
+
+  /* Pending decodings are outdated and return right away */
+  if (self->pool)
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+  self->pool = NULL;
+
+  g_mutex_lock (&self->lock);
+  for (i = 0; i < self->n_slots; i++)
+    clear_slot (&self->slots[i]);
+  g_clear_pointer (&self->slots, g_free);
+  self->n_slots = 0;
+  g_queue_foreach (&self->decoders, (GFunc) ges_image_decoder_free, NULL);
+  g_queue_clear (&self->decoders);
+  gst_caps_replace (&self->caps, NULL);
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_image_sequence_source_unlock (GstBaseSrc * bsrc)
+{
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (bsrc);
+
+  g_mutex_lock (&self->lock);
+  self->flushing = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_image_sequence_source_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (bsrc);
+
+  g_mutex_lock (&self->lock);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+/* Caps are only known once the first frame is decoded, they are set from
+ * create () */
+static gboolean
+gst_image_sequence_source_negotiate (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_image_sequence_source_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_image_sequence_source_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  gint64 index;
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (bsrc);
+
+  /* Frames are only decoded ahead of the playback position */
+  if (segment->rate < 0) {
+    GST_WARNING_OBJECT (self, "Reverse playback is not supported");
+
+    return FALSE;
+  }
+
+  segment->time = segment->start;
+
+  GST_OBJECT_LOCK (self);
+  index = self->start_index + gst_util_uint64_scale (segment->position,
+      self->fps_n, self->fps_d * GST_SECOND);
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+  if (self->slots && index != self->next_index) {
+    GST_DEBUG_OBJECT (self, "Restarting decoding from frame %" G_GINT64_FORMAT,
+        index);
+    reset_window (self, index);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_image_sequence_source_create (GstPushSrc * psrc, GstBuffer ** buffer)
+{
+  gint64 index;
+  GstCaps *caps;
+  GstBuffer *outbuf;
+  GstSample *sample;
+  GstImageSequenceSlot *slot;
+  gint start_index, stop_index, fps_n, fps_d;
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (psrc);
+
+  GST_OBJECT_LOCK (self);
+  start_index = self->start_index;
+  stop_index = self->stop_index;
+  fps_n = self->fps_n;
+  fps_d = self->fps_d;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+  fill_window (self);
+
+  index = self->next_index;
+  if (index >= self->end_index || (stop_index >= 0 && index > stop_index))
+    goto eos;
+
+  slot = &self->slots[index % self->n_slots];
+  while (!slot->done && !self->flushing)
+    g_cond_wait (&self->cond, &self->lock);
+
+  if (self->flushing) {
+    g_mutex_unlock (&self->lock);
+
+    return GST_FLOW_FLUSHING;
+  }
+
+  if (index >= self->end_index)
+    goto eos;
+
+  if (!slot->sample)
+    goto decode_error;
+
+  sample = slot->sample;
+  slot->sample = NULL;
+  clear_slot (slot);
+  self->next_index++;
+  fill_window (self);
+  g_mutex_unlock (&self->lock);
+
+  caps = gst_caps_copy (gst_sample_get_caps (sample));
+  gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION, fps_n, fps_d,
+      NULL);
+  if (!self->caps || !gst_caps_is_equal (caps, self->caps)) {
+    GST_DEBUG_OBJECT (self, "New caps %" GST_PTR_FORMAT, caps);
+    gst_caps_replace (&self->caps, caps);
+    if (!gst_base_src_set_caps (GST_BASE_SRC (self), caps)) {
+      gst_caps_unref (caps);
+      gst_sample_unref (sample);
+
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
+  }
+  gst_caps_unref (caps);
+
+  outbuf = gst_buffer_ref (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+  outbuf = gst_buffer_make_writable (outbuf);
+
+  GST_BUFFER_PTS (outbuf) = gst_util_uint64_scale (index - start_index,
+      fps_d * GST_SECOND, fps_n);
+  GST_BUFFER_DURATION (outbuf) = gst_util_uint64_scale (index - start_index +
+      1, fps_d * GST_SECOND, fps_n) - GST_BUFFER_PTS (outbuf);
+  GST_BUFFER_OFFSET (outbuf) = index - start_index;
+  GST_BUFFER_OFFSET_END (outbuf) = index - start_index + 1;
+  *buffer = outbuf;
+
+  return GST_FLOW_OK;
+
+eos:
+  {
+    g_mutex_unlock (&self->lock);
+    GST_DEBUG_OBJECT (self, "Reached the end of the sequence");
+
+    return GST_FLOW_EOS;
+  }
+
+decode_error:
+  {
+    GError *error = slot->error;
+
+    slot->error = NULL;
+    g_mutex_unlock (&self->lock);
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+        ("Could not decode frame %" G_GINT64_FORMAT ": %s", index,
+            error ? error->message : "unknown error"));
+    g_clear_error (&error);
+
+    return GST_FLOW_ERROR;
+  }
+}
+
+static void
+gst_image_sequence_source_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (property_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, self->location);
+      break;
+    case PROP_START_INDEX:
+      g_value_set_int (value, self->start_index);
+      break;
+    case PROP_STOP_INDEX:
+      g_value_set_int (value, self->stop_index);
+      break;
+    case PROP_FRAMERATE:
+      gst_value_set_fraction (value, self->fps_n, self->fps_d);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
+    case PROP_WINDOW_SIZE:
+      g_value_set_uint (value, self->window_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_image_sequence_source_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (property_id) {
+    case PROP_LOCATION:
+      g_free (self->location);
+      self->location = g_value_dup_string (value);
+      break;
+    case PROP_START_INDEX:
+      self->start_index = g_value_get_int (value);
+      break;
+    case PROP_STOP_INDEX:
+      self->stop_index = g_value_get_int (value);
+      break;
+    case PROP_FRAMERATE:
+      self->fps_n = gst_value_get_fraction_numerator (value);
+      self->fps_d = gst_value_get_fraction_denominator (value);
+      break;
+    case PROP_N_THREADS:
+      self->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_WINDOW_SIZE:
+      self->window_size = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_image_sequence_source_finalize (GObject * object)
+{
+  GstImageSequenceSource *self = GST_IMAGE_SEQUENCE_SOURCE (object);
+
+  g_free (self->location);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (gst_image_sequence_source_parent_class)->finalize (object);
+}
+
+static void
+gst_image_sequence_source_class_init (GstImageSequenceSourceClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSrcClass *base_src_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *push_src_class = GST_PUSH_SRC_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (imagesequencesource_debug, "gesimagesequencesrc",
+      GST_DEBUG_FG_YELLOW, "ges image sequence source");
+
+  gobject_class->get_property = gst_image_sequence_source_get_property;
+  gobject_class->set_property = gst_image_sequence_source_set_property;
+  gobject_class->finalize = gst_image_sequence_source_finalize;
+
+  base_src_class->start = GST_DEBUG_FUNCPTR (gst_image_sequence_source_start);
+  base_src_class->stop = GST_DEBUG_FUNCPTR (gst_image_sequence_source_stop);
+  base_src_class->unlock = GST_DEBUG_FUNCPTR (gst_image_sequence_source_unlock);
+  base_src_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_image_sequence_source_unlock_stop);
+  base_src_class->negotiate =
+      GST_DEBUG_FUNCPTR (gst_image_sequence_source_negotiate);
+  base_src_class->is_seekable =
+      GST_DEBUG_FUNCPTR (gst_image_sequence_source_is_seekable);
+  base_src_class->do_seek =
+      GST_DEBUG_FUNCPTR (gst_image_sequence_source_do_seek);
+  push_src_class->create = GST_DEBUG_FUNCPTR (gst_image_sequence_source_create);
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "Location",
+          "Pattern to create the file names of the frames, the frame index is "
+          "passed as an integer", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_START_INDEX,
+      g_param_spec_int ("start-index", "Start index",
+          "Index of the first frame of the sequence", 0, G_MAXINT,
+          DEFAULT_START_INDEX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STOP_INDEX,
+      g_param_spec_int ("stop-index", "Stop index",
+          "Index of the last frame of the sequence, -1 to stop at the first "
+          "missing file", -1, G_MAXINT, DEFAULT_STOP_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAMERATE,
+      gst_param_spec_fraction ("framerate", "Framerate",
+          "Framerate of the sequence", 1, 1, G_MAXINT, 1, 25, 1,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstImageSequenceSource:n-threads:
+   *
+   * The number of frames decoded in parallel, 0 to use as many threads
+   * as there are processors
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of decoding threads, 0 for one per processor", 0, G_MAXINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstImageSequenceSource:window-size:
+   *
+   * The number of upcoming frames decoded ahead of the playback position,
+   * bounds the memory used by the read-ahead
+   */
+  g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
+      g_param_spec_uint ("window-size", "Window size",
+          "Number of frames decoded ahead", 1, G_MAXINT16,
+          DEFAULT_WINDOW_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "GES image sequence source", "Source/Video",
+      "Decodes the frames of an image sequence ahead, in parallel",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_image_sequence_source_init (GstImageSequenceSource * self)
+{
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->start_index = DEFAULT_START_INDEX;
+  self->stop_index = DEFAULT_STOP_INDEX;
+  self->fps_n = 25;
+  self->fps_d = 1;
+  self->n_threads = DEFAULT_N_THREADS;
+  self->window_size = DEFAULT_WINDOW_SIZE;
+
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+}
@@ -0,0 +1,88 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_IMAGE_SEQUENCE_SOURCE_H_
+#define _GST_IMAGE_SEQUENCE_SOURCE_H_
+
+#include <gst/base/gstpushsrc.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_IMAGE_SEQUENCE_SOURCE   (gst_image_sequence_source_get_type())
+#define GST_IMAGE_SEQUENCE_SOURCE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_IMAGE_SEQUENCE_SOURCE,GstImageSequenceSource))
+#define GST_IMAGE_SEQUENCE_SOURCE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_IMAGE_SEQUENCE_SOURCE,GstImageSequenceSourceClass))
+#define GST_IS_IMAGE_SEQUENCE_SOURCE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_IMAGE_SEQUENCE_SOURCE))
+#define GST_IS_IMAGE_SEQUENCE_SOURCE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_IMAGE_SEQUENCE_SOURCE))
+
+typedef struct _GstImageSequenceSource GstImageSequenceSource;
+typedef struct _GstImageSequenceSourceClass GstImageSequenceSourceClass;
+
+typedef struct
+{
+  /* Index of the frame decoded in the slot, -1 if the slot is free */
+  gint64 index;
+  gboolean done;
+  GstSample *sample;
+  GError *error;
+} GstImageSequenceSlot;
+
+struct _GstImageSequenceSource
+{
+  GstPushSrc parent;
+
+  /* Properties, protected by the object lock */
+  gchar *location;
+  gint start_index;
+  gint stop_index;
+  gint fps_n, fps_d;
+  guint n_threads;
+  guint window_size;
+
+  GThreadPool *pool;
+
+  /* Protects everything below, signaled when a frame is decoded */
+  GMutex lock;
+  GCond cond;
+  /* Ring of window_size frames being decoded, frame N lives in slot
+   * N % window_size */
+  GstImageSequenceSlot *slots;
+  guint n_slots;
+  /* The next frame to output and the next frame to decode */
+  gint64 next_index;
+  gint64 queued_index;
+  /* First missing frame, the sequence ends there */
+  gint64 end_index;
+  /* Incremented on seeks so that outdated decodings are discarded */
+  guint generation;
+  gboolean flushing;
+  /* Decoders not in use by a worker thread */
+  GQueue decoders;
+
+  GstCaps *caps;
+};
+
+struct _GstImageSequenceSourceClass
+{
+  GstPushSrcClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_image_sequence_source_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_IMAGE_SEQUENCE_SOURCE_H_ */
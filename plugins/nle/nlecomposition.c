@@ -50,6 +50,8 @@ enum
 {
   PROP_0,
   PROP_DEACTIVATED_ELEMENTS_STATE,
+  PROP_STACK_SWITCHES,
+  PROP_STACK_SWITCH_TIME,
   PROP_LAST,
 };
 
@@ -198,6 +200,11 @@ struct _NleCompositionPrivate
   gboolean tearing_down_stack;
 
   NleUpdateStackReason updating_reason;
+
+  /* Stack switches statistics, protected by the object lock */
+  GstClockTime stack_switch_start;
+  guint64 n_stack_switches;
+  GstClockTime stack_switch_time;
 };
 
 #define ACTION_CALLBACK(__action) (((GCClosure*) (__action))->callback)
@@ -216,6 +223,8 @@ G_DEFINE_TYPE_WITH_CODE (NleComposition, nle_composition, NLE_TYPE_OBJECT,
 
 static void nle_composition_dispose (GObject * object);
 static void nle_composition_finalize (GObject * object);
+static void nle_composition_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static void nle_composition_reset (NleComposition * comp);
 
 static gboolean nle_composition_add_object (GstBin * bin, GstElement * element);
@@ -979,6 +988,8 @@ nle_composition_class_init (NleCompositionClass * klass)
 
   gobject_class->dispose = GST_DEBUG_FUNCPTR (nle_composition_dispose);
   gobject_class->finalize = GST_DEBUG_FUNCPTR (nle_composition_finalize);
+  gobject_class->get_property =
+      GST_DEBUG_FUNCPTR (nle_composition_get_property);
 
   gstelement_class->change_state = nle_composition_change_state;
 
@@ -1000,6 +1011,27 @@ nle_composition_class_init (NleCompositionClass * klass)
   nleobject_properties[NLEOBJECT_PROP_DURATION] =
       g_object_class_find_property (gobject_class, "duration");
 
+  /**
+   * NleComposition:stack-switches:
+   *
+   * Number of times the stack of objects being played has been changed
+   */
+  g_object_class_install_property (gobject_class, PROP_STACK_SWITCHES,
+      g_param_spec_uint64 ("stack-switches", "Stack switches",
+          "Number of times the stack of objects being played has been changed",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * NleComposition:stack-switch-time:
+   *
+   * Total time spent setting up new stacks, from the moment a new stack
+   * is needed until data flows from it
+   */
+  g_object_class_install_property (gobject_class, PROP_STACK_SWITCH_TIME,
+      g_param_spec_uint64 ("stack-switch-time", "Stack switch time",
+          "Total time spent setting up new stacks", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   _signals[COMMITED_SIGNAL] =
       g_signal_new ("commited", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_FIRST,
       0, NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 1,
@@ -1033,6 +1065,7 @@ nle_composition_init (NleComposition * comp)
 
   priv->segment = gst_segment_new ();
   priv->seek_segment = gst_segment_new ();
+  priv->stack_switch_start = GST_CLOCK_TIME_NONE;
 
   g_rec_mutex_init (&comp->task_rec_lock);
 
@@ -1056,6 +1089,29 @@ nle_composition_init (NleComposition * comp)
       GST_DEBUG_FUNCPTR (nle_composition_event_handler));
 }
 
+static void
+nle_composition_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  NleComposition *comp = (NleComposition *) object;
+
+  switch (prop_id) {
+    case PROP_STACK_SWITCHES:
+      GST_OBJECT_LOCK (comp);
+      g_value_set_uint64 (value, comp->priv->n_stack_switches);
+      GST_OBJECT_UNLOCK (comp);
+      break;
+    case PROP_STACK_SWITCH_TIME:
+      GST_OBJECT_LOCK (comp);
+      g_value_set_uint64 (value, comp->priv->stack_switch_time);
+      GST_OBJECT_UNLOCK (comp);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 _remove_each_nleobj (gpointer data, gpointer udata)
 {
@@ -2272,6 +2328,13 @@ _restart_task (NleComposition * comp)
 
   comp->priv->updating_reason = COMP_UPDATE_STACK_NONE;
   GST_OBJECT_LOCK (comp);
+  if (GST_CLOCK_TIME_IS_VALID (comp->priv->stack_switch_start)) {
+    comp->priv->n_stack_switches++;
+    comp->priv->stack_switch_time +=
+        gst_util_get_timestamp () - comp->priv->stack_switch_start;
+    comp->priv->stack_switch_start = GST_CLOCK_TIME_NONE;
+  }
+
   if (comp->task)
     gst_task_start (comp->task);
   GST_OBJECT_UNLOCK (comp);
@@ -3096,6 +3159,10 @@ update_pipeline (NleComposition * comp, GstClockTime currenttime, gint32 seqnum,
 
   /* If stacks are different, unlink/relink objects */
   if (!samestack) {
+    GST_OBJECT_LOCK (comp);
+    priv->stack_switch_start = gst_util_get_timestamp ();
+    GST_OBJECT_UNLOCK (comp);
+
     _dump_stack (comp, stack);
     _deactivate_stack (comp, _have_to_flush_downstream (update_reason));
     _relink_new_stack (comp, stack, toplevel_seek);
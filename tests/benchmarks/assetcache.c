@@ -0,0 +1,149 @@
+/* Gstreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Measures the contention on the asset cache: an increasing number of
+ * threads request assets that are already cached, as happens when several
+ * timelines get loaded in parallel, while one thread keeps adding new
+ * assets to the cache. */
+
+#include <ges/ges.h>
+
+#define NUM_REQUESTS 200000
+#define MAX_THREADS 16
+/* Per run, cached assets are never freed */
+#define MAX_NEW_ASSETS 20000
+
+typedef struct
+{
+  GType type;
+  const gchar *id;
+} Request;
+
+static const gchar *transitions[] = {
+  "crossfade", "bar-wipe-lr", "bar-wipe-tb", "box-wipe-tl", "box-wipe-tr",
+  "box-wipe-br", "box-wipe-bl", "four-box-wipe-ci", "four-box-wipe-co",
+  "barndoor-v", "barndoor-h", "misc-diagonal-dbd", "iris-rect",
+  "clock-cw12", NULL
+};
+
+static Request *requests;
+static guint n_requests;
+static volatile gint stop_writing;
+
+static gpointer
+request_assets (gpointer unused)
+{
+  guint i;
+
+  for (i = 0; i < NUM_REQUESTS; i++) {
+    Request *request = &requests[i % n_requests];
+    GESAsset *asset = ges_asset_request (request->type, request->id, NULL);
+
+    if (!asset)
+      g_error ("Could not get asset %s", request->id);
+    gst_object_unref (asset);
+  }
+
+  return NULL;
+}
+
+/* Adds new assets to the cache, as discovering media does */
+static gpointer
+add_assets (gpointer unused)
+{
+  guint i = 0;
+  static guint n_assets = 0;
+
+  while (!g_atomic_int_get (&stop_writing) && i++ < MAX_NEW_ASSETS) {
+    gchar *id = g_strdup_printf ("assetcache-benchmark-%u", n_assets++);
+    GESAsset *asset = ges_asset_request (GES_TYPE_TIMELINE, id, NULL);
+
+    if (asset)
+      gst_object_unref (asset);
+    g_free (id);
+  }
+
+  return GUINT_TO_POINTER (MIN (i, MAX_NEW_ASSETS));
+}
+
+static void
+run (guint n_threads, gboolean with_writer)
+{
+  guint i, added = 0;
+  GThread *threads[MAX_THREADS], *writer = NULL;
+  GstClockTime start, elapsed;
+
+  g_atomic_int_set (&stop_writing, FALSE);
+  if (with_writer)
+    writer = g_thread_new ("writer", add_assets, NULL);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_new ("reader", request_assets, NULL);
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+  elapsed = gst_util_get_timestamp () - start;
+
+  if (writer) {
+    g_atomic_int_set (&stop_writing, TRUE);
+    added = GPOINTER_TO_UINT (g_thread_join (writer));
+  }
+
+  g_print ("%" GST_TIME_FORMAT " - %u threads doing %u requests each, "
+      "%.0f requests/s", GST_TIME_ARGS (elapsed), n_threads, NUM_REQUESTS,
+      (gdouble) n_threads * NUM_REQUESTS * GST_SECOND / MAX (elapsed, 1));
+  if (writer)
+    g_print (" (%u assets added meanwhile)", added);
+  g_print ("\n");
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint i, n_threads;
+  GArray *array = g_array_new (FALSE, FALSE, sizeof (Request));
+  Request request;
+
+  gst_init (&argc, &argv);
+  ges_init ();
+
+  /* Warm the cache up */
+  request.type = GES_TYPE_TEST_CLIP;
+  request.id = NULL;
+  g_array_append_val (array, request);
+  request.type = GES_TYPE_TITLE_CLIP;
+  g_array_append_val (array, request);
+  for (i = 0; transitions[i]; i++) {
+    request.type = GES_TYPE_TRANSITION_CLIP;
+    request.id = transitions[i];
+    g_array_append_val (array, request);
+  }
+  n_requests = array->len;
+  requests = (Request *) g_array_free (array, FALSE);
+  request_assets (NULL);
+
+  for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+    run (n_threads, FALSE);
+  for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+    run (n_threads, TRUE);
+
+  g_free (requests);
+  ges_deinit ();
+
+  return 0;
+}
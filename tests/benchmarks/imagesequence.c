@@ -0,0 +1,126 @@
+/* Gstreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Measures the decoding throughput of image sequences: a synthetic PNG
+ * sequence is generated and then decoded with an increasing number of
+ * read-ahead threads. */
+
+#include <glib/gstdio.h>
+#include <ges/ges.h>
+
+#define NUM_FRAMES 100
+#define WIDTH 1920
+#define HEIGHT 1080
+
+static gboolean
+run_pipeline (const gchar * description, GstClockTime * elapsed)
+{
+  GstBus *bus;
+  GstMessage *message;
+  GstClockTime start;
+  GError *err = NULL;
+  gboolean ret = TRUE;
+  GstElement *pipeline = gst_parse_launch (description, &err);
+
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+
+    return FALSE;
+  }
+
+  bus = gst_element_get_bus (pipeline);
+  start = gst_util_get_timestamp ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (elapsed)
+    *elapsed = gst_util_get_timestamp () - start;
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (message, &err, NULL);
+    g_printerr ("ERROR: %s\n", err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint i, n_threads, max_threads;
+  gchar *dir, *location, *description;
+  GstClockTime elapsed;
+  GError *err = NULL;
+
+  gst_init (&argc, &argv);
+  ges_init ();
+
+  dir = g_dir_make_tmp ("ges-imagesequence-XXXXXX", &err);
+  if (!dir) {
+    g_printerr ("Could not create temporary directory: %s\n", err->message);
+    g_clear_error (&err);
+
+    return 1;
+  }
+
+  location = g_build_filename (dir, "%05d.png", NULL);
+  description = g_strdup_printf ("videotestsrc pattern=snow num-buffers=%d "
+      "! video/x-raw,width=%d,height=%d ! pngenc ! multifilesink "
+      "location=\"%s\"", NUM_FRAMES, WIDTH, HEIGHT, location);
+  if (!run_pipeline (description, NULL))
+    goto done;
+  g_free (description);
+  description = NULL;
+
+  max_threads = g_get_num_processors ();
+  for (n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    description = g_strdup_printf ("gesimagesequencesrc location=\"%s\" "
+        "n-threads=%u window-size=%u ! fakesink sync=false", location,
+        n_threads, MAX (8, 2 * n_threads));
+    if (!run_pipeline (description, &elapsed))
+      goto done;
+
+    g_print ("%u threads: %" GST_TIME_FORMAT " - %.2f frames per second\n",
+        n_threads, GST_TIME_ARGS (elapsed),
+        (gdouble) NUM_FRAMES * GST_SECOND / MAX (elapsed, 1));
+    g_free (description);
+    description = NULL;
+  }
+
+done:
+  g_free (description);
+  for (i = 0; i < NUM_FRAMES; i++) {
+    gchar *filename = g_strdup_printf ("%s/%05u.png", dir, i);
+
+    g_unlink (filename);
+    g_free (filename);
+  }
+  g_rmdir (dir);
+  g_free (location);
+  g_free (dir);
+
+  return 0;
+}
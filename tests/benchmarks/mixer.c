@@ -0,0 +1,122 @@
+/* Gstreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Measures the per buffer overhead of the smart video mixer: frames are tiny
+ * so that the time spent positioning the mixer pads from the framepositioner
+ * metas dominates over the actual compositing. */
+
+#include <ges/ges.h>
+
+#define NUM_LAYERS 16
+#define NUM_FRAMES 3000
+#define FRAMERATE 1000
+
+static guint n_buffers = 0;
+
+static GstPadProbeReturn
+count_buffers_cb (GstPad * pad, GstPadProbeInfo * info, gpointer udata)
+{
+  n_buffers++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint i, n_layers = NUM_LAYERS;
+  GESAsset *asset;
+  GESTimeline *timeline;
+  GESTrack *track;
+  GESPipeline *pipeline;
+  GstElement *sink;
+  GstPad *sinkpad;
+  GstBus *bus;
+  GstMessage *message;
+  GstCaps *caps;
+  GstClockTime start, end, duration;
+
+  gst_init (&argc, &argv);
+  ges_init ();
+
+  if (argc > 1)
+    n_layers = MAX (1, g_ascii_strtoull (argv[1], NULL, 10));
+
+  duration = gst_util_uint64_scale (NUM_FRAMES, GST_SECOND, FRAMERATE);
+  timeline = ges_timeline_new ();
+  track = GES_TRACK (ges_video_track_new ());
+  caps = gst_caps_new_simple ("video/x-raw", "width", G_TYPE_INT, 16,
+      "height", G_TYPE_INT, 16, "framerate", GST_TYPE_FRACTION, FRAMERATE, 1,
+      NULL);
+  ges_track_set_restriction_caps (track, caps);
+  gst_caps_unref (caps);
+  ges_timeline_add_track (timeline, track);
+
+  asset = ges_asset_request (GES_TYPE_TEST_CLIP, NULL, NULL);
+  for (i = 0; i < n_layers; i++) {
+    GESLayer *layer = ges_timeline_append_layer (timeline);
+    GESClip *clip = ges_layer_add_asset (layer, asset, 0, 0, duration,
+        GES_TRACK_TYPE_VIDEO);
+
+    ges_timeline_element_set_child_properties (GES_TIMELINE_ELEMENT (clip),
+        "posx", i % 4, "posy", i / 4, "width", 8, "height", 8, NULL);
+  }
+  gst_object_unref (asset);
+
+  pipeline = ges_pipeline_new ();
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER, count_buffers_cb,
+      NULL, NULL);
+  gst_object_unref (sinkpad);
+  ges_pipeline_preview_set_video_sink (pipeline, sink);
+  ges_pipeline_set_timeline (pipeline, timeline);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED);
+  gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+      GST_CLOCK_TIME_NONE);
+
+  bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+  start = gst_util_get_timestamp ();
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  end = gst_util_get_timestamp ();
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (message, &err, NULL);
+    g_printerr ("ERROR: %s\n", err->message);
+    g_clear_error (&err);
+  } else {
+    g_print ("%" GST_TIME_FORMAT " - mixing %u frames of %u layers, %"
+        G_GUINT64_FORMAT " ns per mixed frame, %" G_GUINT64_FORMAT
+        " ns per input buffer\n", GST_TIME_ARGS (end - start), n_buffers,
+        n_layers, (end - start) / MAX (n_buffers, 1),
+        (end - start) / MAX ((guint64) n_buffers * n_layers, 1));
+  }
+
+  gst_message_unref (message);
+  gst_object_unref (bus);
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return 0;
+}
@@ -23,6 +23,7 @@
 #include "../../../ges/ges-internal.h"
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 
 static GMainLoop *mainloop;
 
@@ -308,6 +309,260 @@ GST_START_TEST (test_proxy_asset)
 
 GST_END_TEST;
 
+static void
+check_playback_uris (GESPipeline * pipeline, const gchar * expected_uri)
+{
+  GValue item = G_VALUE_INIT;
+  guint n_decodebins = 0;
+  GstIterator *it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    GstElement *element = g_value_get_object (&item);
+    GstElementFactory *factory = gst_element_get_factory (element);
+
+    if (factory && !g_strcmp0 (GST_OBJECT_NAME (factory), "uridecodebin")) {
+      gchar *uri;
+
+      g_object_get (element, "uri", &uri, NULL);
+      assert_equals_string (uri, expected_uri);
+      g_free (uri);
+      n_decodebins++;
+    }
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  /* One for the audio source and one for the video source */
+  assert_equals_int (n_decodebins, 2);
+}
+
+static gchar *
+copy_test_file (const gchar * filename, const gchar * dest_filename)
+{
+  gsize length;
+  gchar *contents, *path, *uri;
+  gchar *src_uri = ges_test_file_uri (filename);
+
+  path = g_filename_from_uri (src_uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  g_free (path);
+
+  path = g_build_filename (g_get_tmp_dir (), dest_filename, NULL);
+  fail_unless (g_file_set_contents (path, contents, length, NULL));
+  uri = gst_filename_to_uri (path, NULL);
+
+  g_free (path);
+  g_free (contents);
+  g_free (src_uri);
+
+  return uri;
+}
+
+GST_START_TEST (test_uri_clip_proxy_in_pipeline)
+{
+  gchar *uri, *proxy_uri, *output_uri;
+  GESLayer *layer;
+  GESClip *clip;
+  GESPipeline *pipeline;
+  GESTimeline *timeline;
+  GESAsset *asset, *proxy;
+  GstEncodingProfile *profile;
+
+  ges_init ();
+
+  uri = ges_test_file_uri ("audio_video.ogg");
+  proxy_uri = copy_test_file ("audio_video.ogg", "ges-proxy-test.ogg");
+  output_uri = ges_test_get_tmp_uri ("ges-proxy-test-render.ogg");
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+
+  asset = GES_ASSET (ges_uri_clip_asset_request_sync (uri, NULL));
+  fail_unless (GES_IS_ASSET (asset));
+  clip = ges_layer_add_asset (layer, asset, 0, 0, GST_SECOND,
+      GES_TRACK_TYPE_UNKNOWN);
+  fail_unless (ges_extractable_get_asset (GES_EXTRACTABLE (clip)) == asset);
+
+  /* Proxy set after the clip has been created */
+  proxy = GES_ASSET (ges_uri_clip_asset_request_sync (proxy_uri, NULL));
+  fail_unless (ges_asset_set_proxy (asset, proxy));
+  fail_unless (ges_extractable_get_asset (GES_EXTRACTABLE (clip)) == asset);
+
+  pipeline = ges_test_create_pipeline (timeline);
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+      GST_CLOCK_TIME_NONE);
+
+  /* Previewing plays the proxy, the clip keeps its asset so the project
+   * would be saved with the original media */
+  check_playback_uris (pipeline, proxy_uri);
+  fail_unless (ges_extractable_get_asset (GES_EXTRACTABLE (clip)) == asset);
+  fail_unless_equals_int (g_list_length (GES_CONTAINER_CHILDREN (clip)), 2);
+
+  /* Rendering plays the original media */
+  profile = ges_test_create_ogg_profile ();
+  fail_unless (ges_pipeline_set_render_settings (pipeline, output_uri,
+          profile));
+  fail_unless (ges_pipeline_set_mode (pipeline, GES_PIPELINE_MODE_RENDER));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+      GST_CLOCK_TIME_NONE);
+  check_playback_uris (pipeline, uri);
+  fail_unless (ges_extractable_get_asset (GES_EXTRACTABLE (clip)) == asset);
+
+  /* And previewing the proxy again */
+  fail_unless (ges_pipeline_set_mode (pipeline, GES_PIPELINE_MODE_PREVIEW));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+      GST_CLOCK_TIME_NONE);
+  check_playback_uris (pipeline, proxy_uri);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_encoding_profile_unref (profile);
+  gst_object_unref (asset);
+  gst_object_unref (proxy);
+  g_free (uri);
+  g_free (proxy_uri);
+  g_free (output_uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static void
+proxy_generated_cb (GESUriClipAsset * asset, GAsyncResult * res,
+    GMainLoop * mainloop)
+{
+  GError *error = NULL;
+
+  fail_if (ges_uri_clip_asset_generate_proxy_finish (asset, res, &error));
+  fail_unless (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED));
+  g_error_free (error);
+
+  g_main_loop_quit (mainloop);
+}
+
+GST_START_TEST (test_uri_clip_proxy_generation_cancelled)
+{
+  gchar *uri, *proxy_uri, *proxy_path;
+  GESUriClipAsset *asset;
+  GCancellable *cancellable;
+  GMainLoop *mainloop;
+
+  ges_init ();
+
+  uri = ges_test_file_uri ("audio_video.ogg");
+  proxy_uri = ges_test_get_tmp_uri ("ges-proxy-cancelled.mkv");
+  proxy_path = g_filename_from_uri (proxy_uri, NULL, NULL);
+  g_unlink (proxy_path);
+
+  asset = ges_uri_clip_asset_request_sync (uri, NULL);
+  fail_unless (GES_IS_URI_CLIP_ASSET (asset));
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  cancellable = g_cancellable_new ();
+  ges_uri_clip_asset_generate_proxy (asset, proxy_uri, NULL, cancellable,
+      (GAsyncReadyCallback) proxy_generated_cb, mainloop);
+
+  /* The transcoding is already running at that point */
+  g_cancellable_cancel (cancellable);
+  g_main_loop_run (mainloop);
+
+  fail_if (ges_asset_get_proxy (GES_ASSET (asset)));
+  fail_if (g_file_test (proxy_path, G_FILE_TEST_EXISTS));
+
+  g_object_unref (cancellable);
+  g_main_loop_unref (mainloop);
+  gst_object_unref (asset);
+  g_free (proxy_path);
+  g_free (proxy_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static void
+proxy_generation_done_cb (GESUriClipAsset * asset, GAsyncResult * res,
+    GESUriClipAsset ** proxy)
+{
+  GError *error = NULL;
+
+  *proxy = ges_uri_clip_asset_generate_proxy_finish (asset, res, &error);
+  fail_unless (*proxy != NULL);
+  fail_if (error);
+}
+
+GST_START_TEST (test_uri_clip_proxy_generation)
+{
+  gchar *uri, *proxy_uri, *proxy_path;
+  GESLayer *layer;
+  GESClip *clip;
+  GESPipeline *pipeline;
+  GESTimeline *timeline;
+  GESUriClipAsset *asset, *proxy = NULL;
+  GstEncodingProfile *profile;
+
+  ges_init ();
+
+  uri = ges_test_file_uri ("audio_video.ogg");
+  proxy_uri = ges_test_get_tmp_uri ("ges-proxy-generated.ogg");
+  proxy_path = g_filename_from_uri (proxy_uri, NULL, NULL);
+  g_unlink (proxy_path);
+
+  asset = ges_uri_clip_asset_request_sync (uri, NULL);
+  fail_unless (GES_IS_URI_CLIP_ASSET (asset));
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  clip = ges_layer_add_asset (layer, GES_ASSET (asset), 0, 0, GST_SECOND,
+      GES_TRACK_TYPE_UNKNOWN);
+
+  profile = ges_test_create_ogg_profile ();
+  ges_uri_clip_asset_generate_proxy (asset, proxy_uri, profile, NULL,
+      (GAsyncReadyCallback) proxy_generation_done_cb, &proxy);
+  while (!proxy)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* The proxy media has been written and is used by default */
+  assert_equals_string (ges_asset_get_id (GES_ASSET (proxy)), proxy_uri);
+  fail_unless (g_file_test (proxy_path, G_FILE_TEST_EXISTS));
+  fail_unless (ges_asset_get_proxy (GES_ASSET (asset)) == GES_ASSET (proxy));
+  fail_unless (ges_asset_get_proxy_target (GES_ASSET (proxy)) ==
+      GES_ASSET (asset));
+  fail_unless (GST_CLOCK_TIME_IS_VALID (ges_uri_clip_asset_get_duration
+          (proxy)));
+
+  /* Clips switch to it for previewing */
+  pipeline = ges_test_create_pipeline (timeline);
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE);
+  gst_element_get_state (GST_ELEMENT (pipeline), NULL, NULL,
+      GST_CLOCK_TIME_NONE);
+  check_playback_uris (pipeline, proxy_uri);
+  fail_unless (ges_extractable_get_asset (GES_EXTRACTABLE (clip)) ==
+      GES_ASSET (asset));
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_encoding_profile_unref (profile);
+  gst_object_unref (proxy);
+  gst_object_unref (asset);
+  g_unlink (proxy_path);
+  g_free (proxy_path);
+  g_free (proxy_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -322,6 +577,9 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_uri_clip_change_asset);
   tcase_add_test (tc_chain, test_list_asset);
   tcase_add_test (tc_chain, test_proxy_asset);
+  tcase_add_test (tc_chain, test_uri_clip_proxy_in_pipeline);
+  tcase_add_test (tc_chain, test_uri_clip_proxy_generation_cancelled);
+  tcase_add_test (tc_chain, test_uri_clip_proxy_generation);
 
   return s;
 }
@@ -0,0 +1,262 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "test-utils.h"
+#include "../../../ges/gstimagesequencesource.h"
+#include <ges/ges.h>
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
+
+#define FRAME_DURATION (GST_SECOND / 25)
+
+typedef struct
+{
+  gchar *dir;
+  gchar *location;
+  guint n_frames;
+} ImageSequence;
+
+/* Writes @n_frames copies of the test image */
+static ImageSequence *
+image_sequence_new (guint n_frames)
+{
+  guint i;
+  gsize length;
+  gchar *contents, *path;
+  ImageSequence *sequence = g_new0 (ImageSequence, 1);
+
+  path = ges_test_file_name ("image.png");
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  g_free (path);
+
+  sequence->dir = g_dir_make_tmp ("ges-image-sequence-XXXXXX", NULL);
+  fail_unless (sequence->dir != NULL);
+  sequence->location = g_build_filename (sequence->dir, "frame%d.png", NULL);
+  sequence->n_frames = n_frames;
+
+  for (i = 0; i < n_frames; i++) {
+    path = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "frame%d.png",
+        sequence->dir, i);
+    fail_unless (g_file_set_contents (path, contents, length, NULL));
+    g_free (path);
+  }
+  g_free (contents);
+
+  return sequence;
+}
+
+static void
+image_sequence_free (ImageSequence * sequence)
+{
+  guint i;
+
+  for (i = 0; i < sequence->n_frames; i++) {
+    gchar *path = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "frame%d.png",
+        sequence->dir, i);
+
+    g_unlink (path);
+    g_free (path);
+  }
+  g_rmdir (sequence->dir);
+
+  g_free (sequence->location);
+  g_free (sequence->dir);
+  g_free (sequence);
+}
+
+static GstHarness *
+create_harness (ImageSequence * sequence)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("gesimagesequencesrc", NULL,
+      "src");
+
+  g_object_set (h->element, "location", sequence->location, NULL);
+
+  return h;
+}
+
+/* Pulls @n_frames buffers, checking they are the frames following @offset */
+static void
+pull_frames (GstHarness * h, guint64 offset, guint n_frames)
+{
+  guint i;
+
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *buffer = gst_harness_pull (h);
+
+    fail_unless (buffer != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buffer), offset + i);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer),
+        (offset + i) * FRAME_DURATION);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buffer), FRAME_DURATION);
+    gst_buffer_unref (buffer);
+  }
+}
+
+static void
+wait_eos (GstHarness * h)
+{
+  GstEvent *event;
+
+  while ((event = gst_harness_pull_event (h))) {
+    GstEventType type = GST_EVENT_TYPE (event);
+
+    gst_event_unref (event);
+    if (type == GST_EVENT_EOS)
+      return;
+  }
+
+  fail ("No EOS received");
+}
+
+static guint
+get_generation (GstHarness * h)
+{
+  guint generation;
+  GstImageSequenceSource *src = GST_IMAGE_SEQUENCE_SOURCE (h->element);
+
+  g_mutex_lock (&src->lock);
+  generation = src->generation;
+  g_mutex_unlock (&src->lock);
+
+  return generation;
+}
+
+GST_START_TEST (test_image_sequence_end)
+{
+  GstHarness *h;
+  ImageSequence *sequence;
+
+  ges_init ();
+
+  sequence = image_sequence_new (5);
+  h = create_harness (sequence);
+  /* Smaller than the sequence so that the window has to move forward */
+  g_object_set (h->element, "window-size", 2, NULL);
+  gst_harness_play (h);
+
+  /* The sequence ends at the first missing file */
+  pull_frames (h, 0, 5);
+  wait_eos (h);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 5);
+
+  gst_harness_teardown (h);
+  image_sequence_free (sequence);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_image_sequence_stop_index)
+{
+  GstHarness *h;
+  ImageSequence *sequence;
+
+  ges_init ();
+
+  sequence = image_sequence_new (10);
+  h = create_harness (sequence);
+  g_object_set (h->element, "start-index", 2, "stop-index", 5, NULL);
+  gst_harness_play (h);
+
+  /* Frames 2 to 5 included, timestamped from the start index */
+  pull_frames (h, 0, 4);
+  wait_eos (h);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 4);
+
+  gst_harness_teardown (h);
+  image_sequence_free (sequence);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_image_sequence_seek)
+{
+  guint generation;
+  GstHarness *h;
+  GstEvent *event;
+  ImageSequence *sequence;
+
+  ges_init ();
+
+  sequence = image_sequence_new (10);
+  h = create_harness (sequence);
+  g_object_set (h->element, "window-size", 2, NULL);
+  gst_harness_play (h);
+
+  pull_frames (h, 0, 10);
+  wait_eos (h);
+
+  /* Seeking restarts decoding from the new position, and invalidates the
+   * decodings of the previous window */
+  generation = get_generation (h);
+  fail_unless (gst_harness_push_upstream_event (h,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+              GST_SEEK_TYPE_SET, 5 * FRAME_DURATION, GST_SEEK_TYPE_NONE,
+              GST_CLOCK_TIME_NONE)));
+  fail_unless (get_generation (h) > generation);
+
+  pull_frames (h, 5, 5);
+  wait_eos (h);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 15);
+
+  /* Seeking back within the sequence works the same way */
+  generation = get_generation (h);
+  fail_unless (gst_harness_push_upstream_event (h,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+              GST_SEEK_TYPE_SET, 2 * FRAME_DURATION, GST_SEEK_TYPE_NONE,
+              GST_CLOCK_TIME_NONE)));
+  fail_unless (get_generation (h) > generation);
+  pull_frames (h, 2, 8);
+  wait_eos (h);
+
+  /* Reverse playback is refused */
+  generation = get_generation (h);
+  event = gst_event_new_seek (-1.0, GST_FORMAT_TIME, 0, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_SET, 5 * FRAME_DURATION);
+  fail_if (gst_harness_push_upstream_event (h, event));
+  fail_unless_equals_int (get_generation (h), generation);
+
+  gst_harness_teardown (h);
+  image_sequence_free (sequence);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static Suite *
+ges_suite (void)
+{
+  Suite *s = suite_create ("ges-image-sequence-source");
+  TCase *tc_chain = tcase_create ("imagesequencesource");
+
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, test_image_sequence_end);
+  tcase_add_test (tc_chain, test_image_sequence_stop_index);
+  tcase_add_test (tc_chain, test_image_sequence_seek);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ges);
@@ -21,11 +21,21 @@
 #include "test-utils.h"
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
+#include <gst/audio/audio.h>
+#include <gst/check/gstharness.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
+#include <gst/controller/gstdirectcontrolbinding.h>
 
 #include <ges/ges-smart-adder.h>
 
 static GMainLoop *main_loop;
 
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
 GST_START_TEST (simple_smart_adder_test)
 {
   GstPad *requested_pad;
@@ -59,6 +69,477 @@ GST_START_TEST (simple_smart_adder_test)
 
 GST_END_TEST;
 
+GST_START_TEST (smart_adder_single_input_passthrough)
+{
+  GstCaps *caps;
+  GstBuffer *buffer;
+  GESTrack *track;
+  GstElement *smart_adder;
+  GstPad *srcpad, *sinkpad, *requested_pad;
+
+  ges_init ();
+
+  track = GES_TRACK (ges_audio_track_new ());
+  smart_adder = ges_smart_adder_new (track);
+  sinkpad = gst_check_setup_sink_pad (smart_adder, &sinktemplate);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  requested_pad = gst_element_get_request_pad (smart_adder, "sink_%u");
+  fail_unless (GST_IS_PAD (requested_pad));
+  srcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+  fail_unless_equals_int (gst_pad_link (srcpad, requested_pad),
+      GST_PAD_LINK_OK);
+  gst_pad_set_active (srcpad, TRUE);
+
+  fail_if (gst_element_set_state (smart_adder, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  caps = gst_caps_from_string ("audio/x-raw,format=" GST_AUDIO_NE (S32)
+      ",layout=interleaved,rate=44100,channels=2");
+  gst_check_setup_events (srcpad, smart_adder, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* With a single input, buffers should go through untouched */
+  buffer = gst_buffer_new_and_alloc (4410 * 8);
+  gst_buffer_memset (buffer, 0, 0, 4410 * 8);
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = 100 * GST_MSECOND;
+  fail_unless_equals_int (gst_pad_push (srcpad, gst_buffer_ref (buffer)),
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_unless (buffers->data == buffer);
+  gst_buffer_unref (buffer);
+
+  gst_element_set_state (smart_adder, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_unlink (srcpad, requested_pad);
+  gst_object_unref (srcpad);
+  gst_element_release_request_pad (smart_adder, requested_pad);
+  gst_object_unref (requested_pad);
+  gst_check_teardown_sink_pad (smart_adder);
+  gst_object_unref (smart_adder);
+  gst_object_unref (track);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static guint
+count_elements (GstElement * bin, const gchar * factory_name)
+{
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  gboolean done = FALSE;
+  guint count = 0;
+
+  it = gst_bin_iterate_recurse (GST_BIN (bin));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+      {
+        GstElementFactory *factory =
+            gst_element_get_factory (g_value_get_object (&item));
+
+        if (factory && !g_strcmp0 (GST_OBJECT_NAME (factory), factory_name))
+          count++;
+        g_value_reset (&item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        count = 0;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return count;
+}
+
+static GstPad *
+setup_adder_input (GstElement * smart_adder, GstPad ** requested_pad,
+    gint rate)
+{
+  GstCaps *caps;
+  GstPad *srcpad = gst_pad_new_from_static_template (&srctemplate, NULL);
+
+  *requested_pad = gst_element_get_request_pad (smart_adder, "sink_%u");
+  fail_unless (GST_IS_PAD (*requested_pad));
+  fail_unless_equals_int (gst_pad_link (srcpad, *requested_pad),
+      GST_PAD_LINK_OK);
+  gst_pad_set_active (srcpad, TRUE);
+
+  caps = gst_caps_new_simple ("audio/x-raw", "format", G_TYPE_STRING,
+      GST_AUDIO_NE (S16), "layout", G_TYPE_STRING, "interleaved", "rate",
+      G_TYPE_INT, rate, "channels", G_TYPE_INT, 2, NULL);
+  gst_check_setup_events (srcpad, smart_adder, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return srcpad;
+}
+
+static void
+teardown_adder_input (GstElement * smart_adder, GstPad * srcpad,
+    GstPad * requested_pad)
+{
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_unlink (srcpad, requested_pad);
+  gst_object_unref (srcpad);
+  gst_element_release_request_pad (smart_adder, requested_pad);
+  gst_object_unref (requested_pad);
+}
+
+GST_START_TEST (smart_adder_resamples_only_when_needed)
+{
+  GESTrack *track;
+  GstCaps *caps;
+  GstPadTemplate *templ;
+  GstElement *smart_adder;
+  GstPad *sinkpad, *srcpad1, *srcpad2, *requested_pad1, *requested_pad2;
+  GType convert_pad_type = g_type_from_name ("GstAudioAggregatorConvertPad");
+
+  ges_init ();
+
+  track = GES_TRACK (ges_audio_track_new ());
+  smart_adder = ges_smart_adder_new (track);
+  sinkpad = gst_check_setup_sink_pad (smart_adder, &sinktemplate);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_if (gst_element_set_state (smart_adder, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  templ = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS
+      (GES_SMART_ADDER (smart_adder)->adder), "sink_%u");
+  if (!convert_pad_type
+      || !g_type_is_a (GST_PAD_TEMPLATE_GTYPE (templ), convert_pad_type)) {
+    GST_INFO ("The adder does not convert its inputs, skipping test");
+    goto done;
+  }
+
+  /* Same rate as the restriction caps, the adder converts the format */
+  srcpad1 = setup_adder_input (smart_adder, &requested_pad1, 44100);
+  fail_unless_equals_int (count_elements (smart_adder, "audioconvert"), 0);
+  fail_unless_equals_int (count_elements (smart_adder, "audioresample"), 0);
+
+  srcpad2 = setup_adder_input (smart_adder, &requested_pad2, 48000);
+  fail_unless_equals_int (count_elements (smart_adder, "audioconvert"), 1);
+  fail_unless_equals_int (count_elements (smart_adder, "audioresample"), 1);
+
+  /* The output rate changes, the first input now needs resampling too,
+   * which is plugged as soon as something flows */
+  caps = gst_caps_from_string ("audio/x-raw,rate=48000");
+  ges_track_set_restriction_caps (track, caps);
+  gst_caps_unref (caps);
+  fail_unless_equals_int (count_elements (smart_adder, "audioresample"), 1);
+  fail_unless (gst_pad_push_event (srcpad1,
+          gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM,
+              gst_structure_new_empty ("test"))));
+  fail_unless_equals_int (count_elements (smart_adder, "audioresample"), 2);
+
+  teardown_adder_input (smart_adder, srcpad2, requested_pad2);
+  teardown_adder_input (smart_adder, srcpad1, requested_pad1);
+  fail_unless_equals_int (count_elements (smart_adder, "audioresample"), 0);
+
+done:
+  gst_element_set_state (smart_adder, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_check_teardown_sink_pad (smart_adder);
+  gst_object_unref (smart_adder);
+  gst_object_unref (track);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+/* Waits for the smart mixer under test to have output @n_buffers and
+ * returns the last of them */
+static GstBuffer *
+wait_for_output (guint n_buffers)
+{
+  GstBuffer *buffer;
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < n_buffers)
+    g_cond_wait (&check_cond, &check_mutex);
+  buffer = g_list_nth_data (buffers, n_buffers - 1);
+  g_mutex_unlock (&check_mutex);
+
+  return buffer;
+}
+
+/* Links a new pad to @smart_mixer, through @upstream if not %NULL */
+static GstPad *
+setup_bypass_input (GstElement * smart_mixer, GstElement * upstream,
+    GstPad ** requested_pad, const gchar * caps_str)
+{
+  GstCaps *caps;
+  GstPad *peer, *upstream_srcpad;
+  GstPad *srcpad = gst_pad_new_from_static_template (&srctemplate, NULL);
+
+  *requested_pad = gst_element_get_request_pad (smart_mixer, "sink_%u");
+  fail_unless (GST_IS_PAD (*requested_pad));
+  if (upstream) {
+    upstream_srcpad = gst_element_get_static_pad (upstream, "src");
+    fail_unless_equals_int (gst_pad_link (upstream_srcpad, *requested_pad),
+        GST_PAD_LINK_OK);
+    gst_object_unref (upstream_srcpad);
+    peer = gst_element_get_static_pad (upstream, "sink");
+  } else {
+    peer = gst_object_ref (*requested_pad);
+  }
+  fail_unless_equals_int (gst_pad_link (srcpad, peer), GST_PAD_LINK_OK);
+  gst_object_unref (peer);
+  gst_pad_set_active (srcpad, TRUE);
+
+  caps = gst_caps_from_string (caps_str);
+  gst_check_setup_events (srcpad, upstream ? upstream : smart_mixer, caps,
+      GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return srcpad;
+}
+
+static GstBuffer *
+create_audio_buffer (GstClockTime pts)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (4410 * 8);
+
+  gst_buffer_memset (buffer, 0, 0, 4410 * 8);
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = 100 * GST_MSECOND;
+
+  return buffer;
+}
+
+#define BYPASS_AUDIO_CAPS "audio/x-raw,format=" GST_AUDIO_NE (S32) \
+    ",layout=interleaved,rate=44100,channels=2"
+
+GST_START_TEST (smart_adder_bypass_enter_leave)
+{
+  GESTrack *track;
+  guint n_buffers = 1;
+  GstElement *smart_adder;
+  GstBuffer *bypassed, *output;
+  GstClockTime position = 100 * GST_MSECOND;
+  GstPad *sinkpad, *srcpad1, *srcpad2, *requested_pad1, *requested_pad2;
+
+  ges_init ();
+
+  track = GES_TRACK (ges_audio_track_new ());
+  smart_adder = ges_smart_adder_new (track);
+  sinkpad = gst_check_setup_sink_pad (smart_adder, &sinktemplate);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_if (gst_element_set_state (smart_adder, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  /* Single input, bypassing the adder */
+  srcpad1 = setup_bypass_input (smart_adder, NULL, &requested_pad1,
+      BYPASS_AUDIO_CAPS);
+  bypassed = create_audio_buffer (0);
+  fail_unless_equals_int (gst_pad_push (srcpad1, gst_buffer_ref (bypassed)),
+      GST_FLOW_OK);
+  fail_unless (wait_for_output (1) == bypassed);
+  gst_buffer_unref (bypassed);
+
+  /* A second input shows up, the adder takes over and outputs what comes
+   * after the bypassed buffer */
+  srcpad2 = setup_bypass_input (smart_adder, NULL, &requested_pad2,
+      BYPASS_AUDIO_CAPS);
+  fail_unless_equals_int (gst_pad_push (srcpad1,
+          create_audio_buffer (100 * GST_MSECOND)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_pad_push (srcpad2,
+          create_audio_buffer (100 * GST_MSECOND)), GST_FLOW_OK);
+  while (position < 200 * GST_MSECOND) {
+    output = wait_for_output (++n_buffers);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (output), position);
+    position += GST_BUFFER_DURATION (output);
+  }
+  fail_unless_equals_uint64 (position, 200 * GST_MSECOND);
+  teardown_adder_input (smart_adder, srcpad2, requested_pad2);
+
+  /* Once everything was mixed, back to bypassing */
+  bypassed = create_audio_buffer (200 * GST_MSECOND);
+  fail_unless_equals_int (gst_pad_push (srcpad1, gst_buffer_ref (bypassed)),
+      GST_FLOW_OK);
+  fail_unless (wait_for_output (++n_buffers) == bypassed);
+  gst_buffer_unref (bypassed);
+
+  teardown_adder_input (smart_adder, srcpad1, requested_pad1);
+  gst_element_set_state (smart_adder, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_check_teardown_sink_pad (smart_adder);
+  gst_object_unref (smart_adder);
+  gst_object_unref (track);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  guint n_buffers;
+  guint n_gaps;
+  GstClockTime gap_duration;
+} MixerInputCounts;
+
+static GstPadProbeReturn
+count_mixer_input_cb (GstPad * pad, GstPadProbeInfo * info,
+    MixerInputCounts * counts)
+{
+  GstClockTime pts, duration;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    counts->n_buffers++;
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_GAP) {
+    gst_event_parse_gap (GST_PAD_PROBE_INFO_EVENT (info), &pts, &duration);
+    counts->n_gaps++;
+    counts->gap_duration += duration;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (smart_adder_bypass_skips_adder)
+{
+  guint i;
+  GESTrack *track;
+  GstElement *smart_adder;
+  GstPad *internal;
+  MixerInputCounts counts = { 0, };
+  GstPad *sinkpad, *srcpad1, *srcpad2, *requested_pad1, *requested_pad2;
+
+  ges_init ();
+
+  track = GES_TRACK (ges_audio_track_new ());
+  smart_adder = ges_smart_adder_new (track);
+  sinkpad = gst_check_setup_sink_pad (smart_adder, &sinktemplate);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_if (gst_element_set_state (smart_adder, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  srcpad1 = setup_bypass_input (smart_adder, NULL, &requested_pad1,
+      BYPASS_AUDIO_CAPS);
+  internal = GST_PAD (gst_proxy_pad_get_internal (GST_PROXY_PAD
+          (requested_pad1)));
+  gst_pad_add_probe (internal, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) count_mixer_input_cb, &counts, NULL);
+  gst_object_unref (internal);
+
+  /* Nothing reaches the adder while it is bypassed */
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (gst_pad_push (srcpad1,
+            create_audio_buffer (i * 100 * GST_MSECOND)), GST_FLOW_OK);
+  wait_for_output (3);
+  fail_unless_equals_int (counts.n_buffers, 0);
+  fail_unless_equals_int (counts.n_gaps, 0);
+
+  /* When it takes over, a single GAP event covers what was bypassed */
+  srcpad2 = setup_bypass_input (smart_adder, NULL, &requested_pad2,
+      BYPASS_AUDIO_CAPS);
+  fail_unless_equals_int (gst_pad_push (srcpad1,
+          create_audio_buffer (300 * GST_MSECOND)), GST_FLOW_OK);
+  fail_unless_equals_int (counts.n_gaps, 1);
+  fail_unless_equals_uint64 (counts.gap_duration, 300 * GST_MSECOND);
+  fail_unless_equals_int (counts.n_buffers, 1);
+
+  teardown_adder_input (smart_adder, srcpad2, requested_pad2);
+  teardown_adder_input (smart_adder, srcpad1, requested_pad1);
+  gst_element_set_state (smart_adder, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_check_teardown_sink_pad (smart_adder);
+  gst_object_unref (smart_adder);
+  gst_object_unref (track);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static GstBuffer *
+push_video_frame (GstPad * srcpad, GstElement * positioner, gdouble alpha,
+    guint64 index)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, 64 * 48 * 4, NULL);
+
+  gst_buffer_memset (buffer, 0, 0xff, 64 * 48 * 4);
+  GST_BUFFER_PTS (buffer) = index * GST_SECOND / 25;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+  /* Marks our frames, the compositor does not set it */
+  GST_BUFFER_OFFSET (buffer) = 1000 + index;
+
+  g_object_set (positioner, "alpha", alpha, NULL);
+  fail_unless_equals_int (gst_pad_push (srcpad, buffer), GST_FLOW_OK);
+
+  return wait_for_output (index + 1);
+}
+
+GST_START_TEST (smart_mixer_bypass_enter_leave)
+{
+  GESTrack *track;
+  GstBuffer *output;
+  GstElement *smart_mixer, *positioner;
+  GstPad *sinkpad, *srcpad, *requested_pad;
+
+  ges_init ();
+
+  track = GES_TRACK (ges_video_track_new ());
+  smart_mixer = GES_TRACK_GET_CLASS (track)->get_mixing_element (track);
+  gst_object_ref_sink (smart_mixer);
+  sinkpad = gst_check_setup_sink_pad (smart_mixer, &sinktemplate);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  /* The mixer only gets frames with their positioning */
+  positioner = gst_object_ref_sink (gst_element_factory_make ("framepositioner",
+          NULL));
+  g_object_set (positioner, "width", 64, "height", 48, NULL);
+  fail_if (gst_element_set_state (smart_mixer, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (positioner, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+  srcpad = setup_bypass_input (smart_mixer, positioner, &requested_pad,
+      "video/x-raw,format=AYUV,width=64,height=48,framerate=25/1");
+
+  /* Opaque frame covering the whole output, bypassing the compositor */
+  output = push_video_frame (srcpad, positioner, 1.0, 0);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (output), 1000);
+
+  /* Translucent frame, the compositor blends it with the background */
+  output = push_video_frame (srcpad, positioner, 0.5, 1);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (output), GST_SECOND / 25);
+  fail_if (GST_BUFFER_OFFSET (output) == 1001);
+
+  /* Opaque again, bypassing again */
+  output = push_video_frame (srcpad, positioner, 1.0, 2);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (output), 2 * GST_SECOND / 25);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (output), 1002);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+
+  gst_element_set_state (smart_mixer, GST_STATE_NULL);
+  gst_element_set_state (positioner, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_pad_set_active (srcpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_element_unlink (positioner, smart_mixer);
+  gst_element_release_request_pad (smart_mixer, requested_pad);
+  gst_object_unref (requested_pad);
+  gst_check_teardown_sink_pad (smart_mixer);
+  gst_object_unref (smart_mixer);
+  gst_object_unref (positioner);
+  gst_object_unref (track);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static void
 message_received_cb (GstBus * bus, GstMessage * message, GstPipeline * pipeline)
 {
@@ -224,6 +705,334 @@ done:
 
 GST_END_TEST;
 
+static gboolean
+is_videoconvert (const GValue * value)
+{
+  GstElementFactory *factory =
+      gst_element_get_factory (g_value_get_object (value));
+
+  return factory && !g_strcmp0 (GST_OBJECT_NAME (factory), "videoconvert");
+}
+
+static gboolean
+has_converting_sink_pads (GstElement * element)
+{
+  GstPadTemplate *templ =
+      gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (element),
+      "sink_%u");
+  GType convert_pad_type = g_type_from_name ("GstVideoAggregatorConvertPad");
+
+  return templ && convert_pad_type
+      && g_type_is_a (GST_PAD_TEMPLATE_GTYPE (templ), convert_pad_type);
+}
+
+GST_START_TEST (video_mixer_converts_in_compositor)
+{
+  GstBus *bus;
+  GESAsset *asset;
+  GstMessage *message;
+  GESTimeline *timeline;
+  GESPipeline *pipeline;
+  GstIterator *it;
+  GValue item = G_VALUE_INIT;
+  GstElement *mixer = NULL;
+  guint n_converts = 0, n_sinkpads = 0;
+  gboolean done = FALSE, converting_mixer = FALSE;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  ges_timeline_add_track (timeline, GES_TRACK (ges_video_track_new ()));
+  pipeline = ges_test_create_pipeline (timeline);
+
+  asset = GES_ASSET (ges_asset_request (GES_TYPE_TEST_CLIP, NULL, NULL));
+  ges_layer_add_asset (ges_timeline_append_layer (timeline), asset, 0, 0,
+      GST_SECOND, GES_TRACK_TYPE_UNKNOWN);
+  ges_layer_add_asset (ges_timeline_append_layer (timeline), asset, 0, 0,
+      GST_SECOND, GES_TRACK_TYPE_UNKNOWN);
+  gst_object_unref (asset);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+      {
+        GstElement *element = g_value_get_object (&item);
+
+        if (!g_strcmp0 (G_OBJECT_TYPE_NAME (element), "GESSmartMixer"))
+          mixer = gst_object_ref (element);
+        g_value_reset (&item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        gst_clear_object (&mixer);
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+  fail_unless (mixer != NULL);
+
+  /* No per input conversion when the compositor does it while blending */
+  it = gst_bin_iterate_recurse (GST_BIN (mixer));
+  done = FALSE;
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        if (is_videoconvert (&item))
+          n_converts++;
+        else if (has_converting_sink_pads (g_value_get_object (&item)))
+          converting_mixer = TRUE;
+        g_value_reset (&item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        n_converts = 0;
+        converting_mixer = FALSE;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+  if (!converting_mixer) {
+    GST_INFO ("The compositor does not convert its inputs, skipping test");
+    goto cleanup;
+  }
+  fail_unless_equals_int (n_converts, 0);
+
+  /* The mixer inputs are directly ghosted to the compositor pads */
+  it = gst_element_iterate_sink_pads (mixer);
+  done = FALSE;
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+      {
+        GstPad *target =
+            gst_ghost_pad_get_target (GST_GHOST_PAD (g_value_get_object
+                (&item)));
+
+        fail_unless (target != NULL);
+        fail_unless (g_type_is_a (G_OBJECT_TYPE (target),
+                g_type_from_name ("GstVideoAggregatorConvertPad")));
+        n_sinkpads++;
+        gst_object_unref (target);
+        g_value_reset (&item);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        n_sinkpads = 0;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+  fail_unless_equals_int (n_sinkpads, 2);
+
+cleanup:
+  gst_object_unref (mixer);
+  gst_object_unref (bus);
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static gdouble
+push_and_get_alpha (GstHarness * h, GstClockTime pts)
+{
+  gdouble alpha;
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, 16 * 16 * 3 / 2, NULL);
+
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+  gst_buffer_unref (gst_harness_push_and_pull (h, buffer));
+  g_object_get (h->element, "alpha", &alpha, NULL);
+
+  return alpha;
+}
+
+GST_START_TEST (framepositioner_keyframes)
+{
+  GstHarness *h;
+  GstControlSource *source;
+  GstTimedValueControlSource *timed_source;
+
+  ges_init ();
+
+  h = gst_harness_new ("framepositioner");
+  gst_harness_set_src_caps_str (h,
+      "video/x-raw,format=I420,width=16,height=16,framerate=25/1");
+
+  source = gst_interpolation_control_source_new ();
+  g_object_set (source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  timed_source = GST_TIMED_VALUE_CONTROL_SOURCE (source);
+  gst_timed_value_control_source_set (timed_source, 0, 0.5);
+  gst_timed_value_control_source_set (timed_source, GST_SECOND, 0.5);
+  gst_timed_value_control_source_set (timed_source, 2 * GST_SECOND, 1.0);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new (GST_OBJECT (h->element), "alpha",
+          source));
+
+  /* Constant range, then interpolated values */
+  fail_unless_equals_float (push_and_get_alpha (h, 0), 0.5);
+  fail_unless_equals_float (push_and_get_alpha (h, GST_SECOND / 2), 0.5);
+  fail_unless (ABS (push_and_get_alpha (h, 3 * GST_SECOND / 2) - 0.75) <
+      1e-6);
+  fail_unless (ABS (push_and_get_alpha (h, 7 * GST_SECOND / 4) - 0.875) <
+      1e-6);
+
+  /* Changing keyframes is taken into account right away */
+  gst_timed_value_control_source_set (timed_source, GST_SECOND, 0.2);
+  fail_unless (ABS (push_and_get_alpha (h, 3 * GST_SECOND / 2) - 0.6) < 1e-6);
+  gst_timed_value_control_source_set (timed_source, 0, 0.2);
+  fail_unless (ABS (push_and_get_alpha (h, GST_SECOND / 2) - 0.2) < 1e-6);
+
+  gst_object_unref (source);
+  gst_harness_teardown (h);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static guint n_value_arrays = 0;
+static GstControlSourceGetValueArray interpolation_get_value_array = NULL;
+
+static gboolean
+counting_get_value_array (GstControlSource * source, GstClockTime timestamp,
+    GstClockTime interval, guint n_values, gdouble * values)
+{
+  n_value_arrays++;
+
+  return interpolation_get_value_array (source, timestamp, interval,
+      n_values, values);
+}
+
+GST_START_TEST (framepositioner_fractional_framerate)
+{
+  guint i;
+  gdouble alpha;
+  GstHarness *h;
+  GstBuffer *buffer;
+  GstControlSource *source;
+  GstTimedValueControlSource *timed_source;
+
+  ges_init ();
+
+  h = gst_harness_new ("framepositioner");
+  gst_harness_set_src_caps_str (h,
+      "video/x-raw,format=I420,width=16,height=16,framerate=30000/1001");
+
+  source = gst_interpolation_control_source_new ();
+  g_object_set (source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  interpolation_get_value_array = source->get_value_array;
+  source->get_value_array = counting_get_value_array;
+  timed_source = GST_TIMED_VALUE_CONTROL_SOURCE (source);
+  gst_timed_value_control_source_set (timed_source, 0, 0.0);
+  gst_timed_value_control_source_set (timed_source, 10 * GST_SECOND, 1.0);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new (GST_OBJECT (h->element), "alpha",
+          source));
+
+  /* Frame timestamps are rounded, and do not fall exactly on the block
+   * interval, the values are still all evaluated at once */
+  for (i = 0; i < 16; i++) {
+    GstClockTime pts = gst_util_uint64_scale (i, 1001 * GST_SECOND, 30000);
+
+    buffer = gst_buffer_new_allocate (NULL, 16 * 16 * 3 / 2, NULL);
+    GST_BUFFER_PTS (buffer) = pts;
+    GST_BUFFER_DURATION (buffer) = gst_util_uint64_scale (i + 1,
+        1001 * GST_SECOND, 30000) - pts;
+    gst_buffer_unref (gst_harness_push_and_pull (h, buffer));
+    g_object_get (h->element, "alpha", &alpha, NULL);
+    fail_unless (ABS (alpha - (gdouble) pts / (10 * GST_SECOND)) < 1e-6);
+  }
+  fail_unless_equals_int (n_value_arrays, 1);
+
+  gst_object_unref (source);
+  gst_harness_teardown (h);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static GstControlBinding *
+add_constant_alpha_binding (GstElement * element, gdouble value)
+{
+  GstControlBinding *binding;
+  GstControlSource *source = gst_interpolation_control_source_new ();
+
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (source),
+      0, value);
+  binding = gst_direct_control_binding_new (GST_OBJECT (element), "alpha",
+      source);
+  gst_object_add_control_binding (GST_OBJECT (element), binding);
+  gst_object_unref (source);
+
+  return binding;
+}
+
+GST_START_TEST (framepositioner_replace_binding)
+{
+  GstHarness *h;
+  GstControlBinding *binding;
+
+  ges_init ();
+
+  h = gst_harness_new ("framepositioner");
+  gst_harness_set_src_caps_str (h,
+      "video/x-raw,format=I420,width=16,height=16,framerate=25/1");
+
+  add_constant_alpha_binding (h->element, 0.5);
+  fail_unless (ABS (push_and_get_alpha (h, 0) - 0.5) < 1e-6);
+
+  /* Replacing the binding of the same property, the previous one is
+   * released and the new one must be used right away */
+  binding = add_constant_alpha_binding (h->element, 0.2);
+  fail_unless (ABS (push_and_get_alpha (h, GST_SECOND / 25) - 0.2) < 1e-6);
+
+  /* A disabled binding leaves the property alone */
+  gst_control_binding_set_disabled (binding, TRUE);
+  g_object_set (h->element, "alpha", 0.8, NULL);
+  fail_unless (ABS (push_and_get_alpha (h, 2 * GST_SECOND / 25) - 0.8) <
+      1e-6);
+
+  /* And is applied again once enabled */
+  gst_control_binding_set_disabled (binding, FALSE);
+  fail_unless (ABS (push_and_get_alpha (h, 3 * GST_SECOND / 25) - 0.2) <
+      1e-6);
+
+  gst_harness_teardown (h);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -233,8 +1042,17 @@ ges_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, simple_smart_adder_test);
+  tcase_add_test (tc_chain, smart_adder_single_input_passthrough);
+  tcase_add_test (tc_chain, smart_adder_resamples_only_when_needed);
+  tcase_add_test (tc_chain, smart_adder_bypass_enter_leave);
+  tcase_add_test (tc_chain, smart_adder_bypass_skips_adder);
+  tcase_add_test (tc_chain, smart_mixer_bypass_enter_leave);
   tcase_add_test (tc_chain, simple_audio_mixed_with_pipeline);
   tcase_add_test (tc_chain, audio_video_mixed_with_pipeline);
+  tcase_add_test (tc_chain, video_mixer_converts_in_compositor);
+  tcase_add_test (tc_chain, framepositioner_keyframes);
+  tcase_add_test (tc_chain, framepositioner_fractional_framerate);
+  tcase_add_test (tc_chain, framepositioner_replace_binding);
 
   return s;
 }
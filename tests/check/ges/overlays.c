@@ -207,6 +207,114 @@ GST_START_TEST (test_overlay_in_layer)
 
 GST_END_TEST;
 
+static GstPadProbeReturn
+collect_buffers_cb (GstPad * pad, GstPadProbeInfo * info, GList ** buffers)
+{
+  *buffers = g_list_append (*buffers,
+      gst_buffer_ref (GST_PAD_PROBE_INFO_BUFFER (info)));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean
+buffers_have_same_content (GstBuffer * buffer, GstBuffer * other)
+{
+  GstMapInfo map;
+  gboolean res;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  res = gst_buffer_get_size (other) == map.size
+      && !gst_buffer_memcmp (other, 0, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+
+  return res;
+}
+
+GST_START_TEST (test_overlay_reuses_rendered_text)
+{
+  GList *tmp, *rendered = NULL, *outputs = NULL;
+  GstBus *bus;
+  GstPad *pad;
+  GObject *text;
+  GstCaps *caps;
+  GstMessage *message;
+  GESLayer *layer;
+  GESTrack *track;
+  GESTimeline *timeline;
+  GESPipeline *pipeline;
+  GESTrackElement *track_element;
+  GESClip *clip, *background;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  track = GES_TRACK (ges_video_track_new ());
+  caps = gst_caps_from_string ("video/x-raw,width=64,height=48,"
+      "framerate=25/1");
+  ges_track_set_restriction_caps (track, caps);
+  gst_caps_unref (caps);
+  ges_timeline_add_track (timeline, track);
+  layer = ges_timeline_append_layer (timeline);
+
+  background = GES_CLIP (ges_test_clip_new ());
+  g_object_set (background, "duration", (guint64) 200 * GST_MSECOND,
+      "vpattern", GES_VIDEO_TEST_PATTERN_SOLID, NULL);
+  ges_layer_add_clip (layer, background);
+
+  clip = GES_CLIP (ges_text_overlay_clip_new ());
+  g_object_set (clip, "duration", (guint64) 200 * GST_MSECOND, "text",
+      "some text", NULL);
+  ges_layer_add_clip (layer, clip);
+
+  track_element = ges_clip_find_track_element (clip, track,
+      GES_TYPE_TEXT_OVERLAY);
+  fail_unless (ges_timeline_element_lookup_child (GES_TIMELINE_ELEMENT
+          (track_element), "text", &text, NULL));
+  /* Added after the probe of the render cache, so only sees the frames the
+   * text element itself renders the text on */
+  pad = gst_element_get_static_pad (GST_ELEMENT (text), "video_sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) collect_buffers_cb, &rendered, NULL);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (GST_ELEMENT (text), "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) collect_buffers_cb, &outputs, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (text);
+
+  pipeline = ges_test_create_pipeline (timeline);
+  bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* The text is rasterized once, its cached composition is then blended on
+   * all the following frames */
+  fail_unless_equals_int (g_list_length (rendered), 1);
+  fail_unless (g_list_length (outputs) > 1);
+  fail_if (buffers_have_same_content (rendered->data, outputs->data));
+  for (tmp = outputs->next; tmp; tmp = tmp->next) {
+    fail_unless (buffers_have_same_content (outputs->data, tmp->data));
+    fail_unless (GST_BUFFER_PTS (tmp->data) >
+        GST_BUFFER_PTS (tmp->prev->data));
+  }
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  g_list_free_full (rendered, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (outputs, (GDestroyNotify) gst_buffer_unref);
+  gst_object_unref (track_element);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -218,6 +326,7 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_overlay_basic);
   tcase_add_test (tc_chain, test_overlay_properties);
   tcase_add_test (tc_chain, test_overlay_in_layer);
+  tcase_add_test (tc_chain, test_overlay_reuses_rendered_text);
 
   return s;
 }
@@ -0,0 +1,605 @@
+/* GStreamer Editing Services
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "test-utils.h"
+#include <ges/ges.h>
+#include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+
+static GESTimeline *
+create_test_timeline (GstClockTime duration)
+{
+  GESAsset *asset;
+  GESTimeline *timeline = ges_timeline_new_audio_video ();
+  GESLayer *layer = ges_timeline_append_layer (timeline);
+
+  asset = ges_asset_request (GES_TYPE_TEST_CLIP, NULL, NULL);
+  fail_unless (ges_layer_add_asset (layer, asset, 0, 0, duration,
+          GES_TRACK_TYPE_UNKNOWN));
+  gst_object_unref (asset);
+
+  return timeline;
+}
+
+static GESPipeline *
+create_render_pipeline (GESTimeline * timeline, const gchar * output_uri,
+    GstClockTime checkpoint_interval)
+{
+  GstEncodingProfile *profile = ges_test_create_ogg_profile ();
+  GESPipeline *pipeline = ges_test_create_pipeline (timeline);
+
+  g_object_set (pipeline, "render-checkpoint-interval", checkpoint_interval,
+      NULL);
+  fail_unless (ges_pipeline_set_render_settings (pipeline, output_uri,
+          profile));
+  fail_unless (ges_pipeline_set_mode (pipeline, GES_PIPELINE_MODE_RENDER));
+  gst_encoding_profile_unref (profile);
+
+  return pipeline;
+}
+
+/* Index of a fragment from the location splitmuxsink reports */
+static gint
+get_fragment_index (GstMessage * message)
+{
+  const gchar *location, *suffix;
+
+  location = gst_structure_get_string (gst_message_get_structure (message),
+      "location");
+  fail_unless (location != NULL);
+  suffix = g_strrstr (location, ".part");
+  fail_unless (suffix != NULL);
+
+  return atoi (suffix + strlen (".part"));
+}
+
+/* Renders a timeline with checkpoints, interrupting the render once
+ * @stop_after fragments have been completed if it is not 0. Returns the
+ * index of the first fragment that was completed */
+static gint
+render_with_checkpoints (const gchar * output_uri, guint stop_after,
+    gboolean * reached_eos)
+{
+  GstBus *bus;
+  GESPipeline *pipeline;
+  guint n_completed = 0;
+  gint first_index = -1;
+  gboolean done = FALSE;
+
+  pipeline = create_render_pipeline (create_test_timeline (4 * GST_SECOND),
+      output_uri, GST_SECOND);
+  bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  *reached_eos = FALSE;
+  while (!done) {
+    GstMessage *message = gst_bus_timed_pop_filtered (bus, 60 * GST_SECOND,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_ELEMENT);
+
+    fail_unless (message != NULL, "Rendering timed out");
+    fail_if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR,
+        "Error while rendering");
+
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS) {
+      *reached_eos = done = TRUE;
+    } else if (gst_message_has_name (message, "splitmuxsink-fragment-closed")) {
+      if (first_index < 0)
+        first_index = get_fragment_index (message);
+      if (++n_completed == stop_after)
+        done = TRUE;
+    }
+    gst_message_unref (message);
+  }
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  return first_index;
+}
+
+static gsize
+get_n_checkpointed_fragments (const gchar * manifest_path)
+{
+  gchar **fragments;
+  gsize n_fragments = 0;
+  GKeyFile *manifest = g_key_file_new ();
+
+  fail_unless (g_key_file_load_from_file (manifest, manifest_path,
+          G_KEY_FILE_NONE, NULL));
+  fragments = g_key_file_get_string_list (manifest, "checkpoint", "fragments",
+      &n_fragments, NULL);
+  g_strfreev (fragments);
+  g_key_file_free (manifest);
+
+  return n_fragments;
+}
+
+GST_START_TEST (test_render_checkpoint_resume)
+{
+  gsize n_fragments;
+  gboolean reached_eos;
+  gchar *output_uri, *output_path, *manifest_path, *first_fragment_path;
+
+  ges_init ();
+
+  output_uri = ges_test_get_tmp_uri ("ges-checkpoint-test.ogg");
+  output_path = g_filename_from_uri (output_uri, NULL, NULL);
+  manifest_path = g_strconcat (output_path, ".checkpoint", NULL);
+  first_fragment_path = g_strconcat (output_path, ".part00000", NULL);
+  g_unlink (output_path);
+  g_unlink (manifest_path);
+
+  /* Interrupt the render once a fragment has been completed */
+  assert_equals_int (render_with_checkpoints (output_uri, 1, &reached_eos), 0);
+  fail_if (reached_eos);
+  fail_unless (g_file_test (first_fragment_path, G_FILE_TEST_IS_REGULAR));
+  n_fragments = get_n_checkpointed_fragments (manifest_path);
+  fail_unless (n_fragments >= 1);
+
+  /* Rendering the same timeline again only renders the remaining
+   * fragments and stitches everything into the output file */
+  assert_equals_int (render_with_checkpoints (output_uri, 0, &reached_eos),
+      n_fragments);
+  fail_unless (reached_eos);
+  fail_unless (g_file_test (output_path, G_FILE_TEST_IS_REGULAR));
+  fail_if (g_file_test (manifest_path, G_FILE_TEST_EXISTS));
+  fail_if (g_file_test (first_fragment_path, G_FILE_TEST_EXISTS));
+
+  g_unlink (output_path);
+  g_free (first_fragment_path);
+  g_free (manifest_path);
+  g_free (output_path);
+  g_free (output_uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_render_stats)
+{
+  GstBus *bus;
+  gchar *output_uri, *output_path;
+  GESPipeline *pipeline;
+  GstStructure *last_stats;
+  GstClockTime position;
+  guint n_stats = 0;
+  gboolean done = FALSE;
+
+  ges_init ();
+
+  output_uri = ges_test_get_tmp_uri ("ges-render-stats-test.ogg");
+  pipeline = create_render_pipeline (create_test_timeline (4 * GST_SECOND),
+      output_uri, 0);
+  g_object_set (pipeline, "render-stats-interval", 10 * GST_MSECOND, NULL);
+  fail_unless (ges_pipeline_get_render_stats (pipeline) == NULL);
+
+  bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  while (!done) {
+    const GstStructure *stats;
+    const GValue *tracks;
+    GstMessage *message = gst_bus_timed_pop_filtered (bus, 60 * GST_SECOND,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_ELEMENT);
+
+    fail_unless (message != NULL, "Rendering timed out");
+    fail_if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR,
+        "Error while rendering");
+
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS) {
+      done = TRUE;
+    } else if (gst_message_has_name (message, "ges-render-stats")) {
+      stats = gst_message_get_structure (message);
+
+      fail_unless (gst_structure_has_field_typed (stats, "position",
+              GST_TYPE_CLOCK_TIME));
+      fail_unless (gst_structure_has_field_typed (stats, "realtime-factor",
+              G_TYPE_DOUBLE));
+      fail_unless (gst_structure_has_field_typed (stats, "queues",
+              GST_TYPE_ARRAY));
+      fail_unless (gst_structure_has_field_typed (stats, "sources",
+              GST_TYPE_ARRAY));
+
+      /* One entry per rendered track */
+      tracks = gst_structure_get_value (stats, "tracks");
+      fail_unless (tracks != NULL && GST_VALUE_HOLDS_ARRAY (tracks));
+      assert_equals_int (gst_value_array_get_size (tracks), 2);
+      n_stats++;
+    }
+    gst_message_unref (message);
+  }
+
+  fail_unless (n_stats > 0, "No render stats were posted");
+
+  last_stats = ges_pipeline_get_render_stats (pipeline);
+  fail_unless (last_stats != NULL);
+  fail_unless (gst_structure_get_clock_time (last_stats, "position",
+          &position));
+  fail_unless (position > 0);
+  gst_structure_free (last_stats);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  output_path = g_filename_from_uri (output_uri, NULL, NULL);
+  g_unlink (output_path);
+  g_free (output_path);
+  g_free (output_uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static GstStaticPadTemplate audio_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw"));
+
+static gint
+compare_type_name (const GValue * value, const gchar * type_name)
+{
+  return g_strcmp0 (G_OBJECT_TYPE_NAME (g_value_get_object (value)),
+      type_name);
+}
+
+static GstElement *
+find_element (GstBin * bin, const gchar * type_name)
+{
+  GValue item = G_VALUE_INIT;
+  GstElement *element = NULL;
+  GstIterator *it = gst_bin_iterate_recurse (bin);
+
+  if (gst_iterator_find_custom (it, (GCompareFunc) compare_type_name, &item,
+          (gpointer) type_name)) {
+    element = g_value_dup_object (&item);
+    g_value_unset (&item);
+  }
+  gst_iterator_free (it);
+
+  return element;
+}
+
+static void
+pause_pipeline (GESPipeline * pipeline)
+{
+  GstMessage *message;
+  GstBus *bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message),
+      GST_MESSAGE_ASYNC_DONE);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+}
+
+/* Feeds the audio mixer of @pipeline with an input needing resampling and
+ * returns the quality of the resampler it plugged */
+static gint
+get_mixer_resample_quality (GESPipeline * pipeline)
+{
+  gint quality;
+  GstCaps *caps;
+  GstPad *srcpad, *sinkpad;
+  GstElement *adder, *resample;
+
+  adder = find_element (GST_BIN (pipeline), "GESSmartAdder");
+  fail_unless (adder != NULL);
+  sinkpad = gst_element_get_request_pad (adder, "sink_%u");
+  fail_unless (sinkpad != NULL);
+  srcpad = gst_pad_new_from_static_template (&audio_src_template, NULL);
+  fail_unless_equals_int (gst_pad_link (srcpad, sinkpad), GST_PAD_LINK_OK);
+  gst_pad_set_active (srcpad, TRUE);
+
+  /* The track outputs 44100Hz */
+  caps = gst_caps_from_string ("audio/x-raw,format=S16LE,"
+      "layout=interleaved,rate=8000,channels=2");
+  gst_check_setup_events (srcpad, adder, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  resample = find_element (GST_BIN (adder), "GstAudioResample");
+  fail_unless (resample != NULL);
+  g_object_get (resample, "quality", &quality, NULL);
+  gst_object_unref (resample);
+
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_unlink (srcpad, sinkpad);
+  gst_object_unref (srcpad);
+  gst_element_release_request_pad (adder, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (adder);
+
+  return quality;
+}
+
+GST_START_TEST (test_mixer_resample_quality)
+{
+  gchar *output_uri, *output_path;
+  GESPipeline *pipeline;
+
+  ges_init ();
+
+  /* Previewing favours speed */
+  pipeline = ges_test_create_pipeline (create_test_timeline (GST_SECOND));
+  pause_pipeline (pipeline);
+  assert_equals_int (get_mixer_resample_quality (pipeline), 0);
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  /* Rendering uses a better quality, but not the most expensive one */
+  output_uri = ges_test_get_tmp_uri ("ges-resample-quality-test.ogg");
+  pipeline = create_render_pipeline (create_test_timeline (GST_SECOND),
+      output_uri, 0);
+  pause_pipeline (pipeline);
+  assert_equals_int (get_mixer_resample_quality (pipeline), 6);
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  output_path = g_filename_from_uri (output_uri, NULL, NULL);
+  g_unlink (output_path);
+  g_free (output_path);
+  g_free (output_uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unused_track_not_prerolled)
+{
+  GList *tmp, *tracks;
+  GESPipeline *pipeline;
+  GESTimeline *timeline;
+
+  ges_init ();
+
+  timeline = create_test_timeline (GST_SECOND);
+  pipeline = ges_test_create_pipeline (timeline);
+  fail_unless (ges_pipeline_set_mode (pipeline,
+          GES_PIPELINE_MODE_PREVIEW_AUDIO));
+
+  /* Prerolling does not wait for the video track */
+  pause_pipeline (pipeline);
+
+  tracks = ges_timeline_get_tracks (timeline);
+  for (tmp = tracks; tmp; tmp = tmp->next) {
+    GstState state;
+    GstPad *pad = ges_timeline_get_pad_for_track (timeline, tmp->data);
+
+    fail_unless (pad != NULL);
+    fail_unless_equals_int (gst_element_get_state (tmp->data, &state, NULL,
+            0), GST_STATE_CHANGE_SUCCESS);
+    if (GES_TRACK (tmp->data)->type == GES_TRACK_TYPE_VIDEO) {
+      fail_if (gst_pad_is_linked (pad));
+      fail_unless_equals_int (state, GST_STATE_READY);
+    } else {
+      fail_unless (gst_pad_is_linked (pad));
+      fail_unless_equals_int (state, GST_STATE_PAUSED);
+    }
+  }
+  g_list_free_full (tracks, gst_object_unref);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_preview_quality_properties)
+{
+  guint quality;
+  gboolean adaptive;
+  GESPipeline *pipeline;
+
+  ges_init ();
+
+  pipeline = ges_test_create_pipeline (create_test_timeline (GST_SECOND));
+  g_object_get (pipeline, "adaptive-preview", &adaptive, "preview-quality",
+      &quality, NULL);
+  fail_if (adaptive);
+  fail_unless_equals_int (quality, 0);
+
+  g_object_set (pipeline, "adaptive-preview", TRUE, NULL);
+  g_object_get (pipeline, "adaptive-preview", &adaptive, "preview-quality",
+      &quality, NULL);
+  fail_unless (adaptive);
+  fail_unless_equals_int (quality, 0);
+
+  g_object_set (pipeline, "adaptive-preview", FALSE, NULL);
+  g_object_get (pipeline, "adaptive-preview", &adaptive, NULL);
+  fail_if (adaptive);
+
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static void
+send_qos_events (GstPad * pad, guint n_events, gboolean late)
+{
+  guint i;
+
+  for (i = 0; i < n_events; i++)
+    fail_unless (gst_pad_send_event (pad, gst_event_new_qos (late ?
+                GST_QOS_TYPE_UNDERFLOW : GST_QOS_TYPE_OVERFLOW,
+                late ? 1.5 : 0.5, late ? GST_SECOND / 10 : -GST_SECOND / 10,
+                i * GST_SECOND / 30)));
+}
+
+/* Quality is changed from the main context */
+static void
+wait_preview_quality (GESPipeline * pipeline, guint expected)
+{
+  guint quality;
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  do {
+    while (g_main_context_iteration (NULL, FALSE));
+    g_object_get (pipeline, "preview-quality", &quality, NULL);
+  } while (quality != expected && g_get_monotonic_time () < end_time);
+
+  fail_unless_equals_int (quality, expected);
+}
+
+static void
+get_restriction_format (GESTrack * track, gint * width, gint * height,
+    gint * fps_n, gint * fps_d)
+{
+  GstCaps *caps;
+  GstStructure *structure;
+
+  g_object_get (track, "restriction-caps", &caps, NULL);
+  fail_unless (caps != NULL);
+  structure = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_int (structure, "width", width));
+  fail_unless (gst_structure_get_int (structure, "height", height));
+  fail_unless (gst_structure_get_fraction (structure, "framerate", fps_n,
+          fps_d));
+  gst_caps_unref (caps);
+}
+
+GST_START_TEST (test_adaptive_preview_qos)
+{
+  GList *tmp;
+  GstPad *pad;
+  GstCaps *caps;
+  GESTrack *track = NULL;
+  GESPipeline *pipeline;
+  GESTimeline *timeline;
+  GstStructure *structure;
+  gint width, height, fps_n, fps_d;
+  gint full_width, full_height, full_fps_n, full_fps_d;
+
+  ges_init ();
+
+  /* The default video track restriction caps do not specify the format, it
+   * is taken from what got negotiated */
+  timeline = create_test_timeline (10 * GST_SECOND);
+  for (tmp = timeline->tracks; tmp; tmp = tmp->next) {
+    if (GES_TRACK (tmp->data)->type == GES_TRACK_TYPE_VIDEO)
+      track = tmp->data;
+  }
+  fail_unless (track != NULL);
+  caps = gst_caps_new_empty_simple ("video/x-raw");
+  ges_track_set_restriction_caps (track, caps);
+  gst_caps_unref (caps);
+
+  pipeline = ges_test_create_pipeline (timeline);
+  fail_unless (ges_pipeline_set_mode (pipeline, GES_PIPELINE_MODE_PREVIEW));
+  g_object_set (pipeline, "adaptive-preview", TRUE, NULL);
+  pause_pipeline (pipeline);
+
+  pad = ges_timeline_get_pad_for_track (timeline, track);
+  caps = gst_pad_get_current_caps (pad);
+  fail_unless (caps != NULL);
+  structure = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_int (structure, "width", &full_width));
+  fail_unless (gst_structure_get_int (structure, "height", &full_height));
+  fail_unless (gst_structure_get_fraction (structure, "framerate",
+          &full_fps_n, &full_fps_d));
+  gst_caps_unref (caps);
+
+  /* A few late QoS events are not enough */
+  send_qos_events (pad, 5, TRUE);
+  wait_preview_quality (pipeline, 0);
+
+  /* Half the resolution */
+  send_qos_events (pad, 5, TRUE);
+  wait_preview_quality (pipeline, 1);
+  get_restriction_format (track, &width, &height, &fps_n, &fps_d);
+  fail_unless_equals_int (width, (full_width >> 1) & ~1);
+  fail_unless_equals_int (height, (full_height >> 1) & ~1);
+  fail_unless_equals_int (fps_n * full_fps_d, full_fps_n * fps_d);
+
+  /* Then half the framerate, still relative to the full quality */
+  send_qos_events (pad, 10, TRUE);
+  wait_preview_quality (pipeline, 2);
+  get_restriction_format (track, &width, &height, &fps_n, &fps_d);
+  fail_unless_equals_int (width, (full_width >> 1) & ~1);
+  fail_unless_equals_int (fps_n * full_fps_d * 2, full_fps_n * fps_d);
+
+  /* Quarter of the resolution */
+  send_qos_events (pad, 10, TRUE);
+  wait_preview_quality (pipeline, 3);
+  get_restriction_format (track, &width, &height, &fps_n, &fps_d);
+  fail_unless_equals_int (width, (full_width >> 2) & ~1);
+  fail_unless_equals_int (height, (full_height >> 2) & ~1);
+
+  /* Never lower than the last level */
+  send_qos_events (pad, 10, TRUE);
+  wait_preview_quality (pipeline, 3);
+
+  /* Raised back one level at a time when there is enough headroom */
+  send_qos_events (pad, 100, FALSE);
+  wait_preview_quality (pipeline, 2);
+
+  /* Disabling adaptive preview restores the full quality, and the fields
+   * the user did not set */
+  g_object_set (pipeline, "adaptive-preview", FALSE, NULL);
+  wait_preview_quality (pipeline, 0);
+  g_object_get (track, "restriction-caps", &caps, NULL);
+  structure = gst_caps_get_structure (caps, 0);
+  fail_if (gst_structure_has_field (structure, "width"));
+  fail_if (gst_structure_has_field (structure, "height"));
+  fail_if (gst_structure_has_field (structure, "framerate"));
+  gst_caps_unref (caps);
+
+  /* QoS is ignored once disabled */
+  send_qos_events (pad, 10, TRUE);
+  wait_preview_quality (pipeline, 0);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static Suite *
+ges_suite (void)
+{
+  Suite *s = suite_create ("ges-pipeline");
+  TCase *tc_chain = tcase_create ("pipeline");
+
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, test_render_checkpoint_resume);
+  tcase_add_test (tc_chain, test_render_stats);
+  tcase_add_test (tc_chain, test_mixer_resample_quality);
+  tcase_add_test (tc_chain, test_unused_track_not_prerolled);
+  tcase_add_test (tc_chain, test_preview_quality_properties);
+  tcase_add_test (tc_chain, test_adaptive_preview_qos);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ges);
@@ -21,6 +21,8 @@
 #include "test-utils.h"
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <string.h>
 #include <gst/controller/gstdirectcontrolbinding.h>
 #include <gst/controller/gstinterpolationcontrolsource.h>
 
@@ -748,6 +750,966 @@ GST_START_TEST (test_load_xges_and_play)
 GST_END_TEST;
 #endif
 
+static void
+copy_media (const gchar * src_uri, const gchar * dest_uri)
+{
+  gsize length;
+  gchar *contents;
+  gchar *src = g_filename_from_uri (src_uri, NULL, NULL);
+  gchar *dest = g_filename_from_uri (dest_uri, NULL, NULL);
+
+  fail_unless (g_file_get_contents (src, &contents, &length, NULL));
+  fail_unless (g_file_set_contents (dest, contents, length, NULL));
+
+  g_free (contents);
+  g_free (src);
+  g_free (dest);
+}
+
+static void
+media_changed_cb (GESAsset * asset, GMainLoop * mainloop)
+{
+  g_main_loop_quit (mainloop);
+}
+
+GST_START_TEST (test_project_provisional_assets)
+{
+  gchar *contents;
+  GList *clips;
+  GESAsset *asset;
+  GESLayer *layer;
+  GESProject *project;
+  GESTimeline *timeline;
+  gchar *path, *audio_only_uri, *audio_video_uri;
+  gchar *media_uri = ges_test_get_tmp_uri ("test-provisional.ogg");
+  gchar *uri = ges_test_get_tmp_uri ("test-provisional.xges");
+
+  ges_init ();
+
+  audio_only_uri = ges_test_get_audio_only_uri ();
+  audio_video_uri = ges_test_get_audio_video_uri ();
+  copy_media (audio_only_uri, media_uri);
+
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  asset = GES_ASSET (ges_uri_clip_asset_request_sync (media_uri, NULL));
+  fail_unless (asset);
+  fail_unless (ges_layer_add_asset (layer, asset, 0, 0, GST_CLOCK_TIME_NONE,
+          GES_TRACK_TYPE_UNKNOWN));
+  gst_object_unref (asset);
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, NULL, TRUE, NULL));
+  gst_object_unref (timeline);
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, NULL, NULL));
+  fail_unless (g_strrstr (contents, "stream-info="));
+  g_free (contents);
+
+  /* Forget about the asset and change the media behind its back */
+  ges_deinit ();
+  ges_init ();
+  copy_media (audio_video_uri, media_uri);
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  project = ges_project_new (uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb,
+      mainloop);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+
+  /* The clip has been created from what the project stored */
+  layer = ges_timeline_get_layer (timeline, 0);
+  clips = ges_layer_get_clips (layer);
+  assert_equals_int (g_list_length (clips), 1);
+  asset = ges_extractable_get_asset (GES_EXTRACTABLE (clips->data));
+  assert_equals_int (ges_clip_asset_get_supported_formats (GES_CLIP_ASSET
+          (asset)), GES_TRACK_TYPE_AUDIO);
+
+  /* And gets updated once the media got discovered again */
+  g_signal_connect (asset, "media-changed", (GCallback) media_changed_cb,
+      mainloop);
+  g_main_loop_run (mainloop);
+  assert_equals_int (ges_clip_asset_get_supported_formats (GES_CLIP_ASSET
+          (asset)), GES_TRACK_TYPE_AUDIO | GES_TRACK_TYPE_VIDEO);
+  assert_equals_uint64 (ges_timeline_element_get_max_duration (clips->data),
+      ges_uri_clip_asset_get_duration (GES_URI_CLIP_ASSET (asset)));
+  g_signal_handlers_disconnect_by_func (asset, media_changed_cb, mainloop);
+
+  g_list_free_full (clips, gst_object_unref);
+  gst_object_unref (layer);
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  g_unlink (path);
+  g_free (path);
+  path = g_filename_from_uri (media_uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  g_free (audio_only_uri);
+  g_free (audio_video_uri);
+  g_free (media_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static void
+loading_progress_cb (GESProject * project, gdouble progress,
+    gdouble * last_progress)
+{
+  fail_unless (progress >= *last_progress);
+  *last_progress = progress;
+}
+
+GST_START_TEST (test_project_load_compressed)
+{
+  guint i, n_clips;
+  gsize length;
+  gchar *contents, *path;
+  GList *clips;
+  GFile *file;
+  GESLayer *layer;
+  GESProject *project;
+  GESTimeline *timeline;
+  GOutputStream *fstream, *stream;
+  GZlibCompressor *compressor;
+  gdouble last_progress = 0.0;
+  gchar *uri = ges_test_get_tmp_uri ("test-compressed.xges");
+  gchar *compressed_uri = ges_test_get_tmp_uri ("test-compressed-gz.xges");
+
+  ges_init ();
+
+  /* Big enough not to be parsed at once */
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  for (i = 0; i < 300; i++) {
+    GESTimelineElement *clip = GES_TIMELINE_ELEMENT (ges_test_clip_new ());
+
+    ges_timeline_element_set_start (clip, i * GST_SECOND);
+    ges_timeline_element_set_duration (clip, GST_SECOND);
+    fail_unless (ges_layer_add_clip (layer, GES_CLIP (clip)));
+  }
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, NULL, TRUE, NULL));
+  gst_object_unref (timeline);
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  g_unlink (path);
+  g_free (path);
+
+  file = g_file_new_for_uri (compressed_uri);
+  fstream = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
+          G_FILE_CREATE_NONE, NULL, NULL));
+  fail_unless (fstream);
+  compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+  stream = g_converter_output_stream_new (fstream, G_CONVERTER (compressor));
+  fail_unless (g_output_stream_write_all (stream, contents, length, NULL, NULL,
+          NULL));
+  fail_unless (g_output_stream_close (stream, NULL, NULL));
+  g_object_unref (stream);
+  g_object_unref (compressor);
+  g_object_unref (fstream);
+  g_free (contents);
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  project = ges_project_new (compressed_uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb,
+      mainloop);
+  g_signal_connect (project, "loading-progress",
+      (GCallback) loading_progress_cb, &last_progress);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+
+  /* Clips are added while the file is being parsed */
+  layer = ges_timeline_get_layer (timeline, 0);
+  clips = ges_layer_get_clips (layer);
+  n_clips = g_list_length (clips);
+  g_list_free_full (clips, gst_object_unref);
+  fail_unless (n_clips > 0 && n_clips < 300);
+
+  g_main_loop_run (mainloop);
+  clips = ges_layer_get_clips (layer);
+  assert_equals_int (g_list_length (clips), 300);
+  g_list_free_full (clips, gst_object_unref);
+  assert_equals_float (last_progress, 1.0);
+
+  gst_object_unref (layer);
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_free (compressed_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static void
+error_loading_cb (GESProject * project, GESTimeline * timeline,
+    GError * error, GESTimeline ** error_timeline)
+{
+  fail_unless (error != NULL);
+  *error_timeline = timeline;
+}
+
+GST_START_TEST (test_project_load_truncated)
+{
+  guint i;
+  gsize length;
+  gchar *contents, *path;
+  GESLayer *layer;
+  GESProject *project;
+  GESTimeline *timeline, *error_timeline = NULL;
+  GError *error = NULL;
+  gchar *uri = ges_test_get_tmp_uri ("test-truncated.xges");
+
+  ges_init ();
+
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  for (i = 0; i < 300; i++) {
+    GESTimelineElement *clip = GES_TIMELINE_ELEMENT (ges_test_clip_new ());
+
+    ges_timeline_element_set_start (clip, i * GST_SECOND);
+    ges_timeline_element_set_duration (clip, GST_SECOND);
+    fail_unless (ges_layer_add_clip (layer, GES_CLIP (clip)));
+  }
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, NULL, TRUE, NULL));
+  gst_object_unref (timeline);
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  fail_unless (length > 64 * 1024 + 1024);
+
+  /* A file parsed at once fails loading right away */
+  fail_unless (g_file_set_contents (path, contents, 1024, NULL));
+  project = ges_project_new (uri);
+  fail_if (ges_asset_extract (GES_ASSET (project), &error));
+  fail_unless (error != NULL);
+  g_clear_error (&error);
+  gst_object_unref (project);
+
+  /* A bigger one keeps what could be parsed and reports the error */
+  fail_unless (g_file_set_contents (path, contents, length - 1024, NULL));
+  mainloop = g_main_loop_new (NULL, FALSE);
+  project = ges_project_new (uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb,
+      mainloop);
+  g_signal_connect (project, "error-loading", (GCallback) error_loading_cb,
+      &error_timeline);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+  fail_unless (error_timeline == timeline);
+
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  g_unlink (path);
+  g_free (contents);
+  g_free (path);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static guint
+count_loaded_clips (const gchar * uri)
+{
+  guint n_clips;
+  GList *clips;
+  GESLayer *layer;
+  GESTimeline *timeline;
+  GESProject *project = ges_project_new (uri);
+
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb,
+      mainloop);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+
+  layer = ges_timeline_get_layer (timeline, 0);
+  clips = ges_layer_get_clips (layer);
+  n_clips = g_list_length (clips);
+  g_list_free_full (clips, gst_object_unref);
+  gst_object_unref (layer);
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+
+  return n_clips;
+}
+
+/* Checks the header has the version actually needed by the project */
+static void
+check_saved_version (const gchar * uri, GESProject * project)
+{
+  gchar *contents, *header, *path = g_filename_from_uri (uri, NULL, NULL);
+
+  fail_unless (g_file_get_contents (path, &contents, NULL, NULL));
+  header = g_strdup_printf ("<ges version='%s'>",
+      ges_meta_container_get_string (GES_META_CONTAINER (project),
+          GES_META_FORMAT_VERSION));
+  fail_unless (g_str_has_prefix (contents, header), "%s", contents);
+  g_free (header);
+  g_free (contents);
+  g_free (path);
+}
+
+static void
+project_saved_cb (GESProject * project, GAsyncResult * result,
+    gboolean * saved)
+{
+  *saved = ges_project_save_finish (project, result, NULL);
+  g_main_loop_quit (mainloop);
+}
+
+GST_START_TEST (test_project_save_stream)
+{
+  guint i;
+  gsize length;
+  gchar *contents, *path;
+  GESLayer *layer;
+  GESProject *project;
+  GESTimeline *timeline;
+  GESTimelineElement *clip, *first_clip = NULL;
+  GCancellable *cancellable;
+  gboolean saved = FALSE;
+  gchar *uri = ges_test_get_tmp_uri ("test-save-stream.xges");
+  gchar *async_uri = ges_test_get_tmp_uri ("test-save-stream-async.xges");
+  gchar *compressed_uri = ges_test_get_tmp_uri ("test-save-stream.xges.gz");
+
+  ges_init ();
+
+  /* Big enough to be written in several chunks */
+  mainloop = g_main_loop_new (NULL, FALSE);
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  for (i = 0; i < 300; i++) {
+    clip = GES_TIMELINE_ELEMENT (ges_test_clip_new ());
+    ges_timeline_element_set_start (clip, i * GST_SECOND);
+    ges_timeline_element_set_duration (clip, GST_SECOND);
+    fail_unless (ges_layer_add_clip (layer, GES_CLIP (clip)));
+    if (!first_clip)
+      first_clip = clip;
+  }
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, NULL, TRUE, NULL));
+  project = GES_PROJECT (ges_extractable_get_asset (GES_EXTRACTABLE
+          (timeline)));
+  check_saved_version (uri, project);
+
+  /* Cancelled before being serialized */
+  cancellable = g_cancellable_new ();
+  ges_project_save_async (project, timeline, async_uri, NULL, TRUE,
+      cancellable, (GAsyncReadyCallback) project_saved_cb, &saved);
+  g_cancellable_cancel (cancellable);
+  g_main_loop_run (mainloop);
+  fail_if (saved);
+  path = g_filename_from_uri (async_uri, NULL, NULL);
+  fail_if (g_file_test (path, G_FILE_TEST_EXISTS));
+  g_free (path);
+  g_object_unref (cancellable);
+
+  /* The timeline can be modified while the project is being serialized and
+   * written, clips added meanwhile are not saved, nor the removed ones */
+  ges_project_save_async (project, timeline, async_uri, NULL, TRUE, NULL,
+      (GAsyncReadyCallback) project_saved_cb, &saved);
+  clip = GES_TIMELINE_ELEMENT (ges_test_clip_new ());
+  ges_timeline_element_set_start (clip, 300 * GST_SECOND);
+  ges_timeline_element_set_duration (clip, GST_SECOND);
+  fail_unless (ges_layer_add_clip (layer, GES_CLIP (clip)));
+  fail_unless (ges_layer_remove_clip (layer, GES_CLIP (first_clip)));
+  g_main_loop_run (mainloop);
+  fail_unless (saved);
+  check_saved_version (async_uri, project);
+  assert_equals_int (count_loaded_clips (async_uri), 299);
+
+  fail_unless (ges_project_save (project, timeline, compressed_uri, NULL,
+          TRUE, NULL));
+  path = g_filename_from_uri (compressed_uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  fail_unless (length > 2 && (guint8) contents[0] == 0x1f
+      && (guint8) contents[1] == 0x8b);
+  g_free (contents);
+  assert_equals_int (count_loaded_clips (compressed_uri), 300);
+  g_unlink (path);
+  g_free (path);
+
+  gst_object_unref (timeline);
+  g_main_loop_unref (mainloop);
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  path = g_filename_from_uri (async_uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  g_free (compressed_uri);
+  g_free (async_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+/* A formatter whose writes fail midway, as when the disk gets full */
+typedef GESXmlFormatter TestFailingFormatter;
+typedef GESXmlFormatterClass TestFailingFormatterClass;
+
+static GType test_failing_formatter_get_type (void);
+G_DEFINE_TYPE (TestFailingFormatter, test_failing_formatter,
+    GES_TYPE_XML_FORMATTER);
+
+static gboolean
+failing_save_to_stream (GESFormatter * formatter, GESTimeline * timeline,
+    GOutputStream * stream, GError ** error)
+{
+  if (!g_output_stream_write_all (stream, "<ges version=", 13, NULL, NULL,
+          error) || !g_output_stream_flush (stream, NULL, error))
+    return FALSE;
+
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+      "No space left on device");
+
+  return FALSE;
+}
+
+static void
+test_failing_formatter_class_init (TestFailingFormatterClass * klass)
+{
+  GES_BASE_XML_FORMATTER_CLASS (klass)->save_to_stream = failing_save_to_stream;
+  ges_formatter_class_register_metas (GES_FORMATTER_CLASS (klass),
+      "failing", "Fails writing projects", "failing", "application/x-failing",
+      0.1, GST_RANK_NONE);
+}
+
+static void
+test_failing_formatter_init (TestFailingFormatter * self)
+{
+}
+
+GST_START_TEST (test_project_save_failing)
+{
+  gchar *contents, *path;
+  GESAsset *formatter_asset;
+  GESTimeline *timeline;
+  GError *error = NULL;
+  gchar *uri = ges_test_get_tmp_uri ("test-save-failing.xges");
+
+  ges_init ();
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  fail_unless (g_file_set_contents (path, "original", -1, NULL));
+
+  timeline = ges_timeline_new_audio_video ();
+  formatter_asset = ges_asset_request (test_failing_formatter_get_type (),
+      NULL, NULL);
+  fail_unless (formatter_asset);
+  fail_if (ges_timeline_save_to_uri (timeline, uri, formatter_asset, TRUE,
+          &error));
+  fail_unless (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE));
+  g_clear_error (&error);
+
+  /* The file that was there is left untouched */
+  fail_unless (g_file_get_contents (path, &contents, NULL, NULL));
+  assert_equals_string (contents, "original");
+  g_free (contents);
+
+  gst_object_unref (formatter_asset);
+  gst_object_unref (timeline);
+
+  g_unlink (path);
+  g_free (path);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_project_save_binary)
+{
+  gsize length, xml_length;
+  gchar *contents, *path;
+  GESProject *project;
+  GESTimeline *timeline;
+  GESAsset *formatter_asset;
+  gchar *uri = ges_test_file_uri ("test-properties.xges");
+  gchar *xml_uri = ges_test_get_tmp_uri ("test-save-binary.xges");
+  gchar *binary_uri = ges_test_get_tmp_uri ("test-save-binary.gesb");
+
+  ges_init ();
+
+  project = ges_project_new (uri);
+  mainloop = g_main_loop_new (NULL, FALSE);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb, mainloop);
+  g_signal_connect (project, "missing-uri", (GCallback) _set_new_uri, NULL);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  g_main_loop_run (mainloop);
+  _add_properties (timeline);
+
+  fail_unless (ges_project_save (project, timeline, xml_uri, NULL, TRUE,
+          NULL));
+  formatter_asset = ges_asset_request (GES_TYPE_FORMATTER, "gesb", NULL);
+  fail_unless (formatter_asset != NULL);
+  fail_unless (ges_project_save (project, timeline, binary_uri,
+          formatter_asset, TRUE, NULL));
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+
+  path = g_filename_from_uri (xml_uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &xml_length, NULL));
+  g_free (contents);
+  g_unlink (path);
+  g_free (path);
+
+  path = g_filename_from_uri (binary_uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  fail_unless (g_str_has_prefix (contents, "GESB"));
+  fail_unless (length < xml_length);
+  g_free (contents);
+
+  /* The formatter is found from the content of the file */
+  project = ges_project_new (binary_uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb, mainloop);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+
+  assert_equals_string (ges_meta_container_get_string (GES_META_CONTAINER
+          (project), "name"), "Example project");
+  assert_equals_int (g_list_length (timeline->layers), 1);
+  assert_equals_int (g_list_length ((GList *)
+          ges_project_list_encoding_profiles (project)), 1);
+  _check_properties (timeline);
+
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  g_unlink (path);
+  g_free (path);
+  g_free (binary_uri);
+  g_free (xml_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+typedef GESTestClip TestRenamedClip;
+typedef GESTestClipClass TestRenamedClipClass;
+
+static GType test_renamed_clip_get_type (void);
+G_DEFINE_TYPE (TestRenamedClip, test_renamed_clip, GES_TYPE_TEST_CLIP);
+
+static void
+test_renamed_clip_class_init (TestRenamedClipClass * klass)
+{
+}
+
+static void
+test_renamed_clip_init (TestRenamedClip * self)
+{
+}
+
+static void
+error_loading_asset_type_cb (GESProject * project, GError * error,
+    const gchar * id, GType extractable_type, gboolean * reported)
+{
+  fail_unless (g_error_matches (error, GST_CORE_ERROR,
+          GST_CORE_ERROR_MISSING_PLUGIN));
+  assert_equals_string (id, "TestMissingClip");
+  *reported = TRUE;
+}
+
+GST_START_TEST (test_project_load_binary_unknown_type)
+{
+  gsize i, length;
+  gchar *contents, *path;
+  GList *clips;
+  GESLayer *layer;
+  GESAsset *asset;
+  GESProject *project;
+  GESTimeline *timeline;
+  GESAsset *formatter_asset;
+  gboolean reported = FALSE;
+  gchar *uri = ges_test_get_tmp_uri ("test-unknown-type.gesb");
+
+  ges_init ();
+
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  fail_unless (ges_layer_add_clip (layer, GES_CLIP (ges_test_clip_new ())));
+  asset = ges_asset_request (test_renamed_clip_get_type (), NULL, NULL);
+  fail_unless (ges_layer_add_asset (layer, asset, GST_SECOND, 0, GST_SECOND,
+          GES_TRACK_TYPE_UNKNOWN));
+  gst_object_unref (asset);
+
+  formatter_asset = ges_asset_request (GES_TYPE_FORMATTER, "gesb", NULL);
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, formatter_asset,
+          TRUE, NULL));
+  gst_object_unref (formatter_asset);
+  gst_object_unref (timeline);
+
+  /* As if the type came from a plugin that is not available anymore */
+  path = g_filename_from_uri (uri, NULL, NULL);
+  fail_unless (g_file_get_contents (path, &contents, &length, NULL));
+  for (i = 0; i + 15 <= length; i++) {
+    if (!memcmp (contents + i, "TestRenamedClip", 15))
+      memcpy (contents + i, "TestMissingClip", 15);
+  }
+  fail_unless (g_file_set_contents (path, contents, length, NULL));
+  g_free (contents);
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  project = ges_project_new (uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb, mainloop);
+  g_signal_connect (project, "error-loading-asset",
+      (GCallback) error_loading_asset_type_cb, &reported);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+  fail_unless (reported);
+
+  /* The rest of the project is loaded */
+  layer = ges_timeline_get_layer (timeline, 0);
+  fail_unless (layer);
+  clips = ges_layer_get_clips (layer);
+  assert_equals_int (g_list_length (clips), 1);
+  fail_unless (GES_IS_TEST_CLIP (clips->data));
+  g_list_free_full (clips, gst_object_unref);
+  gst_object_unref (layer);
+
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  g_unlink (path);
+  g_free (path);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static guint64
+get_file_size (const gchar * uri)
+{
+  GStatBuf stat_buf;
+  gchar *path = g_filename_from_uri (uri, NULL, NULL);
+
+  fail_unless (g_stat (path, &stat_buf) == 0);
+  g_free (path);
+
+  return stat_buf.st_size;
+}
+
+GST_START_TEST (test_project_journal)
+{
+  guint i;
+  gchar *path;
+  GList *clips;
+  guint64 header_size;
+  GError *err = NULL;
+  GESLayer *layer;
+  GESProject *project;
+  GESTimeline *timeline;
+  GESTimelineElement *clip, *moved, *removed, *added, *effect;
+  gchar *moved_name, *removed_name, *added_name, *effect_clip_name;
+  gchar *uri = ges_test_get_tmp_uri ("test-journal.xges");
+  gchar *journal_uri = g_strconcat (uri, ".journal", NULL);
+
+  ges_init ();
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  for (i = 0; i < 3; i++) {
+    clip = GES_TIMELINE_ELEMENT (ges_test_clip_new ());
+    ges_timeline_element_set_start (clip, i * 10 * GST_SECOND);
+    ges_timeline_element_set_duration (clip, GST_SECOND);
+    fail_unless (ges_layer_add_clip (layer, GES_CLIP (clip)));
+  }
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, NULL, TRUE, NULL));
+  project = GES_PROJECT (ges_extractable_get_asset (GES_EXTRACTABLE
+          (timeline)));
+  fail_unless (ges_project_start_journal (project, timeline, &err));
+  fail_unless (err == NULL);
+  header_size = get_file_size (journal_uri);
+
+  clips = ges_layer_get_clips (layer);
+  moved = clips->data;
+  removed = clips->next->data;
+  ges_timeline_element_set_start (moved, 5 * GST_SECOND);
+  moved_name = ges_timeline_element_get_name (moved);
+  removed_name = ges_timeline_element_get_name (removed);
+  fail_unless (ges_layer_remove_clip (layer, GES_CLIP (removed)));
+
+  effect_clip_name = ges_timeline_element_get_name (clips->next->next->data);
+  effect = GES_TIMELINE_ELEMENT (ges_effect_new ("agingtv"));
+  fail_unless (ges_container_add (clips->next->next->data, effect));
+  g_list_free_full (clips, gst_object_unref);
+  _add_properties (timeline);
+
+  added = GES_TIMELINE_ELEMENT (ges_test_clip_new ());
+  ges_timeline_element_set_start (added, 30 * GST_SECOND);
+  ges_timeline_element_set_duration (added, 2 * GST_SECOND);
+  fail_unless (ges_layer_add_clip (layer, GES_CLIP (added)));
+  added_name = ges_timeline_element_get_name (added);
+  ges_meta_container_set_string (GES_META_CONTAINER (layer), "journaled",
+      "yes");
+
+  fail_unless (ges_project_sync_journal (project, &err));
+  fail_unless (get_file_size (journal_uri) > header_size);
+  ges_project_stop_journal (project);
+  gst_object_unref (timeline);
+
+  /* The journal is applied on top of the saved project */
+  project = ges_project_new (uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb, mainloop);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+
+  layer = ges_timeline_get_layer (timeline, 0);
+  clips = ges_layer_get_clips (layer);
+  assert_equals_int (g_list_length (clips), 3);
+  g_list_free_full (clips, gst_object_unref);
+  assert_equals_string (ges_meta_container_get_string (GES_META_CONTAINER
+          (layer), "journaled"), "yes");
+  gst_object_unref (layer);
+
+  clip = ges_timeline_get_element (timeline, moved_name);
+  fail_unless (clip != NULL);
+  assert_equals_uint64 (_START (clip), 5 * GST_SECOND);
+  gst_object_unref (clip);
+  fail_unless (ges_timeline_get_element (timeline, removed_name) == NULL);
+  clip = ges_timeline_get_element (timeline, added_name);
+  fail_unless (clip != NULL);
+  assert_equals_uint64 (_START (clip), 30 * GST_SECOND);
+  assert_equals_uint64 (_DURATION (clip), 2 * GST_SECOND);
+  gst_object_unref (clip);
+  clip = ges_timeline_get_element (timeline, effect_clip_name);
+  fail_unless (clip != NULL);
+  clips = ges_clip_get_top_effects (GES_CLIP (clip));
+  assert_equals_int (g_list_length (clips), 1);
+  g_list_free_full (clips, gst_object_unref);
+  gst_object_unref (clip);
+  _check_properties (timeline);
+
+  /* Saving the whole project restarts the journal */
+  fail_unless (ges_project_start_journal (project, timeline, &err));
+  fail_unless (get_file_size (journal_uri) > header_size);
+  fail_unless (ges_project_save (project, timeline, uri, NULL, TRUE, &err));
+  assert_equals_uint64 (get_file_size (journal_uri), header_size);
+  ges_project_stop_journal (project);
+
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  path = g_filename_from_uri (journal_uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  g_free (effect_clip_name);
+  g_free (added_name);
+  g_free (removed_name);
+  g_free (moved_name);
+  g_free (journal_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_project_journal_new_asset)
+{
+  gchar *path, *name;
+  GError *err = NULL;
+  GESLayer *layer;
+  GESAsset *asset;
+  GESProject *project;
+  GESTimeline *timeline;
+  GESTimelineElement *clip;
+  gchar *uri = ges_test_get_tmp_uri ("test-journal-asset.xges");
+  gchar *journal_uri = g_strconcat (uri, ".journal", NULL);
+  gchar *media_uri = ges_test_file_uri ("audio_video.ogg");
+
+  ges_init ();
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  timeline = ges_timeline_new_audio_video ();
+  layer = ges_timeline_append_layer (timeline);
+  fail_unless (ges_timeline_save_to_uri (timeline, uri, NULL, TRUE, NULL));
+  project = GES_PROJECT (ges_extractable_get_asset (GES_EXTRACTABLE
+          (timeline)));
+  fail_unless (ges_project_start_journal (project, timeline, &err));
+
+  /* An asset that is not in the saved project */
+  asset = GES_ASSET (ges_uri_clip_asset_request_sync (media_uri, &err));
+  fail_unless (asset != NULL);
+  clip = GES_TIMELINE_ELEMENT (ges_layer_add_asset (layer, asset, 0, 0,
+          GST_SECOND, GES_TRACK_TYPE_UNKNOWN));
+  fail_unless (clip != NULL);
+  name = ges_timeline_element_get_name (clip);
+  gst_object_unref (asset);
+
+  fail_unless (ges_project_sync_journal (project, &err));
+  ges_project_stop_journal (project);
+  gst_object_unref (timeline);
+
+  /* It gets loaded before the clip is replayed, without blocking */
+  project = ges_project_new (uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb, mainloop);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+
+  clip = ges_timeline_get_element (timeline, name);
+  fail_unless (GES_IS_URI_CLIP (clip));
+  assert_equals_uint64 (_DURATION (clip), GST_SECOND);
+  gst_object_unref (clip);
+  asset = ges_project_get_asset (project, media_uri, GES_TYPE_URI_CLIP);
+  fail_unless (asset != NULL);
+  gst_object_unref (asset);
+
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  path = g_filename_from_uri (uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  path = g_filename_from_uri (journal_uri, NULL, NULL);
+  g_unlink (path);
+  g_free (path);
+  g_free (name);
+  g_free (media_uri);
+  g_free (journal_uri);
+  g_free (uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static gchar *
+copy_media_to (const gchar * folder, const gchar * subfolder)
+{
+  gsize length;
+  gchar *contents, *media_path, *dest_folder, *dest;
+  gchar *media_uri = ges_test_file_uri ("audio_video.ogg");
+
+  media_path = g_filename_from_uri (media_uri, NULL, NULL);
+  fail_unless (g_file_get_contents (media_path, &contents, &length, NULL));
+
+  dest_folder = g_build_filename (folder, subfolder, NULL);
+  fail_unless (g_mkdir_with_parents (dest_folder, 0755) == 0);
+  dest = g_build_filename (dest_folder, "audio_video.ogg", NULL);
+  fail_unless (g_file_set_contents (dest, contents, length, NULL));
+
+  g_free (dest_folder);
+  g_free (contents);
+  g_free (media_path);
+  g_free (media_uri);
+
+  return dest;
+}
+
+GST_START_TEST (test_project_relocation_index)
+{
+  GESProject *project;
+  GESTimeline *timeline;
+  GList *clips;
+  gchar *folder, *folder_uri, *project_path, *project_uri, *expected_uri;
+  gchar *paths[3];
+  guint i;
+  const gchar *subfolders[] = { "a", "shoot", "z/b", "z" };
+  const gchar *xges = "<ges version='0.1'><project><resources>"
+      "<asset id='file:///moved/shoot/audio_video.ogg' "
+      "extractable-type-name='GESUriClip'/></resources><timeline>"
+      "<track track-type='2' caps='audio/x-raw' track-id='0'/>"
+      "<layer priority='0'>"
+      "<clip id='0' asset-id='file:///moved/shoot/audio_video.ogg' "
+      "type-name='GESUriClip' layer-priority='0' track-types='2' start='0' "
+      "duration='1000000000'/></layer></timeline></project></ges>";
+
+  ges_init ();
+
+  /* The file is found under several folders, the one named like the
+   * original folder has to be picked */
+  folder = g_dir_make_tmp ("ges-relocation-XXXXXX", NULL);
+  fail_unless (folder != NULL);
+  for (i = 0; i < G_N_ELEMENTS (paths); i++)
+    paths[i] = copy_media_to (folder, subfolders[i]);
+  expected_uri = g_filename_to_uri (paths[1], NULL, NULL);
+
+  project_path = g_build_filename (folder, "project.xges", NULL);
+  fail_unless (g_file_set_contents (project_path, xges, -1, NULL));
+  project_uri = g_filename_to_uri (project_path, NULL, NULL);
+
+  folder_uri = g_filename_to_uri (folder, NULL, NULL);
+  fail_unless (ges_add_missing_uri_relocation_uri (folder_uri, TRUE));
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  project = ges_project_new (project_uri);
+  g_signal_connect (project, "loaded", (GCallback) project_loaded_cb,
+      mainloop);
+  timeline = GES_TIMELINE (ges_asset_extract (GES_ASSET (project), NULL));
+  fail_unless (GES_IS_TIMELINE (timeline));
+  g_main_loop_run (mainloop);
+
+  clips = ges_layer_get_clips (GES_LAYER (timeline->layers->data));
+  assert_equals_int (g_list_length (clips), 1);
+  assert_equals_string (ges_asset_get_id (ges_extractable_get_asset
+          (GES_EXTRACTABLE (clips->data))), expected_uri);
+  g_list_free_full (clips, gst_object_unref);
+
+  gst_object_unref (timeline);
+  gst_object_unref (project);
+  g_main_loop_unref (mainloop);
+
+  for (i = 0; i < G_N_ELEMENTS (paths); i++) {
+    g_unlink (paths[i]);
+    g_free (paths[i]);
+  }
+  for (i = 0; i < G_N_ELEMENTS (subfolders); i++) {
+    gchar *path = g_build_filename (folder, subfolders[i], NULL);
+
+    g_rmdir (path);
+    g_free (path);
+  }
+  g_unlink (project_path);
+  g_rmdir (folder);
+  g_free (project_path);
+  g_free (project_uri);
+  g_free (folder_uri);
+  g_free (folder);
+  g_free (expected_uri);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -761,6 +1723,16 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_project_load_xges);
   tcase_add_test (tc_chain, test_project_add_properties);
   tcase_add_test (tc_chain, test_project_auto_transition);
+  tcase_add_test (tc_chain, test_project_provisional_assets);
+  tcase_add_test (tc_chain, test_project_load_compressed);
+  tcase_add_test (tc_chain, test_project_load_truncated);
+  tcase_add_test (tc_chain, test_project_save_stream);
+  tcase_add_test (tc_chain, test_project_save_failing);
+  tcase_add_test (tc_chain, test_project_save_binary);
+  tcase_add_test (tc_chain, test_project_load_binary_unknown_type);
+  tcase_add_test (tc_chain, test_project_journal);
+  tcase_add_test (tc_chain, test_project_journal_new_asset);
+  tcase_add_test (tc_chain, test_project_relocation_index);
   /*tcase_add_test (tc_chain, test_load_xges_and_play); */
   tcase_add_test (tc_chain, test_project_unexistant_effect);
 
@@ -87,6 +87,32 @@ ges_test_create_pipeline (GESTimeline * timeline)
   return pipeline;
 }
 
+/* Theora and Vorbis in Ogg, to render timelines */
+GstEncodingProfile *
+ges_test_create_ogg_profile (void)
+{
+  GstCaps *caps;
+  GstEncodingContainerProfile *container;
+
+  caps = gst_caps_new_empty_simple ("application/ogg");
+  container = gst_encoding_container_profile_new ("ogg", NULL, caps, NULL);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_new_empty_simple ("video/x-theora");
+  gst_encoding_container_profile_add_profile (container,
+      (GstEncodingProfile *) gst_encoding_video_profile_new (caps, NULL, NULL,
+          0));
+  gst_caps_unref (caps);
+
+  caps = gst_caps_new_empty_simple ("audio/x-vorbis");
+  gst_encoding_container_profile_add_profile (container,
+      (GstEncodingProfile *) gst_encoding_audio_profile_new (caps, NULL, NULL,
+          0));
+  gst_caps_unref (caps);
+
+  return GST_ENCODING_PROFILE (container);
+}
+
 gchar *
 ges_test_file_name (const gchar * filename)
 {
@@ -39,6 +39,7 @@ gchar * ges_test_get_audio_only_uri (void);
 gchar * ges_test_get_audio_video_uri (void);
 gchar * ges_test_get_image_uri (void);
 gchar * ges_test_file_uri (const gchar *filename);
+GstEncodingProfile * ges_test_create_ogg_profile (void);
 
 void check_destroyed (GObject *object_to_unref, GObject *first_object, ...) G_GNUC_NULL_TERMINATED;
 gchar * ges_test_file_name (const gchar *filename);
@@ -211,6 +211,156 @@ GST_START_TEST (test_title_source_in_layer)
 
 GST_END_TEST;
 
+static GstPadProbeReturn
+collect_memories_cb (GstPad * pad, GstPadProbeInfo * info, GList ** memories)
+{
+  *memories = g_list_append (*memories,
+      gst_buffer_peek_memory (GST_PAD_PROBE_INFO_BUFFER (info), 0));
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_title_source_reuses_rendered_frames)
+{
+  GList *tmp, *memories = NULL;
+  GstBus *bus;
+  GstPad *srcpad;
+  GObject *text;
+  GstCaps *caps;
+  GstMessage *message;
+  GESLayer *layer;
+  GESTrack *track;
+  GESTimeline *timeline;
+  GESPipeline *pipeline;
+  GESTrackElement *track_element;
+  GESClip *clip;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  track = GES_TRACK (ges_video_track_new ());
+  caps = gst_caps_from_string ("video/x-raw,width=64,height=48,"
+      "framerate=25/1");
+  ges_track_set_restriction_caps (track, caps);
+  gst_caps_unref (caps);
+  ges_timeline_add_track (timeline, track);
+  layer = ges_timeline_append_layer (timeline);
+
+  clip = GES_CLIP (ges_title_clip_new ());
+  g_object_set (clip, "duration", (guint64) 200 * GST_MSECOND, "text",
+      "some text", NULL);
+  ges_layer_add_clip (layer, clip);
+
+  track_element = ges_clip_find_track_element (clip, track,
+      GES_TYPE_TITLE_SOURCE);
+  fail_unless (ges_timeline_element_lookup_child (GES_TIMELINE_ELEMENT
+          (track_element), "text", &text, NULL));
+  srcpad = gst_element_get_static_pad (GST_ELEMENT (text), "src");
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) collect_memories_cb, &memories, NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (text);
+
+  pipeline = ges_test_create_pipeline (timeline);
+  bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* The text is static so it is only rendered once */
+  fail_unless (g_list_length (memories) > 1);
+  for (tmp = memories->next; tmp; tmp = tmp->next)
+    fail_unless (tmp->data == memories->data);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  g_list_free (memories);
+  gst_object_unref (track_element);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_title_source_keeps_bindings_enabled)
+{
+  GstBus *bus;
+  GObject *text;
+  GstCaps *caps;
+  gdouble xpos;
+  GstMessage *message;
+  GESLayer *layer;
+  GESTrack *track;
+  GESTimeline *timeline;
+  GESPipeline *pipeline;
+  GESTrackElement *track_element;
+  GstControlSource *source;
+  GstControlBinding *binding;
+  GESClip *clip;
+
+  ges_init ();
+
+  timeline = ges_timeline_new ();
+  track = GES_TRACK (ges_video_track_new ());
+  caps = gst_caps_from_string ("video/x-raw,width=64,height=48,"
+      "framerate=25/1");
+  ges_track_set_restriction_caps (track, caps);
+  gst_caps_unref (caps);
+  ges_timeline_add_track (timeline, track);
+  layer = ges_timeline_append_layer (timeline);
+
+  clip = GES_CLIP (ges_title_clip_new ());
+  g_object_set (clip, "duration", (guint64) 200 * GST_MSECOND, "text",
+      "some text", NULL);
+  ges_layer_add_clip (layer, clip);
+
+  track_element = ges_clip_find_track_element (clip, track,
+      GES_TYPE_TITLE_SOURCE);
+  source = gst_interpolation_control_source_new ();
+  g_object_set (source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (source),
+      0, 0.0);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (source),
+      200 * GST_MSECOND, 1.0);
+  fail_unless (ges_track_element_set_control_source (track_element, source,
+          "xpos", "direct-absolute"));
+  gst_object_unref (source);
+
+  pipeline = ges_test_create_pipeline (timeline);
+  bus = gst_element_get_bus (GST_ELEMENT (pipeline));
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* The cache evaluated the binding itself but left it as it found it */
+  binding = ges_track_element_get_control_binding (track_element, "xpos");
+  fail_unless (binding != NULL);
+  fail_if (gst_control_binding_is_disabled (binding));
+  fail_unless (ges_timeline_element_lookup_child (GES_TIMELINE_ELEMENT
+          (track_element), "text", &text, NULL));
+  g_object_get (text, "xpos", &xpos, NULL);
+  fail_unless (xpos > 0.0);
+  gst_object_unref (text);
+
+  gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_NULL);
+  gst_object_unref (track_element);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -222,6 +372,8 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_title_source_basic);
   tcase_add_test (tc_chain, test_title_source_properties);
   tcase_add_test (tc_chain, test_title_source_in_layer);
+  tcase_add_test (tc_chain, test_title_source_reuses_rendered_frames);
+  tcase_add_test (tc_chain, test_title_source_keeps_bindings_enabled);
 
   return s;
 }
@@ -20,6 +20,7 @@
 #include "test-utils.h"
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 
 static gboolean
 compare_caps_from_string (GstCaps * caps, const gchar * desc)
@@ -91,6 +92,93 @@ GST_START_TEST (test_update_restriction_caps)
 
 GST_END_TEST;
 
+GST_START_TEST (test_gap_source_shares_memory)
+{
+  GstMapInfo map;
+  GstHarness *h;
+  GstBuffer *first, *second;
+
+  ges_init ();
+
+  h = gst_harness_new_parse ("gesgapsrc track-type=video num-buffers=2");
+  gst_harness_set_sink_caps_str (h,
+      "video/x-raw,format=I420,width=64,height=48,framerate=25/1");
+  gst_harness_play (h);
+
+  first = gst_harness_pull (h);
+  second = gst_harness_pull (h);
+
+  /* All frames share the same read only black frame */
+  fail_unless (gst_buffer_peek_memory (first, 0) ==
+      gst_buffer_peek_memory (second, 0));
+  fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (first, 0)));
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (first), 0);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (second), GST_SECOND / 25);
+  fail_unless_equals_uint64 (GST_BUFFER_DURATION (second), GST_SECOND / 25);
+
+  fail_unless (gst_buffer_map (first, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.data[0], 16);
+  fail_unless_equals_int (map.data[map.size - 1], 128);
+  gst_buffer_unmap (first, &map);
+
+  gst_buffer_unref (first);
+  gst_buffer_unref (second);
+  gst_harness_teardown (h);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_gap_source_reuses_silence)
+{
+  guint i;
+  GstMapInfo map;
+  GstHarness *h;
+  GstBuffer *buffers[3];
+
+  ges_init ();
+
+  h = gst_harness_new_parse ("gesgapsrc track-type=audio num-buffers=3");
+  gst_harness_set_sink_caps_str (h, "audio/x-raw,format=S16LE,"
+      "layout=interleaved,rate=44100,channels=2");
+  gst_harness_play (h);
+
+  for (i = 0; i < G_N_ELEMENTS (buffers); i++)
+    buffers[i] = gst_harness_pull (h);
+
+  /* The silence is only created once, each buffer references it with its
+   * own timestamps */
+  for (i = 0; i < G_N_ELEMENTS (buffers); i++) {
+    fail_unless (gst_buffer_peek_memory (buffers[i], 0) ==
+        gst_buffer_peek_memory (buffers[0], 0));
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buffers[i], GST_BUFFER_FLAG_GAP));
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffers[i]),
+        i * 100 * GST_MSECOND);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buffers[i]),
+        100 * GST_MSECOND);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buffers[i]), i * 4410);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (buffers[i]),
+        (i + 1) * 4410);
+  }
+  fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buffers[0],
+              0)));
+
+  fail_unless (gst_buffer_map (buffers[0], &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, 4410 * 4);
+  fail_unless_equals_int (map.data[0], 0);
+  fail_unless_equals_int (map.data[map.size - 1], 0);
+  gst_buffer_unmap (buffers[0], &map);
+
+  for (i = 0; i < G_N_ELEMENTS (buffers); i++)
+    gst_buffer_unref (buffers[i]);
+  gst_harness_teardown (h);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 ges_suite (void)
 {
@@ -100,6 +188,8 @@ ges_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_update_restriction_caps);
+  tcase_add_test (tc_chain, test_gap_source_shares_memory);
+  tcase_add_test (tc_chain, test_gap_source_reuses_silence);
 
   return s;
 }
@@ -21,6 +21,8 @@
 #include "test-utils.h"
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
 
 /* This test uri will eventually have to be fixed */
 #define TEST_URI "blahblahblah"
@@ -175,7 +177,87 @@ GST_START_TEST (test_transition_properties)
 
 GST_END_TEST;
 
+static GstHarness *
+create_fade_harness (gdouble start_volume, gdouble end_volume)
+{
+  GstHarness *h = gst_harness_new ("gesaudiofade");
+
+  g_object_set (h->element, "start-volume", start_volume, "end-volume",
+      end_volume, "duration", GST_SECOND, NULL);
+  gst_harness_set_src_caps_str (h, "audio/x-raw,format=" GST_AUDIO_NE (F32)
+      ",layout=interleaved,rate=100,channels=1");
+
+  return h;
+}
+
+static GstBuffer *
+push_ones (GstHarness * h, GstClockTime pts)
+{
+  guint i;
+  GstMapInfo map;
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, 100 * sizeof (gfloat),
+      NULL);
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < 100; i++)
+    ((gfloat *) map.data)[i] = 1.0;
+  gst_buffer_unmap (buffer, &map);
+  GST_BUFFER_PTS (buffer) = pts;
+
+  return gst_harness_push_and_pull (h, buffer);
+}
 
+GST_START_TEST (test_audio_fades_share_curves)
+{
+  guint i;
+  GstMapInfo map, map2;
+  GstBuffer *buffer, *buffer2;
+  GstHarness *h1, *h2, *h3;
+
+  ges_init ();
+
+  h1 = create_fade_harness (0.0, 1.0);
+  h2 = create_fade_harness (0.0, 1.0);
+  h3 = create_fade_harness (1.0, 0.0);
+
+  buffer = push_ones (h1, 0);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless (ABS (((gfloat *) map.data)[0] - 0.0) < 1e-5);
+  fail_unless (ABS (((gfloat *) map.data)[50] - 0.5) < 1e-5);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  /* After the fade, the end volume is kept */
+  buffer = push_ones (h1, GST_SECOND);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless (ABS (((gfloat *) map.data)[0] - 1.0) < 1e-5);
+  fail_unless (ABS (((gfloat *) map.data)[99] - 1.0) < 1e-5);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  /* A fade with the same shape, sharing the curve, outputs the same
+   * samples and the opposite fade the mirrored ones */
+  buffer = push_ones (h2, 0);
+  buffer2 = push_ones (h3, 0);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  gst_buffer_map (buffer2, &map2, GST_MAP_READ);
+  for (i = 0; i < 100; i++) {
+    fail_unless (ABS (((gfloat *) map.data)[i] - i / 100.0) < 1e-5);
+    fail_unless (ABS (((gfloat *) map2.data)[i] - (1.0 - i / 100.0)) < 1e-5);
+  }
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unmap (buffer2, &map2);
+  gst_buffer_unref (buffer);
+  gst_buffer_unref (buffer2);
+
+  gst_harness_teardown (h1);
+  gst_harness_teardown (h2);
+  gst_harness_teardown (h3);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
 
 static Suite *
 ges_suite (void)
@@ -187,6 +269,7 @@ ges_suite (void)
 
   tcase_add_test (tc_chain, test_transition_basic);
   tcase_add_test (tc_chain, test_transition_properties);
+  tcase_add_test (tc_chain, test_audio_fades_share_curves);
 
   return s;
 }
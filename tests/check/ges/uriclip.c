@@ -20,6 +20,8 @@
 #include "test-utils.h"
 #include <ges/ges.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
 
 /* This test uri will eventually have to be fixed */
 #define TEST_URI "http://nowhere/blahblahblah"
@@ -273,6 +275,272 @@ GST_START_TEST (test_filesource_images)
 
 GST_END_TEST;
 
+static GstHarness *
+create_image_harness (const gchar * caps)
+{
+  GstHarness *h = gst_harness_new ("gescachedimagesrc");
+
+  g_object_set (h->element, "uri", image_uri, "num-buffers", 1, NULL);
+  gst_harness_set_sink_caps_str (h, caps);
+  gst_harness_play (h);
+
+  return h;
+}
+
+GST_START_TEST (test_image_sources_share_decoded_frame)
+{
+  GstHarness *h1, *h2, *h3;
+  GstBuffer *buf1, *buf2, *buf3;
+
+  ges_init ();
+
+  h1 = create_image_harness ("video/x-raw,format=I420,framerate=25/1");
+  h2 = create_image_harness ("video/x-raw,format=I420,framerate=30/1");
+  h3 = create_image_harness ("video/x-raw,format=RGBA,framerate=25/1");
+
+  buf1 = gst_harness_pull (h1);
+  buf2 = gst_harness_pull (h2);
+  buf3 = gst_harness_pull (h3);
+
+  /* Same image and format: the frame was decoded and converted once */
+  fail_unless (gst_buffer_peek_memory (buf1, 0) ==
+      gst_buffer_peek_memory (buf2, 0));
+  fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buf1, 0)));
+  /* Different target caps get their own frame */
+  fail_if (gst_buffer_peek_memory (buf1, 0) ==
+      gst_buffer_peek_memory (buf3, 0));
+
+  gst_buffer_unref (buf1);
+  gst_buffer_unref (buf2);
+  gst_buffer_unref (buf3);
+  gst_harness_teardown (h1);
+  gst_harness_teardown (h2);
+  gst_harness_teardown (h3);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+static void
+check_black_row (GstMapInfo * map, gint row)
+{
+  gint i;
+  guint8 *pixel = map->data + row * 64 * 4;
+
+  for (i = 0; i < 64; i++, pixel += 4) {
+    fail_unless_equals_int (pixel[0], 0);
+    fail_unless_equals_int (pixel[1], 0);
+    fail_unless_equals_int (pixel[2], 0);
+    fail_unless_equals_int (pixel[3], 0xff);
+  }
+}
+
+GST_START_TEST (test_image_source_letterboxing)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  ges_init ();
+
+  /* The 16:9 test image in a square frame gets black borders at the top
+   * and the bottom: it is scaled to 64x36 and centered */
+  h = create_image_harness ("video/x-raw,format=RGBA,width=64,height=64,"
+      "pixel-aspect-ratio=1/1,framerate=25/1");
+  buf = gst_harness_pull (h);
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, 64 * 64 * 4);
+  check_black_row (&map, 0);
+  check_black_row (&map, 13);
+  check_black_row (&map, 50);
+  check_black_row (&map, 63);
+  gst_buffer_unmap (buf, &map);
+
+  gst_buffer_unref (buf);
+  gst_harness_teardown (h);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GThread *main_thread;
+  guint n_pending;
+} ParallelDiscoveryData;
+
+static void
+parallel_asset_loaded_cb (GObject * source, GAsyncResult * res,
+    ParallelDiscoveryData * data)
+{
+  GError *error = NULL;
+  GESAsset *asset = ges_asset_request_finish (res, &error);
+
+  fail_unless (error == NULL);
+  fail_unless (GES_IS_URI_CLIP_ASSET (asset));
+  /* Completion is always delivered on the main context */
+  fail_unless (g_thread_self () == data->main_thread);
+  gst_object_unref (asset);
+
+  if (--data->n_pending == 0)
+    g_main_loop_quit (mainloop);
+}
+
+GST_START_TEST (test_parallel_discovery)
+{
+  guint i;
+  gchar *uris[3];
+  ParallelDiscoveryData data;
+
+  g_setenv ("GES_DISCOVERY_POOL_SIZE", "2", TRUE);
+  ges_init ();
+
+  uris[0] = ges_test_get_audio_video_uri ();
+  uris[1] = ges_test_get_audio_only_uri ();
+  uris[2] = ges_test_get_image_uri ();
+
+  mainloop = g_main_loop_new (NULL, FALSE);
+  data.main_thread = g_thread_self ();
+  data.n_pending = G_N_ELEMENTS (uris);
+  for (i = 0; i < G_N_ELEMENTS (uris); i++)
+    ges_asset_request_async (GES_TYPE_URI_CLIP, uris[i], NULL,
+        (GAsyncReadyCallback) parallel_asset_loaded_cb, &data);
+  g_main_loop_run (mainloop);
+  fail_unless_equals_int (data.n_pending, 0);
+
+  g_main_loop_unref (mainloop);
+  for (i = 0; i < G_N_ELEMENTS (uris); i++)
+    g_free (uris[i]);
+
+  ges_deinit ();
+  g_unsetenv ("GES_DISCOVERY_POOL_SIZE");
+}
+
+GST_END_TEST;
+
+static guint
+count_dir_entries (const gchar * path)
+{
+  guint n = 0;
+  GDir *dir = g_dir_open (path, 0, NULL);
+
+  if (!dir)
+    return 0;
+
+  while (g_dir_read_name (dir))
+    n++;
+  g_dir_close (dir);
+
+  return n;
+}
+
+GST_START_TEST (test_discovery_cache)
+{
+  gchar *cache_dir, *uri, *entry;
+  GstClockTime duration;
+  guint n_streams;
+  GESUriClipAsset *asset;
+  GDir *dir;
+
+  cache_dir = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  fail_unless (cache_dir != NULL);
+  g_setenv ("GES_DISCOVERY_CACHE_DIR", cache_dir, TRUE);
+  uri = ges_test_get_audio_video_uri ();
+
+  ges_init ();
+  asset = ges_uri_clip_asset_request_sync (uri, NULL);
+  fail_unless (asset != NULL);
+  duration = ges_uri_clip_asset_get_duration (asset);
+  n_streams = g_list_length ((GList *)
+      ges_uri_clip_asset_get_stream_assets (asset));
+  gst_object_unref (asset);
+  ges_deinit ();
+
+  fail_unless_equals_int (count_dir_entries (cache_dir), 1);
+
+  /* Loaded from the cache this time */
+  ges_init ();
+  asset = ges_uri_clip_asset_request_sync (uri, NULL);
+  fail_unless (asset != NULL);
+  fail_unless_equals_uint64 (ges_uri_clip_asset_get_duration (asset),
+      duration);
+  fail_unless_equals_int (g_list_length ((GList *)
+          ges_uri_clip_asset_get_stream_assets (asset)), n_streams);
+  fail_unless (gst_discoverer_info_get_uri (ges_uri_clip_asset_get_info
+          (asset)) != NULL);
+  gst_object_unref (asset);
+  ges_deinit ();
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  entry = g_build_filename (cache_dir, g_dir_read_name (dir), NULL);
+  g_dir_close (dir);
+  g_unlink (entry);
+  g_free (entry);
+  g_rmdir (cache_dir);
+  g_free (cache_dir);
+  g_free (uri);
+  g_unsetenv ("GES_DISCOVERY_CACHE_DIR");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_discovery_cache_pruning)
+{
+  gchar *cache_dir, *uri, *checksum, *entry_path, *old_path, *contents;
+  gsize length;
+  GFile *old_file;
+  GESUriClipAsset *asset;
+
+  cache_dir = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  fail_unless (cache_dir != NULL);
+  g_setenv ("GES_DISCOVERY_CACHE_DIR", cache_dir, TRUE);
+  g_setenv ("GES_DISCOVERY_CACHE_SIZE", "1", TRUE);
+  uri = ges_test_get_audio_video_uri ();
+
+  /* A corrupted entry for @uri, and an old entry filling the budget */
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  entry_path = g_build_filename (cache_dir, checksum, NULL);
+  g_free (checksum);
+  fail_unless (g_file_set_contents (entry_path, "garbage", -1, NULL));
+  old_path = g_build_filename (cache_dir,
+      "0000000000000000000000000000000000000000", NULL);
+  contents = g_malloc0 (2 * 1024 * 1024);
+  fail_unless (g_file_set_contents (old_path, contents, 2 * 1024 * 1024,
+          NULL));
+  g_free (contents);
+  old_file = g_file_new_for_path (old_path);
+  fail_unless (g_file_set_attribute_uint64 (old_file,
+          G_FILE_ATTRIBUTE_TIME_MODIFIED, 1000, G_FILE_QUERY_INFO_NONE, NULL,
+          NULL));
+  g_object_unref (old_file);
+
+  /* The corrupted entry is discarded, the media discovered again and the
+   * old entry evicted when storing the new one */
+  ges_init ();
+  asset = ges_uri_clip_asset_request_sync (uri, NULL);
+  fail_unless (asset != NULL);
+  gst_object_unref (asset);
+  ges_deinit ();
+
+  fail_if (g_file_test (old_path, G_FILE_TEST_EXISTS));
+  fail_unless_equals_int (count_dir_entries (cache_dir), 1);
+  fail_unless (g_file_get_contents (entry_path, &contents, &length, NULL));
+  fail_if (length == sizeof ("garbage") - 1);
+  g_free (contents);
+
+  g_unlink (entry_path);
+  g_free (entry_path);
+  g_free (old_path);
+  g_rmdir (cache_dir);
+  g_free (cache_dir);
+  g_free (uri);
+  g_unsetenv ("GES_DISCOVERY_CACHE_DIR");
+  g_unsetenv ("GES_DISCOVERY_CACHE_SIZE");
+}
+
+GST_END_TEST;
 
 static Suite *
 ges_suite (void)
@@ -285,6 +553,11 @@ ges_suite (void)
   tcase_add_test (tc_chain, test_filesource_basic);
   tcase_add_test (tc_chain, test_filesource_images);
   tcase_add_test (tc_chain, test_filesource_properties);
+  tcase_add_test (tc_chain, test_image_sources_share_decoded_frame);
+  tcase_add_test (tc_chain, test_image_source_letterboxing);
+  tcase_add_test (tc_chain, test_parallel_discovery);
+  tcase_add_test (tc_chain, test_discovery_cache);
+  tcase_add_test (tc_chain, test_discovery_cache_pruning);
 
   return s;
 }
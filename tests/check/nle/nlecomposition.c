@@ -438,6 +438,89 @@ GST_START_TEST (test_simple_audiomixer)
 
 GST_END_TEST;
 
+/* A composition with a 2 seconds source1 over an expandable default source,
+ * linked to a fakesink in @pipeline */
+static GstElement *
+create_composition_pipeline (GstElement ** pipeline, GstElement ** source1,
+    GstElement ** def)
+{
+  GstElement *comp, *sink;
+  gboolean ret = FALSE;
+
+  *pipeline = gst_pipeline_new ("test_pipeline");
+  comp =
+      gst_element_factory_make_or_warn ("nlecomposition", "test_composition");
+  gst_element_set_state (comp, GST_STATE_READY);
+
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (*pipeline), comp, sink, NULL);
+  gst_element_link (comp, sink);
+
+  *source1 = videotest_nle_src ("source1", 0, 2 * GST_SECOND, 2, 2);
+  *def =
+      videotest_nle_src ("default", 0 * GST_SECOND, 0 * GST_SECOND, 2,
+      G_MAXUINT32);
+  g_object_set (*def, "expandable", TRUE, NULL);
+
+  fail_unless (nle_composition_add (GST_BIN (comp), *source1));
+  fail_unless (nle_composition_add (GST_BIN (comp), *def));
+  commit_and_wait (comp, &ret);
+
+  return comp;
+}
+
+GST_START_TEST (test_stack_switch_stats)
+{
+  GstElement *pipeline;
+  GstElement *comp, *source1, *def;
+  gboolean ret = FALSE;
+  guint64 n_stack_switches, n_stack_switches_after_move;
+  guint64 stack_switch_time;
+
+  ges_init ();
+
+  /* Nothing was set up yet */
+  comp = gst_object_ref_sink (gst_element_factory_make_or_warn
+      ("nlecomposition", "test_composition"));
+  g_object_get (comp, "stack-switches", &n_stack_switches,
+      "stack-switch-time", &stack_switch_time, NULL);
+  assert_equals_uint64 (n_stack_switches, 0);
+  assert_equals_uint64 (stack_switch_time, 0);
+  gst_object_unref (comp);
+
+  comp = create_composition_pipeline (&pipeline, &source1, &def);
+
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline),
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE);
+  check_state_simple (pipeline, GST_STATE_PAUSED);
+
+  /* Setting up the initial stack is accounted as a switch */
+  g_object_get (comp, "stack-switches", &n_stack_switches,
+      "stack-switch-time", &stack_switch_time, NULL);
+  fail_unless (n_stack_switches >= 1);
+  fail_unless (stack_switch_time > 0);
+
+  /* Moving source1 out of the active segment leaves only the default
+   * source in the stack */
+  g_object_set (source1, "start", (guint64) 4 * GST_SECOND, NULL);
+  commit_and_wait (comp, &ret);
+
+  g_object_get (comp, "stack-switches", &n_stack_switches_after_move, NULL);
+  fail_unless (n_stack_switches_after_move > n_stack_switches,
+      "Expected more than %" G_GUINT64_FORMAT " stack switches, got %"
+      G_GUINT64_FORMAT, n_stack_switches, n_stack_switches_after_move);
+
+  fail_if (gst_element_set_state (GST_ELEMENT (pipeline),
+          GST_STATE_NULL) == GST_STATE_CHANGE_FAILURE);
+
+  ASSERT_OBJECT_REFCOUNT_BETWEEN (pipeline, "main pipeline", 1, 2);
+  gst_check_objects_destroyed_on_unref (pipeline, comp, def, NULL);
+
+  ges_deinit ();
+}
+
+GST_END_TEST;
+
 static Suite *
 gnonlin_suite (void)
 {
@@ -451,6 +534,7 @@ gnonlin_suite (void)
   tcase_add_test (tc_chain, test_remove_last_object);
 
   tcase_add_test (tc_chain, test_dispose_on_commit);
+  tcase_add_test (tc_chain, test_stack_switch_stats);
 
   if (gst_registry_check_feature_version (gst_registry_get (), "audiomixer", 1,
           0, 0)) {
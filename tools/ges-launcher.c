@@ -23,6 +23,8 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #ifdef G_OS_UNIX
@@ -46,6 +48,7 @@ typedef struct
   gchar *format;
   gchar *outputuri;
   gchar *encoding_profile;
+  gchar *render_stats_path;
   gchar *videosink;
   gchar *audiosink;
   gboolean list_transitions;
@@ -60,6 +63,7 @@ struct _GESLauncherPrivate
   GESTimeline *timeline;
   GESPipeline *pipeline;
   gboolean seenerrors;
+  FILE *render_stats_file;
 #ifdef G_OS_UNIX
   guint signal_watch_id;
 #endif
@@ -356,6 +360,18 @@ bus_message_cb (GstBus * bus, GstMessage * message, GESLauncher * self)
     case GST_MESSAGE_REQUEST_STATE:
       ges_validate_handle_request_state_change (message, G_APPLICATION (self));
       break;
+    case GST_MESSAGE_ELEMENT:
+      if (self->priv->render_stats_file &&
+          GST_MESSAGE_SRC (message) == GST_OBJECT_CAST (self->priv->pipeline)
+          && gst_message_has_name (message, "ges-render-stats")) {
+        gchar *json =
+            structure_to_json (gst_message_get_structure (message));
+
+        fprintf (self->priv->render_stats_file, "%s\n", json);
+        fflush (self->priv->render_stats_file);
+        g_free (json);
+      }
+      break;
     default:
       break;
   }
@@ -490,6 +506,20 @@ _set_rendering_details (GESLauncher * self)
     }
 
     gst_encoding_profile_unref (prof);
+
+    if (opts->render_stats_path) {
+      if (g_strcmp0 (opts->render_stats_path, "-") == 0)
+        self->priv->render_stats_file = stdout;
+      else if (!(self->priv->render_stats_file =
+              g_fopen (opts->render_stats_path, "w"))) {
+        g_printerr ("Could not open %s to write render statistics\n",
+            opts->render_stats_path);
+        return FALSE;
+      }
+
+      g_object_set (self->priv->pipeline, "render-stats-interval",
+          (guint64) GST_SECOND, NULL);
+    }
   } else {
     ges_pipeline_set_mode (self->priv->pipeline, GES_PIPELINE_MODE_PREVIEW);
   }
@@ -654,6 +684,13 @@ ges_launcher_get_rendering_option_group (GESLauncher * self)
           "See ges-launch-1.0 help profile for more information. "
           "This will have no effect if no outputuri has been specified.",
         "<profile-name>"},
+    {"render-stats", 0, 0, G_OPTION_ARG_STRING, &opts->render_stats_path,
+          "Write rendering statistics (realtime factor, per track fps, "
+          "encoding queues fill level, decoding and stack switch times) "
+          "every second as JSON objects, one per line, to the given file, "
+          "or to stdout if set to '-'. "
+          "This will have no effect if no outputuri has been specified.",
+        "<path>"},
     {NULL}
   };
 
@@ -854,6 +891,10 @@ _shutdown (GApplication * application)
   g_source_remove (self->priv->signal_watch_id);
 #endif
 
+  if (self->priv->render_stats_file && self->priv->render_stats_file != stdout)
+    fclose (self->priv->render_stats_file);
+  self->priv->render_stats_file = NULL;
+
   g_free (opts->sanitized_timeline);
 
   G_APPLICATION_CLASS (ges_launcher_parent_class)->shutdown (application);
@@ -17,6 +17,7 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <math.h>
 #include <stdlib.h>
 #include <glib/gprintf.h>
 #include <string.h>
@@ -142,3 +143,114 @@ print_enum (GType enum_type)
 
   g_type_class_unref (enum_class);
 }
+
+static void _append_json_structure (GString * json,
+    const GstStructure * structure);
+
+static void
+_append_json_string (GString * json, const gchar * str)
+{
+  if (!str) {
+    g_string_append (json, "null");
+    return;
+  }
+
+  g_string_append_c (json, '"');
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\')
+      g_string_append_printf (json, "\\%c", *str);
+    else if ((guchar) * str < 0x20)
+      g_string_append_printf (json, "\\u%04x", (guchar) * str);
+    else
+      g_string_append_c (json, *str);
+  }
+  g_string_append_c (json, '"');
+}
+
+static void
+_append_json_value (GString * json, const GValue * value)
+{
+  GType type = G_VALUE_TYPE (value);
+
+  if (GST_VALUE_HOLDS_STRUCTURE (value)) {
+    _append_json_structure (json, gst_value_get_structure (value));
+  } else if (GST_VALUE_HOLDS_ARRAY (value) || GST_VALUE_HOLDS_LIST (value)) {
+    guint i, size = GST_VALUE_HOLDS_ARRAY (value) ?
+        gst_value_array_get_size (value) : gst_value_list_get_size (value);
+
+    g_string_append_c (json, '[');
+    for (i = 0; i < size; i++) {
+      if (i)
+        g_string_append_c (json, ',');
+      _append_json_value (json, GST_VALUE_HOLDS_ARRAY (value) ?
+          gst_value_array_get_value (value, i) :
+          gst_value_list_get_value (value, i));
+    }
+    g_string_append_c (json, ']');
+  } else if (type == G_TYPE_STRING) {
+    _append_json_string (json, g_value_get_string (value));
+  } else if (type == G_TYPE_BOOLEAN) {
+    g_string_append (json, g_value_get_boolean (value) ? "true" : "false");
+  } else if (type == G_TYPE_DOUBLE || type == G_TYPE_FLOAT) {
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gdouble d = type == G_TYPE_DOUBLE ? g_value_get_double (value) :
+        g_value_get_float (value);
+
+    if (isfinite (d))
+      g_string_append (json, g_ascii_dtostr (buf, sizeof (buf), d));
+    else
+      g_string_append (json, "null");
+  } else if (type == G_TYPE_UINT64) {
+    guint64 v = g_value_get_uint64 (value);
+
+    /* GST_CLOCK_TIME_NONE */
+    if (v == G_MAXUINT64)
+      g_string_append (json, "null");
+    else
+      g_string_append_printf (json, "%" G_GUINT64_FORMAT, v);
+  } else if (type == G_TYPE_INT || type == G_TYPE_UINT ||
+      type == G_TYPE_INT64) {
+    gchar *str = g_strdup_value_contents (value);
+
+    g_string_append (json, str);
+    g_free (str);
+  } else {
+    gchar *str = gst_value_serialize (value);
+
+    _append_json_string (json, str);
+    g_free (str);
+  }
+}
+
+static gboolean
+_append_json_field (GQuark field_id, const GValue * value, GString * json)
+{
+  if (json->str[json->len - 1] != '{')
+    g_string_append_c (json, ',');
+
+  _append_json_string (json, g_quark_to_string (field_id));
+  g_string_append_c (json, ':');
+  _append_json_value (json, value);
+
+  return TRUE;
+}
+
+static void
+_append_json_structure (GString * json, const GstStructure * structure)
+{
+  g_string_append_c (json, '{');
+  gst_structure_foreach (structure,
+      (GstStructureForeachFunc) _append_json_field, json);
+  g_string_append_c (json, '}');
+}
+
+/* g_free after usage */
+gchar *
+structure_to_json (const GstStructure * structure)
+{
+  GString *json = g_string_new (NULL);
+
+  _append_json_structure (json, structure);
+
+  return g_string_free (json, FALSE);
+}
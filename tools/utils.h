@@ -24,3 +24,4 @@ guint get_flags_from_string (GType type, const gchar * str_flags);
 gchar * ensure_uri (const gchar * location);
 GstEncodingProfile * parse_encoding_profile (const gchar * format);
 void print_enum (GType enum_type);
+gchar * structure_to_json (const GstStructure * structure);